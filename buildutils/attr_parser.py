@@ -55,6 +55,10 @@ import xml.parsers.expat
 list_ecl = []
 list_svr = []
 list_defs = []
+list_names = []
+
+INCLUDE_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                           os.pardir, 'src', 'include')
 
 global attr_type
 global newattr
@@ -137,10 +141,144 @@ def getText(svr_file, ecl_file, defines_file):
         defines_file.write(line)
 
 
+def add_name(buf):
+    '''
+    Records the server side name of the current attribute, in array order,
+    for the perfect hash table emitted after the server array
+    buf - the member_name text (a string literal or an ATTR_ macro)
+    '''
+    if attr_type == PropType.SERVER or attr_type == PropType.BOTH:
+        list_names.append(buf.strip('\n \t'))
+
+
+def load_macros():
+    '''
+    Reads the string valued #defines from the PBS include directory so
+    that ATTR_ macros used as member names can be resolved at build time
+    '''
+    macros = {}
+    pat = re.compile(r'^\s*#\s*define\s+(\w+)\s+("[^"]*"|\w+)\s*(/\*.*\*/\s*)?$',
+                     re.M)
+    try:
+        files = os.listdir(INCLUDE_DIR)
+    except OSError:
+        return macros
+    for f in sorted(files):
+        if not f.endswith('.h'):
+            continue
+        with open(os.path.join(INCLUDE_DIR, f), encoding='utf-8',
+                  errors='replace') as fd:
+            for m in pat.finditer(fd.read()):
+                macros.setdefault(m.group(1), m.group(2))
+    return macros
+
+
+def resolve_name(name, macros):
+    '''
+    Returns the string value of a member name or None if it is unknown
+    '''
+    for _ in range(8):
+        if name.startswith('"') and name.endswith('"'):
+            return name[1:-1]
+        if name not in macros:
+            return None
+        name = macros[name]
+    return None
+
+
+def ph_hash(seed, name):
+    '''
+    Case insensitive FNV-1a, must match attr_phash_hash() in attr_func.c
+    '''
+    h = (2166136261 ^ seed) & 0xffffffff
+    for c in name.encode('utf-8'):
+        if 65 <= c <= 90:
+            c += 32
+        h = ((h ^ c) * 16777619) & 0xffffffff
+    return h ^ (h >> 16)
+
+
+def build_phash(names):
+    '''
+    Builds a hash-and-displace perfect hash over names.  Keys are split
+    into buckets by ph_hash(0, key); each bucket, largest first, is given
+    the first displacement seed that lands all of its keys in free slots.
+    names - list of (index, name) tuples
+    Returns (nbucket, nslot, disp, slot)
+    '''
+    nslot = 1
+    while nslot < len(names):
+        nslot *= 2
+    while True:
+        nbucket = max(1, nslot // 2)
+        buckets = [[] for _ in range(nbucket)]
+        for ent in names:
+            buckets[ph_hash(0, ent[1]) & (nbucket - 1)].append(ent)
+        disp = [0] * nbucket
+        slot = [-1] * nslot
+        done = True
+        for b in sorted(range(nbucket), key=lambda x: -len(buckets[x])):
+            if not buckets[b]:
+                break
+            for seed in range(1, 65536):
+                pos = [ph_hash(seed, n) & (nslot - 1) for i, n in buckets[b]]
+                if len(set(pos)) == len(pos) and \
+                        all(slot[x] == -1 for x in pos):
+                    break
+            else:
+                done = False
+                break
+            disp[b] = seed
+            for (i, n), x in zip(buckets[b], pos):
+                slot[x] = i
+        if done:
+            return nbucket, nslot, disp, slot
+        nslot *= 2
+
+
+def do_phash(array):
+    '''
+    Appends the perfect hash table for the server array to the server file.
+    If a member name cannot be resolved the table is emitted empty and the
+    runtime falls back to the dynamic index.
+    array - the name of the server side definition array
+    '''
+    if not array:
+        return
+    macros = load_macros()
+    names = []
+    seen = set()
+    for i, n in enumerate(list_names):
+        val = resolve_name(n, macros)
+        if val is None:
+            names = None
+            break
+        if val.lower() in seen:
+            continue
+        seen.add(val.lower())
+        names.append((i, val))
+
+    list_svr.append('\n/* perfect hash of the definition names, see attr_phash_index() */\n')
+    if not names:
+        list_svr.append('const attr_phash_t ' + array + '_phash = {0, 0, NULL, NULL, ' + array + '};\n')
+        return
+    nbucket, nslot, disp, slot = build_phash(names)
+    list_svr.append('static const unsigned short ' + array + '_disp[] = {')
+    for i, d in enumerate(disp):
+        list_svr.append(('\n\t' if i % 12 == 0 else ' ') + str(d) + ',')
+    list_svr.append('\n};\nstatic const short ' + array + '_slot[] = {')
+    for i, x in enumerate(slot):
+        list_svr.append(('\n\t' if i % 12 == 0 else ' ') + str(x) + ',')
+    list_svr.append('\n};\nconst attr_phash_t ' + array + '_phash = {\n\t' +
+                    str(nbucket) + ', ' + str(nslot) + ', ' + array + '_disp, ' +
+                    array + '_slot, ' + array + '\n};\n')
+
+
 def do_head(node):
     '''
     Processes the head element of the node passed
     '''
+    array = None
     alist = node.getElementsByTagName('head')
     for a in alist:
         list_svr.append ("/*Disclaimer: This is a machine generated file.*/" + '\n')
@@ -153,10 +291,14 @@ def do_head(node):
             text1 = s.childNodes[0].nodeValue
             text1 = text1.strip(' \t')
             list_svr.append(text1)
+            m = re.search(r'(\w+)\s*\[\s*\]\s*=\s*\{', text1)
+            if m:
+                array = m.group(1)
         for e in blist_ecl:
             text2 = e.childNodes[0].nodeValue
             text2 = text2.strip(' \t')
             list_ecl.append(text2)
+    return array
 
 
 def do_index(attr):
@@ -193,6 +335,8 @@ def do_member(attr, p_flag, tag_name):
             for v in value:
                 buf = v.childNodes[0].nodeValue
                 fileappend(PropType.SERVER, comma + '\n' + '\t' + '\t' + buf)
+                if tag_name == 'member_name':
+                    add_name(buf)
 
         ecl = li[0].getElementsByTagName('ECL')
         if ecl:
@@ -208,6 +352,8 @@ def do_member(attr, p_flag, tag_name):
                 s = buf.strip('\n \t')
                 if s:
                     fileappend(p_flag, comma + '\n' + '\t' + '\t' + buf)
+                    if tag_name == 'member_name' and not svr:
+                        add_name(s)
 
 
 def process(master_file, svr_file, ecl_file, defines_file):
@@ -228,7 +374,7 @@ def process(master_file, svr_file, ecl_file, defines_file):
     nodes = doc.getElementsByTagName('data')
 
     for node in nodes:
-        do_head(node)
+        array = do_head(node)
     
         at_list = node.getElementsByTagName('attributes')
         for attr in at_list:
@@ -301,6 +447,8 @@ def process(master_file, svr_file, ecl_file, defines_file):
                 e = e.strip(' \t')
                 list_ecl.append(e)
 
+        do_phash(array)
+
         getText(svr_file, ecl_file, defines_file)
 
 
@@ -146,6 +146,7 @@ static char *output_format_names[] = {"default", "dsv", "json", NULL};
 static int output_format = FORMAT_DEFAULT;
 static int quiet = 0;
 static char *dsv_delim = "|";
+static json_writer json_out;	/* the -F json document */
 
 
 /**
@@ -181,6 +182,17 @@ cmp_node_name(char *n1, char *n2)
 		return 1;
 }
 
+/**
+ * @brief
+ *	end the json document on the way out, so that an exit part way
+ *	through the output still leaves valid json.
+ */
+static void
+end_json_output(void)
+{
+	close_json(&json_out);
+}
+
 /**
  * @brief
  *	Encodes the information in batch_status structure to json format
@@ -203,18 +215,18 @@ encode_to_json(struct batch_status *bstat)
 	double	      value = 0;
 	char	     *prev_jobid = "";
 
-	if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, bstat->name, NULL) == NULL)
+	if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, bstat->name, NULL) == NULL)
 		return 1;
 	for (pattr = bstat->attribs; pattr; pattr = pattr->next) {
 		if (strcmp(pattr->name, "resources_available") == 0) {
-			if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, pattr->name, NULL) == NULL)
+			if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, pattr->name, NULL) == NULL)
 				return 1;
 			for (next = pattr; next; ) {
-				if (add_json_node(JSON_VALUE, JSON_NULL, JSON_FULLESCAPE, next->resource, next->value) == NULL)
+				if (add_json_node(&json_out, JSON_VALUE, JSON_NULL, JSON_FULLESCAPE, next->resource, next->value) == NULL)
 					return 1;
 				if (next->next == NULL || strcmp(next->next->name, "resources_available")) {
 					/* Nothing left in resources_available, close object */
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 						return 1;
 					pattr = next;
 					next = NULL;
@@ -223,7 +235,7 @@ encode_to_json(struct batch_status *bstat)
 				}
 			}
 		} else if (strcmp(pattr->name, "resources_assigned") == 0) {
-			if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, pattr->name, NULL) == NULL)
+			if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, pattr->name, NULL) == NULL)
 				return 1;
 			for (next = pattr; next; ) {
 				str = next->value;
@@ -236,17 +248,17 @@ encode_to_json(struct batch_status *bstat)
 				}
 				/* Adding only non zero values.*/
 				if (value) {
-					if (add_json_node(JSON_VALUE, JSON_NULL, JSON_FULLESCAPE, next->resource, next->value) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_NULL, JSON_FULLESCAPE, next->resource, next->value) == NULL)
 						return 1;
 				} else {
 					if (str[0] != '0') {
-						if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, next->resource, str) == NULL)
+						if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, next->resource, str) == NULL)
 							return 1;
 					}
 				}
 				if (next->next == NULL || strcmp(next->next->name, "resources_assigned")) {
 					/* Nothing left in resources_assigned, close object */
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 						return 1;
 					pattr = next;
 					next = NULL;
@@ -255,7 +267,7 @@ encode_to_json(struct batch_status *bstat)
 				}
 			}
 		} else if (strcmp(pattr->name, "jobs") == 0) {
-			if (add_json_node(JSON_ARRAY, JSON_NULL, JSON_NOVALUE, pattr->name, NULL) == NULL)
+			if (add_json_node(&json_out, JSON_ARRAY, JSON_NULL, JSON_NOVALUE, pattr->name, NULL) == NULL)
 				return 1;
 			pc = pc1 = str = pattr->value;
 			while (*pc1) {
@@ -269,20 +281,20 @@ encode_to_json(struct batch_status *bstat)
 				if (pc1)
 					*pc1 = '\0';
 				if (strcmp(pc, prev_jobid) != 0) {
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, NULL, pc) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, NULL, pc) == NULL)
 						return 1;
 				}
 				prev_jobid = pc;
 			}
-			if (add_json_node(JSON_ARRAY_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+			if (add_json_node(&json_out, JSON_ARRAY_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 				return 1;
 		} else {
-			if (add_json_node(JSON_VALUE, JSON_NULL, JSON_FULLESCAPE, pattr->name, pattr->value) == NULL)
+			if (add_json_node(&json_out, JSON_VALUE, JSON_NULL, JSON_FULLESCAPE, pattr->name, pattr->value) == NULL)
 				return 1;
 		}
 
 	}
-	if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+	if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 		return 1;
 	return 0;
 
@@ -558,63 +570,63 @@ prt_node_summary(char *def_server, struct batch_status *bstatus, int job_summary
 				break;
 
 			case FORMAT_JSON:
-				if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, name, NULL) == NULL)
+				if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, name, NULL) == NULL)
 					return 1;
-				if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "State", state) == NULL)
+				if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "State", state) == NULL)
 					return 1;
 				if (job_summary) {
 
-					if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "Total Jobs", &njobs) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "Total Jobs", &njobs) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "Running Jobs", &run_jobs) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "Running Jobs", &run_jobs) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "Suspended Jobs", &susp_jobs) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "Suspended Jobs", &susp_jobs) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "mem f/t", mem_info) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "mem f/t", mem_info) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "ncpus f/t", ncpus_info) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "ncpus f/t", ncpus_info) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "nmics f/t", nmic_info) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "nmics f/t", nmic_info) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "ngpus f/t", ngpus_info) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "ngpus f/t", ngpus_info) == NULL)
 						return 1;
-					if (add_json_node(JSON_ARRAY, JSON_NULL, JSON_NOVALUE, "jobs", NULL) == NULL)
+					if (add_json_node(&json_out, JSON_ARRAY, JSON_NULL, JSON_NOVALUE, "jobs", NULL) == NULL)
 						return 1;
 					if (strcmp(jobs, "--") != 0) {
 						pc = strtok(jobs, ",");
 						while (pc != NULL) {
-							node = add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, NULL, pc);
+							node = add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, NULL, pc);
 							if (node == NULL)
 								return 1;
 							pc = strtok(NULL, ",");
 						}
 					}
-					if (add_json_node(JSON_ARRAY_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+					if (add_json_node(&json_out, JSON_ARRAY_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 						return 1;
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 						return 1;
 				} else {
 
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "OS", os) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "OS", os) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "hardware", hardware) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "hardware", hardware) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "host", host) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "host", host) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "queue", queue) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "queue", queue) == NULL)
 						return 1;
-					if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "Memory", mem_info) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "Memory", mem_info) == NULL)
 						return 1;
 					value = atol(ncpus_info);
-					if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "ncpus", &value) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "ncpus", &value) == NULL)
 						return 1;
 					value = atol(nmic_info);
-					if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "nmics", &value) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "nmics", &value) == NULL)
 						return 1;
 					value = atol(ngpus_info);
-					if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "ngpus", &value) == NULL)
+					if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "ngpus", &value) == NULL)
 						return 1;
-					if (add_json_node(JSON_OBJECT_END, JSON_STRING, JSON_FULLESCAPE, "comment", comment) == NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_STRING, JSON_FULLESCAPE, "comment", comment) == NULL)
 						return 1;
 				}
 				break;
@@ -1122,20 +1134,22 @@ main(int argc, char *argv[])
 	}
 	/* adding prologue to json output. */
 	if (output_format == FORMAT_JSON) {
+		json_writer_init(&json_out, stdout);
+		atexit(end_json_output);
 		timenow = time(0);
-		if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "timestamp", &timenow) == NULL) {
+		if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "timestamp", &timenow) == NULL) {
 			fprintf(stderr, "pbsnodes: out of memory\n");
 			exit(1);
 		}
-		if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_version", PBS_VERSION) == NULL) {
+		if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_version", PBS_VERSION) == NULL) {
 			fprintf(stderr, "pbsnodes: out of memory\n");
 			exit(1);
 		}
-		if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_server", def_server) == NULL) {
+		if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_server", def_server) == NULL) {
 			fprintf(stderr, "pbsnodes: out of memory\n");
 			exit(1);
 		}
-		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, "nodes", NULL) == NULL) {
+		if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, "nodes", NULL) == NULL) {
 			fprintf(stderr, "pbsnodes: out of memory\n");
 			exit(1);
 		}
@@ -1232,12 +1246,11 @@ main(int argc, char *argv[])
 					prt_node(bstat);
 			}
 			if (output_format == FORMAT_JSON) {
-				if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL) {
+				if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL) {
 					fprintf(stderr, "pbsnodes: out of memory\n");
 					return 1;
 				}
-				generate_json(stdout);
-				free_json_node_list();
+				generate_json(&json_out);
 			}
 			pbs_statfree(bstat_head);
 
@@ -1266,8 +1279,8 @@ main(int argc, char *argv[])
 					if (pbs_errno != 0) {
 
 						if (output_format == FORMAT_JSON) {
-							add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, *pa, NULL);
-							add_json_node(JSON_OBJECT_END, JSON_STRING, JSON_FULLESCAPE, "Error", pbs_geterrmsg(con));
+							add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, *pa, NULL);
+							add_json_node(&json_out, JSON_OBJECT_END, JSON_STRING, JSON_FULLESCAPE, "Error", pbs_geterrmsg(con));
 						} else {
 							fprintf(stderr, "Node: %s,  Error: %s\n", *pa, pbs_geterrmsg(con));
 							rc = 1;
@@ -1285,12 +1298,11 @@ main(int argc, char *argv[])
 				}
 			}
 			if (output_format == FORMAT_JSON) {
-				if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL) {
+				if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL) {
 					fprintf(stderr, "pbsnodes: out of memory\n");
 					exit(1);
 				}
-				generate_json(stdout);
-				free_json_node_list();
+				generate_json(&json_out);
 			}
 
 			break;
@@ -1344,8 +1356,8 @@ main(int argc, char *argv[])
 				if (!bstat) {
 					if (pbs_errno != 0) {
 						if (output_format == FORMAT_JSON) {
-							add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, *pa, NULL);
-							add_json_node(JSON_OBJECT_END, JSON_STRING, JSON_FULLESCAPE, "Error", pbs_geterrmsg(con));
+							add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, *pa, NULL);
+							add_json_node(&json_out, JSON_OBJECT_END, JSON_STRING, JSON_FULLESCAPE, "Error", pbs_geterrmsg(con));
 						} else {
 							fprintf(stderr, "Node: %s,  Error: %s\n", *pa, pbs_geterrmsg(con));
 							rc = 1;
@@ -1356,12 +1368,11 @@ main(int argc, char *argv[])
 				pa++;
 			}
 			if (output_format == FORMAT_JSON) {
-				if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL) {
+				if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL) {
 					fprintf(stderr, "pbsnodes : out of memory");
 					exit(1);
 				}
-				generate_json(stdout);
-				free_json_node_list();
+				generate_json(&json_out);
 			}
 			pbs_statfree(bstat_head);
 			break;
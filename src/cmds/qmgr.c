@@ -1314,10 +1314,12 @@ check_list(char *list, int type)
 		foreptr = backptr;
 
 		/* object names (except nodes ) have to start with an alpha character or
-		 * can be left off if all object of the same type are wanted
+		 * can be left off if all object of the same type are wanted,
+		 * node names may also be patterns starting with a wildcard
 		 */
 		if (type == MGR_OBJ_NODE) {
-			if (!isalnum((int) *backptr) && *backptr != '@')
+			if (!isalnum((int) *backptr) && *backptr != '@' &&
+				*backptr != '*' && *backptr != '?')
 				return (backptr - list ? backptr - list : 1);
 		} else if (!isalpha((int) *backptr) && *backptr != '@')
 			return (backptr - list ? backptr - list : 1);
@@ -2139,6 +2141,160 @@ handle_formula(struct attropl *attribs)
 	return;
 }
 
+/**
+ * @brief
+ *	report_mgr_error - print the error returned by the server for a manager
+ *	request on an object
+ *
+ * @param[in] sp       server the request was sent to
+ * @param[in] obj_name name of the object
+ * @param[in] oper     the command
+ * @param[in] type     the object type
+ * @param[in] errmsg   error text from the server, may be NULL
+ *
+ * @return Void
+ *
+ */
+static void
+report_mgr_error(struct server *sp, char *obj_name, int oper, int type, char *errmsg)
+{
+	int len;
+	char errnomsg[256];		/* Error message with pbs_errno */
+
+	/*
+	 ** IF
+	 **	stdin is a tty			OR
+	 **	the command is not SET		OR
+	 **	the object type is not NODE	OR
+	 **	the error is not "attempt to set READ ONLY attribute"
+	 ** THEN print error messages
+	 ** ELSE don't print error messages
+	 **
+	 ** This is to deal with bug 4941 where errors are generated
+	 ** from running qmgr with input from a file which was generated
+	 ** by 'qmgr -c "p n @default" > /tmp/nodes_out'.
+	 */
+	if (!isatty(0) && (oper == MGR_CMD_SET) && (type == MGR_OBJ_NODE) &&
+		(pbs_errno == PBSE_ATTRRO))
+		return;
+
+	if (errmsg != NULL) {
+		len = strlen(errmsg) + strlen(obj_name) + strlen(Svrname(sp)) + 20;
+		if (len < 256) {
+			sprintf(errnomsg, "qmgr obj=%s svr=%s: %s\n",
+				obj_name, Svrname(sp),  errmsg);
+			pstderr(errnomsg);
+		}
+		else {
+			/*obviously, this is to cover a highly unlikely case*/
+
+			pstderr_big(Svrname(sp), obj_name, errmsg);
+		}
+	}
+
+	if (pbs_errno == PBSE_PROTOCOL) {
+		if ((check_time - start_time) >= QMGR_TIMEOUT) {
+			pstderr("qmgr: Server disconnected due to idle connection timeout\n");
+		} else {
+			pstderr("qmgr: Protocol error, server disconnected\n");
+		}
+		exit(1);
+	}
+	else if (pbs_errno == PBSE_HOOKERROR) {
+		pstderr("qmgr: hook error returned from server\n");
+	}
+	else
+		if (pbs_errno != 0)  /* 0 happens with hooks if no hooks found */
+			PSTDERR1("qmgr: Error (%d) returned from server\n", pbs_errno)
+}
+
+/**
+ * @brief
+ *	report_mgr_message - print the text returned by the server along with
+ *	a successful reply
+ *
+ * @param[in] msg   text from the server
+ *
+ * @return Void
+ *
+ */
+static void
+report_mgr_message(char *msg)
+{
+	char *pmsg;
+
+	if ((pmsg = malloc(strlen(msg) + 2)) != NULL) {
+		strcpy(pmsg, msg);
+		strcat(pmsg, "\n");
+		pstderr(pmsg);
+		free(pmsg);
+	}
+}
+
+/**
+ * @brief
+ *	execute_node_list - create, set or unset a list of nodes with a single
+ *	request to the one active server, so that the server saves the nodes
+ *	and notifies the Moms once for the whole list rather than once per node.
+ *
+ * @param[in] oper     The command, either create, set or unset.
+ * @param[in] names    The node name list.
+ * @param[in] attribs  The attribute list with operators.
+ *
+ * @return int
+ * @retval 0 for success
+ * @retval -1 the list was not sent as one request, or the server did not
+ *	take it as one and changed nothing, the caller should handle each node
+ * @retval >0 error from the server, already reported
+ *
+ */
+static int
+execute_node_list(int oper, struct objname *names, struct attropl *attribs)
+{
+	struct objname *pname;
+	struct server *sp;
+	char *list;
+	char *errmsg;
+	int len = 0;
+	int perr;
+
+	if ((names == NULL) || (names->next == NULL) ||
+		(active_servers == NULL) || (active_servers->next != NULL))
+		return -1;
+	for (pname = names; pname != NULL; pname = pname->next) {
+		if ((pname->svr_name != NULL) || (pname->obj_name[0] == '\0'))
+			return -1;
+		len += strlen(pname->obj_name) + 1;
+	}
+	if ((active_servers->svr == NULL) && connect_servers(active_servers, 1))
+		return -1;
+	sp = active_servers->svr;
+
+	if ((list = malloc(len)) == NULL)
+		return -1;
+	list[0] = '\0';
+	for (pname = names; pname != NULL; pname = pname->next) {
+		if (pname != names)
+			strcat(list, ",");
+		strcat(list, pname->obj_name);
+	}
+
+	perr = pbs_manager(sp->s_connect, oper, MGR_OBJ_NODE, list, attribs, NULL);
+	errmsg = pbs_geterrmsg(sp->s_connect);
+	if (perr == 0) {
+		if (errmsg != NULL)
+			report_mgr_message(errmsg);
+	} else if ((pbs_errno == PBSE_UNKNODE) ||
+		((oper == MGR_CMD_CREATE) && ((pbs_errno == PBSE_BADNDATVAL) ||
+		(pbs_errno == PBSE_NODEEXIST) || (pbs_errno == PBSE_NODENBIG)))) {
+		/* nothing was changed, a request per node reports which failed */
+		perr = -1;
+	} else
+		report_mgr_error(sp, list, oper, MGR_OBJ_NODE, errmsg);
+	free(list);
+	return perr;
+}
+
 /**
  * @brief
  * 	execute - contact the server and execute the command
@@ -2170,9 +2326,7 @@ execute(int aopt, int oper, int type, char *names, struct attropl *attribs)
 	int cerror;
 	int error;			/* Error value returned */
 	int perr;			/* Value returned from pbs_manager */
-	char *pmsg;
 	char *errmsg;			/* Error message from pbs_errmsg */
-	char errnomsg[256];		/* Error message with pbs_errno */
 	struct objname *name;		/* Pointer to a list of object names */
 	struct objname *pname = NULL;	/* Pointer to current object name */
 	struct objname *sname = NULL;	/* Pointer to current server name */
@@ -2222,6 +2376,17 @@ execute(int aopt, int oper, int type, char *names, struct attropl *attribs)
 	else
 		pname = name;
 
+	if ((type == MGR_OBJ_NODE) &&
+		((oper == MGR_CMD_CREATE) || (oper == MGR_CMD_SET) || (oper == MGR_CMD_UNSET))) {
+		error = execute_node_list(oper, pname, attribs);
+		if (error != -1) {
+			if (name != NULL)
+				free_objname_list(name);
+			return error;
+		}
+		error = 0;
+	}
+
 	for (; pname != NULL; pname = pname->next) {
 		if (pname->svr_name != NULL)
 			svrs = temp_objname(NULL, pname->svr_name, pname->svr);
@@ -2498,65 +2663,14 @@ execute(int aopt, int oper, int type, char *names, struct attropl *attribs)
 
 			errmsg = pbs_geterrmsg(sp->s_connect);
 			if (perr) {
-				/*
-				 ** IF
-				 **	stdin is a tty			OR
-				 **	the command is not SET		OR
-				 **	the object type is not NODE	OR
-				 **	the error is not "attempt to set READ ONLY attribute"
-				 ** THEN print error messages
-				 ** ELSE don't print error messages
-				 **
-				 ** This is to deal with bug 4941 where errors are generated
-				 ** from running qmgr with input from a file which was generated
-				 ** by 'qmgr -c "p n @default" > /tmp/nodes_out'.
-				 */
-				if (isatty(0) ||
-					(oper != MGR_CMD_SET) || (type != MGR_OBJ_NODE) ||
-					(pbs_errno != PBSE_ATTRRO)) {
-					if (errmsg != NULL) {
-						len = strlen(errmsg) + strlen(pname->obj_name) + strlen(Svrname(sp)) + 20;
-						if (len < 256) {
-							sprintf(errnomsg, "qmgr obj=%s svr=%s: %s\n",
-								pname->obj_name, Svrname(sp),  errmsg);
-							pstderr(errnomsg);
-						}
-						else {
-							/*obviously, this is to cover a highly unlikely case*/
-
-							pstderr_big(Svrname(sp), pname->obj_name, errmsg);
-						}
-					}
-
-					if (pbs_errno == PBSE_PROTOCOL) {
-						if ((check_time - start_time) >= QMGR_TIMEOUT) {
-							pstderr("qmgr: Server disconnected due to idle connection timeout\n");
-						} else {
-							pstderr("qmgr: Protocol error, server disconnected\n");
-						}
-						exit(1);
-					}
-					else if (pbs_errno == PBSE_HOOKERROR) {
-						pstderr("qmgr: hook error returned from server\n");
-					}
-					else
-						if (pbs_errno != 0)  /* 0 happens with hooks if no hooks found */
-							PSTDERR1("qmgr: Error (%d) returned from server\n", pbs_errno)
-				}
-
+				report_mgr_error(sp, pname->obj_name, oper, type, errmsg);
 				if (aopt)
 					return perr;
 				error = perr;
 			}
 			else if (errmsg != NULL) {
 				/* batch reply code is 0 but a text message is also being returned */
-
-				if ((pmsg = malloc(strlen(errmsg) + 2)) != NULL) {
-					strcpy(pmsg, errmsg);
-					strcat(pmsg, "\n");
-					pstderr(pmsg);
-					free(pmsg);
-				}
+				report_mgr_message(errmsg);
 			} else {
 
 				if (oper == MGR_CMD_EXPORT) {
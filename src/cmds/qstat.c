@@ -166,6 +166,7 @@ static char *delimiter = "\n";
 static char *prev_resc_name = NULL;
 static int  first_stat = 1;
 static int conn;
+static json_writer json_out;	/* the -F json document */
 
 static struct attrl *display_attribs = &basic_attribs[0];
 
@@ -368,6 +369,72 @@ convert_feed_chars(char *val) {
 	return buf;
 }
 
+/**
+ * @brief
+ *	end the json document on the way out, so that an exit part way
+ *	through the output still leaves valid json.
+ */
+static void
+end_json_output(void)
+{
+	close_json(&json_out);
+}
+
+/*
+ * Number of jobs asked for per status request when all the jobs of a queue
+ * or the server are written as json, so that each page of the reply can be
+ * written out and freed before the next one is read.
+ */
+#define JSON_JOB_PAGE	1000
+
+/**
+ * @brief
+ *	status one page of the jobs of a queue or the server
+ *
+ * @param[in] c - connection to the server
+ * @param[in] dest - queue name, or "" for all the jobs of the server
+ * @param[in] attribs - attributes to status
+ * @param[in] ext - extend flags of the status request
+ * @param[in] offset - number of jobs to skip
+ * @param[out] more - set if there may be jobs after this page
+ *
+ * @return struct batch_status *
+ * @retval status of the jobs of the page, as from pbs_statjob()
+ *
+ * @note
+ *	A server which does not page the reply gets one plain request for
+ *	all the jobs.  The pages are taken in queue order, so a job which ends
+ *	while the pages are read can make the job after it be skipped.
+ */
+static struct batch_status *
+statjob_page(int c, char *dest, struct attrl *attribs, char *ext, int offset, int *more)
+{
+	char pext[64];
+	struct batch_status *bs;
+	struct batch_status *p;
+	int n = 0;
+
+	*more = 0;
+	snprintf(pext, sizeof(pext), "%s%c%s=%d%c%s=%d", ext,
+		STATJOB_OPT_SEP, STATJOB_LIMIT, JSON_JOB_PAGE,
+		STATJOB_OPT_SEP, STATJOB_OFFSET, offset);
+	bs = pbs_statjob(c, dest, attribs, pext);
+	if (bs == NULL) {
+		if (pbs_errno == PBSE_IVALREQ && offset == 0)
+			return pbs_statjob(c, dest, attribs, ext);
+		return NULL;
+	}
+	for (p = bs; p != NULL; p = p->next)
+		n++;
+	if (n > JSON_JOB_PAGE) {
+		/* the server ignored the paging options */
+		pbs_statfree(bs);
+		return (offset == 0) ? pbs_statjob(c, dest, attribs, ext) : NULL;
+	}
+	*more = (n == JSON_JOB_PAGE);
+	return bs;
+}
+
 /**
  * @brief
  *	print the exit message and die.
@@ -404,7 +471,7 @@ prt_attr(char *name, char *resource, char *value, int one_line) {
 	switch (output_format) {
 	case FORMAT_JSON:
 		if (strcmp(name, ATTR_v) == 0) {
-			if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, name, NULL) == NULL)
+			if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, name, NULL) == NULL)
 				exit_qstat("out of memory");
 			buf = strdup(value);
 			temp = buf;
@@ -427,39 +494,39 @@ prt_attr(char *name, char *resource, char *value, int one_line) {
 					*buf++ = *value++;
 				}
 				*buf = '\0';
-				if (add_json_node(JSON_VALUE, JSON_NULL, JSON_ESCAPE, key, val) == NULL)
+				if (add_json_node(&json_out, JSON_VALUE, JSON_NULL, JSON_ESCAPE, key, val) == NULL)
 					exit_qstat("out of memory");
 				if (*value != '\0')
 					value++;
 			}
-			if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+			if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 				exit_qstat("out of memory");
 			free(temp);
 		} else {
 			if (resource) {
 				if (prev_resc_name && strcmp(prev_resc_name, name) != 0) {
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL)
 							== NULL)
 						exit_qstat("out of memory");
 					prev_resc_name = NULL;
 				}
 				if (prev_resc_name == NULL || strcmp(prev_resc_name, name) != 0) {
-					if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, name, NULL)
+					if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, name, NULL)
 							== NULL)
 						exit_qstat("out of memory");
 					prev_resc_name = name;
 				}
-				if (add_json_node(JSON_VALUE, JSON_NULL, JSON_ESCAPE, resource, value)
+				if (add_json_node(&json_out, JSON_VALUE, JSON_NULL, JSON_ESCAPE, resource, value)
 						== NULL)
 					exit_qstat("out of memory");
 			} else {
 				if (prev_resc_name) {
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL)
 							== NULL)
 						exit_qstat("out of memory");
 					prev_resc_name = NULL;
 				}
-				if (add_json_node(JSON_VALUE, JSON_NULL, JSON_ESCAPE, name, value) == NULL)
+				if (add_json_node(&json_out, JSON_VALUE, JSON_NULL, JSON_ESCAPE, name, value) == NULL)
 					exit_qstat("out of memory");
 			}
 		}
@@ -1374,7 +1441,7 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
-		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_FULLESCAPE, "Jobs", NULL) == NULL)
+		if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_FULLESCAPE, "Jobs", NULL) == NULL)
 			return 1;
 		first_stat = 0;
 	}
@@ -1396,7 +1463,7 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 			if (output_format == FORMAT_DSV || output_format == FORMAT_DEFAULT)
 				printf("Job Id: %s%s", p->name, delimiter);
 			else if (output_format == FORMAT_JSON)
-				if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, p->name, NULL) == NULL)
+				if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, p->name, NULL) == NULL)
 					return 1;
 			a = p->attribs;
 			while (a != NULL) {
@@ -1464,9 +1531,9 @@ display_statjob(struct batch_status *status, struct batch_status *prtheader, int
 				printf("%s", delimiter);
 			else if (output_format == FORMAT_JSON) {
 				if (prev_resc_name != NULL)
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 						return 1;
-				if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+				if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 					return 1;
 			}
 		} else {
@@ -1669,7 +1736,7 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 	}
 
 	if (output_format == FORMAT_JSON && first_stat) {
-		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_FULLESCAPE, "Queue", NULL) == NULL)
+		if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_FULLESCAPE, "Queue", NULL) == NULL)
 			return 1;
 		first_stat = 0;
 	}
@@ -1692,7 +1759,7 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 			if(output_format == FORMAT_DSV || output_format == FORMAT_DEFAULT)
 				printf("Queue: %s%s", p->name, delimiter);
 			else if (output_format == FORMAT_JSON) {
-				if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, p->name, NULL) == NULL)
+				if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, p->name, NULL) == NULL)
 					return 1;
 			}
 			a = p->attribs;
@@ -1711,9 +1778,9 @@ display_statque(struct batch_status *status, int prtheader, int full, int alt_op
 			else if (output_format == FORMAT_JSON) {
 				/* end the resource node, if it exists */
 				if (prev_resc_name != NULL)
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 						return 1;
-				if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+				if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 					return 1;
 			}
 		} else {
@@ -1825,7 +1892,7 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 	}
 
 	if(output_format == FORMAT_JSON && first_stat) {
-		if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, "Server", NULL) == NULL)
+		if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, "Server", NULL) == NULL)
 			return 1;
 		first_stat = 0;
 	}
@@ -1845,7 +1912,7 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 			if (output_format == FORMAT_DSV || output_format == FORMAT_DEFAULT)
 				printf("Server: %s%s", p->name, delimiter);
 			else if (output_format == FORMAT_JSON)
-				if (add_json_node(JSON_OBJECT, JSON_NULL, JSON_NOVALUE, p->name, NULL)
+				if (add_json_node(&json_out, JSON_OBJECT, JSON_NULL, JSON_NOVALUE, p->name, NULL)
 						== NULL)
 					return 1;
 			a = p->attribs;
@@ -1858,10 +1925,10 @@ display_statserver(struct batch_status *status, int prtheader, int full, int alt
 					printf("%s", delimiter);
 				else if (output_format == FORMAT_JSON) {
 					if (prev_resc_name != NULL)
-						if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL,
+						if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL,
 								NULL) == NULL)
 							return 1;
-					if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL)
+					if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL)
 							== NULL)
 						return 1;
 				}
@@ -2378,6 +2445,8 @@ main(int argc, char **argv, char **envp) /* qstat */
 	int f_opt, B_opt, Q_opt, how_opt, E_opt;
 	int p_header = TRUE;
 	int stat_single_job = 0;
+	int page_jobs = 0;	/* more pages of json job status to read */
+	int page_offset = 0;
 	int new_remote_server = 0;
 	enum { JOBS, QUEUES, SERVERS } mode;
 	struct batch_status *p_status;
@@ -2768,13 +2837,15 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 		delimiter = dsv_delim;
 	else if(output_format == FORMAT_JSON) {
 		delimiter = "";
+		json_writer_init(&json_out, stdout);
+		atexit(end_json_output);
 		/* adding prologue to json output. */
 		timenow = time(0);
-		if (add_json_node(JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "timestamp", &timenow) == NULL)
+		if (add_json_node(&json_out, JSON_VALUE, JSON_INT, JSON_FULLESCAPE, "timestamp", &timenow) == NULL)
 			exit_qstat("out of memory");
-		if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_version", PBS_VERSION) == NULL)
+		if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_version", PBS_VERSION) == NULL)
 			exit_qstat("out of memory");
-		if (add_json_node(JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_server", def_server) == NULL)
+		if (add_json_node(&json_out, JSON_VALUE, JSON_STRING, JSON_FULLESCAPE, "pbs_server", def_server) == NULL)
 			exit_qstat("out of memory");
 	}
 
@@ -2961,9 +3032,15 @@ job_no_args:
 					}
 				}
 
+				page_jobs = 0;
+				page_offset = 0;
 				if ((stat_single_job == 1) || (new_atropl == 0)) {
 					if (E_opt == 1)
 						p_status = pbs_statjob(conn, query_job_list, display_attribs, extend);
+					else if (stat_single_job == 0 && output_format == FORMAT_JSON &&
+						strchr(extend, (int)'t') == NULL &&
+						((alt_opt & ~ALT_DISPLAY_w) == 0 || (wide && f_opt)))
+						p_status = statjob_page(conn, job_id_out, display_attribs, extend, 0, &page_jobs);
 					else
 						p_status = pbs_statjob(conn, job_id_out, display_attribs, extend);
 				} else {
@@ -3051,6 +3128,21 @@ job_no_args:
 #endif /* localmod 071 */
 					p_header = FALSE;
 					pbs_statfree(p_status);
+					while (page_jobs) {
+						page_offset += JSON_JOB_PAGE;
+						p_status = statjob_page(conn, job_id_out, display_attribs, extend,
+							page_offset, &page_jobs);
+						if (p_status == NULL) {
+							if (pbs_errno != PBSE_NONE) {
+								prt_job_err("qstat", conn, job_id_out);
+								any_failed = pbs_errno;
+							}
+							break;
+						}
+						if (display_statjob(p_status, NULL, f_opt, how_opt, alt_opt, wide))
+							exit_qstat("out of memory");
+						pbs_statfree(p_status);
+					}
 				}
 				pbs_statfree(p_server);
 				p_server = NULL;
@@ -3203,10 +3295,9 @@ svr_no_args:
 			break;
 	}
 	if(output_format == FORMAT_JSON) {
-		if (add_json_node(JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
+		if (add_json_node(&json_out, JSON_OBJECT_END, JSON_NULL, JSON_NOVALUE, NULL, NULL) == NULL)
 			exit_qstat("out of memory");
-		generate_json(stdout);
-		free_json_node_list();
+		generate_json(&json_out);
 	}
 #ifdef NAS /* localmod 071 */
 	tcl_run(tcl_opt);
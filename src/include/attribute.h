@@ -206,6 +206,38 @@ struct attribute_def {
 };
 typedef struct attribute_def attribute_def;
 
+/*
+ * Perfect hash of the names in a built-in definition array, generated with
+ * the array by buildutils/attr_parser.py.  A name hashes (seed 0) to one of
+ * ph_nbucket buckets; the bucket's displacement seed then hashes it to a
+ * unique slot of ph_slot, which holds the index into ph_defs or -1.  A hit
+ * must still be confirmed against the definition's name.
+ */
+typedef struct attr_phash {
+	unsigned int ph_nbucket;	 /* number of buckets, power of 2 */
+	unsigned int ph_nslot;		 /* number of slots, power of 2, 0 if none */
+	const unsigned short *ph_disp;	 /* displacement seed per bucket */
+	const short *ph_slot;		 /* definition index per slot */
+	const void *ph_defs;		 /* the definition array hashed */
+} attr_phash_t;
+
+/*
+ * Sparse attribute storage for objects which define many attributes but
+ * typically set only a few of them (jobs, reservations).  Slots are handed
+ * out in chunks of ATTR_SPARSE_CHUNK the first time an attribute index is
+ * asked for and are never moved afterwards, so a pointer returned for an
+ * index stays valid until the container is freed.  as_map holds the slot
+ * number plus one for each attribute index, 0 if it has no slot yet.
+ */
+#define ATTR_SPARSE_CHUNK 8
+#define ATTR_SPARSE_MAX 255	/* slot numbers must fit as_map */
+
+typedef struct attr_sparse {
+	unsigned char *as_map;	/* slot + 1 per attribute index */
+	attribute **as_chunk;	/* chunks of ATTR_SPARSE_CHUNK slots */
+	int as_nslot;		/* slots handed out so far */
+} attr_sparse;
+
 /**
  * This structure is used by IFL verification mechanism to associate
  * specific verification routines to specific attributes. New attributes added
@@ -300,6 +332,7 @@ struct array_strings {
 	int	as_bufsize;	/* size of buffer holding strings */
 	char   *as_buf;		/* address of buffer */
 	char   *as_next;	/* first available byte in buffer */
+	void   *as_acl;		/* ACL index built by acl_check(), or NULL */
 	char   *as_string[1];	/* first string pointer */
 };
 
@@ -316,6 +349,8 @@ extern void clear_attr(attribute *pattr, attribute_def *pdef);
 extern int  find_attr  (void *attrdef_idx, attribute_def *attr_def, char *name);
 extern int  recov_attr_fs(int fd, void *parent, void *padef_idx, attribute_def *padef,
 	attribute *pattr, int limit, int unknown);
+extern int  recov_attr_journal_fs(int fd, void *parent, void *padef_idx, attribute_def *padef,
+	attribute *pattr, int limit, int unknown);
 extern void free_null  (attribute *attr);
 extern void free_none  (attribute *attr);
 extern svrattrl *attrlist_alloc(int szname, int szresc, int szval);
@@ -331,6 +366,9 @@ extern int  attr_atomic_node_set(svrattrl *plist, attribute *old,
 	int unkn, int privil, int *badattr);
 extern void attr_atomic_kill(attribute *temp, attribute_def *pdef, int);
 extern void attr_atomic_copy(attribute *old, attribute *nattr, attribute_def *pdef, int limit);
+extern int  attr_atomic_set_sparse(svrattrl *plist, attr_sparse *old, attribute *nattr, void *pdef_idx, attribute_def *pdef, int limit, int unkn, int privil, int *badattr);
+extern void attr_atomic_copy_from_sparse(attribute *to, attr_sparse *from, attribute_def *pdef, int limit);
+extern void attr_atomic_copy_to_sparse(attr_sparse *to, attribute *from, attribute_def *pdef, int limit);
 
 extern int copy_svrattrl_list(pbs_list_head *from_phead, pbs_list_head *to_head);
 extern int convert_attrl_to_svrattrl(struct attrl *from_list, pbs_list_head *to_head);
@@ -472,11 +510,13 @@ extern char *return_internal_value(char *name, char *val);
 /* other associated funtions */
 
 extern int   acl_check(attribute *, char *canidate, int type);
+extern void  (*pfn_free_acl_index)(struct array_strings *);
 extern int   check_duplicates(struct array_strings *strarr);
 
 extern char *arst_string(char *str, attribute *pattr);
 extern void  attrl_fixlink(pbs_list_head *svrattrl);
 extern int   save_attr_fs(attribute_def *, attribute *, int);
+extern int   save_attr_journal_fs(attribute_def *, attribute *, int, char *);
 
 extern int      encode_state(const attribute *, pbs_list_head *, char *,
 	char *, int, svrattrl **rtnl);
@@ -601,6 +641,9 @@ extern int encode_single_attr_db(attribute_def *padef, attribute *pattr, pbs_db_
 extern int encode_attr_db(attribute_def *padef, attribute *pattr, int numattr,  pbs_db_attr_list_t *db_attr_list, int all);
 extern int decode_attr_db(void *parent, pbs_list_head *attr_list,
 	void *padef_idx, attribute_def *padef, attribute *pattr, int limit, int unknown);
+extern int encode_attr_sparse_db(attribute_def *padef, attr_sparse *psparse, int numattr, pbs_db_attr_list_t *db_attr_list, int all);
+extern int decode_attr_sparse_db(void *parent, pbs_list_head *attr_list,
+	void *padef_idx, attribute_def *padef, attr_sparse *psparse, int limit, int unknown);
 
 extern int is_attr(int, char *, int);
 
@@ -608,7 +651,8 @@ extern int set_attr(struct attrl **attrib, const char *attrib_name, const char *
 extern int set_attr_resc(struct attrl **attrib, const char *attrib_name, const char *attrib_resc, const char *attrib_value);
 
 extern svrattrl *make_attr(char *attr_name, char *attr_resc, char *attr_value, int attr_flags);
-extern void *cr_attrdef_idx(attribute_def *adef, int limit);
+extern void *cr_attrdef_idx(attribute_def *adef, int limit, const attr_phash_t *phash);
+extern int attr_phash_index(const attr_phash_t *phash, const char *name);
 
 /* Attr setters */
 int set_attr_generic(attribute *pattr, attribute_def *pdef, char *value, char *rescn, enum batch_op op);
@@ -633,6 +677,11 @@ attribute *_get_attr_by_idx(attribute *list, int attr_idx);
 pbs_list_head get_attr_list(const attribute *pattr);
 void free_attr(attribute_def *attr_def, attribute *pattr, int attr_idx);
 
+/* Sparse attribute storage */
+attribute *attr_sparse_find(const attr_sparse *psparse, int attr_idx);
+attribute *attr_sparse_get(attr_sparse *psparse, attribute_def *padef, int attr_idx, int limit);
+void attr_sparse_free(attr_sparse *psparse, attribute_def *padef, int limit);
+
 /* "type" to pass to acl_check() */
 #define ACL_Host  1
 #define ACL_User  2
@@ -158,6 +158,10 @@ struct hook {
 	pbs_list_link	hi_execjob_postsuspend_hooks;
 	pbs_list_link	hi_execjob_preresume_hooks;
 	struct work_task *ptask;		    /* work task pointer, used in periodic hooks */
+	long	periodic_runs;		/* server periodic runs completed */
+	long	periodic_skipped;	/* occurrences skipped, previous run busy */
+	long	periodic_total_ms;	/* wall time of completed runs */
+	long	periodic_max_ms;	/* longest completed run */
 };
 
 typedef struct hook hook;
@@ -138,6 +138,8 @@ extern int recreate_request(struct batch_request *);
 
 /* Server periodic hook call-back */
 extern void run_periodic_hook (struct work_task *ptask);
+extern void periodic_hook_changed(void);
+extern void periodic_hook_objs_changed(void);
 
 extern int get_server_hook_results(char *input_file, int *accept_flag, int *reject_flag,
 	char *reject_msg, int reject_msg_size, job *pjob, hook *phook, hook_output_param_t *hook_output);
@@ -223,6 +223,7 @@ typedef struct resc_limit {		/* per node limits for Mom	*/
  */
 
 extern attribute_def job_attr_def[];
+extern const attr_phash_t job_attr_def_phash;
 extern void *job_attr_idx;
 
 #ifndef PBS_MOM
@@ -329,6 +330,11 @@ typedef struct	noderes {
 #define	MOM_SISTER_ERR		0x0004	/* a sisterhood operation failed */
 #define	MOM_NO_PROC		0x0008	/* no procs found for job */
 #define	MOM_RESTART_ACTIVE	0x0010	/* restart in progress */
+#define	MOM_JOB_SAVED		0x0020	/* full image of job is in its job file */
+#define	MOM_JOB_UNSYNCED	0x0040	/* job file written but not yet synced */
+
+/* journal records appended to a job file before it is rewritten in full */
+#define JOB_JOURNAL_MAXRECS	32
 
 
 #define PBS_MAX_POLL_DOWNTIME 300 /* 5 minutes by default */
@@ -481,6 +487,8 @@ struct job {
 	tm_node_id ji_nodekill;		   /* set to nodeid requesting job die */
 	int ji_flags;			   /* mom only flags */
 	void *ji_setup;			   /* save setup info */
+	int ji_journal_recs;		   /* journal records since last full save */
+	char ji_journal_set[JOB_ATR_LAST]; /* attribute set as of last save */
 
 #ifdef WIN32
 	HANDLE ji_hJob;				    /* handle for job */
@@ -497,6 +505,7 @@ struct job {
 	int ji_discarding;		   /* discarding job */
 	struct batch_request *ji_prunreq;  /* outstanding runjob request */
 	pbs_list_head ji_svrtask;	   /* links to svr work_task list */
+	pbs_list_link ji_histjobs;	   /* links to history jobs, oldest first */
 	struct pbs_queue *ji_qhdr;	   /* current queue header */
 	struct resc_resv *ji_myResv;	   /* !=0 job belongs to a reservation, see also, attribute JOB_ATR_myResv */
 
@@ -602,11 +611,17 @@ struct job {
 	} ji_extended;
 
 	/*
-	 * The following array holds the decode	 format of the attributes.
-	 * Its presence is for rapid acces to the attributes.
+	 * The following holds the decode format of the attributes.
+	 * Its presence is for rapid acces to the attributes.  The server
+	 * keeps many jobs with few attributes set, so it only stores the
+	 * ones touched, see get_jattr().
 	 */
 
+#ifdef PBS_MOM
 	attribute ji_wattr[JOB_ATR_LAST]; /* decoded attributes  */
+#else
+	attr_sparse ji_wattr; /* decoded attributes  */
+#endif
 
 	short newobj; /* newly created job? */
 };
@@ -1022,6 +1037,7 @@ extern char	 state_int2char(int);
 extern int   uniq_nameANDfile(char*, char*, char*);
 extern long  determine_accruetype(job *);
 extern int   update_eligible_time(long, job *);
+extern long  get_eligible_time(const job *);
 
 #define	TOLERATE_NODE_FAILURES_ALL	"all"
 #define	TOLERATE_NODE_FAILURES_JOB_START	"job_start"
@@ -1052,6 +1068,7 @@ void free_jattr(job *pjob, int attr_idx);
 void mark_jattr_not_set(job *pjob, int attr_idx);
 void mark_jattr_set(job *pjob, int attr_idx);
 attribute *get_jattr(const job *pjob, int attr_idx);
+attribute *find_jattr(const job *pjob, int attr_idx);
 
 /*
  *	The filesystem related recovery/save routines are renamed
@@ -1068,6 +1085,8 @@ attribute *get_jattr(const job *pjob, int attr_idx);
 
 extern job *job_recov_fs(char *);
 extern int job_save_fs(job *);
+extern void job_recov_prefetch_fs(char **, int);
+extern void job_save_fs_sync(void);
 
 #define job_save  job_save_fs
 #define job_recov job_recov_fs
@@ -124,6 +124,7 @@ typedef struct pbs_conn {
 	char *ch_errtxt;	  /* pointer to last server error text	*/
 	pthread_mutex_t ch_mutex; /* serialize connection between threads */
 	pbs_tcp_chan_t *ch_chan;  /* pointer tcp chan structure for this connection */
+	int ch_pending;		  /* requests sent whose reply is not read in full */
 } pbs_conn_t;
 
 int destroy_connection(int);
@@ -133,6 +134,8 @@ int set_conn_errno(int, int);
 int get_conn_errno(int);
 pbs_tcp_chan_t * get_conn_chan(int);
 int set_conn_chan(int, pbs_tcp_chan_t *);
+void adj_conn_pending(int, int);
+int get_conn_pending(int);
 pthread_mutex_t * get_conn_mutex(int);
 
 #define SVR_CONN_STATE_DOWN 0
@@ -355,6 +358,7 @@ int PBSD_py_spawn_put(int, char *, char **, char **, int, char **);
 int PBSD_sig_put(int, char *, char *, char *, int, char **);
 int PBSD_term_put(int, int, char *);
 int PBSD_jobfile(int, int, char *, char *, enum job_file, int, char **);
+int PBSD_scbuf(int, int, int, char *, int, char *, enum job_file, int, char **);
 int PBSD_status_put(int, int, char *, struct attrl *, char *, int, char **);
 int PBSD_select_put(int, int, struct attropl *, struct attrl *, char *);
 struct batch_reply *PBSD_rdrpy(int);
@@ -86,6 +86,9 @@ extern char	pbs_jobdir_root[];
 extern int	pbs_jobdir_root_shared;
 #define JOBDIR_DEFAULT	"PBS_USER_HOME"
 
+/* suffix of the "host:count" form of PBS_NODEFILE */
+#define NODEFILE_COMPACT_SUFFIX	".compact"
+
 /* test bits */
 #define PBSQA_DELJOB_SLEEP	1
 #define PBSQA_DELJOB_CRASH	2
@@ -256,6 +259,7 @@ extern pre_finish_results_t pre_finish_exec(job *pjob, int do_job_setup_send);
 extern void	finish_exec(job *pjob);
 extern void	exec_bail(job *pjob, int code, char *txt);
 extern int	generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz, char *err_msg, int err_msg_sz);
+extern int	generate_pbs_nodefile_compact(job *pjob, char *nodefile, int nodefile_sz, char *err_msg, int err_msg_sz);
 extern int	job_nodes_inner(struct job *pjob, hnodent **mynp);
 extern int	job_nodes(job *pjob);
 extern int	tm_reply(int stream, int version, int com, tm_event_t event);
@@ -382,6 +386,7 @@ extern int   setwinsize(int);
 extern void  set_termcc(int);
 extern int   conn_qsub(char *host, long port);
 extern int  state_to_server(int, int);
+extern int  vnl_report_pending(void);
 extern int   send_hook_vnl(void *vnl);
 extern int hook_requests_to_server(pbs_list_head *);
 extern int init_x11_display(struct pfwdsock *, int, char *, char *, char *);
@@ -118,6 +118,12 @@ typedef unsigned long pbs_net_t;        /* for holding host addresses */
 #define IS_HOOK_CHECKSUMS               20 /* mom reports about hooks seen */
 #define IS_UPDATE_FROM_HOOK2            21 /* request to update vnodes from a hook running on a parent mom host or an allowed non-parent mom host */
 #define IS_HELLOSVR                     22 /* hello send to server from mom to initiate a hello sequence */
+#define IS_UPDATE_DELTA                 23 /* like IS_UPDATE2, with only the vnode attributes changed since the last one */
+
+/*	Values of the need inventory flag in IS_REPLYHELLO */
+#define IS_NEED_INV_NONE                0 /* server has the vnodes of the mom */
+#define IS_NEED_INV                     1 /* mom must send IS_UPDATE2 */
+#define IS_NEED_INV_DELTA               2 /* as IS_NEED_INV, server also takes IS_UPDATE_DELTA */
 
 /*	Types of Peer Server messages (between Server and Server). */
 #define PS_CONNECT		1 /* hello from peer server  */
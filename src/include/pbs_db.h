@@ -231,6 +231,9 @@ struct pbs_db_query_options {
 };
 typedef struct pbs_db_query_options pbs_db_query_options_t;
 
+/* query option flags */
+#define FIND_JOBS_BY_QUE 1	/* jobs of the queue in ji_queue only */
+
 
 #define PBS_DB_SVR		0
 #define PBS_DB_SCHED		1
@@ -294,6 +297,10 @@ typedef void (*query_cb_t)(pbs_db_obj_info_t *, int *);
 #define PBS_DB_CNT_TIMEOUT_INFINITE	0
 
 
+/* Datastore backends, see PBS_DATA_SERVICE_BACKEND */
+#define PBS_DB_BACKEND_PGSQL	"pgsql"
+#define PBS_DB_BACKEND_EMBEDDED	"embedded"
+
 /* Database start stop control commands */
 #define PBS_DB_CONTROL_STATUS	"status"
 #define PBS_DB_CONTROL_START	"start"
@@ -319,6 +326,52 @@ typedef void (*query_cb_t)(pbs_db_obj_info_t *, int *);
  */
 int pbs_db_connect(void **conn, char *host, int port, int timeout);
 
+/**
+ * @brief
+ *	Same as pbs_db_connect, but to a named datastore backend rather than
+ *	the one configured with PBS_DATA_SERVICE_BACKEND
+ *
+ * @param[out]  conn		- Initialized connecetion handler
+ * @param[in]   backend		- PBS_DB_BACKEND_PGSQL or PBS_DB_BACKEND_EMBEDDED
+ * @param[in]   host		- The name of the host on which database resides
+ * @param[in]	port		- The port number where database is running
+ * @param[in]   timeout		- The timeout value in seconds to attempt the connection
+ *
+ * @return      int
+ * @retval      !0  - Failure
+ * @retval      0 - Success
+ *
+ */
+int pbs_db_connect_backend(void **conn, char *backend, char *host, int port, int timeout);
+
+/**
+ * @brief
+ *	Same as pbs_db_connect, but only to read the datastore. The embedded
+ *	backend then takes no lock, so this works while the server is
+ *	running; a writable connection fails in that case.
+ *
+ * @param[out]  conn		- Initialized connecetion handler
+ * @param[in]   host		- The name of the host on which database resides
+ * @param[in]	port		- The port number where database is running
+ * @param[in]   timeout		- The timeout value in seconds to attempt the connection
+ *
+ * @return      int
+ * @retval      !0  - Failure
+ * @retval      0 - Success
+ *
+ */
+int pbs_db_connect_readonly(void **conn, char *host, int port, int timeout);
+
+/**
+ * @brief
+ *	Name of the datastore backend configured with PBS_DATA_SERVICE_BACKEND
+ *
+ * @return      char * - PBS_DB_BACKEND_PGSQL or PBS_DB_BACKEND_EMBEDDED
+ * @retval      NULL - PBS_DATA_SERVICE_BACKEND names no known backend
+ *
+ */
+char *pbs_db_backend_name(void);
+
 /**
  * @brief
  *	Disconnect from the database and frees all allocated memory.
@@ -332,6 +385,17 @@ int pbs_db_connect(void **conn, char *host, int port, int timeout);
  */
 int pbs_db_disconnect(void *conn);
 
+/**
+ * @brief
+ *	Close the descriptors a forked child inherited with conn (the
+ *	embedded datastore lock and log, the database socket), leaving the
+ *	connection itself to the parent. The child must not use conn again.
+ *
+ * @param[in]   conn - Connected database handle inherited from the parent
+ *
+ */
+void pbs_db_close_fds(void *conn);
+
 /**
  * @brief
  *	Insert a new object into the database
@@ -348,6 +412,45 @@ int pbs_db_disconnect(void *conn);
  */
 int pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype);
 
+/**
+ * @brief
+ *	Queue subsequent saves and deletes on the connection instead of waiting
+ *	for each one; they are flushed by pbs_db_end_pipeline
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ */
+void pbs_db_begin_pipeline(void *conn);
+
+/**
+ * @brief
+ *	Flush the saves and deletes queued since pbs_db_begin_pipeline and
+ *	wait for their results
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval      -1  - Failure of one of the queued statements
+ * @retval       0  - success
+ *
+ */
+int pbs_db_end_pipeline(void *conn);
+
+/**
+ * @brief
+ *	Check whether saves on the connection are being queued, so that a
+ *	save which returns 0 is not known to be stored until
+ *	pbs_db_end_pipeline succeeds
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval       1  - between pbs_db_begin_pipeline and pbs_db_end_pipeline
+ * @retval       0  - otherwise
+ *
+ */
+int pbs_db_in_pipeline(void *conn);
+
 /**
  * @brief
  *	Delete an existing object from the database
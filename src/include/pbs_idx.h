@@ -138,6 +138,8 @@ extern int pbs_idx_delete_byctx(void *ctx);
  *
  * @note
  * 	ctx should be free'd after use, using pbs_idx_free_ctx()
+ *	The index may be changed while iterating, the next call continues
+ *	after the last entry returned.
  *
  */
 extern int pbs_idx_find(void *idx, void **key, void **data, void **ctx);
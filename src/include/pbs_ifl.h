@@ -249,6 +249,7 @@ extern "C" {
 #define ATTR_rsvsync    "reserved_sync"
 #define ATTR_start	"started"
 #define ATTR_count	"state_count"
+#define ATTR_user_count	"user_state_count"
 #define ATTR_number	"number_jobs"
 #define ATTR_jobscript_max_size "jobscript_max_size"
 #ifdef NAS
@@ -505,6 +506,17 @@ enum batch_op {	SET, UNSET, INCR, DECR,
 #define SUPPRESS_EMAIL  		"suppress_email"
 #define DELETEHISTORY			"deletehist"
 
+/*
+ * options that may be passed by pbs_statjob() api to the server via its extend
+ * parameter, each as ":<option>=<value>" after any extend characters,
+ * e.g. "x:sort=-qtime,Job_Name:limit=20:offset=40"
+ */
+
+#define STATJOB_OPT_SEP			':'
+#define STATJOB_SORT			"sort"
+#define STATJOB_LIMIT			"limit"
+#define STATJOB_OFFSET			"offset"
+
 /*
  ** This structure is identical to attropl so they can be used
  ** interchangably.  The op field is not used.
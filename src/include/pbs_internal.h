@@ -237,6 +237,7 @@ struct pbs_config
 	char *pbs_mom_home;			/* path to alternate home for Mom */
 	char *pbs_core_limit;			/* RLIMIT_CORE setting */
 	char *pbs_data_service_host;		/* dataservice host */
+	char *pbs_data_service_backend;		/* dataservice backend: pgsql or embedded */
 	char *pbs_tmpdir;			/* temporary file directory */
 	char *pbs_server_host_name;	/* name of host on which Server is running */
 	char *pbs_public_host_name;	/* name of the local host for outgoing connections */
@@ -285,6 +286,7 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_MANAGER_SERVICE_PORT	     "PBS_MANAGER_SERVICE_PORT"
 #define PBS_CONF_DATA_SERVICE_PORT           "PBS_DATA_SERVICE_PORT"
 #define PBS_CONF_DATA_SERVICE_HOST           "PBS_DATA_SERVICE_HOST"
+#define PBS_CONF_DATA_SERVICE_BACKEND        "PBS_DATA_SERVICE_BACKEND"
 #define PBS_CONF_USE_COMPRESSION     	     "PBS_USE_COMPRESSION"
 #define PBS_CONF_USE_MCAST		     "PBS_USE_MCAST"
 #define PBS_CONF_LEAF_NAME		     "PBS_LEAF_NAME"
@@ -322,6 +324,7 @@ extern struct pbs_config pbs_conf;
 #define PBS_CONF_LOG_HIGHRES_TIMESTAMP	"PBS_LOG_HIGHRES_TIMESTAMP"
 #define PBS_CONF_SCHED_THREADS	"PBS_SCHED_THREADS"
 #define PBS_CONF_DAEMON_SERVICE_USER "PBS_DAEMON_SERVICE_USER"
+#define PBS_CONF_CLIENT_DAEMON	"PBS_CLIENT_DAEMON" /* environment only, non-zero for the commands to use a client daemon */
 #ifdef WIN32
 #define PBS_CONF_REMOTE_VIEWER "PBS_REMOTE_VIEWER"	/* Executable for remote viewer application alongwith its launch options, for PBS GUI jobs */
 #endif
@@ -474,11 +477,14 @@ DECLDIR int      cnt2server(char *);
 DECLDIR int      cnt2server_extend(char *, char *);
 DECLDIR int      get_server(char *, char *, char *);
 DECLDIR int      PBSD_ucred(int, char *, int, char *, int);
+DECLDIR void     pbs_client_daemon_enable(void);
 
 #else
 
 extern int pbs_connect_noblk(char *, int);
 
+extern void pbs_client_daemon_enable(void);
+
 extern int pbs_connection_set_nodelay(int);
 
 extern int pbs_geterrno(void);
@@ -82,10 +82,34 @@ struct JsonNode {
 	} value;
 };
 
-JsonNode *add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type, char *key, void *value);
+#define JSON_NESTING_LEVEL 500 /* deepest nesting of JSON arrays */
+
+/*
+ * State of one JSON document being written.  add_json_node() writes each
+ * node to the writer's stream as it is added, so the node it returns is only
+ * good for a NULL check.  generate_json() ends the document, closing any
+ * object or array still open so that the output is valid JSON even when the
+ * caller gives up part way through.
+ */
+typedef struct json_writer {
+	FILE *jw_stream;
+	int jw_state;			/* JSON_WRITER_* */
+	int jw_indent;
+	int jw_prnt_comma;
+	int jw_arr_lvl[JSON_NESTING_LEVEL];
+	int jw_curnt_arr_lvl;
+	JsonNode jw_node;		/* the node being written */
+} json_writer;
+
+#define JSON_WRITER_NEW		0	/* nothing written yet */
+#define JSON_WRITER_OPEN	1	/* document started */
+#define JSON_WRITER_DONE	2	/* document ended */
+
+void json_writer_init(json_writer *jw, FILE *stream);
+JsonNode *add_json_node(json_writer *jw, JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type, char *key, void *value);
 char *strdup_escape(JsonEscapeType esc_type, const char *str);
-int generate_json(FILE *stream);
-void free_json_node_list();
+int generate_json(json_writer *jw);
+void close_json(json_writer *jw);
 
 #ifdef	__cplusplus
 }
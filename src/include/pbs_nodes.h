@@ -81,6 +81,8 @@ struct daemon_info {
 	int		dmn_stream;   /* TPP stream to service */
 	unsigned long	*dmn_addrs;   /* IP addresses of host */
 	pbs_list_head	dmn_deferred_cmds;	/* links to svr work_task list for TPP replies */
+	pbs_list_head	dmn_jsend_active;	/* task streaming a job's files on dmn_stream */
+	pbs_list_head	dmn_jsend_wait;		/* job sends waiting for that stream to free up */
 };
 typedef struct daemon_info dmn_info_t;
 
@@ -344,6 +346,7 @@ INUSE_RESVEXCL|INUSE_UNRESOLVABLE|INUSE_MAINTENANCE|INUSE_SLEEP)
 #define NODE_UNLICENSED 0x02 /* To record if the node is added to the list of unlicensed node */
 #define NODE_NEWOBJ     0x04	/* new node ? */
 #define NODE_ACCTED     0x08	/* resc recorded in job acct */
+#define NODE_SAVEQUEUED 0x10	/* save queued in a datastore pipeline */
 
 /* operators to set the state of a vnode. Nd_State_Set is "=",
  * Nd_State_Or is "|=" and Nd_State_And is "&=". This is used in set_vnode_state
@@ -379,6 +382,7 @@ struct tree {
 
 extern void *node_attr_idx;
 extern attribute_def node_attr_def[]; /* node attributes defs */
+extern const attr_phash_t node_attr_def_phash;
 extern struct pbsnode **pbsndlist;           /* array of ptr to nodes  */
 extern int svr_totnodes;                     /* number of nodes (hosts) */
 extern struct tree *ipaddrs;
@@ -467,6 +471,7 @@ extern void mcast_moms();
 
 #ifndef PBS_MOM
 extern int node_save_db(struct pbsnode *pnode);
+extern void node_save_db_done(int ok);
 struct pbsnode *node_recov_db(char *nd_name, struct pbsnode *pnode);
 extern int add_mom_to_pool(mominfo_t *);
 extern void reset_pool_inventory_mom(mominfo_t *);
@@ -81,6 +81,7 @@ enum sched_atr {
 
 extern void *sched_attr_idx;
 extern attribute_def sched_attr_def[];
+extern const attr_phash_t sched_attr_def_phash;
 
 typedef struct pbs_sched {
 	pbs_list_link sc_link;					      /* link to all scheds known to server */
@@ -88,6 +88,7 @@ struct python_interpreter_data  svr_interp_data;
 int svr_delay_entry = 0;
 pbs_list_head svr_queues;  /* list of queues */
 pbs_list_head svr_alljobs;  /* list of all jobs in server */
+pbs_list_head svr_histjobs;  /* history jobs in purge order */
 pbs_list_head svr_allresvs;  /* all reservations in server */
 pbs_list_head svr_queues;
 pbs_list_head svr_alljobs;
@@ -106,6 +106,7 @@ typedef struct dynlist {
  */
 typedef struct vnode_list {
 	time_t	vnl_modtime;		/* last mod time for these data */
+	unsigned long vnl_changes;	/* serial of the last change, see vnl_changed() */
 	void *vnl_ix;			/* index with vnode name as key */
 	dl_t	vnl_dl;			/* current state of vnal_t list */
 #define	vnl_nelem	vnl_dl.dl_nelem
@@ -190,6 +191,16 @@ typedef		int (callfunc_t)(char *, char *, char *);
  */
 extern int	vn_addvnr(vnl_t *, char *, char *, char *, int, int, callfunc_t);
 
+/**
+ * @brief	note that a vnode list was changed
+ *
+ * @par Side-effects
+ *	Gives the list a change serial that no earlier change of any list
+ *	in this process had, so two lists or two states of one list can be
+ *	told apart without the 1-second resolution of vnl_modtime.
+ */
+extern void	vnl_changed(vnl_t *);
+
 /**
  * @return
  *	an attribute in a vnal_t
@@ -251,6 +262,19 @@ extern vnl_t	*vn_merge(vnl_t *, vnl_t *, callfunc_t);
  */
 extern vnl_t	*vn_merge2(vnl_t *, vnl_t *, char **, callfunc_t);
 
+/**
+ * @brief	compute the attributes added or changed between two vnode lists
+ *
+ * @return
+ *	a pointer to a vnode list holding the changes
+ *
+ * @retval	NULL	a vnode or attribute was removed or added, or error
+ *
+ * @par Side-effects
+ *	Space allocated for vnode list should be freed with vnl_free().
+ */
+extern vnl_t	*vn_delta(vnl_t *, vnl_t *);
+
 /**
  * @brief	parse a file containing vnode information into a vnode list
  *
@@ -66,6 +66,7 @@ enum queueattr {
 
 extern void *que_attr_idx;
 extern attribute_def que_attr_def[];
+extern const attr_phash_t que_attr_def_phash;
 
 /* at last we come to the queue definition itself	*/
 
@@ -86,6 +87,13 @@ struct pbs_queue {
 	int qu_numjobs;			 /* current numb jobs in queue */
 	int qu_njstate[PBS_NUMJOBSTATE]; /* # of jobs per state */
 
+	/* routing queues are only walked by queue_route() when one is set */
+	int qu_route_pending;		 /* an event may have unblocked a job */
+	int qu_route_force;		 /* retry jobs before their retry time */
+	time_t qu_route_next;		 /* earliest job retry/expiry, 0 if none */
+
+	struct que_rules *qu_rules;	 /* compiled admission limits, see svr_jobfunc.c */
+
 	/* the queue attributes */
 
 	attribute qu_attr[QA_ATR_LAST];
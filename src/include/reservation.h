@@ -103,6 +103,7 @@ enum resvState_discrim {
 
 extern void *resv_attr_idx;
 extern attribute_def resv_attr_def[];
+extern const attr_phash_t resv_attr_def_phash;
 extern int	     index_atrJob_to_atrResv [][2];
 
 /* linked list of vnodes associated to the soonest reservation */
@@ -227,10 +228,10 @@ struct resc_resv {
 	} ri_qs;
 
 	/*
-	 * The following array holds the decode	 format of the attributes.
-	 * Its presence is for rapid access to the attributes.
+	 * The following holds the decode format of the attributes, only
+	 * those touched are stored, see get_rattr().
 	 */
-	attribute		ri_wattr[RESV_ATR_LAST];  /*reservation's attributes*/
+	attr_sparse		ri_wattr;  /*reservation's attributes*/
 	short			newobj;
 };
 
@@ -313,6 +314,7 @@ extern void pbsd_init_resv(resc_resv *presv, int type);
 
 
 attribute *get_rattr(const resc_resv *presv, int attr_idx);
+attribute *find_rattr(const resc_resv *presv, int attr_idx);
 char *get_rattr_str(const resc_resv *presv, int attr_idx);
 struct array_strings *get_rattr_arst(const resc_resv *presv, int attr_idx);
 pbs_list_head get_rattr_list(const resc_resv *presv, int attr_idx);
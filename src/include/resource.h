@@ -107,6 +107,7 @@ typedef struct resource_def {
 	unsigned int rs_entlimflg;	  /* tracking entity limits for this  */
 	struct resource_def *rs_next;
 	unsigned int rs_custom; /* bit flag to indicate custom resource or builtin */
+	int rs_id;		/* dense id of the definition, see cr_rescdef_idx() */
 } resource_def;
 
 struct resc_sum {
@@ -126,8 +127,10 @@ typedef struct svr_entlim_leaf {
 extern struct resc_sum *svr_resc_sum;
 extern void *resc_attrdef_idx;
 extern resource_def *svr_resc_def; /* the resource definition array */
+extern const attr_phash_t svr_resc_defm_phash; /* perfect hash of the built-in resources */
 extern int svr_resc_size;	   /* size (num elements) in above  */
 extern int svr_resc_unk;	   /* index to "unknown" resource   */
+extern int svr_resc_next_id;	   /* next free resource_def id     */
 
 extern resource *add_resource_entry(attribute *, resource_def *);
 extern int cr_rescdef_idx(resource_def *resc_def, int limit);
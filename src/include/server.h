@@ -79,6 +79,7 @@ extern char server_host[];
 extern uint pbs_server_port_dis;
 extern void *svr_attr_idx;
 extern attribute_def svr_attr_def[];
+extern const attr_phash_t svr_attr_def_phash;
 /* for trillion job id */
 extern long long svr_max_job_sequence_id;
 
@@ -86,6 +87,15 @@ extern long long svr_max_job_sequence_id;
 extern long svr_history_enable;
 extern long svr_history_duration;
 
+/*
+ * job state counts of a single user, kept in users_jobstates_idx keyed
+ * by the user part of the job owner
+ */
+struct user_jobstates {
+	char uj_user[PBS_MAXUSER + 1];
+	int uj_njstate[PBS_NUMJOBSTATE]; /* # of the user's jobs per state */
+};
+
 struct server {
 	struct server_qs {
 		int sv_numjobs;		  /* number of job owned by server   */
@@ -113,6 +123,7 @@ struct server {
 
 extern struct server	server;
 extern	pbs_list_head	svr_alljobs;
+extern	pbs_list_head	svr_histjobs;	/* history jobs in purge order */
 extern	pbs_list_head	svr_allresvs;	/* all reservations in server */
 
 /* degraded reservations globals */
@@ -166,7 +177,7 @@ enum failover_state {
  * Server job history defines & globals
  */
 #define SVR_CLEAN_JOBHIST_TM		120	/* after 2 minutes, reschedule the work task */
-#define SVR_CLEAN_JOBHIST_SECS	5	/* never spend more than 5 seconds in one sweep to clean hist */
+#define SVR_CLEAN_JOBHIST_SLICE	1000	/* history jobs purged before yielding to other work */
 #define SVR_JOBHIST_DEFAULT		1209600	/* default time period to keep job history: 2 weeks */
 #define SVR_MAX_JOB_SEQ_NUM_DEFAULT	9999999	/* default max job id is 9999999 */
 
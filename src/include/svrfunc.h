@@ -76,6 +76,7 @@ extern void process_request(int);
 extern void process_dis_request(int);
 extern int save_flush(void);
 extern void save_setup(int);
+extern void que_rules_changed(void);
 extern int save_struct(char *, unsigned int);
 extern int schedule_jobs(pbs_sched *);
 extern int schedule_high(pbs_sched *);
@@ -144,6 +145,7 @@ extern int find_prov_vnode_list(job *, exec_vnode_listtype *, char **);
 #endif /* _PROVISION_H */
 
 extern void *jobs_idx;
+extern void *users_jobstates_idx;
 
 #ifdef _RESERVATION_H
 extern int set_nodes(void *, int, char *, char **, char **, char **, int, int);
@@ -177,6 +179,7 @@ extern void remove_stagein(job *);
 extern size_t check_for_cred(job *, char **);
 extern void svr_mailowner(job *, int, int, char *);
 extern void svr_mailowner_id(char *, job *, int, int, char *);
+extern void svr_mail_shutdown(void);
 extern char *lastname(char *);
 extern void chk_array_doneness(job *);
 extern job *create_subjob(job *, char *, int *);
@@ -188,6 +191,7 @@ extern char *subst_array_index(job *, char *);
 #ifndef PBS_MOM
 extern void svr_setjob_histinfo(job *, histjob_type);
 extern void svr_histjob_update(job *, char, int);
+extern void svr_user_jobstate(job *, int, int);
 extern char *form_attr_comment(const char *, const char *);
 extern void complete_running(job *);
 extern void am_jobs_add(job *);
@@ -216,6 +220,7 @@ extern int send_job_exec_update_to_mom(job *, char *, int, struct batch_request
 extern int free_sister_vnodes(job *, char *, char *, char *, int, struct batch_request *);
 #ifdef _WORK_TASK_H
 extern int send_job(job *, pbs_net_t, int, int, void (*)(struct work_task *), struct batch_request *);
+extern void jsend_cancel(job *);
 extern int relay_to_mom(job *, struct batch_request *, void (*)(struct work_task *));
 extern int relay_to_mom2(job *, struct batch_request *, void (*)(struct work_task *), struct work_task **);
 extern int recreate_exec_vnode(job *, char *, char *, char *, int);
@@ -290,14 +295,17 @@ extern int   removefiles_action(attribute *pattr, void *pobject, int actmode);
 /* Functions below exposed as they are now accessed by the Python hooks */
 extern void update_state_ct(attribute *, int *, attribute_def *attr_def);
 extern void update_license_ct();
+extern void update_user_state_ct(attribute *, attribute_def *, char *);
 
 #ifdef _PBS_JOB_H
 extern int job_set_wait(attribute *, void *, int);
 #endif /* _PBS_JOB_H */
 #ifdef _QUEUE_H
 extern int chk_resc_limits(attribute *, pbs_queue *);
+extern void free_que_rules(pbs_queue *);
 extern int set_resc_deflt(void *, int, pbs_queue *);
 extern void queue_route(pbs_queue *);
+extern void queue_route_changed(pbs_queue *);
 extern int que_purge(pbs_queue *);
 #endif /* _QUEUE_H */
 #endif /* _ATTRIBUTE_H */
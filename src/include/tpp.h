@@ -128,6 +128,7 @@ extern void DIS_tpp_funcs();
 extern int tpp_open(char *, unsigned int);
 extern int tpp_close(int);
 extern int tpp_eom(int);
+extern int tpp_send_backlog(void);
 extern int tpp_bind(unsigned int);
 extern int tpp_poll(void);
 extern void tpp_terminate(void);
@@ -59,7 +59,11 @@
  *
  * @par	Included is:
  *	attr_atomic_set()
+ *	attr_atomic_set_sparse()
  *	attr_atomic_kill()
+ *	attr_atomic_copy()
+ *	attr_atomic_copy_from_sparse()
+ *	attr_atomic_copy_to_sparse()
  *
  * 	The prototypes are declared in "attr_func.h"
  */
@@ -68,6 +72,31 @@
 
 extern int resc_access_perm;	/* see lib/Libattr/attr_fn_resc.c */
 
+/**
+ * @brief
+ *	Return attribute 'idx' of an attribute array, or of a sparse
+ *	container when the array is NULL.
+ *
+ * @param[in] arr - the attribute array, or NULL
+ * @param[in] psparse - the sparse container used if arr is NULL
+ * @param[in] pdef - the attribute definition array
+ * @param[in] idx - index of the attribute
+ * @param[in] limit - number of entries in pdef
+ * @param[in] alloc - hand out a slot if the container has none for idx
+ *
+ * @return	attribute *
+ * @retval	NULL	- the container holds no slot (or no memory for one)
+ */
+static attribute *
+atomic_attr(attribute *arr, attr_sparse *psparse, attribute_def *pdef, int idx, int limit, int alloc)
+{
+	if (arr != NULL)
+		return arr + idx;
+	if (alloc)
+		return attr_sparse_get(psparse, pdef, idx, limit);
+	return attr_sparse_find(psparse, idx);
+}
+
 /**
  * @brief
  *	atomically set a attribute array with values from a svrattrl
@@ -89,8 +118,8 @@ extern int resc_access_perm;	/* see lib/Libattr/attr_fn_resc.c */
  *
  */
 
-int
-attr_atomic_set(struct svrattrl *plist, attribute *old, attribute *new, void *pdef_idx, attribute_def *pdef, int limit, int unkn, int privil, int *badattr)
+static int
+atomic_set(struct svrattrl *plist, attribute *old, attr_sparse *psold, attribute *new, void *pdef_idx, attribute_def *pdef, int limit, int unkn, int privil, int *badattr)
 {
 	int	    acc;
 	int	    index;
@@ -98,6 +127,7 @@ attr_atomic_set(struct svrattrl *plist, attribute *old, attribute *new, void *pd
 	resource   *prc;
 	int	    rc;
 	attribute   temp;
+	attribute  *pold;
 	int	    privil2;
 
 	for (index=0; index<limit; index++)
@@ -156,9 +186,10 @@ attr_atomic_set(struct svrattrl *plist, attribute *old, attribute *new, void *pd
 
 		/* duplicate current value, if set AND not already dup-ed */
 
-		if (((old + index)->at_flags & ATR_VFLAG_SET) &&
+		pold = atomic_attr(old, psold, pdef, index, limit, 0);
+		if (is_attr_set(pold) &&
 			!((new + index)->at_flags & ATR_VFLAG_SET)) {
-			if ((rc = (pdef + index)->at_set(new + index, old + index, SET)) != 0)
+			if ((rc = (pdef + index)->at_set(new + index, pold, SET)) != 0)
 				break;
 			/*
 			 * we need to know if the value is changed during
@@ -204,6 +235,57 @@ attr_atomic_set(struct svrattrl *plist, attribute *old, attribute *new, void *pd
 	return rc;
 }
 
+/**
+ * @brief
+ *	atomically set a attribute array with values from a svrattrl
+ *
+ * @param[in] plist - Pointer to list of attributes to set
+ * @param[in] old - Pointer to the original/old attribute
+ * @param[in] new - Pointer to the new/updated attribute
+ * @param[in] pdef_idx - Search index for the attribute def array
+ * @param[in] pdef - Pointer to the attribute definition
+ * @param[in] limit - The index up to which to search for a definition
+ * @param[in] unkn - Whether to allow unknown resources or not
+ * @param[in] privil - Permissions of the caller requesting the operation
+ * @param[out] badattr - Pointer to the attribute index in case of a failed
+ * 			operation
+ *
+ * @return 	int
+ * @retval 	PBSE_NONE 	on success
+ * @retval 	PBS error code 	otherwise
+ */
+int
+attr_atomic_set(struct svrattrl *plist, attribute *old, attribute *new, void *pdef_idx, attribute_def *pdef, int limit, int unkn, int privil, int *badattr)
+{
+	return atomic_set(plist, old, NULL, new, pdef_idx, pdef, limit, unkn, privil, badattr);
+}
+
+/**
+ * @brief
+ *	attr_atomic_set() for an object keeping its original attributes in
+ *	a sparse container; the new values still go to a full array.
+ *
+ * @param[in] plist - Pointer to list of attributes to set
+ * @param[in] old - the object's sparse attribute storage
+ * @param[in] nattr - Pointer to the new/updated attribute
+ * @param[in] pdef_idx - Search index for the attribute def array
+ * @param[in] pdef - Pointer to the attribute definition
+ * @param[in] limit - The index up to which to search for a definition
+ * @param[in] unkn - Whether to allow unknown resources or not
+ * @param[in] privil - Permissions of the caller requesting the operation
+ * @param[out] badattr - Pointer to the attribute index in case of a failed
+ * 			operation
+ *
+ * @return 	int
+ * @retval 	PBSE_NONE 	on success
+ * @retval 	PBS error code 	otherwise
+ */
+int
+attr_atomic_set_sparse(struct svrattrl *plist, attr_sparse *old, attribute *nattr, void *pdef_idx, attribute_def *pdef, int limit, int unkn, int privil, int *badattr)
+{
+	return atomic_set(plist, NULL, old, nattr, pdef_idx, pdef, limit, unkn, privil, badattr);
+}
+
 
 /**
  * @brief
@@ -231,6 +313,46 @@ attr_atomic_kill(attribute *temp, attribute_def *pdef, int limit)
 	free(temp);
 }
 
+/**
+ * @brief
+ * 	atomic_copy - copy the attributes of 'from' to 'to', each either an
+ *	attribute array or, when the array is NULL, a sparse container.
+ *	See attr_atomic_copy().
+ *
+ * 	@param[out] to - attribute array copied into, or NULL
+ * 	@param[out] psto - sparse storage copied into if 'to' is NULL
+ * 	@param[in] from - attribute array copied from, or NULL
+ * 	@param[in] psfrom - sparse storage copied from if 'from' is NULL
+ * 	@param[in] pdef - pointer to attribute_def structure
+ * 	@param[in] limit - Last attribute in the list
+ */
+
+static void
+atomic_copy(attribute *to, attr_sparse *psto, attribute *from, attr_sparse *psfrom, attribute_def *pdef, int limit)
+{
+	int i;
+	attribute *pto;
+	attribute *pfrom;
+
+	for (i = 0; i < limit; i++) {
+		pfrom = atomic_attr(from, psfrom, pdef, i, limit, 0);
+		/* an attribute without a sparse slot needs one only to be set */
+		pto = atomic_attr(to, psto, pdef, i, limit, is_attr_set(pfrom));
+		if (pto == NULL)
+			continue;
+
+		if ((pto->at_flags & ATR_VFLAG_SET) && (pdef + i)->at_set != set_null)
+			(pdef + i)->at_free(pto);
+
+		if ((pdef + i)->at_set != set_null)
+			clear_attr(pto, pdef + i);
+		if (is_attr_set(pfrom)) {
+			(pdef + i)->at_set(pto, pfrom, SET);
+			pto->at_flags = pfrom->at_flags;
+		}
+	}
+}
+
 /**
  * @brief
  * 	attr_atomic_copy - make a copy of the attributes in attribute array 'from' to the attribute array 'to'.
@@ -247,16 +369,39 @@ attr_atomic_kill(attribute *temp, attribute_def *pdef, int limit)
 void
 attr_atomic_copy(attribute *to, attribute *from, attribute_def *pdef, int limit)
 {
-	int i;
-	for (i = 0; i < limit; i++) {
-		if (((to + i)->at_flags & ATR_VFLAG_SET) && (pdef + i)->at_set != set_null)
-			(pdef + i)->at_free(to + i);
+	atomic_copy(to, NULL, from, NULL, pdef, limit);
+}
 
-		if ((pdef + i)->at_set != set_null)
-			clear_attr(to + i, pdef + i);
-		if ((from + i)->at_flags & ATR_VFLAG_SET) {
-			(pdef + i)->at_set((to + i), (from + i), SET);
-			(to + i)->at_flags = (from + i)->at_flags;
-		}
-	}
+/**
+ * @brief
+ * 	attr_atomic_copy() from an object's sparse attribute storage into a
+ *	preallocated attribute array
+ *
+ * 	@param[out] to - attribute array copied into
+ * 	@param[in] from - sparse attribute storage copied from
+ * 	@param[in] pdef - pointer to attribute_def structure
+ * 	@param[in] limit - Last attribute in the list
+ */
+
+void
+attr_atomic_copy_from_sparse(attribute *to, attr_sparse *from, attribute_def *pdef, int limit)
+{
+	atomic_copy(to, NULL, NULL, from, pdef, limit);
+}
+
+/**
+ * @brief
+ * 	attr_atomic_copy() from an attribute array back into an object's
+ *	sparse attribute storage
+ *
+ * 	@param[out] to - sparse attribute storage copied into
+ * 	@param[in] from - attribute array copied from
+ * 	@param[in] pdef - pointer to attribute_def structure
+ * 	@param[in] limit - Last attribute in the list
+ */
+
+void
+attr_atomic_copy_to_sparse(attr_sparse *to, attribute *from, attribute_def *pdef, int limit)
+{
+	atomic_copy(NULL, to, from, NULL, pdef, limit);
 }
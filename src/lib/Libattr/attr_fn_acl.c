@@ -54,6 +54,7 @@
 #include "list_link.h"
 #include "attribute.h"
 #include "pbs_error.h"
+#include "pbs_idx.h"
 
 
 /**
@@ -82,6 +83,12 @@
  * 	comp_arst(), and free_arst() are used for those functions.
  *
  * 	set_ugacl() is different because of the special  sorting required.
+ *
+ * 	acl_check() compiles a long ACL, and every group ACL, into an acl_index
+ * 	kept with the array_strings: hash indexes for the exact entries and a
+ * 	reversed suffix trie for the '*' host entries.  Anything that changes
+ * 	the strings drops the index through pfn_free_acl_index and the next
+ * 	check builds it again.
  */
 
 /* External Functions called */
@@ -94,10 +101,42 @@ static int user_match(const char *can, const char *master);
 static int host_order(char *old, char *new);
 static int user_order(char *old, char *new);
 static int group_order(char *old, char *new);
+static void free_acl_index(struct array_strings *pas);
+static struct acl_index *acl_index_get(struct array_strings *pas, int type);
+static int acl_index_first(struct acl_index *pai, struct array_strings *pas, char *name);
 static int
 set_allacl(attribute *, attribute *, enum batch_op,
 	int (*order_func)());
 
+#define ACL_INDEX_MIN	8	/* shorter ACLs are scanned, see acl_index_get() */
+#define ACL_INDEX_FAIL	-2	/* acl_index_first() could not complete */
+
+/* node of the reversed suffix trie holding the '*' entries of a host ACL */
+struct acl_trie {
+	struct acl_trie *tr_kid;	/* first child */
+	struct acl_trie *tr_sib;	/* next sibling */
+	int		 tr_idx;	/* first entry ending here, -1 if none */
+	int		 tr_ch;		/* lower case character of this node */
+};
+
+/* wildcard host entry of a user ACL, chained per user name */
+struct acl_wild {
+	char		*aw_host;	/* host part of the entry, starts with '*' */
+	int		 aw_idx;	/* position of the entry in the ACL */
+	struct acl_wild	*aw_next;	/* next entry for the same user */
+};
+
+/* compiled form of an ACL, hung off array_strings.as_acl */
+struct acl_index {
+	int		 ai_type;	/* ACL type the index was built for */
+	int		 ai_default;	/* result when no entry matches */
+	void		*ai_exact;	/* exact entries, data is &as_string[] */
+	void		*ai_wild;	/* ACL_User: user name -> acl_wild chain */
+	struct acl_wild	*ai_wents;	/* storage for the acl_wild chains */
+	int		 ai_nwild;	/* used entries of ai_wents */
+	struct acl_trie	*ai_trie;	/* ACL_Host: root of the '*' entries */
+};
+
 /* for all decode_*acl() - use decode_arst() */
 /* for all encode_*acl() - use encode_arst() */
 
@@ -209,6 +248,7 @@ acl_check(attribute *pattr, char *name, int type)
 	int		      default_rtn = 0;
 #endif	/* HOST_ACL_DEFAULT_ALL */
 	struct array_strings *pas;
+	struct acl_index     *pai;
 	char		     *pstr;
 	int (*match_func)(const char *name, const char *master);
 
@@ -248,6 +288,15 @@ acl_check(attribute *pattr, char *name, int type)
 #endif
 	}
 
+	if ((pai = acl_index_get(pas, type)) != NULL) {
+		i = acl_index_first(pai, pas, name);
+		if (i == -1)
+			return (pai->ai_default);
+		if (i >= 0)
+			return (*pas->as_string[i] == '-' ? 0 : 1);
+		/* could not use the index, scan the list instead */
+	}
+
 	for (i=0; i<pas->as_usedptr; i++) {
 		pstr = pas->as_string[i];
 		if ((*pstr == '+') || (*pstr == '-')) {
@@ -370,8 +419,10 @@ set_allacl(attribute *attr, attribute *new, enum batch_op op, int (*order_func)(
 		pas->as_bufsize = 0;
 		pas->as_buf     = NULL;
 		pas->as_next   = NULL;
+		pas->as_acl    = NULL;
 		attr->at_val.at_arst = pas;
-	}
+	} else
+		free_acl_index(pas);	/* entries are about to change */
 
 	/*
 	 * At this point we know we have a array_strings struct initialized
@@ -776,3 +827,477 @@ host_order(char *s1, char *s2)
 		}
 	}
 }
+
+/**
+ * @brief
+ *	free the trie below and including a node and its siblings
+ *
+ * @param[in] pn - first node to free
+ */
+
+static void
+acl_trie_free(struct acl_trie *pn)
+{
+	struct acl_trie *next;
+
+	while (pn) {
+		next = pn->tr_sib;
+		acl_trie_free(pn->tr_kid);
+		free(pn);
+		pn = next;
+	}
+}
+
+/**
+ * @brief
+ * 	free_acl_index - free the acl_index of an array of strings, if any.
+ *	Must be called whenever the strings are changed or freed.
+ *
+ * @param[in] pas - array of strings holding the ACL
+ */
+
+static void
+free_acl_index(struct array_strings *pas)
+{
+	struct acl_index *pai;
+
+	if ((pas == NULL) || ((pai = pas->as_acl) == NULL))
+		return;
+
+	if (pai->ai_exact)
+		pbs_idx_destroy(pai->ai_exact);
+	if (pai->ai_wild)
+		pbs_idx_destroy(pai->ai_wild);
+	free(pai->ai_wents);
+	acl_trie_free(pai->ai_trie);
+	free(pai);
+	pas->as_acl = NULL;
+}
+
+/**
+ * @brief
+ *	return the earlier of two entry positions, -1 meaning none
+ */
+
+static int
+acl_earlier(int i, int j)
+{
+	if (i < 0)
+		return j;
+	if ((j < 0) || (i < j))
+		return i;
+	return j;
+}
+
+/**
+ * @brief
+ *	build "user@host" with the host in lower case
+ *
+ * @param[in] user - user name, need not be null terminated
+ * @param[in] ulen - length of the user name
+ * @param[in] host - host name
+ * @param[in] buf  - buffer to use if the key fits
+ * @param[in] size - size of buf
+ *
+ * @return	char *
+ * @retval	buf or a malloc'ed key which the caller frees
+ * @retval	NULL	out of memory
+ */
+
+static char *
+acl_user_key(const char *user, size_t ulen, const char *host, char *buf, size_t size)
+{
+	char *key = buf;
+	char *pc;
+
+	if ((ulen + strlen(host) + 2 > size) &&
+		((key = malloc(ulen + strlen(host) + 2)) == NULL))
+		return NULL;
+
+	memcpy(key, user, ulen);
+	pc = key + ulen;
+	*pc++ = '@';
+	while (*host)
+		*pc++ = tolower((int)(unsigned char)*host++);
+	*pc = '\0';
+	return key;
+}
+
+/**
+ * @brief
+ *	add an exact entry to the index, an earlier equal entry wins
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+
+static int
+acl_exact_add(struct acl_index *pai, struct array_strings *pas, char *key, int i)
+{
+	void *data;
+	void *k = key;
+
+	if (pbs_idx_find(pai->ai_exact, &k, &data, NULL) == PBS_IDX_RET_OK)
+		return 0;
+	if (pbs_idx_insert(pai->ai_exact, key, &pas->as_string[i]) != PBS_IDX_RET_OK)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	find an exact entry in the index
+ *
+ * @return	int
+ * @retval	position of the entry
+ * @retval	-1	none
+ */
+
+static int
+acl_exact_find(struct acl_index *pai, struct array_strings *pas, char *key)
+{
+	char **pp;
+	void *k = key;
+
+	if (pbs_idx_find(pai->ai_exact, &k, (void **)&pp, NULL) == PBS_IDX_RET_OK)
+		return (int)(pp - pas->as_string);
+	return -1;
+}
+
+/**
+ * @brief
+ *	add a '*' host entry to the trie, keyed by the rest of the
+ *	entry read backwards
+ *
+ * @param[in] root - root of the trie
+ * @param[in] suffix - entry without the leading '*'
+ * @param[in] i - position of the entry
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+
+static int
+acl_trie_add(struct acl_trie *root, const char *suffix, int i)
+{
+	struct acl_trie *pn = root;
+	struct acl_trie *kid;
+	const char *pc = suffix + strlen(suffix);
+	int c;
+
+	while (pc > suffix) {
+		c = tolower((int)(unsigned char)*--pc);
+		for (kid = pn->tr_kid; kid; kid = kid->tr_sib) {
+			if (kid->tr_ch == c)
+				break;
+		}
+		if (kid == NULL) {
+			if ((kid = malloc(sizeof(struct acl_trie))) == NULL)
+				return -1;
+			kid->tr_kid = NULL;
+			kid->tr_sib = pn->tr_kid;
+			kid->tr_idx = -1;
+			kid->tr_ch = c;
+			pn->tr_kid = kid;
+		}
+		pn = kid;
+	}
+	if (pn->tr_idx < 0)
+		pn->tr_idx = i;
+	return 0;
+}
+
+/**
+ * @brief
+ *	find the first '*' host entry matching a host name.  As in
+ *	hacl_match(), the '*' must stand for at least one character
+ *	unless it is the whole entry.
+ *
+ * @return	int
+ * @retval	position of the entry
+ * @retval	-1	none
+ */
+
+static int
+acl_trie_find(struct acl_trie *root, const char *name)
+{
+	struct acl_trie *pn = root;
+	const char *pc = name + strlen(name);
+	int first = root->tr_idx;
+	int c;
+
+	while (pc > name) {
+		c = tolower((int)(unsigned char)*--pc);
+		for (pn = pn->tr_kid; pn; pn = pn->tr_sib) {
+			if (pn->tr_ch == c)
+				break;
+		}
+		if (pn == NULL)
+			break;
+		if (pc > name)
+			first = acl_earlier(first, pn->tr_idx);
+	}
+	return first;
+}
+
+/**
+ * @brief
+ *	add an entry of a user ACL to the index.  See user_match() for
+ *	how the entry splits into user and host.
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	out of memory
+ */
+
+static int
+acl_user_add(struct acl_index *pai, struct array_strings *pas, char *pstr, int i)
+{
+	char buf[256];
+	char *key;
+	char *at;
+	size_t ulen;
+	struct acl_wild *pw;
+	struct acl_wild *prev;
+	int rc = 0;
+
+	if (*pstr == '\0')
+		return 0;
+	if ((at = strchr(pstr + 1, '@')) == NULL)
+		return (acl_exact_add(pai, pas, pstr, i));
+	if (*(at + 1) == '\0')
+		return 0;	/* empty host name matches nothing */
+
+	ulen = at - pstr;
+	if ((key = acl_user_key(pstr, ulen, at + 1, buf, sizeof(buf))) == NULL)
+		return -1;
+
+	if (*(at + 1) == '*') {
+		key[ulen] = '\0';
+		pw = &pai->ai_wents[pai->ai_nwild++];
+		pw->aw_host = at + 1;
+		pw->aw_idx = i;
+		pw->aw_next = NULL;
+		if (pbs_idx_find(pai->ai_wild, (void **)&key, (void **)&prev, NULL) == PBS_IDX_RET_OK) {
+			while (prev->aw_next)
+				prev = prev->aw_next;
+			prev->aw_next = pw;
+		} else if (pbs_idx_insert(pai->ai_wild, key, pw) != PBS_IDX_RET_OK)
+			rc = -1;
+	} else
+		rc = acl_exact_add(pai, pas, key, i);
+
+	if (key != buf)
+		free(key);
+	return rc;
+}
+
+/**
+ * @brief
+ *	find the first entry of a user ACL matching "user[@host]"
+ *
+ * @return	int
+ * @retval	position of the entry
+ * @retval	-1	none
+ * @retval	ACL_INDEX_FAIL	out of memory
+ */
+
+static int
+acl_user_first(struct acl_index *pai, struct array_strings *pas, char *name)
+{
+	char buf[256];
+	char *key;
+	char *at;
+	size_t ulen;
+	struct acl_wild *pw;
+	int first;
+
+	if ((*name == '\0') || ((at = strchr(name + 1, '@')) == NULL))
+		return (acl_exact_find(pai, pas, name));
+
+	ulen = at - name;
+	if ((key = acl_user_key(name, ulen, at + 1, buf, sizeof(buf))) == NULL)
+		return ACL_INDEX_FAIL;
+
+	first = acl_exact_find(pai, pas, key);
+
+	/* entries without a host part and '*' host entries for the user */
+	key[ulen] = '\0';
+	first = acl_earlier(first, acl_exact_find(pai, pas, key));
+	if (pbs_idx_find(pai->ai_wild, (void **)&key, (void **)&pw, NULL) == PBS_IDX_RET_OK) {
+		for (; pw; pw = pw->aw_next) {
+			if (hacl_match(at + 1, pw->aw_host) == 0) {
+				first = acl_earlier(first, pw->aw_idx);
+				break;
+			}
+		}
+	}
+
+	if (key != buf)
+		free(key);
+	return first;
+}
+
+#ifndef WIN32
+/**
+ * @brief
+ *	find the first entry of a group ACL naming a group the user is
+ *	in.  The user's groups are looked up once instead of once per
+ *	entry as gacl_match() does.
+ *
+ * @return	int
+ * @retval	position of the entry
+ * @retval	-1	none
+ */
+
+static int
+acl_group_first(struct acl_index *pai, struct array_strings *pas, char *name)
+{
+	int i, ng = 0;
+	int first = -1;
+	struct passwd *pw;
+	struct group *gr;
+	gid_t *groups = NULL;
+
+	if ((pw = getpwnam(name)) == NULL)
+		return -1;
+
+	if (getgrouplist(name, pw->pw_gid, NULL, &ng) < 0) {
+		if ((groups = (gid_t *) malloc(ng * sizeof (gid_t))) == NULL)
+			return -1;
+		getgrouplist(name, pw->pw_gid, groups, &ng);
+	}
+
+	for (i = 0; i < ng; i++) {
+		if ((gr = getgrgid(groups[i])) != NULL)
+			first = acl_earlier(first, acl_exact_find(pai, pas, gr->gr_name));
+	}
+
+	free(groups);
+	return first;
+}
+#endif
+
+/**
+ * @brief
+ *	find the first entry of an ACL matching a name, the entry
+ *	acl_check() would stop at when scanning the list
+ *
+ * @param[in] pai - index of the ACL
+ * @param[in] pas - array of strings holding the ACL
+ * @param[in] name - name to check
+ *
+ * @return	int
+ * @retval	position of the entry
+ * @retval	-1	none
+ * @retval	ACL_INDEX_FAIL	out of memory
+ */
+
+static int
+acl_index_first(struct acl_index *pai, struct array_strings *pas, char *name)
+{
+	switch (pai->ai_type) {
+		case ACL_Host:
+			return (acl_earlier(acl_exact_find(pai, pas, name),
+				acl_trie_find(pai->ai_trie, name)));
+		case ACL_User:
+			return (acl_user_first(pai, pas, name));
+#ifndef WIN32
+		case ACL_Group:
+			return (acl_group_first(pai, pas, name));
+#endif
+		default:
+			return (acl_exact_find(pai, pas, name));
+	}
+}
+
+/**
+ * @brief
+ *	return the acl_index of an ACL, building it if needed.  Short
+ *	ACLs are not indexed as scanning them is as fast, except for
+ *	group ACLs where each entry scanned costs a group list lookup.
+ *
+ * @param[in] pas - array of strings holding the ACL
+ * @param[in] type - type of acl
+ *
+ * @return	struct acl_index *
+ * @retval	the index
+ * @retval	NULL	ACL is not indexed
+ */
+
+static struct acl_index *
+acl_index_get(struct array_strings *pas, int type)
+{
+	struct acl_index *pai;
+	char *pstr;
+	int i;
+	int rc;
+
+	if ((pai = pas->as_acl) != NULL) {
+		if (pai->ai_type == type)
+			return pai;
+		free_acl_index(pas);
+	}
+	if ((pas->as_usedptr < ACL_INDEX_MIN) && (type != ACL_Group))
+		return NULL;
+
+	if ((pai = calloc(1, sizeof(struct acl_index))) == NULL)
+		return NULL;
+	pfn_free_acl_index = free_acl_index;	/* see attr_fn_arst.c */
+	pas->as_acl = pai;
+	pai->ai_type = type;
+#ifdef HOST_ACL_DEFAULT_ALL
+	pai->ai_default = 1;
+#else
+	pai->ai_default = 0;
+#endif
+
+	pai->ai_exact = pbs_idx_create((type == ACL_Host) ? PBS_IDX_ICASE_CMP : 0, 0);
+	if (pai->ai_exact == NULL)
+		goto err;
+	if (type == ACL_Host) {
+		if ((pai->ai_trie = calloc(1, sizeof(struct acl_trie))) == NULL)
+			goto err;
+		pai->ai_trie->tr_idx = -1;
+	} else if (type == ACL_User) {
+		pai->ai_wents = malloc(pas->as_usedptr * sizeof(struct acl_wild));
+		if ((pai->ai_wents == NULL) ||
+			((pai->ai_wild = pbs_idx_create(0, 0)) == NULL))
+			goto err;
+	}
+
+	for (i = 0; i < pas->as_usedptr; i++) {
+		pstr = pas->as_string[i];
+		if ((*pstr == '+') || (*pstr == '-')) {
+			if (*(pstr + 1) == '\0')	/* "+" or "-" sets default */
+				pai->ai_default = (*pstr == '+');
+			pstr++;
+		}
+
+		switch (type) {
+			case ACL_Host:
+				if (*pstr == '\0')
+					rc = 0;
+				else if (*pstr == '*')
+					rc = acl_trie_add(pai->ai_trie, pstr + 1, i);
+				else
+					rc = acl_exact_add(pai, pas, pstr, i);
+				break;
+			case ACL_User:
+				rc = acl_user_add(pai, pas, pstr, i);
+				break;
+			default:
+				rc = acl_exact_add(pai, pas, pstr, i);
+				break;
+		}
+		if (rc != 0)
+			goto err;
+	}
+	return pai;
+
+err:
+	free_acl_index(pas);
+	return NULL;
+}
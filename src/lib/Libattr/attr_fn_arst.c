@@ -82,6 +82,28 @@
  * 	struct
  */
 
+/*
+ * acl_check() may hang a compiled index off the array_strings of an ACL.
+ * The index code lives with acl_check() in the Server only, so it
+ * registers the function that frees an index here when it builds one.
+ */
+void (*pfn_free_acl_index)(struct array_strings *) = NULL;
+
+/**
+ * @brief
+ *	drop the ACL index of an array of strings, if it has one, before
+ *	its strings are changed or freed
+ *
+ * @param[in] pas - the array of strings
+ */
+
+static void
+drop_acl_index(struct array_strings *pas)
+{
+	if ((pas->as_acl != NULL) && (pfn_free_acl_index != NULL))
+		pfn_free_acl_index(pas);
+}
+
 /**
  * @brief
  *	decode a comma string into an attribute of type ATR_TYPE_ARST
@@ -146,6 +168,7 @@ decode_arst_direct(attribute *patr, char *val)
 	/* number of slots (sub strings) */
 	stp->as_npointers = ns;
 	stp->as_usedptr = 0;
+	stp->as_acl = NULL;
 	/* for the strings themselves */
 	stp->as_buf     = pbuf;
 	stp->as_next    = pbuf;
@@ -401,8 +424,10 @@ set_arst(attribute *attr, attribute *new, enum batch_op op)
 		pas->as_bufsize = 0;
 		pas->as_buf     = NULL;
 		pas->as_next    = NULL;
+		pas->as_acl     = NULL;
 		attr->at_val.at_arst = pas;
-	}
+	} else
+		drop_acl_index(pas);	/* strings are about to change */
 	if ((op == INCR) && !pas->as_buf)
 		op = SET;	/* no current strings, change op to SET */
 
@@ -575,6 +600,7 @@ void
 free_arst(attribute *attr)
 {
 	if ((attr->at_flags & ATR_VFLAG_SET) && (attr->at_val.at_arst)) {
+		drop_acl_index(attr->at_val.at_arst);
 		(void)free(attr->at_val.at_arst->as_buf);
 		(void)free((char *)attr->at_val.at_arst);
 	}
@@ -810,6 +836,7 @@ decode_arst_direct_bs(attribute *patr, char *val)
 	/* number of slots (sub strings) */
 	stp->as_npointers = ns;
 	stp->as_usedptr = 0;
+	stp->as_acl = NULL;
 	/* for the strings themselves */
 	stp->as_buf     = pbuf;
 	stp->as_next    = pbuf;
@@ -1095,8 +1122,10 @@ set_arst_uniq(attribute *attr, attribute *new, enum batch_op op)
 		pas->as_bufsize = 0;
 		pas->as_buf     = NULL;
 		pas->as_next   = NULL;
+		pas->as_acl    = NULL;
 		attr->at_val.at_arst = pas;
-	}
+	} else
+		drop_acl_index(pas);	/* strings are about to change */
 
 	/*
 	 * At this point we know we have a array_strings struct initialized
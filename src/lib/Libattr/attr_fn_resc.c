@@ -94,6 +94,128 @@ int comp_resc_eq;	/* count of resources compared = */
 int comp_resc_lt;	/* count of resources compared < */
 int comp_resc_nc;	/* count of resources not compared  */
 void *resc_attrdef_idx = NULL;
+int svr_resc_next_id = 0;
+
+/*
+ * Scratch index of the entries of one resource list, addressed by the
+ * rs_id of their definition.  set_resc() and comp_resc() load the list
+ * they search into it once instead of walking it for every resource of
+ * the other list.  A slot is only valid while its stamp equals ri_gen,
+ * so loading another list does not need to clear the arrays.
+ */
+static struct resc_idx {
+	resource **ri_ent;	/* entry of the list for each rs_id */
+	unsigned int *ri_stamp;	/* generation in which ri_ent[id] was set */
+	int ri_size;		/* number of slots allocated */
+	unsigned int ri_gen;	/* current generation */
+} resc_scratch;
+
+/**
+ * @brief
+ * 	load the entries of a resource list into resc_scratch
+ *
+ * @param[in] pattr - attribute heading the resource list
+ *
+ * @return	int
+ * @retval	0  - index loaded
+ * @retval	-1 - no index, resource ids are not assigned or out of memory;
+ *		     the caller must fall back to find_resc_entry()
+ *
+ */
+static int
+resc_idx_load(const attribute *pattr)
+{
+	struct resc_idx *pidx = &resc_scratch;
+	resource *pr;
+
+	if (svr_resc_next_id <= 0)
+		return -1;
+
+	if (pidx->ri_size < svr_resc_next_id) {
+		int nsize = svr_resc_next_id + 16;
+		resource **nent;
+		unsigned int *nstamp;
+
+		nent = realloc(pidx->ri_ent, nsize * sizeof(resource *));
+		if (nent == NULL)
+			return -1;
+		pidx->ri_ent = nent;
+		nstamp = realloc(pidx->ri_stamp, nsize * sizeof(unsigned int));
+		if (nstamp == NULL)
+			return -1;
+		memset(nstamp + pidx->ri_size, 0, (nsize - pidx->ri_size) * sizeof(unsigned int));
+		pidx->ri_stamp = nstamp;
+		pidx->ri_size = nsize;
+	}
+
+	if (++pidx->ri_gen == 0) {
+		/* generation wrapped, forget every stamp */
+		memset(pidx->ri_stamp, 0, pidx->ri_size * sizeof(unsigned int));
+		pidx->ri_gen = 1;
+	}
+
+	for (pr = (resource *)GET_NEXT(pattr->at_val.at_list);
+	     pr != NULL;
+	     pr = (resource *)GET_NEXT(pr->rs_link)) {
+		int id = pr->rs_defin->rs_id;
+
+		if (id < 0 || id >= pidx->ri_size)
+			return -1;
+		/* keep the first entry, as find_resc_entry() would */
+		if (pidx->ri_stamp[id] != pidx->ri_gen) {
+			pidx->ri_stamp[id] = pidx->ri_gen;
+			pidx->ri_ent[id] = pr;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ * 	record an entry just added to the list loaded in resc_scratch
+ *
+ * @param[in] pr - new resource entry
+ *
+ * @return	void
+ *
+ */
+static void
+resc_idx_add(resource *pr)
+{
+	int id = pr->rs_defin->rs_id;
+
+	if (id >= 0 && id < resc_scratch.ri_size) {
+		resc_scratch.ri_stamp[id] = resc_scratch.ri_gen;
+		resc_scratch.ri_ent[id] = pr;
+	}
+}
+
+/**
+ * @brief
+ * 	find the entry for a resource definition in the list last loaded
+ * 	by resc_idx_load(), or by walking the list if it was not loaded
+ *
+ * @param[in] pattr - attribute heading the resource list
+ * @param[in] prdef - resource definition to find
+ * @param[in] idx_rc - result of resc_idx_load() for pattr
+ *
+ * @return	resource *
+ * @retval	entry found
+ * @retval	NULL if the list has no entry for prdef
+ *
+ */
+static resource *
+resc_idx_find(const attribute *pattr, resource_def *prdef, int idx_rc)
+{
+	struct resc_idx *pidx = &resc_scratch;
+	int id = prdef->rs_id;
+
+	if (idx_rc != 0)
+		return find_resc_entry(pattr, prdef);
+	if (id < 0 || id >= pidx->ri_size || pidx->ri_stamp[id] != pidx->ri_gen)
+		return NULL;
+	return pidx->ri_ent[id];
+}
 
 /**
  * @brief
@@ -299,9 +421,11 @@ set_resc(attribute *old, attribute *new, enum batch_op op)
 	resource *newresc;
 	resource *oldresc;
 	int	  rc;
+	int	  idx_rc;
 
 	assert(old && new);
 
+	idx_rc = resc_idx_load(old);
 	newresc = (resource *)GET_NEXT(new->at_val.at_list);
 	while (newresc != NULL) {
 
@@ -309,7 +433,7 @@ set_resc(attribute *old, attribute *new, enum batch_op op)
 
 		/* search for old that has same definition as new */
 
-		oldresc = find_resc_entry(old, newresc->rs_defin);
+		oldresc = resc_idx_find(old, newresc->rs_defin, idx_rc);
 		if (oldresc == NULL) {
 			/* add new resource to list */
 			oldresc = add_resource_entry(old, newresc->rs_defin);
@@ -317,6 +441,8 @@ set_resc(attribute *old, attribute *new, enum batch_op op)
 				log_err(-1, "set_resc", "Unable to malloc space");
 				return (PBSE_SYSTEM);
 			}
+			if (idx_rc == 0)
+				resc_idx_add(oldresc);
 		}
 
 		/*
@@ -386,6 +512,7 @@ comp_resc(attribute *attr, attribute *with)
 	resource *atresc;
 	resource *wiresc;
 	int rc;
+	int idx_rc;
 
 	comp_resc_gt = 0;
 	comp_resc_eq = 0;
@@ -395,10 +522,11 @@ comp_resc(attribute *attr, attribute *with)
 	if ((attr == NULL) || (with == NULL))
 		return (-1);
 
+	idx_rc = resc_idx_load(attr);
 	wiresc = (resource *)GET_NEXT(with->at_val.at_list);
 	while (wiresc != NULL) {
 		if (wiresc->rs_value.at_flags & ATR_VFLAG_SET) {
-			atresc = find_resc_entry(attr, wiresc->rs_defin);
+			atresc = resc_idx_find(attr, wiresc->rs_defin, idx_rc);
 			if (atresc != NULL) {
 				if (atresc->rs_value.at_flags & ATR_VFLAG_SET) {
 					if ((rc=atresc->rs_defin->rs_comp(&atresc->rs_value, 				      &wiresc->rs_value)) > 0)
@@ -454,10 +582,41 @@ free_resc(attribute *pattr)
 	CLEAR_HEAD(pattr->at_val.at_list);
 }
 
+/**
+ * @brief
+ * 	look a name up in the perfect hash of the built-in resources
+ *
+ * @param[in] name - name of resource
+ *
+ * @return	pointer to structure
+ * @retval	pointer to the built-in resource_def - Success
+ * @retval	NULL - not a built-in resource
+ *
+ */
+static resource_def *
+find_builtin_resc_def(char *name)
+{
+	int i;
+	resource_def *def;
+
+	if ((i = attr_phash_index(&svr_resc_defm_phash, name)) < 0)
+		return NULL;
+
+	def = &((resource_def *) svr_resc_defm_phash.ph_defs)[i];
+	if (strcasecmp(def->rs_name, name) != 0)
+		return NULL;
+	return def;
+}
+
 /**
  * @brief
  * 	 create the search index for resource deinitions
  *
+ *	Also numbers the definitions densely through rs_id, custom
+ *	resources added later take ids from svr_resc_next_id.  A definition
+ *	created before this runs keeps rs_id -1, so lists holding it are
+ *	searched without the index.
+ *
  * @param[in] rscdf - address of array of resource_def structs
  * @param[in] limit - number of members in resource_def array
  *
@@ -478,14 +637,20 @@ cr_rescdef_idx(resource_def *resc_def, int limit)
 	if ((resc_attrdef_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
 		return -1;
 
-	/* add all attributes to the tree with key as the attr name */
+	/*
+	 * add the resources not already resolved by the built-in perfect
+	 * hash to the tree with key as the resource name
+	 */
 	for (i = 0; i < limit; i++) {
-		if (strcmp(resc_def->rs_name, RESC_NOOP_DEF) != 0) {
+		resc_def->rs_id = i;
+		if (strcmp(resc_def->rs_name, RESC_NOOP_DEF) != 0 &&
+		    find_builtin_resc_def(resc_def->rs_name) != resc_def) {
 			if (pbs_idx_insert(resc_attrdef_idx, resc_def->rs_name, resc_def) != PBS_IDX_RET_OK)
 				return -1;
 		}
 		resc_def++;
 	}
+	svr_resc_next_id = limit;
 	return 0;
 }
 
@@ -493,6 +658,9 @@ cr_rescdef_idx(resource_def *resc_def, int limit)
  * @brief
  * 	find the resource_def structure for a resource with a given name
  *
+ *	Built-in resources are resolved through the perfect hash generated
+ *	with svr_resc_defm, custom resources through resc_attrdef_idx.
+ *
  * @param[in] rscdf - address of array of resource_def structs
  * @param[in] name - name of resource
  *
@@ -506,6 +674,9 @@ find_resc_def(resource_def *resc_def, char *name)
 {
 	resource_def *found_def = NULL, *def = NULL;
 
+	if ((def = find_builtin_resc_def(name)) != NULL)
+		return def;
+
 	if (pbs_idx_find(resc_attrdef_idx, (void **) &name, (void **)&found_def, NULL) == PBS_IDX_RET_OK)
 		def = &resc_def[found_def - resc_def];
 
@@ -90,12 +90,78 @@ clear_attr(attribute *pattr, attribute_def *pdef)
 		CLEAR_HEAD(pattr->at_val.at_list);
 }
 
+/*
+ * Search handle returned by cr_attrdef_idx(): the compile time perfect hash
+ * of a built-in array when it is usable, otherwise a dynamic pbs_idx.
+ */
+struct attrdef_idx {
+	const attr_phash_t *phash;
+	void *idx;
+};
+
+/**
+ * @brief
+ * 	Hash a definition name for the perfect hash tables, case insensitive
+ *	FNV-1a.  Must match ph_hash() in buildutils/attr_parser.py.
+ *
+ * @param[in] seed - 0 to pick the bucket, the bucket's seed to pick the slot
+ * @param[in] name - the name to hash
+ *
+ * @return	unsigned int
+ * @retval	the hash value
+ *
+ */
+static unsigned int
+attr_phash_hash(unsigned int seed, const char *name)
+{
+	unsigned int h = 2166136261U ^ seed;
+	unsigned char c;
+
+	while ((c = (unsigned char) *name++) != '\0') {
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		h = (h ^ c) * 16777619U;
+	}
+	return h ^ (h >> 16);
+}
+
+/**
+ * @brief
+ * 	Look a name up in a compile time perfect hash table
+ *
+ *	The slot found is the only candidate for the name; the caller must
+ *	still compare the name with the definition at the returned index.
+ *
+ * @param[in] phash - the perfect hash table
+ * @param[in] name - name to look up
+ *
+ * @return	int
+ * @retval	>=0	index of the candidate definition
+ * @retval	-1	the name is not in the table
+ *
+ */
+int
+attr_phash_index(const attr_phash_t *phash, const char *name)
+{
+	unsigned int b;
+
+	if (phash == NULL || phash->ph_nslot == 0 || name == NULL)
+		return -1;
+
+	b = attr_phash_hash(0, name) & (phash->ph_nbucket - 1);
+	return phash->ph_slot[attr_phash_hash(phash->ph_disp[b], name) & (phash->ph_nslot - 1)];
+}
+
 /**
  * @brief
  * 	Create the search index for the provided attribute def array
  *
+ *	When the array has a compile time perfect hash table which resolves
+ *	every name in the array, that table is used and no index is built.
+ *
  * @param[in] attr_def - ptr to attribute definitions
  * @param[in] limit - limit on size of def array
+ * @param[in] phash - perfect hash table generated for attr_def, or NULL
  *
  * @return	void *
  * @retval	 NULL	Failure
@@ -103,21 +169,39 @@ clear_attr(attribute *pattr, attribute_def *pdef)
  *
  */
 void *
-cr_attrdef_idx(attribute_def *adef, int limit)
+cr_attrdef_idx(attribute_def *adef, int limit, const attr_phash_t *phash)
 {
 	int i;
-	void *attrdef_idx = NULL;
+	struct attrdef_idx *attrdef_idx = NULL;
 
 	if (!adef)
 		return NULL;
 
+	if ((attrdef_idx = calloc(1, sizeof(struct attrdef_idx))) == NULL)
+		return NULL;
+
+	/* use the generated table only if it matches this array exactly */
+	if (phash != NULL && phash->ph_nslot != 0 && phash->ph_defs == adef) {
+		for (i = 0; i < limit; i++) {
+			if (strcmp(adef[i].at_name, "noop") != 0 &&
+			    attr_phash_index(phash, adef[i].at_name) != i)
+				break;
+		}
+		if (i == limit) {
+			attrdef_idx->phash = phash;
+			return attrdef_idx;
+		}
+	}
+
 	/* create the attribute index */
-	if ((attrdef_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
+	if ((attrdef_idx->idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL) {
+		free(attrdef_idx);
 		return NULL;
+	}
 
 	/* add all attributes to the tree with key as the attr name */
 	for (i = 0; i < limit; i++) {
-		if (pbs_idx_insert(attrdef_idx, adef->at_name, adef) != PBS_IDX_RET_OK)
+		if (pbs_idx_insert(attrdef_idx->idx, adef->at_name, adef) != PBS_IDX_RET_OK)
 			return NULL;
 
 		adef++;
@@ -146,9 +230,17 @@ int
 find_attr(void *attrdef_idx, attribute_def *attr_def, char *name)
 {
 	int index = -1;
+	struct attrdef_idx *pidx = attrdef_idx;
 	attribute_def *found_def = NULL;
 
-	if (pbs_idx_find(attrdef_idx, (void **) &name, (void **)&found_def, NULL) == PBS_IDX_RET_OK)
+	if (pidx == NULL || name == NULL)
+		return -1;
+
+	if (pidx->phash != NULL) {
+		index = attr_phash_index(pidx->phash, name);
+		if (index >= 0 && strcasecmp(attr_def[index].at_name, name) != 0)
+			index = -1;
+	} else if (pbs_idx_find(pidx->idx, (void **) &name, (void **)&found_def, NULL) == PBS_IDX_RET_OK)
 		index = (found_def - attr_def);
 
 	return index;
@@ -1889,6 +1981,118 @@ free_attr(attribute_def *attr_def, attribute *pattr, int attr_idx)
 		attr_def[attr_idx].at_free(pattr);
 }
 
+/**
+ * @brief
+ *	Find the slot of an attribute in a sparse container without
+ *	allocating one.
+ *
+ * @param[in]	psparse		- the sparse container
+ * @param[in]	attr_idx	- index of the attribute
+ *
+ * @return	attribute *
+ * @retval	NULL	- the container holds no slot for the attribute,
+ *			  which is the same as a cleared, unset attribute
+ * @retval	!NULL	- pointer to the attribute
+ */
+attribute *
+attr_sparse_find(const attr_sparse *psparse, int attr_idx)
+{
+	int slot;
+
+	if (psparse == NULL || psparse->as_map == NULL)
+		return NULL;
+
+	slot = psparse->as_map[attr_idx];
+	if (slot == 0)
+		return NULL;
+	slot--;
+
+	return &psparse->as_chunk[slot / ATTR_SPARSE_CHUNK][slot % ATTR_SPARSE_CHUNK];
+}
+
+/**
+ * @brief
+ *	Return the slot of an attribute in a sparse container, allocating
+ *	and clearing one the first time the attribute is asked for.
+ *
+ * @param[in,out] psparse	- the sparse container
+ * @param[in]	  padef		- the object's attribute definition array
+ * @param[in]	  attr_idx	- index of the attribute
+ * @param[in]	  limit		- number of entries in padef
+ *
+ * @return	attribute *
+ * @retval	NULL	- out of memory
+ * @retval	!NULL	- pointer to the attribute, stable until attr_sparse_free()
+ */
+attribute *
+attr_sparse_get(attr_sparse *psparse, attribute_def *padef, int attr_idx, int limit)
+{
+	attribute *pattr;
+	attribute **chunks;
+	int slot;
+
+	if (psparse == NULL)
+		return NULL;
+
+	if ((pattr = attr_sparse_find(psparse, attr_idx)) != NULL)
+		return pattr;
+
+	assert(limit <= ATTR_SPARSE_MAX);
+	if (psparse->as_map == NULL) {
+		if ((psparse->as_map = calloc(limit, sizeof(unsigned char))) == NULL)
+			return NULL;
+	}
+
+	slot = psparse->as_nslot;
+	if ((slot % ATTR_SPARSE_CHUNK) == 0) {
+		chunks = realloc(psparse->as_chunk, (slot / ATTR_SPARSE_CHUNK + 1) * sizeof(attribute *));
+		if (chunks == NULL)
+			return NULL;
+		psparse->as_chunk = chunks;
+		chunks[slot / ATTR_SPARSE_CHUNK] = malloc(ATTR_SPARSE_CHUNK * sizeof(attribute));
+		if (chunks[slot / ATTR_SPARSE_CHUNK] == NULL)
+			return NULL;
+	}
+
+	pattr = &psparse->as_chunk[slot / ATTR_SPARSE_CHUNK][slot % ATTR_SPARSE_CHUNK];
+	clear_attr(pattr, &padef[attr_idx]);
+	psparse->as_map[attr_idx] = (unsigned char)(slot + 1);
+	psparse->as_nslot++;
+
+	return pattr;
+}
+
+/**
+ * @brief
+ *	Free the values held in a sparse container and the container's
+ *	own storage, leaving it empty.
+ *
+ * @param[in,out] psparse	- the sparse container
+ * @param[in]	  padef		- the object's attribute definition array
+ * @param[in]	  limit		- number of entries in padef
+ */
+void
+attr_sparse_free(attr_sparse *psparse, attribute_def *padef, int limit)
+{
+	int i;
+	attribute *pattr;
+
+	if (psparse == NULL)
+		return;
+
+	for (i = 0; i < limit; i++) {
+		if ((pattr = attr_sparse_find(psparse, i)) != NULL)
+			free_attr(padef, pattr, i);
+	}
+	for (i = 0; i * ATTR_SPARSE_CHUNK < psparse->as_nslot; i++)
+		free(psparse->as_chunk[i]);
+	free(psparse->as_chunk);
+	free(psparse->as_map);
+	psparse->as_chunk = NULL;
+	psparse->as_map = NULL;
+	psparse->as_nslot = 0;
+}
+
 /**
  * @brief	Generic getter for attribute's list value
  * 
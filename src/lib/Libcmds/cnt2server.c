@@ -74,6 +74,8 @@ cnt2server_extend(char *server, char *extend)
 {
 	int connect;
 
+	/* the commands are single threaded and may leave a client daemon */
+	pbs_client_daemon_enable();
 	connect = pbs_connect_extend(server, extend);
 	if (connect <= 0) {
 		if (pbs_errno > PBSE_) {
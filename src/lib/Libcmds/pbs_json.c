@@ -41,61 +41,56 @@
 #include <ctype.h>
 #include "pbs_json.h"
 #include "libutil.h"
-#define ARRAY_NESTING_LEVEL 500 /* describes the nesting level of a JSON array*/
-
-typedef struct JsonLink JsonLink;
-struct JsonLink{
-	JsonNode *node;
-	JsonLink *next;
-};
-
-static JsonLink *head = NULL, *prev_link = NULL;
 
 /**
  * @brief
- *	create_json_node
- * 	malloc and initialize a new json node
+ *	initialize a json writer for a document to be written to stream
  *
- * @return	pointer to newly created json node.
+ * @param[out] jw - the writer
+ * @param[in] stream - stream to write to
+ *
+ * @return	void
  */
-static JsonNode*
-create_json_node() {
-	JsonNode *new_node = malloc(sizeof(JsonNode));
-	if (new_node == NULL) {
-		return NULL;
-	}
-	new_node->node_type  = JSON_VALUE;
-	new_node->value_type = JSON_NULL;
-	new_node->key = NULL;
-	return new_node;
+void
+json_writer_init(json_writer *jw, FILE *stream)
+{
+	memset(jw, 0, sizeof(*jw));
+	jw->jw_stream = stream;
+	jw->jw_state = JSON_WRITER_NEW;
 }
 
 /**
  * @brief
- *	link a json node
+ *	initialize the node to be written
  *
- * @param[in] node - pointer to JsonNode
+ * @param[out] node - the node
  *
- * @return	int
- * @retval	0	if linked
- * @retval	1	if node null
+ * @return	void
+ */
+static void
+init_json_node(JsonNode *node)
+{
+	node->node_type  = JSON_VALUE;
+	node->value_type = JSON_NULL;
+	node->key = NULL;
+}
+
+static int write_json_node(json_writer *jw, JsonNode *node);
+
+/**
+ * @brief
+ *	start the json document of a writer
+ *
+ * @param[in] jw - the writer
  *
+ * @return	void
  */
-static int
-link_node(JsonNode *node) {
-	JsonLink *new_link = malloc(sizeof(JsonLink));
-	if (new_link == NULL)
-		return 1;
-	new_link->node = node;
-	new_link->next = NULL;
-	if (head == NULL) {
-		head = new_link;
-		prev_link = head;
-	} else {
-		prev_link->next = new_link;
-		prev_link = new_link;
-	}
-	return 0;
+static void
+start_json(json_writer *jw)
+{
+	jw->jw_state = JSON_WRITER_OPEN;
+	fprintf(jw->jw_stream, "{");
+	jw->jw_indent = 4;
 }
 
 /**
@@ -216,42 +211,22 @@ strdup_escape(JsonEscapeType esc_type, const char *str)
 }
 
 /**
- * @brief free an individual json node
- * @param[in] node - node to free
+ * @brief free the key and value of a json node
+ * @param[in] node - node whose key and value to free
  *
  * @return void
  */
-void
+static void
 free_json_node(JsonNode *node)
 {
 	if ((node->value_type == JSON_STRING) || (node->value_type == JSON_NUMERIC)) {
 		if (node->value.string != NULL)
 			free(node->value.string);
+		node->value.string = NULL;
 	}
 	if (node->key != NULL)
 		free(node->key);
-	free(node);
-}
-
-/**
- * @brief
- *	frees the json node list
- *
- * @return	Void
- *
- */
-void
-free_json_node_list()
-{
-	JsonLink *link = head;
-	while (link != NULL) {
-		free_json_node(link->node);
-		head = link->next;
-		free(link);
-		link = head;
-	}
-	head = NULL;
-	prev_link = NULL;
+	node->key = NULL;
 }
 
 /**
@@ -280,31 +255,31 @@ whitespace_only(const char *str) {
 
 /**
  * @brief
- *	add node to json list
+ *	write a node to a json document, starting the document first if this
+ *	is its first node
  *
+ * @param[in] jw - the writer
  * @param[in] ntype - node type
  * @param[in] vtype - value type
  * @param[in] key - node key
  * @param[in] value - value for node
  *
  * @return 	structure handle
- * @retval	structure handle to JsonNode list	success
- * @retval	NULL					error
+ * @retval	non-NULL	success
+ * @retval	NULL		error
  *
  */
 JsonNode*
-add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type, char *key, void *value) {
+add_json_node(json_writer *jw, JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type, char *key, void *value) {
 	int 	  rc = 0;
 	char	  *ptr = NULL;
 	char 	  *pc  = NULL;
-	JsonNode  *node = NULL;
+	JsonNode  *node = &jw->jw_node;
 	int	  value_is_whitespace = 0;
 
-	node = create_json_node();
-	if (node == NULL) {
-		fprintf(stderr, "Json Node: out of memory\n");
+	if (jw->jw_state == JSON_WRITER_DONE)
 		return NULL;
-	}
+	init_json_node(node);
 	node->node_type = ntype;
 	if (key != NULL) {
 		ptr = strdup((char *)key);
@@ -352,6 +327,7 @@ add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type,
 	}
 
 	if (node->value_type == JSON_STRING) {
+		ptr = NULL;
 		if (value != NULL) {
 			ptr = strdup_escape(esc_type, value);
 			if (ptr == NULL) {
@@ -361,171 +337,214 @@ add_json_node(JsonNodeType ntype, JsonValueType vtype, JsonEscapeType esc_type,
 		}
 		node->value.string = ptr;
 	}
-	rc = link_node(node);
-	if (rc) {
-		free_json_node(node);
-		fprintf(stderr, "Json link: out of memory\n");
+	if (jw->jw_state == JSON_WRITER_NEW)
+		start_json(jw);
+	rc = write_json_node(jw, node);
+	free_json_node(node);
+	if (rc)
 		return NULL;
-	}
 	return node;
 }
 
 /**
  * @brief
- *	generate_json_node
- *	Takes a JsonNode type link list and file stream as an input.
- * 	Reads the link-list node by node and write the json output
- * 	on the passed file stream.
+ *	write_json_node
+ *	Writes one node to the json document.
  *
- * @param[in] stream - fd to which json o/p written
+ * @param[in] jw - the writer
+ * @param[in] node - the node to write
  *
  * @return	int
  * @retval	0	success
  * @retval	1	error
  *
  */
-int
-generate_json(FILE * stream) {
-	int	  indent = 0;
-	int	  prnt_comma = 0;
+static int
+write_json_node(json_writer *jw, JsonNode *node) {
 	int	  last_object_value = 0;
 	int	  last_array_value = 0;
-	int	 *arr_lvl = NULL;
-	int	  curnt_arr_lvl= 0;
-	JsonNode *node = NULL;
-	JsonLink *link = head;
-
-	fprintf(stream, "{");
-	indent += 4;
-	arr_lvl = malloc(ARRAY_NESTING_LEVEL * sizeof(int*));
-	memset(arr_lvl, 0, (ARRAY_NESTING_LEVEL * sizeof(int)));
-
-	while (link) {
-		node = link->node;
-		switch (node->node_type) {
-			case JSON_OBJECT:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s{", indent, indent, " ");
-				else
-					fprintf(stream, "%*.*s\"%s\":{", indent, indent, " ", node->key);
-				indent += 4;
-				prnt_comma = 0;
-				/*moving to next node since there's no value associated within an OBJECT type node*/
-				link = link->next;
-				continue;
-
-			case JSON_OBJECT_END:
-				last_object_value = 1;
-				break;
+	FILE	 *stream = jw->jw_stream;
 
-			case JSON_ARRAY:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s[",indent,indent," ");
-				else
-					fprintf(stream, "%*.*s\"%s\":[", indent, indent, " ", node->key);
-				indent += 4;
-				prnt_comma = 0;
-				arr_lvl[curnt_arr_lvl+1] = indent;
-				curnt_arr_lvl++;
-				break;
+	switch (node->node_type) {
+		case JSON_OBJECT:
+			if (jw->jw_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+			if (jw->jw_arr_lvl[jw->jw_curnt_arr_lvl] == jw->jw_indent)
+				fprintf(stream, "%*.*s{", jw->jw_indent, jw->jw_indent, " ");
+			else
+				fprintf(stream, "%*.*s\"%s\":{", jw->jw_indent, jw->jw_indent, " ", node->key);
+			jw->jw_indent += 4;
+			jw->jw_prnt_comma = 0;
+			/* there's no value associated within an OBJECT type node */
+			return 0;
 
-			case JSON_ARRAY_END:
-				last_array_value = 1;
-				break;
+		case JSON_OBJECT_END:
+			if (jw->jw_indent <= 0)
+				return 1;
+			last_object_value = 1;
+			break;
 
-			case JSON_VALUE:
-				break;
+		case JSON_ARRAY:
+			if (jw->jw_curnt_arr_lvl + 1 >= JSON_NESTING_LEVEL)
+				return 1;
+			if (jw->jw_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+			if (jw->jw_arr_lvl[jw->jw_curnt_arr_lvl] == jw->jw_indent)
+				fprintf(stream, "%*.*s[",jw->jw_indent,jw->jw_indent," ");
+			else
+				fprintf(stream, "%*.*s\"%s\":[", jw->jw_indent, jw->jw_indent, " ", node->key);
+			jw->jw_indent += 4;
+			jw->jw_prnt_comma = 0;
+			jw->jw_arr_lvl[jw->jw_curnt_arr_lvl+1] = jw->jw_indent;
+			jw->jw_curnt_arr_lvl++;
+			break;
 
-			default:
-				free(arr_lvl);
+		case JSON_ARRAY_END:
+			if (jw->jw_curnt_arr_lvl <= 0)
 				return 1;
-		}
-		switch (node->value_type) {
-			case JSON_STRING:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-				if (arr_lvl[curnt_arr_lvl]==indent)
-					fprintf(stream, "%*.*s\"%s\"", indent, indent, " ", show_nonprint_chars(node->value.string));
-				else
-					fprintf(stream, "%*.*s\"%s\":\"%s\"", indent, indent, " ", node->key, show_nonprint_chars(node->value.string));
-				prnt_comma = 1;
-				break;
+			last_array_value = 1;
+			break;
 
-			case JSON_INT:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s%ld",indent,indent," ", node->value.inumber);
-				else
-					fprintf(stream, "%*.*s\"%s\":%ld", indent, indent, " ", node->key, node->value.inumber);
-				prnt_comma = 1;
-				break;
-			case JSON_FLOAT:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-
-
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s%lf",indent,indent," ", node->value.fnumber);
-				else
-					fprintf(stream, "%*.*s\"%s\":%lf", indent, indent, " ", node->key, node->value.fnumber);
-				prnt_comma = 1;
-				break;
-			case JSON_NUMERIC:
-				if (prnt_comma)
-					fprintf(stream, ",\n");
-				else
-					fprintf(stream, "\n");
-
-				if (arr_lvl[curnt_arr_lvl] == indent)
-					fprintf(stream, "%*.*s%s", indent, indent, " ", node->value.string);      /*print the string but type remain same*/
-				else
-					fprintf(stream, "%*.*s\"%s\":%s", indent, indent, " ", node->key, node->value.string); /* print the string but type remain same*/
-				prnt_comma = 1;
-				break;
+		case JSON_VALUE:
+			break;
 
+		default:
+			return 1;
+	}
+	switch (node->value_type) {
+		case JSON_STRING:
+			if (jw->jw_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+			if (jw->jw_arr_lvl[jw->jw_curnt_arr_lvl]==jw->jw_indent)
+				fprintf(stream, "%*.*s\"%s\"", jw->jw_indent, jw->jw_indent, " ", show_nonprint_chars(node->value.string));
+			else
+				fprintf(stream, "%*.*s\"%s\":\"%s\"", jw->jw_indent, jw->jw_indent, " ", node->key, show_nonprint_chars(node->value.string));
+			jw->jw_prnt_comma = 1;
+			break;
 
-			case JSON_NULL:
-				break;
+		case JSON_INT:
+			if (jw->jw_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
 
-			default:
-				free(arr_lvl);
-				return 1;
-		}
+			if (jw->jw_arr_lvl[jw->jw_curnt_arr_lvl] == jw->jw_indent)
+				fprintf(stream, "%*.*s%ld",jw->jw_indent,jw->jw_indent," ", node->value.inumber);
+			else
+				fprintf(stream, "%*.*s\"%s\":%ld", jw->jw_indent, jw->jw_indent, " ", node->key, node->value.inumber);
+			jw->jw_prnt_comma = 1;
+			break;
+		case JSON_FLOAT:
+			if (jw->jw_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
 
-		if (last_array_value) {
-			indent -= 4;
-			fprintf(stream, "\n%*.*s]", indent, indent, " ");
-			last_array_value = 0;
-			curnt_arr_lvl--;
-			prnt_comma = 1;
-		} else if (last_object_value) {
-			indent -= 4;
-			fprintf(stream, "\n%*.*s}", indent, indent, " ");
-			last_object_value = 0;
-			prnt_comma = 1;
-		}
-		link = link->next;
+
+			if (jw->jw_arr_lvl[jw->jw_curnt_arr_lvl] == jw->jw_indent)
+				fprintf(stream, "%*.*s%lf",jw->jw_indent,jw->jw_indent," ", node->value.fnumber);
+			else
+				fprintf(stream, "%*.*s\"%s\":%lf", jw->jw_indent, jw->jw_indent, " ", node->key, node->value.fnumber);
+			jw->jw_prnt_comma = 1;
+			break;
+		case JSON_NUMERIC:
+			if (jw->jw_prnt_comma)
+				fprintf(stream, ",\n");
+			else
+				fprintf(stream, "\n");
+
+			if (jw->jw_arr_lvl[jw->jw_curnt_arr_lvl] == jw->jw_indent)
+				fprintf(stream, "%*.*s%s", jw->jw_indent, jw->jw_indent, " ", node->value.string);      /*print the string but type remain same*/
+			else
+				fprintf(stream, "%*.*s\"%s\":%s", jw->jw_indent, jw->jw_indent, " ", node->key, node->value.string); /* print the string but type remain same*/
+			jw->jw_prnt_comma = 1;
+			break;
+
+
+		case JSON_NULL:
+			break;
+
+		default:
+			return 1;
+	}
+
+	if (last_array_value) {
+		jw->jw_indent -= 4;
+		fprintf(stream, "\n%*.*s]", jw->jw_indent, jw->jw_indent, " ");
+		jw->jw_curnt_arr_lvl--;
+		jw->jw_prnt_comma = 1;
+	} else if (last_object_value) {
+		jw->jw_indent -= 4;
+		fprintf(stream, "\n%*.*s}", jw->jw_indent, jw->jw_indent, " ");
+		jw->jw_prnt_comma = 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	generate_json
+ *	Ends the json document whose nodes add_json_node() has written so
+ *	far, starting it first if no node was added.  Any object or array
+ *	left open is closed first.
+ *
+ * @param[in] jw - the writer
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	1	containers had to be closed, or the document was ended
+ *			already
+ *
+ */
+int
+generate_json(json_writer *jw) {
+	FILE *stream = jw->jw_stream;
+	int rc = 0;
+
+	if (jw->jw_state == JSON_WRITER_DONE)
+		return 1;
+	if (jw->jw_state == JSON_WRITER_NEW)
+		start_json(jw);
+	jw->jw_state = JSON_WRITER_DONE;
+	while (jw->jw_indent > 4) {
+		jw->jw_indent -= 4;
+		if (jw->jw_curnt_arr_lvl > 0 &&
+			jw->jw_arr_lvl[jw->jw_curnt_arr_lvl] == jw->jw_indent + 4) {
+			fprintf(stream, "\n%*.*s]", jw->jw_indent, jw->jw_indent, " ");
+			jw->jw_curnt_arr_lvl--;
+		} else
+			fprintf(stream, "\n%*.*s}", jw->jw_indent, jw->jw_indent, " ");
+		rc = 1;
 	}
-	free(arr_lvl);
-	indent -= 4;
-	if (indent != 0)
+	if (jw->jw_indent <= 0) {
+		/* the caller closed the document itself */
+		fprintf(stream, "\n");
 		return 1;
+	}
+	jw->jw_indent = 0;
 	fprintf(stream, "\n}\n");
-	return 0;
+	return rc;
+}
+
+/**
+ * @brief
+ *	End a json document that was started and not ended yet, e.g. when
+ *	the command exits on an error part way through its output.
+ *
+ * @param[in] jw - the writer
+ *
+ * @return	void
+ */
+void
+close_json(json_writer *jw)
+{
+	if (jw->jw_state == JSON_WRITER_OPEN)
+		(void)generate_json(jw);
+	fflush(jw->jw_stream);
 }
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    db_backend.c
+ *
+ * @brief
+ *	Implementation of the pbs_db.h interface on top of the configured
+ *	datastore backend.
+ *
+ *	Every connection handle returned to the caller wraps the handle of the
+ *	backend that created it, so a process (like pbs_ds_migrate) can hold
+ *	connections to both backends at the same time. Calls that are not tied
+ *	to a connection go to the backend named by PBS_DATA_SERVICE_BACKEND.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+#include <stdio.h>
+#include <strings.h>
+#include "pbs_internal.h"
+#include "libutil.h"
+#include "db_backend.h"
+
+struct db_backend_conn {
+	pbs_db_backend_t *be;	/* backend that owns the connection */
+	void *conn;		/* the backend's own connection handle */
+	int in_pipeline;	/* between begin_pipeline and end_pipeline */
+};
+
+static pbs_db_backend_t *db_backends[] = {
+	&pg_db_backend,
+	&emb_db_backend
+};
+
+/* backend whose error the next pbs_db_get_errmsg(PBS_DB_ERR) reports */
+static pbs_db_backend_t *last_be = NULL;
+
+/**
+ * @brief
+ *	Find a backend by name
+ *
+ * @param[in]	name - backend name, NULL for the one configured in pbs.conf
+ *
+ * @return	pbs_db_backend_t *
+ * @retval	NULL - no such backend
+ *
+ */
+static pbs_db_backend_t *
+find_backend(char *name)
+{
+	size_t i;
+
+	if (name == NULL)
+		name = pbs_conf.pbs_data_service_backend;
+	if (name == NULL || *name == '\0')
+		return &pg_db_backend;
+
+	for (i = 0; i < sizeof(db_backends) / sizeof(db_backends[0]); i++) {
+		if (strcasecmp(db_backends[i]->name, name) == 0)
+			return db_backends[i];
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	The backend configured in pbs.conf. PBS_DATA_SERVICE_BACKEND left
+ *	unset means pgsql, which is what older pbs.conf files expect; a value
+ *	naming no backend is an error, not a silent switch to pgsql.
+ *
+ * @return	pbs_db_backend_t *
+ * @retval	NULL - PBS_DATA_SERVICE_BACKEND names no known backend
+ */
+static pbs_db_backend_t *
+default_backend(void)
+{
+	return (last_be = find_backend(NULL));
+}
+
+/**
+ * @brief
+ *	Return the name of the backend configured in pbs.conf
+ *
+ * @return	char *
+ * @retval	NULL - PBS_DATA_SERVICE_BACKEND names no known backend
+ */
+char *
+pbs_db_backend_name(void)
+{
+	pbs_db_backend_t *be;
+
+	if ((be = default_backend()) == NULL)
+		return NULL;
+	return be->name;
+}
+
+/**
+ * @brief
+ *	Connect to the given backend
+ *
+ * @param[out]	conn	- Initialized connecetion handler
+ * @param[in]	backend	- Backend name ("pgsql", "embedded"), NULL for the configured one
+ * @param[in]	readonly - only read the datastore, see pbs_db_connect_readonly
+ * @param[in]	host	- The name of the host on which database resides
+ * @param[in]	port	- The port number where database is running
+ * @param[in]	timeout	- The timeout value in seconds to attempt the connection
+ *
+ * @return	int
+ * @retval	!0 - Failure
+ * @retval	0 - Success
+ *
+ */
+static int
+db_connect(void **conn, char *backend, int readonly, char *host, int port, int timeout)
+{
+	struct db_backend_conn *bconn;
+	pbs_db_backend_t *be;
+	void *lconn = NULL;
+	int rc;
+
+	*conn = NULL;
+	if (backend == NULL)
+		be = default_backend();
+	else
+		be = find_backend(backend);
+	if ((last_be = be) == NULL)
+		return PBS_DB_ERR;
+
+	if (readonly)
+		rc = be->connect_readonly(&lconn, host, port, timeout);
+	else
+		rc = be->connect(&lconn, host, port, timeout);
+	if (rc != 0 || lconn == NULL)
+		return rc ? rc : PBS_DB_CONNFAILED;
+
+	if ((bconn = malloc(sizeof(struct db_backend_conn))) == NULL) {
+		be->disconnect(lconn);
+		return PBS_DB_NOMEM;
+	}
+	bconn->be = be;
+	bconn->conn = lconn;
+	bconn->in_pipeline = 0;
+	*conn = bconn;
+
+	return 0;
+}
+
+int
+pbs_db_connect_backend(void **conn, char *backend, char *host, int port, int timeout)
+{
+	return db_connect(conn, backend, 0, host, port, timeout);
+}
+
+int
+pbs_db_connect_readonly(void **conn, char *host, int port, int timeout)
+{
+	return db_connect(conn, NULL, 1, host, port, timeout);
+}
+
+int
+pbs_db_connect(void **conn, char *host, int port, int timeout)
+{
+	return pbs_db_connect_backend(conn, NULL, host, port, timeout);
+}
+
+int
+pbs_db_disconnect(void *conn)
+{
+	struct db_backend_conn *bconn = conn;
+	int rc;
+
+	if (bconn == NULL)
+		return -1;
+
+	last_be = bconn->be;
+	rc = bconn->be->disconnect(bconn->conn);
+	free(bconn);
+	return rc;
+}
+
+void
+pbs_db_close_fds(void *conn)
+{
+	struct db_backend_conn *bconn = conn;
+
+	if (bconn == NULL)
+		return;
+	bconn->be->close_fds(bconn->conn);
+}
+
+int
+pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
+{
+	struct db_backend_conn *bconn = conn;
+
+	last_be = bconn->be;
+	return bconn->be->save_obj(bconn->conn, obj, savetype);
+}
+
+int
+pbs_db_delete_obj(void *conn, pbs_db_obj_info_t *obj)
+{
+	struct db_backend_conn *bconn = conn;
+
+	last_be = bconn->be;
+	return bconn->be->delete_obj(bconn->conn, obj);
+}
+
+int
+pbs_db_delete_attr_obj(void *conn, pbs_db_obj_info_t *obj, void *obj_id, pbs_db_attr_list_t *db_attr_list)
+{
+	struct db_backend_conn *bconn = conn;
+
+	last_be = bconn->be;
+	return bconn->be->delete_attr_obj(bconn->conn, obj, obj_id, db_attr_list);
+}
+
+int
+pbs_db_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts, query_cb_t query_cb)
+{
+	struct db_backend_conn *bconn = conn;
+
+	last_be = bconn->be;
+	return bconn->be->search(bconn->conn, obj, opts, query_cb);
+}
+
+int
+pbs_db_load_obj(void *conn, pbs_db_obj_info_t *obj)
+{
+	struct db_backend_conn *bconn = conn;
+
+	last_be = bconn->be;
+	return bconn->be->load_obj(bconn->conn, obj);
+}
+
+void
+pbs_db_begin_pipeline(void *conn)
+{
+	struct db_backend_conn *bconn = conn;
+
+	if (bconn == NULL)
+		return;
+	bconn->in_pipeline = 1;
+	bconn->be->begin_pipeline(bconn->conn);
+}
+
+int
+pbs_db_end_pipeline(void *conn)
+{
+	struct db_backend_conn *bconn = conn;
+
+	if (bconn == NULL)
+		return 0;
+	last_be = bconn->be;
+	bconn->in_pipeline = 0;
+	return bconn->be->end_pipeline(bconn->conn);
+}
+
+int
+pbs_db_in_pipeline(void *conn)
+{
+	struct db_backend_conn *bconn = conn;
+
+	return (bconn != NULL && bconn->in_pipeline);
+}
+
+int
+pbs_db_password(void *conn, char *userid, char *password, char *olduser)
+{
+	struct db_backend_conn *bconn = conn;
+
+	last_be = bconn->be;
+	return bconn->be->password(bconn->conn, userid, password, olduser);
+}
+
+int
+pbs_status_db(char *pbs_ds_host, int pbs_ds_port)
+{
+	pbs_db_backend_t *be;
+
+	if ((be = default_backend()) == NULL)
+		return -1;
+	return be->status_db(pbs_ds_host, pbs_ds_port);
+}
+
+int
+pbs_start_db(char *pbs_ds_host, int pbs_ds_port)
+{
+	pbs_db_backend_t *be;
+
+	if ((be = default_backend()) == NULL)
+		return -1;
+	return be->start_db(pbs_ds_host, pbs_ds_port);
+}
+
+int
+pbs_stop_db(char *pbs_ds_host, int pbs_ds_port)
+{
+	pbs_db_backend_t *be;
+
+	if ((be = default_backend()) == NULL)
+		return -1;
+	return be->stop_db(pbs_ds_host, pbs_ds_port);
+}
+
+void
+pbs_db_get_errmsg(int err_code, char **err_msg)
+{
+	pbs_db_backend_t *be = last_be;
+
+	if (be == NULL && (be = default_backend()) == NULL) {
+		free(*err_msg);
+		*err_msg = NULL;
+		pbs_asprintf(err_msg, "Unknown %s value \"%s\"",
+			PBS_CONF_DATA_SERVICE_BACKEND, pbs_conf.pbs_data_service_backend);
+		return;
+	}
+	be->get_errmsg(err_code, err_msg);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ *
+ * @brief
+ *  Datastore backend interface
+ *
+ * The functions of pbs_db.h are implemented by a small dispatch layer
+ * (db_backend.c) which forwards every call to one of the backends below.
+ * Each backend fills in a pbs_db_backend_t with its implementation of the
+ * pbs_db.h entry points. The backend is picked from PBS_DATA_SERVICE_BACKEND
+ * in pbs.conf, so the rest of PBS never sees which one is in use.
+ *
+ * The functions/interfaces in this header are PBS Private.
+ */
+
+#ifndef _DB_BACKEND_H
+#define	_DB_BACKEND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "pbs_db.h"
+
+struct pbs_db_backend {
+	char *name;
+	int (*connect)(void **conn, char *host, int port, int timeout);
+	int (*connect_readonly)(void **conn, char *host, int port, int timeout);
+	int (*disconnect)(void *conn);
+	void (*close_fds)(void *conn);
+	int (*save_obj)(void *conn, pbs_db_obj_info_t *obj, int savetype);
+	int (*delete_obj)(void *conn, pbs_db_obj_info_t *obj);
+	int (*delete_attr_obj)(void *conn, pbs_db_obj_info_t *obj, void *obj_id, pbs_db_attr_list_t *db_attr_list);
+	int (*search)(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts, query_cb_t query_cb);
+	int (*load_obj)(void *conn, pbs_db_obj_info_t *obj);
+	void (*begin_pipeline)(void *conn);
+	int (*end_pipeline)(void *conn);
+	int (*status_db)(char *host, int port);
+	int (*start_db)(char *host, int port);
+	int (*stop_db)(char *host, int port);
+	void (*get_errmsg)(int err_code, char **err_msg);
+	int (*password)(void *conn, char *userid, char *password, char *olduser);
+};
+typedef struct pbs_db_backend pbs_db_backend_t;
+
+extern pbs_db_backend_t pg_db_backend;
+extern pbs_db_backend_t emb_db_backend;
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _DB_BACKEND_H */
@@ -0,0 +1,1364 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    db_emb_common.c
+ *
+ * @brief
+ *	Embedded datastore: in-memory object store, the append-only log and
+ *	its snapshots, connection handling and service control.
+ *
+ *	See db_embedded.h for the on-disk layout.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include "pbs_internal.h"
+#include "db_backend.h"
+#include "db_embedded.h"
+
+#define EMB_HASH_INIT	1024
+#define EMB_LOAD_TRIES	5
+#define EMB_MAX_REC_LEN	(1U << 30)	/* anything longer is garbage */
+
+struct emb_buf {
+	char *data;
+	size_t len;
+	size_t size;
+};
+
+struct emb_reader {
+	char *p;
+	size_t left;
+};
+
+static char *errmsg_cache = NULL;
+static emb_conn_t *rw_conn = NULL;	/* the connection holding the lock */
+static int emb_started = 0;		/* "service" started by pbs_start_db */
+static struct emb_buf recbuf = {NULL, 0, 0};
+
+/**
+ * @brief
+ *	Remember the error reported by the next pbs_db_get_errmsg(PBS_DB_ERR)
+ *
+ * @param[in]	fmt - printf style format, followed by its arguments
+ *
+ */
+void
+emb_set_error(const char *fmt, ...)
+{
+	char msg[MAXPATHLEN * 2];
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(msg, sizeof(msg), fmt, args);
+	va_end(args);
+
+	free(errmsg_cache);
+	errmsg_cache = strdup(msg);
+}
+
+/**
+ * @brief
+ *	FNV-1a hash of a buffer, used both for the index and as the record
+ *	checksum
+ */
+static uint32_t
+emb_hash(uint32_t h, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+
+	while (len-- > 0) {
+		h ^= *p++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static uint32_t
+emb_key_hash(int type, char *key)
+{
+	unsigned char t = (unsigned char) type;
+
+	return emb_hash(emb_hash(2166136261U, &t, 1), key, strlen(key));
+}
+
+/**
+ * @brief
+ *	Look up an object in the index
+ *
+ * @param[in]	conn - embedded datastore connection
+ * @param[in]	type - PBS_DB_* object type
+ * @param[in]	key  - object id
+ *
+ * @return	emb_obj_t *
+ * @retval	NULL - no such object
+ *
+ */
+emb_obj_t *
+emb_find(emb_conn_t *conn, int type, char *key)
+{
+	emb_obj_t *obj;
+
+	obj = conn->hash[emb_key_hash(type, key) & (conn->hash_size - 1)];
+	for (; obj != NULL; obj = obj->hnext) {
+		if (obj->type == type && strcmp(obj->key, key) == 0)
+			return obj;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Double the index once it holds as many objects as it has buckets
+ */
+static void
+emb_grow_hash(emb_conn_t *conn)
+{
+	emb_obj_t **nhash;
+	emb_obj_t *obj;
+	emb_obj_t *next;
+	int nsize = conn->hash_size * 2;
+	int i;
+
+	if ((nhash = calloc(nsize, sizeof(emb_obj_t *))) == NULL)
+		return; /* keep going with longer chains */
+
+	for (i = 0; i < conn->hash_size; i++) {
+		for (obj = conn->hash[i]; obj != NULL; obj = next) {
+			uint32_t h = emb_key_hash(obj->type, obj->key) & (nsize - 1);
+
+			next = obj->hnext;
+			obj->hnext = nhash[h];
+			nhash[h] = obj;
+		}
+	}
+	free(conn->hash);
+	conn->hash = nhash;
+	conn->hash_size = nsize;
+}
+
+/**
+ * @brief
+ *	Add a new, empty object to the store
+ *
+ * @param[in]	conn - embedded datastore connection
+ * @param[in]	type - PBS_DB_* object type
+ * @param[in]	key  - object id
+ *
+ * @return	emb_obj_t *
+ * @retval	NULL - out of memory
+ *
+ */
+emb_obj_t *
+emb_create(emb_conn_t *conn, int type, char *key)
+{
+	emb_obj_t *obj;
+	uint32_t h;
+
+	if ((obj = calloc(1, sizeof(emb_obj_t))) == NULL)
+		return NULL;
+	if ((obj->key = strdup(key)) == NULL) {
+		free(obj);
+		return NULL;
+	}
+	obj->type = type;
+	obj->seq = conn->next_seq++;
+
+	if (conn->count >= conn->hash_size)
+		emb_grow_hash(conn);
+	h = emb_key_hash(type, key) & (conn->hash_size - 1);
+	obj->hnext = conn->hash[h];
+	conn->hash[h] = obj;
+	conn->count++;
+
+	obj->prev = conn->tail[type];
+	if (conn->tail[type])
+		conn->tail[type]->next = obj;
+	else
+		conn->head[type] = obj;
+	conn->tail[type] = obj;
+
+	return obj;
+}
+
+static void
+emb_free_contents(emb_obj_t *obj)
+{
+	int i;
+
+	for (i = 0; i < EMB_MAX_STRS; i++) {
+		free(obj->str[i]);
+		obj->str[i] = NULL;
+	}
+	for (i = 0; i < obj->nattrs; i++) {
+		free(obj->attrs[i].name);
+		free(obj->attrs[i].resc);
+		free(obj->attrs[i].value);
+	}
+	free(obj->attrs);
+	obj->attrs = NULL;
+	obj->nattrs = 0;
+	obj->attr_size = 0;
+	free(obj->text);
+	obj->text = NULL;
+}
+
+/**
+ * @brief
+ *	Unlink an object from the store and free it
+ *
+ * @param[in]	conn - embedded datastore connection
+ * @param[in]	obj  - object to remove
+ *
+ */
+void
+emb_remove(emb_conn_t *conn, emb_obj_t *obj)
+{
+	emb_obj_t **pp;
+
+	pp = &conn->hash[emb_key_hash(obj->type, obj->key) & (conn->hash_size - 1)];
+	for (; *pp != NULL; pp = &(*pp)->hnext) {
+		if (*pp == obj) {
+			*pp = obj->hnext;
+			break;
+		}
+	}
+	conn->count--;
+
+	if (obj->prev)
+		obj->prev->next = obj->next;
+	else
+		conn->head[obj->type] = obj->next;
+	if (obj->next)
+		obj->next->prev = obj->prev;
+	else
+		conn->tail[obj->type] = obj->prev;
+
+	emb_free_contents(obj);
+	free(obj->key);
+	free(obj);
+}
+
+static void
+emb_remove_all(emb_conn_t *conn)
+{
+	int t;
+
+	for (t = 0; t < PBS_DB_NUM_TYPES; t++) {
+		while (conn->head[t])
+			emb_remove(conn, conn->head[t]);
+	}
+}
+
+/**
+ * @brief
+ *	Replace a string field of an object. NULL and "" are both stored as NULL.
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - out of memory
+ */
+int
+emb_set_str(char **dst, char *src)
+{
+	char *s = NULL;
+
+	if (src && *src != '\0' && (s = strdup(src)) == NULL)
+		return -1;
+	free(*dst);
+	*dst = s;
+	return 0;
+}
+
+static int
+emb_same_resc(char *a, char *b)
+{
+	if (a == NULL || *a == '\0')
+		return (b == NULL || *b == '\0');
+	return (b != NULL && strcmp(a, b) == 0);
+}
+
+static emb_attr_t *
+emb_find_attr(emb_obj_t *obj, char *name, char *resc)
+{
+	int i;
+
+	for (i = 0; i < obj->nattrs; i++) {
+		if (strcmp(obj->attrs[i].name, name) == 0 && emb_same_resc(obj->attrs[i].resc, resc))
+			return &obj->attrs[i];
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Set the attributes in attr_list on the object, replacing the value of
+ *	any attribute (name and resource) it already has
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - out of memory
+ */
+int
+emb_merge_attrs(emb_obj_t *obj, pbs_db_attr_list_t *attr_list)
+{
+	svrattrl *pal;
+	emb_attr_t *pa;
+
+	for (pal = (svrattrl *) GET_NEXT(attr_list->attrs); pal != NULL; pal = (svrattrl *) GET_NEXT(pal->al_link)) {
+		if ((pa = emb_find_attr(obj, pal->al_atopl.name, pal->al_atopl.resource)) == NULL) {
+			if (obj->nattrs == obj->attr_size) {
+				int nsize = obj->attr_size ? obj->attr_size * 2 : 16;
+				emb_attr_t *tmp = realloc(obj->attrs, nsize * sizeof(emb_attr_t));
+
+				if (tmp == NULL)
+					return -1;
+				obj->attrs = tmp;
+				obj->attr_size = nsize;
+			}
+			pa = &obj->attrs[obj->nattrs];
+			memset(pa, 0, sizeof(emb_attr_t));
+			if ((pa->name = strdup(pal->al_atopl.name)) == NULL)
+				return -1;
+			if (emb_set_str(&pa->resc, pal->al_atopl.resource) != 0) {
+				free(pa->name);
+				return -1;
+			}
+			obj->nattrs++;
+		}
+		if (emb_set_str(&pa->value, pal->al_atopl.value) != 0)
+			return -1;
+		pa->flags = pal->al_flags;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Remove the attributes named in attr_list from the object
+ *
+ * @return	int
+ * @retval	0 - success
+ */
+int
+emb_remove_attrs(emb_obj_t *obj, pbs_db_attr_list_t *attr_list)
+{
+	svrattrl *pal;
+	emb_attr_t *pa;
+
+	for (pal = (svrattrl *) GET_NEXT(attr_list->attrs); pal != NULL; pal = (svrattrl *) GET_NEXT(pal->al_link)) {
+		if ((pa = emb_find_attr(obj, pal->al_atopl.name, pal->al_atopl.resource)) == NULL)
+			continue;
+		free(pa->name);
+		free(pa->resc);
+		free(pa->value);
+		obj->nattrs--;
+		memmove(pa, pa + 1, (obj->nattrs - (pa - obj->attrs)) * sizeof(emb_attr_t));
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Build the attribute list of an object, as dbarray_to_attrlist does for
+ *	the rows read from PostgreSQL
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - out of memory
+ */
+int
+emb_get_attrs(emb_obj_t *obj, pbs_db_attr_list_t *attr_list)
+{
+	svrattrl *pal;
+	int i;
+
+	CLEAR_HEAD(attr_list->attrs);
+	attr_list->attr_count = 0;
+
+	for (i = 0; i < obj->nattrs; i++) {
+		pal = make_attr(obj->attrs[i].name, obj->attrs[i].resc, obj->attrs[i].value, obj->attrs[i].flags);
+		if (pal == NULL)
+			return -1;
+		append_link(&attr_list->attrs, &pal->al_link, pal);
+		attr_list->attr_count++;
+	}
+	return 0;
+}
+
+/*
+ * Record encoding helpers. Records are written in host byte order; the
+ * datastore is private to the server host.
+ */
+static int
+buf_put(struct emb_buf *b, const void *data, size_t len)
+{
+	if (b->len + len > b->size) {
+		size_t nsize = b->size ? b->size : 4096;
+		char *tmp;
+
+		while (nsize < b->len + len)
+			nsize *= 2;
+		if ((tmp = realloc(b->data, nsize)) == NULL)
+			return -1;
+		b->data = tmp;
+		b->size = nsize;
+	}
+	memcpy(b->data + b->len, data, len);
+	b->len += len;
+	return 0;
+}
+
+static int
+buf_put_i32(struct emb_buf *b, int32_t v)
+{
+	return buf_put(b, &v, sizeof(v));
+}
+
+static int
+buf_put_str(struct emb_buf *b, char *s)
+{
+	int32_t len = s ? (int32_t) strlen(s) : -1;
+
+	if (buf_put_i32(b, len) != 0)
+		return -1;
+	return (len > 0) ? buf_put(b, s, len) : 0;
+}
+
+static int
+rd_get(struct emb_reader *r, void *data, size_t len)
+{
+	if (r->left < len)
+		return -1;
+	memcpy(data, r->p, len);
+	r->p += len;
+	r->left -= len;
+	return 0;
+}
+
+/* decode a string written by buf_put_str, NULL stays NULL */
+static int
+rd_get_str(struct emb_reader *r, char **s)
+{
+	int32_t len;
+
+	*s = NULL;
+	if (rd_get(r, &len, sizeof(len)) != 0)
+		return -1;
+	if (len < 0)
+		return 0;
+	if ((size_t) len > r->left || (*s = malloc(len + 1)) == NULL)
+		return -1;
+	memcpy(*s, r->p, len);
+	(*s)[len] = '\0';
+	r->p += len;
+	r->left -= len;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Encode one record (header and payload) into recbuf
+ *
+ * @param[in]	op   - EMB_OP_*
+ * @param[in]	type - object type
+ * @param[in]	key  - object id (EMB_OP_DEL)
+ * @param[in]	obj  - object (EMB_OP_PUT)
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - out of memory
+ */
+static int
+emb_encode(int op, int type, char *key, emb_obj_t *obj)
+{
+	struct emb_buf *b = &recbuf;
+	emb_rec_hdr_t hdr;
+	int rc = 0;
+	int i;
+
+	b->len = 0;
+	memset(&hdr, 0, sizeof(hdr));
+	if (buf_put(b, &hdr, sizeof(hdr)) != 0)
+		return -1;
+
+	if (op == EMB_OP_DEL)
+		rc = buf_put_str(b, key);
+	else if (op == EMB_OP_PUT) {
+		uint8_t n;
+
+		rc |= buf_put_str(b, obj->key);
+		rc |= buf_put(b, &obj->seq, sizeof(obj->seq));
+		n = EMB_MAX_NUMS;
+		rc |= buf_put(b, &n, sizeof(n));
+		rc |= buf_put(b, obj->num, sizeof(obj->num));
+		n = EMB_MAX_STRS;
+		rc |= buf_put(b, &n, sizeof(n));
+		for (i = 0; i < EMB_MAX_STRS; i++)
+			rc |= buf_put_str(b, obj->str[i]);
+		rc |= buf_put_i32(b, obj->nattrs);
+		for (i = 0; i < obj->nattrs; i++) {
+			rc |= buf_put_str(b, obj->attrs[i].name);
+			rc |= buf_put_str(b, obj->attrs[i].resc);
+			rc |= buf_put_str(b, obj->attrs[i].value);
+			rc |= buf_put_i32(b, obj->attrs[i].flags);
+		}
+		rc |= buf_put_str(b, obj->text);
+	}
+	if (rc != 0)
+		return -1;
+
+	hdr.magic = EMB_REC_MAGIC;
+	hdr.len = b->len - sizeof(hdr);
+	hdr.cksum = emb_hash(2166136261U, b->data + sizeof(hdr), hdr.len);
+	hdr.op = op;
+	hdr.type = type;
+	memcpy(b->data, &hdr, sizeof(hdr));
+	return 0;
+}
+
+/**
+ * @brief
+ *	Apply one record read back from the snapshot or the log to the store
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - malformed record or out of memory
+ */
+static int
+emb_apply(emb_conn_t *conn, emb_rec_hdr_t *hdr, char *payload)
+{
+	struct emb_reader r = {payload, hdr->len};
+	emb_obj_t *obj;
+	char *key = NULL;
+	BIGINT seq;
+	uint8_t n;
+	int32_t nattrs;
+	int32_t flags;
+	int i;
+
+	if (hdr->type >= PBS_DB_NUM_TYPES && hdr->op != EMB_OP_CLEAR)
+		return -1;
+
+	switch (hdr->op) {
+		case EMB_OP_CLEAR:
+			emb_remove_all(conn);
+			return 0;
+
+		case EMB_OP_DEL:
+			if (rd_get_str(&r, &key) != 0 || key == NULL)
+				break;
+			if ((obj = emb_find(conn, hdr->type, key)) != NULL)
+				emb_remove(conn, obj);
+			free(key);
+			return 0;
+
+		case EMB_OP_PUT:
+			if (rd_get_str(&r, &key) != 0 || key == NULL || rd_get(&r, &seq, sizeof(seq)) != 0)
+				break;
+			if ((obj = emb_find(conn, hdr->type, key)) == NULL) {
+				if ((obj = emb_create(conn, hdr->type, key)) == NULL)
+					break;
+			} else
+				emb_free_contents(obj);
+			free(key);
+			key = NULL;
+			obj->seq = seq;
+			if (seq >= conn->next_seq)
+				conn->next_seq = seq + 1;
+
+			if (rd_get(&r, &n, sizeof(n)) != 0 || n != EMB_MAX_NUMS ||
+				rd_get(&r, obj->num, sizeof(obj->num)) != 0)
+				return -1;
+			if (rd_get(&r, &n, sizeof(n)) != 0 || n != EMB_MAX_STRS)
+				return -1;
+			for (i = 0; i < EMB_MAX_STRS; i++) {
+				if (rd_get_str(&r, &obj->str[i]) != 0)
+					return -1;
+			}
+			if (rd_get(&r, &nattrs, sizeof(nattrs)) != 0 || nattrs < 0)
+				return -1;
+			if (nattrs > 0) {
+				if ((obj->attrs = calloc(nattrs, sizeof(emb_attr_t))) == NULL)
+					return -1;
+				obj->attr_size = nattrs;
+			}
+			for (i = 0; i < nattrs; i++) {
+				emb_attr_t *pa = &obj->attrs[i];
+
+				obj->nattrs++;
+				if (rd_get_str(&r, &pa->name) != 0 || pa->name == NULL ||
+					rd_get_str(&r, &pa->resc) != 0 ||
+					rd_get_str(&r, &pa->value) != 0 ||
+					rd_get(&r, &flags, sizeof(flags)) != 0)
+					return -1;
+				pa->flags = flags;
+			}
+			if (rd_get_str(&r, &obj->text) != 0)
+				return -1;
+			return 0;
+
+		default:
+			break;
+	}
+	free(key);
+	return -1;
+}
+
+/**
+ * @brief
+ *	Read the records of a snapshot or log file into the store
+ *
+ * @param[in]	conn - embedded datastore connection
+ * @param[in]	path - file to read
+ * @param[out]	gen  - generation from the file header
+ * @param[out]	end  - offset just past the last intact record
+ *
+ * @return	int
+ * @retval	0 - every record read
+ * @retval	1 - the file ends in a torn record, *end is where it starts
+ * @retval	2 - the file does not exist
+ * @retval	-1 - error
+ */
+static int
+emb_replay(emb_conn_t *conn, char *path, uint32_t *gen, off_t *end)
+{
+	FILE *fp;
+	emb_file_hdr_t fhdr;
+	emb_rec_hdr_t hdr;
+	char *payload = NULL;
+	size_t psize = 0;
+	int rc = 0;
+
+	*end = 0;
+	if ((fp = fopen(path, "r")) == NULL) {
+		if (errno == ENOENT)
+			return 2;
+		emb_set_error("Unable to open %s: %s", path, strerror(errno));
+		return -1;
+	}
+
+	if (fread(&fhdr, sizeof(fhdr), 1, fp) != 1) {
+		/* a log that was being created when we crashed */
+		fclose(fp);
+		*gen = 0;
+		return 1;
+	}
+	if (fhdr.magic != EMB_FILE_MAGIC || fhdr.version != EMB_VERSION) {
+		fclose(fp);
+		emb_set_error("%s is not a PBS datastore file", path);
+		return -1;
+	}
+	*gen = fhdr.gen;
+	*end = sizeof(fhdr);
+
+	while (fread(&hdr, sizeof(hdr), 1, fp) == 1) {
+		if (hdr.magic != EMB_REC_MAGIC || hdr.len > EMB_MAX_REC_LEN) {
+			rc = 1;
+			break;
+		}
+		if (hdr.len > psize) {
+			char *tmp = realloc(payload, hdr.len);
+
+			if (tmp == NULL) {
+				emb_set_error("Out of memory reading %s", path);
+				rc = -1;
+				break;
+			}
+			payload = tmp;
+			psize = hdr.len;
+		}
+		if ((hdr.len > 0 && fread(payload, hdr.len, 1, fp) != 1) ||
+			emb_hash(2166136261U, payload, hdr.len) != hdr.cksum) {
+			rc = 1;
+			break;
+		}
+		if (emb_apply(conn, &hdr, payload) != 0) {
+			emb_set_error("Malformed record at offset %lld of %s", (long long) *end, path);
+			rc = -1;
+			break;
+		}
+		*end += sizeof(hdr) + hdr.len;
+	}
+	if (rc == 0 && ferror(fp)) {
+		emb_set_error("Error reading %s: %s", path, strerror(errno));
+		rc = -1;
+	} else if (rc == 0 && ftell(fp) != *end)
+		rc = 1; /* partial record header at the end */
+
+	free(payload);
+	fclose(fp);
+	return rc;
+}
+
+static int
+emb_write_all(int fd, char *data, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		if ((n = write(fd, data, len)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		data += n;
+		len -= n;
+	}
+	return 0;
+}
+
+static int
+emb_write_file_hdr(int fd, uint32_t gen)
+{
+	emb_file_hdr_t fhdr;
+
+	memset(&fhdr, 0, sizeof(fhdr));
+	fhdr.magic = EMB_FILE_MAGIC;
+	fhdr.version = EMB_VERSION;
+	fhdr.gen = gen;
+	return emb_write_all(fd, (char *) &fhdr, sizeof(fhdr));
+}
+
+/**
+ * @brief
+ *	Empty the log and start it over for generation gen
+ */
+static int
+emb_reset_log(emb_conn_t *conn, uint32_t gen)
+{
+	if (ftruncate(conn->log_fd, 0) != 0 ||
+		emb_write_file_hdr(conn->log_fd, gen) != 0 ||
+		fdatasync(conn->log_fd) != 0) {
+		emb_set_error("Unable to reset datastore log in %s: %s", conn->dir, strerror(errno));
+		return -1;
+	}
+	conn->log_size = sizeof(emb_file_hdr_t);
+	conn->unsynced = 0;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Write every live object to a new snapshot and start a new, empty log
+ *
+ *	The snapshot is written under a temporary name and renamed into place,
+ *	so a crash leaves either the old snapshot with the old log or the new
+ *	snapshot; a log left over from the old generation is then discarded
+ *	on the next load, as everything in it is in the new snapshot.
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure, the old snapshot and log are still in use
+ */
+static int
+emb_compact(emb_conn_t *conn)
+{
+	char tmp_path[MAXPATHLEN + 1];
+	char snap_path[MAXPATHLEN + 1];
+	emb_obj_t *obj;
+	off_t size = sizeof(emb_file_hdr_t);
+	int fd;
+	int t;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s/%s.new", conn->dir, EMB_SNAP_FILE);
+	snprintf(snap_path, sizeof(snap_path), "%s/%s", conn->dir, EMB_SNAP_FILE);
+
+	if ((fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)) == -1)
+		goto err;
+	if (emb_write_file_hdr(fd, conn->gen + 1) != 0)
+		goto err;
+	for (t = 0; t < PBS_DB_NUM_TYPES; t++) {
+		for (obj = conn->head[t]; obj != NULL; obj = obj->next) {
+			if (emb_encode(EMB_OP_PUT, t, NULL, obj) != 0 ||
+				emb_write_all(fd, recbuf.data, recbuf.len) != 0)
+				goto err;
+			size += recbuf.len;
+		}
+	}
+	if (fsync(fd) != 0 || close(fd) != 0) {
+		fd = -1;
+		goto err;
+	}
+	fd = -1;
+	if (rename(tmp_path, snap_path) != 0)
+		goto err;
+	if ((fd = open(conn->dir, O_RDONLY)) != -1) {
+		(void) fsync(fd);
+		close(fd);
+	}
+
+	conn->gen++;
+	conn->snap_size = size;
+	return emb_reset_log(conn, conn->gen);
+
+err:
+	emb_set_error("Unable to write datastore snapshot %s: %s", tmp_path, strerror(errno));
+	if (fd != -1)
+		close(fd);
+	unlink(tmp_path);
+	return -1;
+}
+
+static void
+emb_maybe_compact(emb_conn_t *conn)
+{
+	if (conn->log_size >= EMB_COMPACT_MIN && conn->log_size > conn->snap_size)
+		(void) emb_compact(conn);
+}
+
+/**
+ * @brief
+ *	Append the record in recbuf to the log and make it durable, unless a
+ *	pipeline is open, in which case the sync happens at its end
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure, the log is left as it was
+ */
+static int
+emb_log_append(emb_conn_t *conn)
+{
+	if (emb_write_all(conn->log_fd, recbuf.data, recbuf.len) != 0) {
+		emb_set_error("Unable to write datastore log in %s: %s", conn->dir, strerror(errno));
+		/* drop the partial record so later ones are not lost behind it */
+		(void) ftruncate(conn->log_fd, conn->log_size);
+		return -1;
+	}
+	conn->log_size += recbuf.len;
+
+	if (conn->in_pipeline) {
+		conn->unsynced = 1;
+		return 0;
+	}
+	if (fdatasync(conn->log_fd) != 0) {
+		emb_set_error("Unable to sync datastore log in %s: %s", conn->dir, strerror(errno));
+		return -1;
+	}
+	emb_maybe_compact(conn);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Check that the connection may change the datastore
+ *
+ * @return	int
+ * @retval	0 - writable
+ * @retval	-1 - the connection is read-only
+ */
+int
+emb_check_writable(emb_conn_t *conn)
+{
+	if (conn->readonly) {
+		emb_set_error("PBS datastore connection to %s is read-only", conn->dir);
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Log the current state of an object
+ */
+int
+emb_log_put(emb_conn_t *conn, emb_obj_t *obj)
+{
+	if (emb_encode(EMB_OP_PUT, obj->type, NULL, obj) != 0) {
+		emb_set_error("Out of memory saving %s", obj->key);
+		return -1;
+	}
+	return emb_log_append(conn);
+}
+
+/**
+ * @brief
+ *	Log the removal of an object
+ */
+int
+emb_log_del(emb_conn_t *conn, int type, char *key)
+{
+	if (emb_encode(EMB_OP_DEL, type, key, NULL) != 0) {
+		emb_set_error("Out of memory deleting %s", key);
+		return -1;
+	}
+	return emb_log_append(conn);
+}
+
+/**
+ * @brief
+ *	Remove every object from the store and log that
+ */
+int
+emb_log_clear(emb_conn_t *conn)
+{
+	if (emb_encode(EMB_OP_CLEAR, 0, NULL, NULL) != 0 || emb_log_append(conn) != 0)
+		return -1;
+	emb_remove_all(conn);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Read the generation from the header of a snapshot or log file
+ *
+ * @return	int
+ * @retval	0 - *gen is set
+ * @retval	1 - the file has no (complete) header
+ * @retval	2 - the file does not exist
+ */
+static int
+emb_file_gen(char *path, uint32_t *gen)
+{
+	emb_file_hdr_t fhdr;
+	FILE *fp;
+	int rc = 1;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return 2;
+	if (fread(&fhdr, sizeof(fhdr), 1, fp) == 1) {
+		*gen = fhdr.gen;
+		rc = 0;
+	}
+	fclose(fp);
+	return rc;
+}
+
+/**
+ * @brief
+ *	Load the snapshot and replay the log
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure
+ */
+static int
+emb_load(emb_conn_t *conn)
+{
+	char snap_path[MAXPATHLEN + 1];
+	char log_path[MAXPATHLEN + 1];
+	uint32_t snap_gen;
+	uint32_t log_gen;
+	off_t end;
+	int tries;
+	int rc;
+
+	snprintf(snap_path, sizeof(snap_path), "%s/%s", conn->dir, EMB_SNAP_FILE);
+	snprintf(log_path, sizeof(log_path), "%s/%s", conn->dir, EMB_LOG_FILE);
+
+	for (tries = 0; tries < EMB_LOAD_TRIES; tries++) {
+		emb_remove_all(conn);
+		conn->next_seq = 1;
+
+		snap_gen = 0;
+		if ((rc = emb_replay(conn, snap_path, &snap_gen, &end)) == -1)
+			return -1;
+		if (rc == 1) {
+			emb_set_error("Datastore snapshot %s is truncated", snap_path);
+			return -1;
+		}
+		conn->snap_size = (rc == 2) ? 0 : end;
+		conn->gen = snap_gen;
+
+		if (emb_file_gen(log_path, &log_gen) != 0) {
+			/* no log yet */
+			if (conn->readonly)
+				return 0;
+			return emb_reset_log(conn, snap_gen);
+		}
+		if (log_gen != snap_gen) {
+			if (conn->readonly)
+				continue; /* a writer compacted between the two reads */
+			if (log_gen < snap_gen) {
+				/* compaction finished but the log was not reset yet */
+				return emb_reset_log(conn, snap_gen);
+			}
+			emb_set_error("Datastore log %s is newer than snapshot %s", log_path, snap_path);
+			return -1;
+		}
+
+		if ((rc = emb_replay(conn, log_path, &log_gen, &end)) == -1)
+			return -1;
+		if (conn->readonly) {
+			if (rc == 2 || log_gen != snap_gen)
+				continue;
+			return 0;
+		}
+		if (rc == 1 && ftruncate(conn->log_fd, end) != 0) {
+			emb_set_error("Unable to truncate torn record in %s: %s", log_path, strerror(errno));
+			return -1;
+		}
+		conn->log_size = end;
+		return 0;
+	}
+
+	emb_set_error("Datastore in %s changed while being loaded", conn->dir);
+	return -1;
+}
+
+/**
+ * @brief
+ *	Try to take the datastore lock without waiting
+ *
+ * @param[in]	dir - datastore directory
+ *
+ * @return	int
+ * @retval	>=0 - descriptor holding the lock
+ * @retval	-1  - another process holds the lock
+ * @retval	-2  - the lock file cannot be opened
+ */
+static int
+emb_try_lock(char *dir)
+{
+	char path[MAXPATHLEN + 1];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, EMB_LOCK_FILE);
+	if ((fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600)) == -1)
+		return -2;
+	if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static void
+emb_dir(char *dir, size_t len)
+{
+	snprintf(dir, len, "%s/%s", pbs_conf.pbs_home_path ? pbs_conf.pbs_home_path : "", EMB_DS_DIR);
+}
+
+/**
+ * @brief
+ *	Open the embedded datastore. A writable connection takes the
+ *	datastore lock and fails if another process (a running server, say)
+ *	already holds it. A read-only connection (printjob while the server is
+ *	running) never takes the lock and sees the state at the time of
+ *	connect.
+ *
+ * @param[out]	db_conn - connection handle
+ * @param[in]	readonly - open read-only rather than writable
+ *
+ * @return	int - failcode
+ * @retval	0 - success
+ * @retval	!0 - PBS_DB_* error code
+ */
+static int
+emb_db_open(void **db_conn, int readonly)
+{
+	emb_conn_t *conn;
+	char path[MAXPATHLEN + 1];
+
+	*db_conn = NULL;
+	if ((conn = calloc(1, sizeof(emb_conn_t))) == NULL)
+		return PBS_DB_NOMEM;
+	conn->lock_fd = -1;
+	conn->log_fd = -1;
+	conn->readonly = readonly;
+	conn->hash_size = EMB_HASH_INIT;
+	if ((conn->hash = calloc(conn->hash_size, sizeof(emb_obj_t *))) == NULL) {
+		free(conn);
+		return PBS_DB_NOMEM;
+	}
+
+	emb_dir(conn->dir, sizeof(conn->dir));
+	if (mkdir(conn->dir, 0700) != 0 && errno != EEXIST) {
+		emb_set_error("Unable to create datastore directory %s: %s", conn->dir, strerror(errno));
+		goto err;
+	}
+
+	if (!readonly) {
+		if (rw_conn != NULL) {
+			emb_set_error("PBS datastore in %s is already open for writing", conn->dir);
+			goto err;
+		}
+		if ((conn->lock_fd = emb_try_lock(conn->dir)) < 0) {
+			if (conn->lock_fd == -1)
+				emb_set_error("PBS datastore in %s is in use by another process", conn->dir);
+			else
+				emb_set_error("Unable to open datastore lock in %s: %s", conn->dir, strerror(errno));
+			conn->lock_fd = -1;
+			goto err;
+		}
+		snprintf(path, sizeof(path), "%s/%s", conn->dir, EMB_LOG_FILE);
+		if ((conn->log_fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600)) == -1) {
+			emb_set_error("Unable to open datastore log %s: %s", path, strerror(errno));
+			goto err;
+		}
+	}
+
+	if (emb_load(conn) != 0)
+		goto err;
+
+	if (!conn->readonly)
+		rw_conn = conn;
+	*db_conn = conn;
+	return 0;
+
+err:
+	if (conn->log_fd != -1)
+		close(conn->log_fd);
+	if (conn->lock_fd != -1)
+		close(conn->lock_fd);
+	emb_remove_all(conn);
+	free(conn->hash);
+	free(conn);
+	return PBS_DB_CONNFAILED;
+}
+
+static int
+emb_db_connect(void **db_conn, char *host, int port, int timeout)
+{
+	return emb_db_open(db_conn, 0);
+}
+
+static int
+emb_db_connect_readonly(void **db_conn, char *host, int port, int timeout)
+{
+	return emb_db_open(db_conn, 1);
+}
+
+/**
+ * @brief
+ *	Close this process's copies of the lock and log descriptors in a
+ *	forked child. The parent keeps the lock; the child's handle becomes
+ *	read-only and must not be used for writing.
+ *
+ * @param[in]	db_conn - connection handle inherited from the parent
+ */
+static void
+emb_db_close_fds(void *db_conn)
+{
+	emb_conn_t *conn = db_conn;
+
+	if (conn == NULL)
+		return;
+	if (conn->log_fd != -1) {
+		close(conn->log_fd);
+		conn->log_fd = -1;
+	}
+	if (conn->lock_fd != -1) {
+		close(conn->lock_fd);
+		conn->lock_fd = -1;
+	}
+	conn->readonly = 1;
+	conn->in_pipeline = 0;
+	conn->unsynced = 0;
+	if (conn == rw_conn)
+		rw_conn = NULL;
+}
+
+static int
+emb_db_disconnect(void *db_conn)
+{
+	emb_conn_t *conn = db_conn;
+
+	if (conn == NULL)
+		return -1;
+
+	if (conn->log_fd != -1) {
+		if (conn->unsynced)
+			(void) fdatasync(conn->log_fd);
+		close(conn->log_fd);
+	}
+	if (conn->lock_fd != -1)
+		close(conn->lock_fd);	/* releases the lock */
+	if (conn == rw_conn) {
+		rw_conn = NULL;
+		emb_started = 0;
+	}
+	emb_remove_all(conn);
+	free(conn->hash);
+	free(conn);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Defer syncing the log until emb_db_end_pipeline, so a run of saves
+ *	costs a single sync
+ */
+static void
+emb_db_begin_pipeline(void *db_conn)
+{
+	emb_conn_t *conn = db_conn;
+
+	if (conn != NULL && !conn->readonly)
+		conn->in_pipeline = 1;
+}
+
+static int
+emb_db_end_pipeline(void *db_conn)
+{
+	emb_conn_t *conn = db_conn;
+
+	if (conn == NULL || !conn->in_pipeline)
+		return 0;
+
+	conn->in_pipeline = 0;
+	if (conn->unsynced) {
+		if (fdatasync(conn->log_fd) != 0) {
+			emb_set_error("Unable to sync datastore log in %s: %s", conn->dir, strerror(errno));
+			return -1;
+		}
+		conn->unsynced = 0;
+		emb_maybe_compact(conn);
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	The embedded datastore runs inside the process that connects to it;
+ *	it counts as "running" once started here, and as running elsewhere
+ *	while another process holds its lock.
+ *
+ * @return	int
+ * @retval	0 - running in this process
+ * @retval	1 - not running
+ * @retval	2 - in use by another process
+ */
+static int
+emb_status_db(char *host, int port)
+{
+	char dir[MAXPATHLEN + 1];
+	int fd;
+
+	if (rw_conn != NULL || emb_started)
+		return 0;
+
+	emb_dir(dir, sizeof(dir));
+	if ((fd = emb_try_lock(dir)) == -1)
+		return 2;
+	if (fd >= 0)
+		close(fd);
+	return 1;
+}
+
+static int
+emb_start_db(char *host, int port)
+{
+	char dir[MAXPATHLEN + 1];
+	int fd;
+
+	if (rw_conn == NULL) {
+		emb_dir(dir, sizeof(dir));
+		if ((fd = emb_try_lock(dir)) == -1) {
+			emb_set_error("PBS datastore in %s is in use by another process", dir);
+			return -1;
+		}
+		/* only checking; the connect takes the lock for real */
+		if (fd >= 0)
+			close(fd);
+	}
+	emb_started = 1;
+	return 0;
+}
+
+static int
+emb_stop_db(char *host, int port)
+{
+	emb_started = 0;
+	return 0;
+}
+
+static void
+emb_db_get_errmsg(int err_code, char **err_msg)
+{
+	if (*err_msg) {
+		free(*err_msg);
+		*err_msg = NULL;
+	}
+
+	switch (err_code) {
+		case PBS_DB_NOMEM:
+			*err_msg = strdup("PBS out of memory in connect");
+			break;
+
+		case PBS_DB_CONNFAILED:
+		case PBS_DB_ERR:
+			if (errmsg_cache)
+				*err_msg = strdup(errmsg_cache);
+			break;
+
+		default:
+			*err_msg = strdup("PBS datastore error");
+			break;
+	}
+}
+
+static int
+emb_db_password(void *conn, char *userid, char *password, char *olduser)
+{
+	emb_set_error("The embedded PBS datastore has no database users");
+	return -1;
+}
+
+/**
+ * Embedded implementation of the pbs_db.h interface
+ */
+pbs_db_backend_t emb_db_backend = {
+	PBS_DB_BACKEND_EMBEDDED,
+	emb_db_connect,
+	emb_db_connect_readonly,
+	emb_db_disconnect,
+	emb_db_close_fds,
+	emb_save_obj,
+	emb_delete_obj,
+	emb_delete_attr_obj,
+	emb_search,
+	emb_load_obj,
+	emb_db_begin_pipeline,
+	emb_db_end_pipeline,
+	emb_status_db,
+	emb_start_db,
+	emb_stop_db,
+	emb_db_get_errmsg,
+	emb_db_password
+};
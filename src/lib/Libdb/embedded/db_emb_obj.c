@@ -0,0 +1,598 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    db_emb_obj.c
+ *
+ * @brief
+ *	Embedded datastore: mapping of the pbs_db_*_info_t structures to the
+ *	generic stored objects, and the save, load, search and delete
+ *	operations. The semantics follow the PostgreSQL backend: a quick save
+ *	replaces the quick save fields, saved attributes are merged into the
+ *	existing ones, and an update of a missing object returns 1.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "db_embedded.h"
+
+/* positions of the quick save fields in emb_obj_t num[] and str[] */
+#define SVR_JOBIDNUMBER	0
+
+#define QUE_TYPE	0
+
+#define ND_INDEX	0
+#define ND_MOM_MODTIME	1
+#define ND_STATE	2
+#define ND_NTYPE	3
+#define ND_HOSTNAME	0
+#define ND_PQUE		1
+
+#define MIT_TIME	0
+#define MIT_GEN		1
+
+#define JI_STATE	0
+#define JI_SUBSTATE	1
+#define JI_SVRFLAGS	2
+#define JI_STIME	3
+#define JI_UN_TYPE	4
+#define JI_EXITSTAT	5
+#define JI_QUETIME	6
+#define JI_RTERETRY	7
+#define JI_FROMSOCK	8
+#define JI_FROMADDR	9
+#define JI_CREDTYPE	10
+#define JI_QRANK	11
+#define JI_QUEUE	0
+#define JI_DESTIN	1
+#define JI_JID		2
+
+#define RI_STATE	0
+#define RI_SUBSTATE	1
+#define RI_STIME	2
+#define RI_ETIME	3
+#define RI_DURATION	4
+#define RI_TACTIVE	5
+#define RI_SVRFLAGS	6
+#define RI_QUEUE	0
+
+static char *emb_type_name[PBS_DB_NUM_TYPES] = {
+	"server", "scheduler", "queue", "node", "mominfo_time", "job", "job script", "reservation"
+};
+
+/* copy a stored string into a fixed size field */
+#define GET_STR(dst, src) snprintf((dst), sizeof(dst), "%s", (src) ? (src) : "")
+
+/**
+ * @brief
+ *	Id of the object described by obj; the server and mominfo_time are
+ *	singletons with an empty id
+ */
+static char *
+emb_obj_key(pbs_db_obj_info_t *obj)
+{
+	switch (obj->pbs_db_obj_type) {
+		case PBS_DB_SCHED:
+			return obj->pbs_db_un.pbs_db_sched->sched_name;
+		case PBS_DB_QUEUE:
+			return obj->pbs_db_un.pbs_db_que->qu_name;
+		case PBS_DB_NODE:
+			return obj->pbs_db_un.pbs_db_node->nd_name;
+		case PBS_DB_JOB:
+			return obj->pbs_db_un.pbs_db_job->ji_jobid;
+		case PBS_DB_JOBSCR:
+			return obj->pbs_db_un.pbs_db_jobscr->ji_jobid;
+		case PBS_DB_RESV:
+			return obj->pbs_db_un.pbs_db_resv->ri_resvid;
+		default:
+			return "";
+	}
+}
+
+static pbs_db_attr_list_t *
+emb_obj_attrs(pbs_db_obj_info_t *obj)
+{
+	switch (obj->pbs_db_obj_type) {
+		case PBS_DB_SVR:
+			return &obj->pbs_db_un.pbs_db_svr->db_attr_list;
+		case PBS_DB_SCHED:
+			return &obj->pbs_db_un.pbs_db_sched->db_attr_list;
+		case PBS_DB_QUEUE:
+			return &obj->pbs_db_un.pbs_db_que->db_attr_list;
+		case PBS_DB_NODE:
+			return &obj->pbs_db_un.pbs_db_node->db_attr_list;
+		case PBS_DB_JOB:
+			return &obj->pbs_db_un.pbs_db_job->db_attr_list;
+		case PBS_DB_RESV:
+			return &obj->pbs_db_un.pbs_db_resv->db_attr_list;
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * @brief
+ *	Copy the quick save fields (and the script) of obj into the stored object
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - out of memory
+ */
+static int
+emb_put_fields(emb_obj_t *eo, pbs_db_obj_info_t *obj)
+{
+	pbs_db_node_info_t *pnd;
+	pbs_db_job_info_t *pj;
+	pbs_db_resv_info_t *pr;
+	int rc = 0;
+
+	switch (obj->pbs_db_obj_type) {
+		case PBS_DB_SVR:
+			eo->num[SVR_JOBIDNUMBER] = obj->pbs_db_un.pbs_db_svr->sv_jobidnumber;
+			break;
+
+		case PBS_DB_QUEUE:
+			eo->num[QUE_TYPE] = obj->pbs_db_un.pbs_db_que->qu_type;
+			break;
+
+		case PBS_DB_NODE:
+			pnd = obj->pbs_db_un.pbs_db_node;
+			eo->num[ND_INDEX] = pnd->nd_index;
+			eo->num[ND_MOM_MODTIME] = pnd->mom_modtime;
+			eo->num[ND_STATE] = pnd->nd_state;
+			eo->num[ND_NTYPE] = pnd->nd_ntype;
+			rc |= emb_set_str(&eo->str[ND_HOSTNAME], pnd->nd_hostname);
+			rc |= emb_set_str(&eo->str[ND_PQUE], pnd->nd_pque);
+			break;
+
+		case PBS_DB_MOMINFO_TIME:
+			eo->num[MIT_TIME] = obj->pbs_db_un.pbs_db_mominfo_tm->mit_time;
+			eo->num[MIT_GEN] = obj->pbs_db_un.pbs_db_mominfo_tm->mit_gen;
+			break;
+
+		case PBS_DB_JOB:
+			pj = obj->pbs_db_un.pbs_db_job;
+			eo->num[JI_STATE] = pj->ji_state;
+			eo->num[JI_SUBSTATE] = pj->ji_substate;
+			eo->num[JI_SVRFLAGS] = pj->ji_svrflags;
+			eo->num[JI_STIME] = pj->ji_stime;
+			eo->num[JI_UN_TYPE] = pj->ji_un_type;
+			eo->num[JI_EXITSTAT] = pj->ji_exitstat;
+			eo->num[JI_QUETIME] = pj->ji_quetime;
+			eo->num[JI_RTERETRY] = pj->ji_rteretry;
+			eo->num[JI_FROMSOCK] = pj->ji_fromsock;
+			eo->num[JI_FROMADDR] = pj->ji_fromaddr;
+			eo->num[JI_CREDTYPE] = pj->ji_credtype;
+			eo->num[JI_QRANK] = pj->ji_qrank;
+			rc |= emb_set_str(&eo->str[JI_QUEUE], pj->ji_queue);
+			rc |= emb_set_str(&eo->str[JI_DESTIN], pj->ji_destin);
+			rc |= emb_set_str(&eo->str[JI_JID], pj->ji_jid);
+			break;
+
+		case PBS_DB_JOBSCR:
+			rc = emb_set_str(&eo->text, obj->pbs_db_un.pbs_db_jobscr->script);
+			break;
+
+		case PBS_DB_RESV:
+			pr = obj->pbs_db_un.pbs_db_resv;
+			eo->num[RI_STATE] = pr->ri_state;
+			eo->num[RI_SUBSTATE] = pr->ri_substate;
+			eo->num[RI_STIME] = pr->ri_stime;
+			eo->num[RI_ETIME] = pr->ri_etime;
+			eo->num[RI_DURATION] = pr->ri_duration;
+			eo->num[RI_TACTIVE] = pr->ri_tactive;
+			eo->num[RI_SVRFLAGS] = pr->ri_svrflags;
+			rc |= emb_set_str(&eo->str[RI_QUEUE], pr->ri_queue);
+			break;
+
+		default:
+			break;
+	}
+	return rc ? -1 : 0;
+}
+
+/**
+ * @brief
+ *	Fill obj from a stored object: id, quick save fields, attributes
+ *	and script
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - out of memory
+ */
+static int
+emb_get_fields(emb_obj_t *eo, pbs_db_obj_info_t *obj)
+{
+	pbs_db_attr_list_t *attr_list;
+	pbs_db_node_info_t *pnd;
+	pbs_db_job_info_t *pj;
+	pbs_db_resv_info_t *pr;
+
+	switch (obj->pbs_db_obj_type) {
+		case PBS_DB_SVR:
+			obj->pbs_db_un.pbs_db_svr->sv_jobidnumber = eo->num[SVR_JOBIDNUMBER];
+			break;
+
+		case PBS_DB_SCHED:
+			GET_STR(obj->pbs_db_un.pbs_db_sched->sched_name, eo->key);
+			break;
+
+		case PBS_DB_QUEUE:
+			GET_STR(obj->pbs_db_un.pbs_db_que->qu_name, eo->key);
+			obj->pbs_db_un.pbs_db_que->qu_type = eo->num[QUE_TYPE];
+			break;
+
+		case PBS_DB_NODE:
+			pnd = obj->pbs_db_un.pbs_db_node;
+			GET_STR(pnd->nd_name, eo->key);
+			pnd->nd_index = eo->num[ND_INDEX];
+			pnd->mom_modtime = eo->num[ND_MOM_MODTIME];
+			pnd->nd_state = eo->num[ND_STATE];
+			pnd->nd_ntype = eo->num[ND_NTYPE];
+			GET_STR(pnd->nd_hostname, eo->str[ND_HOSTNAME]);
+			GET_STR(pnd->nd_pque, eo->str[ND_PQUE]);
+			break;
+
+		case PBS_DB_MOMINFO_TIME:
+			obj->pbs_db_un.pbs_db_mominfo_tm->mit_time = eo->num[MIT_TIME];
+			obj->pbs_db_un.pbs_db_mominfo_tm->mit_gen = eo->num[MIT_GEN];
+			break;
+
+		case PBS_DB_JOB:
+			pj = obj->pbs_db_un.pbs_db_job;
+			GET_STR(pj->ji_jobid, eo->key);
+			pj->ji_state = eo->num[JI_STATE];
+			pj->ji_substate = eo->num[JI_SUBSTATE];
+			pj->ji_svrflags = eo->num[JI_SVRFLAGS];
+			pj->ji_stime = eo->num[JI_STIME];
+			pj->ji_un_type = eo->num[JI_UN_TYPE];
+			pj->ji_exitstat = eo->num[JI_EXITSTAT];
+			pj->ji_quetime = eo->num[JI_QUETIME];
+			pj->ji_rteretry = eo->num[JI_RTERETRY];
+			pj->ji_fromsock = eo->num[JI_FROMSOCK];
+			pj->ji_fromaddr = eo->num[JI_FROMADDR];
+			pj->ji_credtype = eo->num[JI_CREDTYPE];
+			pj->ji_qrank = eo->num[JI_QRANK];
+			GET_STR(pj->ji_queue, eo->str[JI_QUEUE]);
+			GET_STR(pj->ji_destin, eo->str[JI_DESTIN]);
+			GET_STR(pj->ji_jid, eo->str[JI_JID]);
+			break;
+
+		case PBS_DB_JOBSCR:
+			if ((obj->pbs_db_un.pbs_db_jobscr->script = strdup(eo->text ? eo->text : "")) == NULL)
+				return -1;
+			break;
+
+		case PBS_DB_RESV:
+			pr = obj->pbs_db_un.pbs_db_resv;
+			GET_STR(pr->ri_resvid, eo->key);
+			pr->ri_state = eo->num[RI_STATE];
+			pr->ri_substate = eo->num[RI_SUBSTATE];
+			pr->ri_stime = eo->num[RI_STIME];
+			pr->ri_etime = eo->num[RI_ETIME];
+			pr->ri_duration = eo->num[RI_DURATION];
+			pr->ri_tactive = eo->num[RI_TACTIVE];
+			pr->ri_svrflags = eo->num[RI_SVRFLAGS];
+			GET_STR(pr->ri_queue, eo->str[RI_QUEUE]);
+			break;
+
+		default:
+			break;
+	}
+
+	if ((attr_list = emb_obj_attrs(obj)) != NULL)
+		return emb_get_attrs(eo, attr_list);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Insert or update an object
+ *
+ * @param[in]	conn - embedded datastore connection
+ * @param[in]	obj  - object to save
+ * @param[in]	savetype - OBJ_SAVE_NEW and/or OBJ_SAVE_QS
+ *
+ * @return	int
+ * @retval	-1 - failure
+ * @retval	 0 - success
+ * @retval	 1 - update of an object that does not exist
+ */
+int
+emb_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
+{
+	emb_conn_t *c = conn;
+	int type = obj->pbs_db_obj_type;
+	char *key = emb_obj_key(obj);
+	pbs_db_attr_list_t *attr_list = emb_obj_attrs(obj);
+	int has_attrs = (attr_list != NULL && attr_list->attr_count > 0);
+	emb_obj_t *eo;
+
+	if (emb_check_writable(c) != 0)
+		return -1;
+
+	if (type == PBS_DB_JOBSCR)
+		savetype = OBJ_SAVE_NEW;
+
+	if (savetype & OBJ_SAVE_NEW) {
+		/* a new server means a new datastore */
+		if (type == PBS_DB_SVR && emb_log_clear(c) != 0)
+			return -1;
+
+		if (emb_find(c, type, key) != NULL) {
+			emb_set_error("Insert of %s %s failed: duplicate key value", emb_type_name[type], key);
+			return -1;
+		}
+		if ((eo = emb_create(c, type, key)) == NULL ||
+			emb_put_fields(eo, obj) != 0 ||
+			(attr_list != NULL && emb_merge_attrs(eo, attr_list) != 0) ||
+			emb_log_put(c, eo) != 0) {
+			if (eo != NULL)
+				emb_remove(c, eo);
+			emb_set_error("Insert of %s %s failed", emb_type_name[type], key);
+			return -1;
+		}
+		return 0;
+	}
+
+	/* the server and mominfo_time have no quick save area of their own */
+	if (type == PBS_DB_SVR || type == PBS_DB_MOMINFO_TIME)
+		savetype |= OBJ_SAVE_QS;
+	if (!(savetype & OBJ_SAVE_QS) && !has_attrs)
+		return 0;
+
+	if ((eo = emb_find(c, type, key)) == NULL)
+		return 1;
+
+	if ((savetype & OBJ_SAVE_QS) && emb_put_fields(eo, obj) != 0)
+		goto err;
+	if (has_attrs && emb_merge_attrs(eo, attr_list) != 0)
+		goto err;
+	return emb_log_put(c, eo);
+
+err:
+	emb_set_error("Update of %s %s failed: out of memory", emb_type_name[type], key);
+	return -1;
+}
+
+/**
+ * @brief
+ *	Delete an object; deleting a job also deletes its script
+ *
+ * @return	int
+ * @retval	-1 - failure
+ * @retval	 0 - success
+ * @retval	 1 - no such object
+ */
+int
+emb_delete_obj(void *conn, pbs_db_obj_info_t *obj)
+{
+	emb_conn_t *c = conn;
+	int type = obj->pbs_db_obj_type;
+	char *key = emb_obj_key(obj);
+	emb_obj_t *eo;
+	int rc = 1;
+
+	if (emb_check_writable(c) != 0)
+		return -1;
+
+	if (type == PBS_DB_SVR || type == PBS_DB_MOMINFO_TIME) {
+		emb_set_error("Delete of %s is not supported", emb_type_name[type]);
+		return -1;
+	}
+
+	if ((eo = emb_find(c, type, key)) != NULL) {
+		if (emb_log_del(c, type, key) != 0)
+			return -1;
+		emb_remove(c, eo);
+		rc = 0;
+	}
+
+	if (type == PBS_DB_JOB && (eo = emb_find(c, PBS_DB_JOBSCR, key)) != NULL) {
+		if (emb_log_del(c, PBS_DB_JOBSCR, key) != 0)
+			return -1;
+		emb_remove(c, eo);
+	}
+
+	return rc;
+}
+
+/**
+ * @brief
+ *	Remove some attributes of an object
+ *
+ * @param[in]	conn - embedded datastore connection
+ * @param[in]	obj  - object type
+ * @param[in]	obj_id - object id (ignored for the server)
+ * @param[in]	attr_list - attributes to remove
+ *
+ * @return	int
+ * @retval	-1 - failure
+ * @retval	 0 - success
+ * @retval	 1 - no such object
+ */
+int
+emb_delete_attr_obj(void *conn, pbs_db_obj_info_t *obj, void *obj_id, pbs_db_attr_list_t *attr_list)
+{
+	emb_conn_t *c = conn;
+	int type = obj->pbs_db_obj_type;
+	emb_obj_t *eo;
+
+	if (emb_check_writable(c) != 0)
+		return -1;
+
+	if (type == PBS_DB_SVR || obj_id == NULL)
+		obj_id = "";
+	if ((eo = emb_find(c, type, obj_id)) == NULL)
+		return 1;
+
+	emb_remove_attrs(eo, attr_list);
+	return emb_log_put(c, eo);
+}
+
+/**
+ * @brief
+ *	Load a single object
+ *
+ * @return	int
+ * @retval	-1 - failure
+ * @retval	 0 - success
+ * @retval	 1 - no such object
+ */
+int
+emb_load_obj(void *conn, pbs_db_obj_info_t *obj)
+{
+	emb_obj_t *eo;
+
+	if ((eo = emb_find(conn, obj->pbs_db_obj_type, emb_obj_key(obj))) == NULL)
+		return 1;
+	if (emb_get_fields(eo, obj) != 0) {
+		emb_set_error("Load of %s %s failed: out of memory", emb_type_name[obj->pbs_db_obj_type], eo->key);
+		return -1;
+	}
+	return 0;
+}
+
+/* jobs are recovered in queue rank order */
+static int
+cmp_job_qrank(const void *a, const void *b)
+{
+	const emb_obj_t *x = *(emb_obj_t * const *) a;
+	const emb_obj_t *y = *(emb_obj_t * const *) b;
+
+	if (x->num[JI_QRANK] != y->num[JI_QRANK])
+		return (x->num[JI_QRANK] < y->num[JI_QRANK]) ? -1 : 1;
+	return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+/* nodes are recovered by index, then in creation order */
+static int
+cmp_node_index(const void *a, const void *b)
+{
+	const emb_obj_t *x = *(emb_obj_t * const *) a;
+	const emb_obj_t *y = *(emb_obj_t * const *) b;
+
+	if (x->num[ND_INDEX] != y->num[ND_INDEX])
+		return (x->num[ND_INDEX] < y->num[ND_INDEX]) ? -1 : 1;
+	return (x->seq < y->seq) ? -1 : (x->seq > y->seq);
+}
+
+/**
+ * @brief
+ *	Call query_cb for every object of the type of obj, in the order the
+ *	PostgreSQL backend returns them. The ids are collected up front, so
+ *	the callback may save or delete objects as it goes.
+ *
+ * @return	int
+ * @retval	-1 - failure
+ * @retval	>=0 - number of objects the callback refreshed
+ */
+int
+emb_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts, query_cb_t query_cb)
+{
+	emb_conn_t *c = conn;
+	int type = obj->pbs_db_obj_type;
+	char que[PBS_MAXQUEUENAME + 1] = "";
+	emb_obj_t **objs;
+	emb_obj_t *eo;
+	char **keys;
+	int n = 0;
+	int i;
+	int refreshed;
+	int totcount = 0;
+
+	if (type == PBS_DB_JOB && opts != NULL && opts->flags == FIND_JOBS_BY_QUE)
+		GET_STR(que, obj->pbs_db_un.pbs_db_job->ji_queue);
+
+	for (eo = c->head[type]; eo != NULL; eo = eo->next)
+		n++;
+	if (n == 0)
+		return 0;
+
+	if ((objs = malloc(n * sizeof(emb_obj_t *))) == NULL) {
+		emb_set_error("Search of %s failed: out of memory", emb_type_name[type]);
+		return -1;
+	}
+	for (n = 0, eo = c->head[type]; eo != NULL; eo = eo->next) {
+		if (que[0] != '\0' && (eo->str[JI_QUEUE] == NULL || strcmp(eo->str[JI_QUEUE], que) != 0))
+			continue;
+		objs[n++] = eo;
+	}
+	if (type == PBS_DB_JOB)
+		qsort(objs, n, sizeof(emb_obj_t *), cmp_job_qrank);
+	else if (type == PBS_DB_NODE)
+		qsort(objs, n, sizeof(emb_obj_t *), cmp_node_index);
+
+	if ((keys = malloc((n + 1) * sizeof(char *))) == NULL) {
+		free(objs);
+		emb_set_error("Search of %s failed: out of memory", emb_type_name[type]);
+		return -1;
+	}
+	for (i = 0; i < n; i++) {
+		if ((keys[i] = strdup(objs[i]->key)) == NULL)
+			break;
+	}
+	free(objs);
+	if (i < n) {
+		while (--i >= 0)
+			free(keys[i]);
+		free(keys);
+		emb_set_error("Search of %s failed: out of memory", emb_type_name[type]);
+		return -1;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (totcount >= 0 && (eo = emb_find(c, type, keys[i])) != NULL) {
+			if (emb_get_fields(eo, obj) != 0) {
+				emb_set_error("Search of %s failed: out of memory", emb_type_name[type]);
+				totcount = -1;
+			} else {
+				query_cb(obj, &refreshed);
+				if (refreshed)
+					totcount++;
+			}
+		}
+		free(keys[i]);
+	}
+	free(keys);
+
+	return totcount;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ *
+ * @brief
+ *  Embedded datastore implementation
+ *
+ * The embedded backend keeps every PBS object in memory, indexed by a hash
+ * table on (object type, object id), and makes each save durable by
+ * appending the new state of the object to a log file. When the log grows
+ * past the size of the last snapshot, the live objects are written to a new
+ * snapshot and the log is started afresh. Startup loads the snapshot and
+ * replays the log, so no separate database service is needed.
+ *
+ * Files live in PBS_HOME/server_priv/datastore:
+ *	lock	  - flock()ed by the one process that may write
+ *	snapshot  - all live objects as of the start of the current log
+ *	log	  - every change since the snapshot was taken
+ *
+ * Both files start with an emb_file_hdr_t; the generation in the log header
+ * must match the one in the snapshot header, which is how a reader notices
+ * that it raced with a compaction. Each record is an emb_rec_hdr_t followed
+ * by its payload; the payload checksum detects a record torn by a crash.
+ *
+ * The functions/interfaces in this header are PBS Private.
+ */
+
+#ifndef _DB_EMBEDDED_H
+#define	_DB_EMBEDDED_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "pbs_db.h"
+#include "list_link.h"
+#include "attribute.h"
+
+#define EMB_DS_DIR	"server_priv/datastore"
+#define EMB_LOCK_FILE	"lock"
+#define EMB_SNAP_FILE	"snapshot"
+#define EMB_LOG_FILE	"log"
+
+#define EMB_FILE_MAGIC	0x50425344	/* "PBSD" */
+#define EMB_REC_MAGIC	0x50425352	/* "PBSR" */
+#define EMB_VERSION	1
+
+/* compact only once the log is at least this big and bigger than the snapshot */
+#define EMB_COMPACT_MIN	(16 * 1024 * 1024)
+
+/* log record operations */
+#define EMB_OP_PUT	1	/* full new state of one object */
+#define EMB_OP_DEL	2	/* object removed */
+#define EMB_OP_CLEAR	3	/* every object removed (new server) */
+
+#define EMB_MAX_NUMS	12	/* numeric quick save fields of any object type */
+#define EMB_MAX_STRS	3	/* string quick save fields of any object type */
+
+typedef struct emb_file_hdr {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t gen;		/* snapshot generation the file belongs to */
+	uint32_t reserved;
+} emb_file_hdr_t;
+
+typedef struct emb_rec_hdr {
+	uint32_t magic;
+	uint32_t len;		/* length of the payload following the header */
+	uint32_t cksum;		/* checksum of the payload */
+	uint8_t op;		/* EMB_OP_* */
+	uint8_t type;		/* PBS_DB_* object type */
+	uint16_t reserved;
+} emb_rec_hdr_t;
+
+typedef struct emb_attr {
+	char *name;
+	char *resc;
+	char *value;
+	int flags;
+} emb_attr_t;
+
+/* one stored object, whatever its type */
+typedef struct emb_obj {
+	int type;
+	char *key;			/* object id, "" for the singletons */
+	BIGINT seq;			/* creation order */
+	BIGINT num[EMB_MAX_NUMS];
+	char *str[EMB_MAX_STRS];
+	int nattrs;
+	int attr_size;
+	emb_attr_t *attrs;
+	char *text;			/* job script */
+	struct emb_obj *hnext;		/* hash chain */
+	struct emb_obj *prev;		/* objects of the same type, */
+	struct emb_obj *next;		/* in creation order */
+} emb_obj_t;
+
+typedef struct emb_conn {
+	char dir[MAXPATHLEN + 1];
+	int readonly;			/* opened read-only, holds no lock */
+	int lock_fd;
+	int log_fd;
+	off_t log_size;
+	off_t snap_size;
+	uint32_t gen;
+	int in_pipeline;		/* defer the log sync to the end */
+	int unsynced;			/* log written but not synced */
+	BIGINT next_seq;
+	emb_obj_t **hash;
+	int hash_size;
+	int count;
+	emb_obj_t *head[PBS_DB_NUM_TYPES];
+	emb_obj_t *tail[PBS_DB_NUM_TYPES];
+} emb_conn_t;
+
+/* store, log and snapshot: db_emb_common.c */
+void emb_set_error(const char *fmt, ...);
+emb_obj_t *emb_find(emb_conn_t *conn, int type, char *key);
+emb_obj_t *emb_create(emb_conn_t *conn, int type, char *key);
+void emb_remove(emb_conn_t *conn, emb_obj_t *obj);
+int emb_set_str(char **dst, char *src);
+int emb_merge_attrs(emb_obj_t *obj, pbs_db_attr_list_t *attr_list);
+int emb_remove_attrs(emb_obj_t *obj, pbs_db_attr_list_t *attr_list);
+int emb_get_attrs(emb_obj_t *obj, pbs_db_attr_list_t *attr_list);
+int emb_log_put(emb_conn_t *conn, emb_obj_t *obj);
+int emb_log_del(emb_conn_t *conn, int type, char *key);
+int emb_log_clear(emb_conn_t *conn);
+int emb_check_writable(emb_conn_t *conn);
+
+/* object type specific operations: db_emb_obj.c */
+int emb_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype);
+int emb_delete_obj(void *conn, pbs_db_obj_info_t *obj);
+int emb_delete_attr_obj(void *conn, pbs_db_obj_info_t *obj, void *obj_id, pbs_db_attr_list_t *attr_list);
+int emb_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts, query_cb_t query_cb);
+int emb_load_obj(void *conn, pbs_db_obj_info_t *obj);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* _DB_EMBEDDED_H */
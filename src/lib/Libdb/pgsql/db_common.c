@@ -50,6 +50,7 @@
 #include <pbs_config.h> /* the master config generated by configure */
 #include "pbs_db.h"
 #include "db_postgres.h"
+#include "db_backend.h"
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -63,11 +64,20 @@
 
 #define IPV4_STR_LEN 15
 
+/*
+ * Number of statements queued in pipeline mode before the pipeline is synced
+ * and its results read back. Keeps the unread results small enough that
+ * neither end of the connection can block on a full socket buffer.
+ */
+#define DB_PIPELINE_MAX_PENDING 256
+
 char *errmsg_cache = NULL;
 pg_conn_data_t *conn_data = NULL;
 pg_conn_trx_t *conn_trx = NULL;
 static char pg_ctl[MAXPATHLEN + 1] = "";
 static char *pg_user = NULL;
+static int pipeline_pending = 0; /* statements queued since the last sync */
+static int pipeline_failed = 0; /* a statement failed since the pipeline began */
 
 static int is_conn_error(void *conn, int *failcode);
 static char *get_dataservice_password(char *user, char *errmsg, int len);
@@ -217,8 +227,8 @@ db_destroy_state(void *st)
  * @retval	>0	- Success and number of rows found
  *
  */
-int
-pbs_db_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts, query_cb_t query_cb)
+static int
+pg_db_search(void *conn, pbs_db_obj_info_t *obj, pbs_db_query_options_t *opts, query_cb_t query_cb)
 {
 	void *st;
 	int ret;
@@ -292,8 +302,8 @@ db_cursor_next(void *conn, void *st, pbs_db_obj_info_t *obj)
  * @retval	1   -  Success but no rows deleted
  *
  */
-int
-pbs_db_delete_obj(void *conn, pbs_db_obj_info_t *obj)
+static int
+pg_db_delete_obj(void *conn, pbs_db_obj_info_t *obj)
 {
 	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_delete_obj(conn, obj));
 }
@@ -313,8 +323,8 @@ pbs_db_delete_obj(void *conn, pbs_db_obj_info_t *obj)
  * @retval	 1 -  Success but no rows loaded
  *
  */
-int
-pbs_db_load_obj(void *conn, pbs_db_obj_info_t *obj)
+static int
+pg_db_load_obj(void *conn, pbs_db_obj_info_t *obj)
 {
 	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_load_obj(conn, obj));
 }
@@ -630,8 +640,8 @@ pbs_dataservice_control(char *cmd, char *pbs_ds_host, int pbs_ds_port)
  * @retval       2  - Data service running on another host
  *
  */
-int
-pbs_status_db(char *pbs_ds_host, int pbs_ds_port)
+static int
+pg_status_db(char *pbs_ds_host, int pbs_ds_port)
 {
 	return (pbs_dataservice_control(PBS_DB_CONTROL_STATUS, pbs_ds_host, pbs_ds_port));
 }
@@ -648,8 +658,8 @@ pbs_status_db(char *pbs_ds_host, int pbs_ds_port)
  * @retval       !=0   - Failure
  *
  */
-int
-pbs_start_db(char *pbs_ds_host, int pbs_ds_port)
+static int
+pg_start_db(char *pbs_ds_host, int pbs_ds_port)
 {
 	return (pbs_dataservice_control(PBS_DB_CONTROL_START, pbs_ds_host, pbs_ds_port));
 }
@@ -667,8 +677,8 @@ pbs_start_db(char *pbs_ds_host, int pbs_ds_port)
  * @retval        0  - Success
  *
  */
-int
-pbs_stop_db(char *pbs_ds_host, int pbs_ds_port)
+static int
+pg_stop_db(char *pbs_ds_host, int pbs_ds_port)
 {
 	return (pbs_dataservice_control(PBS_DB_CONTROL_STOP, pbs_ds_host, pbs_ds_port));
 }
@@ -688,8 +698,8 @@ pbs_stop_db(char *pbs_ds_host, int pbs_ds_port)
  * @retval        0  - Success
  *
  */
-int
-pbs_db_password(void *conn, char *userid, char *password, char *olduser)
+static int
+pg_db_password(void *conn, char *userid, char *password, char *olduser)
 {
 	char sqlbuff[1024];
 	char *pquoted = NULL;
@@ -785,8 +795,8 @@ is_conn_error(void *conn, int *failcode)
  * @retval      0 - Success
  *
  */
-int
-pbs_db_connect(void **db_conn, char *host, int port, int timeout)
+static int
+pg_db_connect(void **db_conn, char *host, int port, int timeout)
 {
 	int failcode = PBS_DB_SUCCESS;
 	int len = PBS_MAX_DB_CONN_INIT_ERR;
@@ -830,7 +840,7 @@ pbs_db_connect(void **db_conn, char *host, int port, int timeout)
 		if (db_prepare_sqls(*db_conn) != 0) {
 			/* this means there is programmatic/unrecoverable error, so we quit */
 			failcode = PBS_DB_ERR;
-			pbs_stop_db(host, port);
+			pg_stop_db(host, port);
 		}
 	}
 
@@ -854,8 +864,8 @@ db_cnerr:
  * @retval      -1  - Failure
  *
  */
-int
-pbs_db_disconnect(void *conn)
+static int
+pg_db_disconnect(void *conn)
 {
 	if (!conn)
 		return -1;
@@ -869,6 +879,23 @@ pbs_db_disconnect(void *conn)
 	return 0;
 }
 
+/**
+ * @brief
+ *	Close this process's copy of the database socket in a forked child,
+ *	without the goodbye PQfinish would send on the parent's session
+ *
+ * @param[in]	conn - Connected database handle inherited from the parent
+ *
+ */
+static void
+pg_db_close_fds(void *conn)
+{
+	int fd;
+
+	if (conn && (fd = PQsocket((PGconn *)conn)) != -1)
+		close(fd);
+}
+
 /**
  * @brief
  *	Saves a new object into the database
@@ -883,8 +910,8 @@ pbs_db_disconnect(void *conn)
  * @retval	 1  - Success but no rows inserted
  *
  */
-int
-pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
+static int
+pg_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
 {
 	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_save_obj(conn, obj, savetype));
 }
@@ -903,7 +930,8 @@ pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
  * @retval     -1  - Failure
  *
  */
-int pbs_db_delete_attr_obj(void *conn, pbs_db_obj_info_t *obj, void *obj_id, pbs_db_attr_list_t *db_attr_list)
+static int
+pg_db_delete_attr_obj(void *conn, pbs_db_obj_info_t *obj, void *obj_id, pbs_db_attr_list_t *db_attr_list)
 {
 	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_del_attr_obj(conn, obj_id, db_attr_list));
 }
@@ -981,6 +1009,146 @@ db_prepare_stmt(void *conn, char *stmt, char *sql, int num_vars)
 	return 0;
 }
 
+#ifdef LIBPQ_HAS_PIPELINING
+/**
+ * @brief
+ *	Sync the pipeline and read back the results of every statement queued
+ *	since the previous sync. The statements of one sync segment run as a
+ *	single implicit transaction, so a failed statement rolls back the
+ *	whole segment.
+ *
+ *	A failure is latched in pipeline_failed, with the message of the
+ *	first one, until pbs_db_end_pipeline reports it.  It cannot be told
+ *	to the caller whose statement happened to fill the segment, since the
+ *	saves rolled back with it were made by other callers.
+ *
+ * @param[in]	conn - The connnection handle
+ *
+ * @return      Error code
+ * @retval	-1 - One of the queued statements (or the sync) failed
+ * @retval	 0 - Success
+ *
+ */
+static int
+db_pipeline_sync(void *conn)
+{
+	PGresult *res;
+	int rc = 0;
+
+	pipeline_pending = 0;
+	if (PQpipelineSync((PGconn *)conn) != 1) {
+		if (!pipeline_failed)
+			db_set_error(conn, &errmsg_cache, "Pipeline", "sync", NULL);
+		pipeline_failed = 1;
+		return -1;
+	}
+
+	for (;;) {
+		res = PQgetResult((PGconn *)conn);
+		if (res == NULL) {
+			/* end of the results of one statement */
+			if (PQstatus((PGconn *)conn) == CONNECTION_BAD) {
+				if (!pipeline_failed)
+					db_set_error(conn, &errmsg_cache, "Pipeline", "sync", NULL);
+				pipeline_failed = 1;
+				return -1;
+			}
+			continue;
+		}
+
+		switch (PQresultStatus(res)) {
+			case PGRES_PIPELINE_SYNC:
+				PQclear(res);
+				if (rc != 0)
+					pipeline_failed = 1;
+				return rc;
+
+			case PGRES_FATAL_ERROR:
+				if (rc == 0 && !pipeline_failed)
+					db_set_error(conn, &errmsg_cache, "Execution of Pipelined statement", "",
+						PQresultErrorField(res, PG_DIAG_SQLSTATE));
+				rc = -1;
+				break;
+
+			case PGRES_PIPELINE_ABORTED:
+				rc = -1;
+				break;
+
+			default:
+				break;
+		}
+		PQclear(res);
+	}
+}
+#endif
+
+/**
+ * @brief
+ *	Switch the connection to pipeline mode. Until pbs_db_end_pipeline is
+ *	called, db_cmd only queues its statement and returns 0 without waiting
+ *	for the server, so a run of saves costs one round trip per
+ *	DB_PIPELINE_MAX_PENDING statements instead of one per statement.
+ *	Errors, including those found when a full segment is synced, are only
+ *	reported by pbs_db_end_pipeline, so a save that returned 0 while the
+ *	pipeline was open is not known to be stored until then. Queries cannot
+ *	be run while the pipeline is open.
+ *
+ *	If libpq does not support pipelining, or the connection cannot switch,
+ *	statements keep running synchronously and this is a no-op.
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ */
+static void
+pg_db_begin_pipeline(void *conn)
+{
+#ifdef LIBPQ_HAS_PIPELINING
+	if (conn == NULL || PQpipelineStatus((PGconn *)conn) != PQ_PIPELINE_OFF)
+		return;
+
+	pipeline_pending = 0;
+	pipeline_failed = 0;
+	(void) PQenterPipelineMode((PGconn *)conn);
+#endif
+}
+
+/**
+ * @brief
+ *	Flush the statements queued since pbs_db_begin_pipeline, wait for
+ *	their results and switch the connection back to synchronous mode.
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      Error code
+ * @retval	-1 - A queued statement failed, see pbs_db_get_errmsg
+ * @retval	 0 - Success, or the connection was not in pipeline mode
+ *
+ */
+static int
+pg_db_end_pipeline(void *conn)
+{
+	int rc = 0;
+
+#ifdef LIBPQ_HAS_PIPELINING
+	if (conn == NULL || PQpipelineStatus((PGconn *)conn) == PQ_PIPELINE_OFF)
+		return 0;
+
+	if (pipeline_pending > 0)
+		(void) db_pipeline_sync(conn);
+	if (pipeline_failed)
+		rc = -1;
+	pipeline_failed = 0;
+
+	if (PQexitPipelineMode((PGconn *)conn) != 1) {
+		if (rc == 0)
+			db_set_error(conn, &errmsg_cache, "Pipeline", "exit", NULL);
+		rc = -1;
+	}
+#endif
+
+	return rc;
+}
+
 /**
  * @brief
  *	Execute a prepared DML (insert or update) statement
@@ -991,7 +1159,8 @@ db_prepare_stmt(void *conn, char *stmt, char *sql, int num_vars)
  *
  * @return      Error code
  * @retval	-1 - Execution of prepared statement failed
- * @retval	 0 - Success and > 0 rows were affected
+ * @retval	 0 - Success and > 0 rows were affected, or, in pipeline mode,
+ *		     the statement was queued (see pg_db_begin_pipeline)
  * @retval	 1 - Execution succeeded but statement did not affect any rows
  *
  *
@@ -1002,6 +1171,24 @@ db_cmd(void *conn, char *stmt, int num_vars)
 	PGresult *res;
 	char *rows_affected = NULL;
 
+#ifdef LIBPQ_HAS_PIPELINING
+	if (PQpipelineStatus((PGconn *)conn) != PQ_PIPELINE_OFF) {
+		if (PQsendQueryPrepared((PGconn *)conn, stmt, num_vars,
+				conn_data->paramValues,
+				conn_data->paramLengths,
+				conn_data->paramFormats, 0) != 1) {
+			if (!pipeline_failed)
+				db_set_error(conn, &errmsg_cache, "Queueing of Prepared statement", stmt, NULL);
+			pipeline_failed = 1;
+			return 0;
+		}
+		/* a failed sync is latched for pbs_db_end_pipeline */
+		if (++pipeline_pending >= DB_PIPELINE_MAX_PENDING)
+			(void) db_pipeline_sync(conn);
+		return 0;
+	}
+#endif
+
 	res = PQexecPrepared((PGconn *)conn, stmt, num_vars,
 				conn_data->paramValues,
 				conn_data->paramLengths,
@@ -1046,6 +1233,15 @@ int
 db_query(void *conn, char *stmt, int num_vars, PGresult **res)
 {
 	int conn_result_format = 1;
+
+#ifdef LIBPQ_HAS_PIPELINING
+	if (PQpipelineStatus((PGconn *)conn) != PQ_PIPELINE_OFF) {
+		db_set_error(conn, &errmsg_cache, "Execution of Prepared statement", stmt, "not allowed in pipeline mode");
+		*res = NULL;
+		return -1;
+	}
+#endif
+
 	*res = PQexecPrepared((PGconn *)conn, stmt, num_vars,
 			conn_data->paramValues, conn_data->paramLengths,
 			conn_data->paramFormats, conn_result_format);
@@ -1326,8 +1522,8 @@ db_escape_str(void *conn, char *str)
  * @param[out]   err_msg - The translated error message (newly allocated memory)
  *
  */
-void
-pbs_db_get_errmsg(int err_code, char **err_msg)
+static void
+pg_db_get_errmsg(int err_code, char **err_msg)
 {
 	if (*err_msg) {
 		free(*err_msg);
@@ -1391,3 +1587,26 @@ db_ntohll(unsigned long long x)
 	 */
 	return (unsigned long long)(((unsigned long long)ntohl((x)&0xffffffff)) << 32) | ntohl(((unsigned long long)(x)) >> 32);
 }
+
+/**
+ * PostgreSQL implementation of the pbs_db.h interface
+ */
+pbs_db_backend_t pg_db_backend = {
+	PBS_DB_BACKEND_PGSQL,
+	pg_db_connect,
+	pg_db_connect,
+	pg_db_disconnect,
+	pg_db_close_fds,
+	pg_db_save_obj,
+	pg_db_delete_obj,
+	pg_db_delete_attr_obj,
+	pg_db_search,
+	pg_db_load_obj,
+	pg_db_begin_pipeline,
+	pg_db_end_pipeline,
+	pg_status_db,
+	pg_start_db,
+	pg_stop_db,
+	pg_db_get_errmsg,
+	pg_db_password
+};
@@ -324,8 +324,6 @@ typedef struct postgres_db_fn pg_db_fn_t;
 #define GET_PARAM_BIN(res, row, itm, fnum) \
 		(itm) = PQgetvalue((res), (row), (fnum));
 
-#define FIND_JOBS_BY_QUE 1
-
 /* common functions */
 int db_prepare_job_sqls(void *conn);
 int db_prepare_resv_sqls(void *conn);
@@ -134,6 +134,7 @@ add_connection(int fd)
 			free(connection[fd]->ch_errtxt);
 		connection[fd]->ch_errtxt = NULL;
 		connection[fd]->ch_errno = 0;
+		connection[fd]->ch_pending = 0;
 	}
 
 	return 0;
@@ -488,6 +489,79 @@ get_conn_chan(int fd)
 	return chan;
 }
 
+/**
+ * @brief
+ * 	adj_conn_pending - count a request sent on a connection, or a reply
+ * 	read in full from it
+ *
+ * @param[in] fd - socket number
+ * @param[in] delta - 1 for a request, -1 for a reply
+ *
+ * @return void
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ * @note
+ *	Only connections already in the table are counted, so a stream
+ *	which is not a client connection never gets an entry from this.
+ */
+void
+adj_conn_pending(int fd, int delta)
+{
+	if (INVALID_SOCK(fd) || fd >= curr_connection_sz)
+		return;
+
+	if (pbs_client_thread_init_thread_context() != 0 ||
+		pbs_client_thread_lock_conntable() != 0)
+		return;
+	if (fd < curr_connection_sz && connection[fd] != NULL) {
+		connection[fd]->ch_pending += delta;
+		if (connection[fd]->ch_pending < 0)
+			connection[fd]->ch_pending = 0;
+	}
+	(void)pbs_client_thread_unlock_conntable();
+}
+
+/**
+ * @brief
+ * 	get_conn_pending - get the number of requests sent on a connection
+ * 	whose reply has not been read in full
+ *
+ * @param[in] fd - socket number
+ *
+ * @return int
+ * @retval >= 0 - number of requests
+ * @retval -1 - error
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+get_conn_pending(int fd)
+{
+	pbs_conn_t *p = NULL;
+	int pending;
+
+	if (INVALID_SOCK(fd))
+		return -1;
+
+	LOCK_TABLE(-1);
+	p = get_connection(fd);
+	if (p == NULL) {
+		UNLOCK_TABLE(-1);
+		return -1;
+	}
+	pending = p->ch_pending;
+	UNLOCK_TABLE(-1);
+	return pending;
+}
+
 /**
  * @brief
  * 	get_conn_mutex - get connection mutex synchronously
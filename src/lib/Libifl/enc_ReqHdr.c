@@ -80,5 +80,7 @@ encode_DIS_ReqHdr(int sock, int reqt, char *user)
 		(rc = diswst(sock, user))) {
 		return rc;
 	}
+	/* a client daemon only reuses a connection with no reply owed on it */
+	adj_conn_pending(sock, 1);
 	return 0;
 }
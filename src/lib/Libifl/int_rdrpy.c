@@ -100,8 +100,10 @@ PBSD_rdrpy_sock(int sock, int *rc, int prot)
 	}
 
 	dis_reset_buf(sock, DIS_READ_BUF);
-	if (prot == PROT_TCP)
+	if (prot == PROT_TCP) {
 		pbs_tcp_timeout = old_timeout;
+		adj_conn_pending(sock, -1);
+	}
 
 	pbs_errno = reply->brp_code;
 	return reply;
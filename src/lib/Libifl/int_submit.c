@@ -288,7 +288,7 @@ PBSD_commit(int c, char *jobid, int prot, char **msgid, char *extend)
  * @retval      !0(pbs_errno)   failure
  *
  */
-static int
+int
 PBSD_scbuf(int c, int reqtype, int seq, char *buf, int len, char *jobid, enum job_file which, int prot, char **msgid)
 {
 	struct batch_reply   *reply;
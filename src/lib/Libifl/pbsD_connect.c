@@ -63,6 +63,12 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
+#ifndef WIN32
+#include <poll.h>
+#include <signal.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
 #include <pbs_ifl.h>
 #include "libpbs.h"
 #include "net_connect.h"
@@ -304,6 +310,467 @@ tcp_connect(char *hostname, int server_port, char *extend_data)
 	return sd;
 }
 
+#ifndef WIN32
+/*
+ * Client daemon
+ *
+ * A program opts in with pbs_client_daemon_enable(), which only the
+ * single threaded PBS commands do, through cnt2server().  When it has
+ * and PBS_CLIENT_DAEMON is set to 1 in the environment, the first
+ * command to connect to a server leaves a per-user daemon behind which
+ * holds authenticated connections to that server.  Later commands connect
+ * to the daemon over a unix domain socket and the daemon relays their
+ * requests and the replies packet by packet, so they skip the connect and
+ * authentication with the server.  The socket is only accessible by the
+ * user, in the same way as the socket of the background qsub, and like
+ * that socket its name depends on the pbs.conf file and the
+ * authentication method as well as on the server.  A command only uses a
+ * socket, and the daemon only serves a command, owned by the same user.
+ *
+ * A server connection goes back to the daemon's idle pool only when the
+ * command ends it with a CLIENT_DMN_DONE packet, which pbs_disconnect()
+ * sends when every request made on the connection has had its reply read
+ * in full.  A command which exits or fails part way through a reply never
+ * sends it, and its server connection is closed.
+ */
+#define CLIENT_DMN_TIMEOUT	60	/* idle seconds before the daemon exits */
+#define CLIENT_DMN_ACK_TIMEOUT	5	/* seconds to wait for the daemon to take a client */
+#define CLIENT_DMN_MAX_RELAYS	16	/* clients served at the same time */
+#define CLIENT_DMN_MAX_IDLE	4	/* server connections kept while unused */
+#define CLIENT_DMN_DONE		AUTH_LAST_MSG	/* packet type, never relayed */
+
+struct client_relay {
+	int cr_cfd;	/* connection from the command */
+	int cr_sfd;	/* connection to the server */
+	int cr_done;	/* the command finished cleanly, no reply is owed */
+};
+
+static int client_daemon_ok = 0;	/* set by pbs_client_daemon_enable() */
+
+/**
+ * @brief
+ *	Check whether commands should go through a client daemon.
+ *
+ * @return int
+ * @retval 1 - use the client daemon
+ * @retval 0 - connect to the server directly
+ */
+static int
+client_daemon_wanted(void)
+{
+	char *p;
+	unsigned int uvalue;
+
+	if (!client_daemon_ok)
+		return 0;
+	p = getenv(PBS_CONF_CLIENT_DAEMON);
+	return ((p != NULL) && (sscanf(p, "%u", &uvalue) == 1) && (uvalue > 0));
+}
+
+/**
+ * @brief
+ *	Form the name of the unix domain socket of the client daemon for a
+ *	server.  Like the name of the background qsub socket, it holds the
+ *	pbs.conf file path and the authentication method besides the uid and
+ *	the server, so that commands run with a different configuration never
+ *	share a daemon.
+ *
+ * @param[out] s_un - socket address to fill
+ * @param[in]  host - server host
+ * @param[in]  port - server port
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval -1 - the name does not fit, no daemon is used
+ */
+static int
+client_daemon_addr(struct sockaddr_un *s_un, char *host, uint port)
+{
+	char *conf = pbs_conf.pbs_conf_file ? pbs_conf.pbs_conf_file : "";
+	char *p;
+	int len;
+
+	memset(s_un, 0, sizeof(*s_un));
+	s_un->sun_family = AF_UNIX;
+	len = snprintf(s_un->sun_path, sizeof(s_un->sun_path), "%s/pbs_cmd_%lu_%s_%u_%s_%s_",
+		       pbs_conf.pbs_tmpdir, (unsigned long) getuid(), host, port,
+		       pbs_conf.auth_method, pbs_conf.encrypt_method);
+	if (len + strlen(conf) >= sizeof(s_un->sun_path))
+		return -1;
+	/* the conf file path goes in as one file name component */
+	for (p = s_un->sun_path + len; *conf != '\0'; conf++)
+		*p++ = (*conf == '/' || *conf == ' ' || *conf == '.') ? '_' : *conf;
+	*p = '\0';
+	return 0;
+}
+
+/**
+ * @brief
+ *	Check whether a connection is one to a client daemon.
+ *
+ * @param[in] sd - connection
+ *
+ * @return int
+ * @retval 1 - connection to a client daemon
+ * @retval 0 - connection to a server
+ */
+static int
+is_client_daemon_conn(int sd)
+{
+	struct sockaddr_storage addr;
+	pbs_socklen_t len = sizeof(addr);
+
+	if (getsockname(sd, (struct sockaddr *) &addr, &len) != 0)
+		return 0;
+	return (addr.ss_family == AF_UNIX);
+}
+
+/**
+ * @brief
+ *	Connect to the client daemon for a server.
+ *
+ * @param[in] host - server host
+ * @param[in] port - server port
+ *
+ * @return int
+ * @retval >= 0 - connection to the daemon, to be used as one to the server
+ * @retval -1 - no daemon is serving this server
+ */
+static int
+client_daemon_connect(char *host, uint port)
+{
+	struct sockaddr_un s_un;
+	struct stat sb;
+	struct pollfd pfd;
+	char ack;
+	int sd;
+
+	if (client_daemon_addr(&s_un, host, port) != 0)
+		return -1;
+	/* pbs_tmpdir is shared, only trust a socket the user owns */
+	if (lstat(s_un.sun_path, &sb) != 0 || !S_ISSOCK(sb.st_mode) ||
+	    sb.st_uid != getuid())
+		return -1;
+	if ((sd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return -1;
+	if (connect(sd, (struct sockaddr *) &s_un, sizeof(s_un)) != 0) {
+		/* the daemon has gone, remove its socket */
+		if (errno == ECONNREFUSED)
+			unlink(s_un.sun_path);
+		close(sd);
+		return -1;
+	}
+#ifdef SO_PEERCRED
+	{
+		struct ucred cred;
+		socklen_t len = sizeof(cred);
+
+		if (getsockopt(sd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 ||
+		    cred.uid != getuid()) {
+			close(sd);
+			return -1;
+		}
+	}
+#endif
+
+	/* the daemon sends one byte once it has a server connection for us */
+	pfd.fd = sd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if ((poll(&pfd, 1, CLIENT_DMN_ACK_TIMEOUT * 1000) != 1) ||
+	    (read(sd, &ack, 1) != 1)) {
+		close(sd);
+		return -1;
+	}
+
+	if (pbs_client_thread_init_connect_context(sd) != 0) {
+		close(sd);
+		return -1;
+	}
+	DIS_tcp_funcs();
+	pbs_strncpy(pbs_server, host, sizeof(pbs_server));
+	pbs_tcp_timeout = PBS_DIS_TCP_TIMEOUT_VLONG;
+
+	return sd;
+}
+
+/**
+ * @brief
+ *	Close a server connection held by the client daemon.
+ *
+ * @param[in] sd - connection
+ */
+static void
+client_daemon_close(int sd)
+{
+	closesocket(sd);
+	dis_destroy_chan(sd);
+	destroy_connection(sd);
+}
+
+/**
+ * @brief
+ *	Relay one packet from one connection to the other.  A
+ *	CLIENT_DMN_DONE packet from the command is not relayed.
+ *
+ * @param[in]  from  - connection to read the packet from
+ * @param[in]  to    - connection to write the packet to
+ * @param[out] ptype - type of the packet
+ *
+ * @return int
+ * @retval 0 - relayed
+ * @retval -1 - either connection failed or closed
+ */
+static int
+client_daemon_relay(int from, int to, int *ptype)
+{
+	void *data;
+	size_t len;
+
+	if (transport_recv_pkt(from, ptype, &data, &len) <= 0)
+		return -1;
+	if (*ptype == CLIENT_DMN_DONE)
+		return 0;
+	if (transport_send_pkt(to, *ptype, data, len) < 0)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	The body of the client daemon.  It listens on its unix domain socket
+ *	and gives each command that connects a server connection, reusing the
+ *	ones left by earlier commands.  It exits after CLIENT_DMN_TIMEOUT
+ *	seconds without a command.
+ *
+ * @param[in] host - server host
+ * @param[in] port - server port
+ *
+ * @return void
+ */
+static void
+client_daemon_run(char *host, uint port)
+{
+	struct sockaddr_un s_un;
+	struct client_relay relays[CLIENT_DMN_MAX_RELAYS];
+	int idle[CLIENT_DMN_MAX_IDLE];
+	struct pollfd pfds[1 + CLIENT_DMN_MAX_IDLE + 2 * CLIENT_DMN_MAX_RELAYS];
+	int nrelays = 0;
+	int nidle = 0;
+	int npolled;
+	int bindfd;
+	int npfds;
+	int i;
+	int n;
+	char ack = 0;
+
+	if (client_daemon_addr(&s_un, host, port) != 0)
+		return;
+	umask(0077);
+	signal(SIGPIPE, SIG_IGN);
+	if ((bindfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return;
+	/* another command may have started a daemon already */
+	if (bind(bindfd, (struct sockaddr *) &s_un, sizeof(s_un)) != 0) {
+		close(bindfd);
+		return;
+	}
+	if (listen(bindfd, CLIENT_DMN_MAX_RELAYS) != 0)
+		goto out;
+	if ((idle[0] = tcp_connect(host, port, NULL)) != -1)
+		nidle = 1;
+
+	while (1) {
+		npfds = 0;
+		pfds[npfds].fd = bindfd;
+		pfds[npfds++].events = POLLIN;
+		npolled = nidle;
+		for (i = 0; i < nidle; i++) {
+			pfds[npfds].fd = idle[i];
+			pfds[npfds++].events = POLLIN;
+		}
+		for (i = 0; i < nrelays; i++) {
+			pfds[npfds].fd = relays[i].cr_cfd;
+			pfds[npfds++].events = POLLIN;
+			pfds[npfds].fd = relays[i].cr_sfd;
+			pfds[npfds++].events = POLLIN;
+		}
+		for (i = 0; i < npfds; i++)
+			pfds[i].revents = 0;
+
+		n = poll(pfds, npfds, CLIENT_DMN_TIMEOUT * 1000);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1 || (n == 0 && nrelays == 0))
+			break;
+
+		/* relays first, their slots in pfds follow the idle ones */
+		for (i = nrelays - 1; i >= 0; i--) {
+			struct pollfd *pc = &pfds[1 + npolled + 2 * i];
+			struct client_relay *pr = &relays[i];
+			int done = 0;
+			int type;
+
+			if (pc[1].revents) {
+				if (client_daemon_relay(pr->cr_sfd, pr->cr_cfd, &type) == 0) {
+					/* a reply after the command said it was done */
+					pr->cr_done = 0;
+				} else {
+					/* the server or the command went away */
+					client_daemon_close(pr->cr_sfd);
+					pr->cr_sfd = -1;
+					done = 1;
+				}
+			}
+			if (!done && pc[0].revents) {
+				if (client_daemon_relay(pr->cr_cfd, pr->cr_sfd, &type) == 0)
+					pr->cr_done = (type == CLIENT_DMN_DONE);
+				else
+					done = 1;
+			}
+			if (!done)
+				continue;
+
+			/* keep the server connection only if the command finished cleanly */
+			if (pr->cr_sfd != -1) {
+				if (pr->cr_done && nidle < CLIENT_DMN_MAX_IDLE)
+					idle[nidle++] = pr->cr_sfd;
+				else
+					client_daemon_close(pr->cr_sfd);
+			}
+			close(pr->cr_cfd);
+			dis_destroy_chan(pr->cr_cfd);
+			destroy_connection(pr->cr_cfd);
+			relays[i] = relays[--nrelays];
+		}
+
+		/* the server closed an unused connection */
+		for (i = 0; i < npolled; i++) {
+			if (pfds[1 + i].revents) {
+				client_daemon_close(idle[i]);
+				idle[i] = -1;
+			}
+		}
+		for (i = 0, n = 0; i < nidle; i++) {
+			if (idle[i] != -1)
+				idle[n++] = idle[i];
+		}
+		nidle = n;
+
+		if (pfds[0].revents) {
+			struct client_relay *pr;
+			int sd;
+
+			if ((sd = accept(bindfd, NULL, NULL)) == -1)
+				continue;
+#ifdef SO_PEERCRED
+			{
+				struct ucred cred;
+				socklen_t len = sizeof(cred);
+
+				if (getsockopt(sd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0 ||
+				    cred.uid != getuid()) {
+					close(sd);
+					continue;
+				}
+			}
+#endif
+			if (nrelays == CLIENT_DMN_MAX_RELAYS) {
+				/* the command connects to the server itself */
+				close(sd);
+				continue;
+			}
+			pr = &relays[nrelays];
+			pr->cr_cfd = sd;
+			pr->cr_done = 0;
+			if (nidle > 0)
+				pr->cr_sfd = idle[--nidle];
+			else if ((pr->cr_sfd = tcp_connect(host, port, NULL)) == -1) {
+				close(sd);
+				continue;
+			}
+			if (write(sd, &ack, 1) != 1) {
+				close(sd);
+				if (nidle < CLIENT_DMN_MAX_IDLE)
+					idle[nidle++] = pr->cr_sfd;
+				else
+					client_daemon_close(pr->cr_sfd);
+				continue;
+			}
+			dis_setup_chan(sd, get_conn_chan);
+			nrelays++;
+		}
+	}
+
+out:
+	unlink(s_un.sun_path);
+	close(bindfd);
+}
+
+/**
+ * @brief
+ *	Start a client daemon for a server.  The daemon is detached from the
+ *	command, which carries on with its own connection to the server.
+ *
+ * @param[in] sd   - the connection of the command to the server
+ * @param[in] host - server host
+ * @param[in] port - server port
+ *
+ * @return void
+ */
+static void
+client_daemon_start(int sd, char *host, uint port)
+{
+	pid_t pid;
+	int i;
+
+	if ((pid = fork()) == -1)
+		return;
+	if (pid > 0) {
+		/* reap the intermediate child, the daemon is its orphan */
+		while (waitpid(pid, NULL, 0) == -1 && errno == EINTR)
+			;
+		return;
+	}
+	if (fork() != 0)
+		_exit(0);
+
+	setsid();
+	/* leave the connection of the command alone, it stays with the command */
+	client_daemon_close(sd);
+	/* nor keep anything else the command had open */
+	i = sysconf(_SC_OPEN_MAX);
+	while (--i > 2)
+		(void) close(i);
+	for (i = 0; i < 3; i++) {
+		close(i);
+		(void) open("/dev/null", i == 0 ? O_RDONLY : O_WRONLY);
+	}
+	if (chdir("/") != 0)
+		_exit(1);
+	pbs_client_thread_set_single_threaded_mode();
+	client_daemon_run(host, port);
+	_exit(0);
+}
+#endif /* WIN32 */
+
+/**
+ * @brief
+ *	Let pbs_connect() use a client daemon when PBS_CLIENT_DAEMON is set.
+ *	Starting the daemon forks the caller, so only a single threaded
+ *	program which calls nothing but PBS in the child may opt in.  The
+ *	PBS commands do so through cnt2server().
+ *
+ * @return void
+ */
+void
+pbs_client_daemon_enable(void)
+{
+#ifndef WIN32
+	client_daemon_ok = 1;
+#endif
+}
+
 /**
  * @brief	Creating the server corresponds to the server instance
  *
@@ -508,7 +975,16 @@ connect_to_server(svr_conn_t *conn, char *extend_data)
 	}
 
 	if (conn->state != SVR_CONN_STATE_UP) {
-		if ((sd = tcp_connect(conn->name, conn->port, extend_data)) != -1) {
+#ifndef WIN32
+		/* extend data goes with the connection, so it needs a connection of its own */
+		if (extend_data == NULL && client_daemon_wanted()) {
+			if ((sd = client_daemon_connect(conn->name, conn->port)) == -1 &&
+			    (sd = tcp_connect(conn->name, conn->port, NULL)) != -1)
+				client_daemon_start(sd, conn->name, conn->port);
+		} else
+#endif
+			sd = tcp_connect(conn->name, conn->port, extend_data);
+		if (sd != -1) {
 			conn->state = SVR_CONN_STATE_UP;
 			conn->sd = sd;
 		} else
@@ -839,6 +1315,16 @@ disconnect_from_server(int connect)
 	/* send close-connection message */
 
 	DIS_tcp_funcs();
+#ifndef WIN32
+	/*
+	 * a client daemon keeps its server connection open for the next
+	 * command, if no reply is owed on it
+	 */
+	if (is_client_daemon_conn(connect)) {
+		if (get_conn_pending(connect) == 0)
+			(void)transport_send_pkt(connect, CLIENT_DMN_DONE, "", 1);
+	} else
+#endif
 	if ((encode_DIS_ReqHdr(connect, PBS_BATCH_Disconnect, pbs_current_user) == 0) &&
 		(dis_flush(connect) == 0)) {
 		for (;;) {	/* wait for server to close connection */
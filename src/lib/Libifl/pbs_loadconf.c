@@ -113,6 +113,7 @@ struct pbs_config pbs_conf = {
 	NULL,					/* aux Mom home   */
 	NULL,					/* pbs_core_limit */
 	NULL,					/* default database host  */
+	NULL,					/* default database backend */
 	NULL,					/* pbs_tmpdir */
 	NULL,					/* pbs_server_host_name */
 	NULL,					/* pbs_public_host_name */
@@ -544,6 +545,10 @@ __pbs_loadconf(int reload)
 				free(pbs_conf.pbs_data_service_host);
 				pbs_conf.pbs_data_service_host = strdup(conf_value);
 			}
+			else if (!strcmp(conf_name, PBS_CONF_DATA_SERVICE_BACKEND)) {
+				free(pbs_conf.pbs_data_service_backend);
+				pbs_conf.pbs_data_service_backend = strdup(conf_value);
+			}
 			else if (!strcmp(conf_name, PBS_CONF_USE_COMPRESSION)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_use_compression = ((uvalue > 0) ? 1 : 0);
@@ -842,6 +847,12 @@ __pbs_loadconf(int reload)
 			goto err;
 		}
 	}
+	if ((gvalue = getenv(PBS_CONF_DATA_SERVICE_BACKEND)) != NULL) {
+		free(pbs_conf.pbs_data_service_backend);
+		if ((pbs_conf.pbs_data_service_backend = strdup(gvalue)) == NULL) {
+			goto err;
+		}
+	}
 	if ((gvalue = getenv(PBS_CONF_USE_COMPRESSION)) != NULL) {
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_use_compression = ((uvalue > 0) ? 1 : 0);
@@ -1158,6 +1169,10 @@ err:
 		free(pbs_conf.pbs_data_service_host);
 		pbs_conf.pbs_data_service_host = NULL;
 	}
+	if (pbs_conf.pbs_data_service_backend) {
+		free(pbs_conf.pbs_data_service_backend);
+		pbs_conf.pbs_data_service_backend = NULL;
+	}
 	if (pbs_conf.pbs_home_path) {
 		free(pbs_conf.pbs_home_path);
 		pbs_conf.pbs_home_path = NULL;
@@ -979,6 +979,34 @@ tpp_send(int sd, void *data, int len)
 	return rc;
 }
 
+/**
+ * @brief
+ *	Bytes sent by the app and still queued for the active router.
+ *
+ * @par Functionality:
+ *	tpp_send() only queues data for the IO thread, so an app sending a
+ *	large amount of data uses this to pace itself against the network.
+ *
+ * @return  bytes queued
+ * @retval  -1 - No active router
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_send_backlog(void)
+{
+	tpp_router_t *router = get_active_router();
+
+	if ((router == NULL) || (router->conn_fd == -1) || (router->state != TPP_ROUTER_STATE_CONNECTED))
+		return -1;
+
+	return tpp_transport_send_backlog(router->conn_fd);
+}
+
 /**
  * @brief
  *	poll function to check if any streams have a message/notification
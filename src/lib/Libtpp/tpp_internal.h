@@ -51,7 +51,6 @@ extern "C" {
 #include <netinet/in.h>
 #include "log.h"
 #include "list_link.h"
-#include "avltree.h"
 
 #include "tpp.h"
 
@@ -455,6 +454,7 @@ void tpp_free_tls(void);
 int tpp_transport_connect(char *, int, void *, int *);
 int tpp_transport_vsend(int, tpp_packet_t *pkt);
 int tpp_transport_isresvport(int);
+int tpp_transport_send_backlog(int);
 int tpp_transport_init(struct tpp_config *);
 void tpp_transport_set_handlers(
 	int (*pkt_presend_handler)(int, tpp_packet_t *, void *, void *),
@@ -1063,6 +1063,39 @@ tpp_transport_vsend(int tfd, tpp_packet_t *pkt)
 	return rc;
 }
 
+/**
+ * @brief
+ *	Number of bytes queued on a connection and not yet written out
+ *
+ * @param[in] tfd   - The file descriptor of the connection
+ *
+ * @return  bytes queued
+ * @retval  -1 - Bad or closed connection
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+tpp_transport_send_backlog(int tfd)
+{
+	int slot_state;
+	int size;
+	phy_conn_t *conn;
+
+	conn = get_transport_atomic(tfd, &slot_state);
+	if (conn == NULL || slot_state != TPP_SLOT_BUSY)
+		return -1;
+
+	tpp_lock(&conn->send_mbox.mbox_mutex);
+	size = conn->send_mbox.mbox_size;
+	tpp_unlock(&conn->send_mbox.mbox_mutex);
+
+	return size;
+}
+
 /**
  * @brief
  *	Whether the underlying connection is from a reserved port or not
@@ -1335,9 +1368,6 @@ handle_cmd(thrd_data_t *td, int tfd, int cmd, void *data)
 
 		tpp_log(LOG_INFO, NULL, "Thrd exiting, had %d connections", num_cons);
 
-		/* destory the AVL tls */
-		free_avl_tls();
-
 		pthread_exit(NULL);
 		/* no execution after this */
 
@@ -37,18 +37,682 @@
  * subject to Altair's trademark licensing policies.
  */
 
+/*
+ * pbs_idx - generic index used for jobs, queues, reservations, nodes,
+ * attribute definitions and the TPP stream tables.
+ *
+ * Exact-match lookups are served by an open-addressing hash table (linear
+ * probing, backward-shift deletion, cached hash values). Ordered access is
+ * served by a B+tree whose leaves are chained in key order. An index that
+ * allows duplicate keys lives only in the B+tree; for any other index the
+ * B+tree is built on the first ordered access (iteration or find with a
+ * context) and kept up to date from then on, so indexes that are only used
+ * for lookups never pay for it.
+ *
+ * Entries are ordered by key and, for duplicate keys, by data pointer,
+ * which is the order the previous AVL based implementation used.
+ */
+
 #include "pbs_idx.h"
-#include "avltree.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#define IDX_HASH_MINSIZE 16		/* initial number of hash slots, power of 2 */
+#define IDX_BT_ORDER 32			/* max entries in a B+tree node */
+#define IDX_BT_MIN (IDX_BT_ORDER / 2)	/* min entries in a non-root B+tree node */
+
+/* key and data of an entry */
+typedef struct idx_ent {
+	void *key;
+	void *data;
+} idx_ent;
+
+/* hash table slot, empty when key is NULL */
+typedef struct idx_slot {
+	unsigned int hash;
+	void *key;
+	void *data;
+} idx_slot;
+
+/*
+ * B+tree node. In a leaf ent[] holds the entries; in an inner node ent[i]
+ * is a copy of the first entry of the subtree child[i].
+ */
+typedef struct bt_node {
+	int leaf;
+	int n;
+	struct bt_node *next; /* next leaf in key order */
+	idx_ent ent[IDX_BT_ORDER];
+	struct bt_node *child[IDX_BT_ORDER];
+} bt_node;
+
+typedef struct idx_desc {
+	int flags;		 /* PBS_IDX_DUPS_OK, PBS_IDX_ICASE_CMP */
+	int keylen;		 /* zero for null-terminated strings */
+	idx_slot *slots;	 /* hash table, not used with PBS_IDX_DUPS_OK */
+	size_t size;		 /* number of slots, power of 2 */
+	size_t count;		 /* number of used slots */
+	int ordered;		 /* B+tree is built and maintained */
+	bt_node *root;		 /* B+tree root, NULL if empty */
+	unsigned long version;	 /* bumped on every B+tree change */
+	pthread_mutex_t bt_lock; /* serializes building the B+tree */
+} idx_desc;
 
 /* iteration context structure, opaque to application */
 typedef struct _iter_ctx {
-	AVL_IX_DESC *idx; /* pointer to idx */
-	AVL_IX_REC *pkey; /* pointer to key used while iteration */
+	idx_desc *idx;		/* pointer to idx */
+	bt_node *leaf;		/* leaf of the current entry */
+	int pos;		/* position of the current entry in leaf */
+	unsigned long version;	/* idx version leaf/pos are valid for */
+	void *key;		/* copy of the current key */
+	size_t keysize;		/* size of the key buffer */
+	void *data;		/* data of the current entry */
 } iter_ctx;
 
+static int
+idx_keycmp(idx_desc *idx, const void *k1, const void *k2)
+{
+	if (idx->keylen)
+		return memcmp(k1, k2, idx->keylen);
+	if (idx->flags & PBS_IDX_ICASE_CMP)
+		return strcasecmp(k1, k2);
+	return strcmp(k1, k2);
+}
+
+/* compare entries by key, then by data pointer for duplicate keys */
+static int
+idx_entcmp(idx_desc *idx, const void *k1, const void *d1, const void *k2, const void *d2)
+{
+	int n = idx_keycmp(idx, k1, k2);
+
+	if (n || !(idx->flags & PBS_IDX_DUPS_OK))
+		return n;
+	if ((uintptr_t) d1 == (uintptr_t) d2)
+		return 0;
+	return ((uintptr_t) d1 < (uintptr_t) d2) ? -1 : 1;
+}
+
+/* FNV-1a hash of a key, folded to lower case for case-insensitive indexes */
+static unsigned int
+idx_hash(idx_desc *idx, const void *key)
+{
+	const unsigned char *p = key;
+	unsigned int h = 2166136261U;
+	size_t i;
+
+	if (idx->keylen) {
+		for (i = 0; i < (size_t) idx->keylen; i++)
+			h = (h ^ p[i]) * 16777619U;
+	} else if (idx->flags & PBS_IDX_ICASE_CMP) {
+		for (; *p; p++)
+			h = (h ^ (unsigned char) tolower(*p)) * 16777619U;
+	} else {
+		for (; *p; p++)
+			h = (h ^ *p) * 16777619U;
+	}
+	return h;
+}
+
+static void *
+idx_key_dup(idx_desc *idx, void *key)
+{
+	void *k;
+
+	if (idx->keylen == 0)
+		return strdup(key);
+	if ((k = malloc(idx->keylen)) != NULL)
+		memcpy(k, key, idx->keylen);
+	return k;
+}
+
+/**
+ * @brief
+ *	find the slot of key in the hash table
+ *
+ * @return long
+ * @retval >=0 - slot index
+ * @retval -1  - not found
+ */
+static long
+hash_find(idx_desc *idx, void *key, unsigned int h)
+{
+	size_t mask = idx->size - 1;
+	size_t i;
+
+	if (idx->slots == NULL)
+		return -1;
+
+	for (i = h & mask; idx->slots[i].key != NULL; i = (i + 1) & mask) {
+		if (idx->slots[i].hash == h && idx_keycmp(idx, idx->slots[i].key, key) == 0)
+			return (long) i;
+	}
+	return -1;
+}
+
+/* place an entry known not to be in the table */
+static void
+hash_place(idx_slot *slots, size_t size, unsigned int h, void *key, void *data)
+{
+	size_t mask = size - 1;
+	size_t i;
+
+	for (i = h & mask; slots[i].key != NULL; i = (i + 1) & mask)
+		;
+	slots[i].hash = h;
+	slots[i].key = key;
+	slots[i].data = data;
+}
+
+/* grow the hash table so that it stays below 3/4 full */
+static int
+hash_reserve(idx_desc *idx)
+{
+	idx_slot *nslots;
+	size_t nsize;
+	size_t i;
+
+	if (idx->slots != NULL && (idx->count + 1) * 4 <= idx->size * 3)
+		return PBS_IDX_RET_OK;
+
+	nsize = idx->slots ? idx->size * 2 : IDX_HASH_MINSIZE;
+	if ((nslots = calloc(nsize, sizeof(idx_slot))) == NULL)
+		return PBS_IDX_RET_FAIL;
+	for (i = 0; i < idx->size; i++) {
+		if (idx->slots[i].key != NULL)
+			hash_place(nslots, nsize, idx->slots[i].hash, idx->slots[i].key, idx->slots[i].data);
+	}
+	free(idx->slots);
+	idx->slots = nslots;
+	idx->size = nsize;
+	return PBS_IDX_RET_OK;
+}
+
+/* remove slot i, shifting back the entries of its probe sequence */
+static void
+hash_remove(idx_desc *idx, size_t i)
+{
+	size_t mask = idx->size - 1;
+	size_t j = i;
+	size_t k;
+
+	for (;;) {
+		j = (j + 1) & mask;
+		if (idx->slots[j].key == NULL)
+			break;
+		k = idx->slots[j].hash & mask;
+		/* move slot j to the hole unless its home lies cyclically in (i, j] */
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		idx->slots[i] = idx->slots[j];
+		i = j;
+	}
+	idx->slots[i].key = NULL;
+	idx->slots[i].data = NULL;
+	idx->count--;
+}
+
+static bt_node *
+bt_alloc(int leaf)
+{
+	bt_node *node = malloc(sizeof(bt_node));
+
+	if (node != NULL) {
+		node->leaf = leaf;
+		node->n = 0;
+		node->next = NULL;
+	}
+	return node;
+}
+
+/* free a B+tree, and the keys in it if free_keys is set */
+static void
+bt_free(bt_node *node, int free_keys)
+{
+	int i;
+
+	if (node == NULL)
+		return;
+	for (i = 0; i < node->n; i++) {
+		if (!node->leaf)
+			bt_free(node->child[i], free_keys);
+		else if (free_keys)
+			free(node->ent[i].key);
+	}
+	free(node);
+}
+
+/* first position in node whose entry is >= (key, data), or > if strict */
+static int
+bt_bound(idx_desc *idx, bt_node *node, void *key, void *data, int strict)
+{
+	int lo = 0;
+	int hi = node->n;
+	int mid;
+	int c;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		c = idx_entcmp(idx, node->ent[mid].key, node->ent[mid].data, key, data);
+		if (c > 0 || (c == 0 && !strict))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/* child of an inner node whose subtree holds (key, data) */
+static int
+bt_route(idx_desc *idx, bt_node *node, void *key, void *data, int strict)
+{
+	int i = bt_bound(idx, node, key, data, strict);
+
+	return (i > 0) ? i - 1 : 0;
+}
+
+/* insert entry (and child) at position pos of a node that is not full */
+static void
+bt_put(bt_node *node, int pos, idx_ent *ent, bt_node *child)
+{
+	memmove(&node->ent[pos + 1], &node->ent[pos], (node->n - pos) * sizeof(idx_ent));
+	node->ent[pos] = *ent;
+	if (!node->leaf) {
+		memmove(&node->child[pos + 1], &node->child[pos], (node->n - pos) * sizeof(bt_node *));
+		node->child[pos] = child;
+	}
+	node->n++;
+}
+
+/* remove position pos of a node */
+static void
+bt_take(bt_node *node, int pos)
+{
+	node->n--;
+	memmove(&node->ent[pos], &node->ent[pos + 1], (node->n - pos) * sizeof(idx_ent));
+	if (!node->leaf)
+		memmove(&node->child[pos], &node->child[pos + 1], (node->n - pos) * sizeof(bt_node *));
+}
+
+/* move the upper half of a full node to a new right sibling */
+static bt_node *
+bt_split(bt_node *node)
+{
+	bt_node *right;
+	int half = IDX_BT_ORDER / 2;
+
+	if ((right = bt_alloc(node->leaf)) == NULL)
+		return NULL;
+	right->n = node->n - half;
+	memcpy(right->ent, &node->ent[half], right->n * sizeof(idx_ent));
+	if (!node->leaf)
+		memcpy(right->child, &node->child[half], right->n * sizeof(bt_node *));
+	node->n = half;
+	if (node->leaf) {
+		right->next = node->next;
+		node->next = right;
+	}
+	return right;
+}
+
+/* refill child i of node after it dropped below IDX_BT_MIN entries */
+static void
+bt_rebalance(bt_node *node, int i)
+{
+	bt_node *c = node->child[i];
+	bt_node *l;
+	bt_node *r;
+
+	if (i > 0 && node->child[i - 1]->n > IDX_BT_MIN) {
+		/* borrow the last entry of the left sibling */
+		l = node->child[i - 1];
+		bt_put(c, 0, &l->ent[l->n - 1], l->leaf ? NULL : l->child[l->n - 1]);
+		l->n--;
+		node->ent[i] = c->ent[0];
+		return;
+	}
+	if (i + 1 < node->n && node->child[i + 1]->n > IDX_BT_MIN) {
+		/* borrow the first entry of the right sibling */
+		r = node->child[i + 1];
+		bt_put(c, c->n, &r->ent[0], r->leaf ? NULL : r->child[0]);
+		bt_take(r, 0);
+		node->ent[i] = c->ent[0];
+		node->ent[i + 1] = r->ent[0];
+		return;
+	}
+
+	/* merge with a sibling, the pair fits in one node */
+	if (i > 0)
+		i--;
+	if (i + 1 >= node->n)
+		return;
+	l = node->child[i];
+	r = node->child[i + 1];
+	memcpy(&l->ent[l->n], r->ent, r->n * sizeof(idx_ent));
+	if (!l->leaf)
+		memcpy(&l->child[l->n], r->child, r->n * sizeof(bt_node *));
+	l->n += r->n;
+	if (l->leaf)
+		l->next = r->next;
+	free(r);
+	bt_take(node, i + 1);
+	if (l->n > 0)
+		node->ent[i] = l->ent[0];
+}
+
+/**
+ * @brief
+ *	delete (key, data) from the subtree of node
+ *
+ * @param[out] out - the deleted entry
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - not found
+ */
+static int
+bt_delete(idx_desc *idx, bt_node *node, void *key, void *data, idx_ent *out)
+{
+	int pos;
+
+	if (node->leaf) {
+		pos = bt_bound(idx, node, key, data, 0);
+		if (pos >= node->n || idx_entcmp(idx, node->ent[pos].key, node->ent[pos].data, key, data) != 0)
+			return PBS_IDX_RET_FAIL;
+		*out = node->ent[pos];
+		bt_take(node, pos);
+		return PBS_IDX_RET_OK;
+	}
+
+	pos = bt_route(idx, node, key, data, 1);
+	if (bt_delete(idx, node->child[pos], key, data, out) != PBS_IDX_RET_OK)
+		return PBS_IDX_RET_FAIL;
+	if (node->child[pos]->n > 0)
+		node->ent[pos] = node->child[pos]->ent[0];
+	if (node->child[pos]->n < IDX_BT_MIN)
+		bt_rebalance(node, pos);
+	return PBS_IDX_RET_OK;
+}
+
+/**
+ * @brief
+ *	insert an entry in the B+tree. Full nodes are split on the way down,
+ *	so a failed allocation leaves a valid tree without the entry.
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - entry already present or out of memory
+ */
+static int
+bt_add(idx_desc *idx, void *key, void *data)
+{
+	bt_node *path[64];
+	int ppos[64];
+	int depth = 0;
+	bt_node *node;
+	bt_node *right;
+	idx_ent ent;
+	int pos;
+
+	if (idx->root == NULL && (idx->root = bt_alloc(1)) == NULL)
+		return PBS_IDX_RET_FAIL;
+
+	if (idx->root->n == IDX_BT_ORDER) {
+		if ((node = bt_alloc(0)) == NULL)
+			return PBS_IDX_RET_FAIL;
+		if ((right = bt_split(idx->root)) == NULL) {
+			free(node);
+			return PBS_IDX_RET_FAIL;
+		}
+		node->n = 2;
+		node->ent[0] = idx->root->ent[0];
+		node->child[0] = idx->root;
+		node->ent[1] = right->ent[0];
+		node->child[1] = right;
+		idx->root = node;
+		idx->version++;
+	}
+
+	ent.key = key;
+	ent.data = data;
+	node = idx->root;
+	while (!node->leaf) {
+		pos = bt_route(idx, node, key, data, 1);
+		if (node->child[pos]->n == IDX_BT_ORDER) {
+			if ((right = bt_split(node->child[pos])) == NULL)
+				return PBS_IDX_RET_FAIL;
+			bt_put(node, pos + 1, &right->ent[0], right);
+			idx->version++;
+			if (idx_entcmp(idx, right->ent[0].key, right->ent[0].data, key, data) <= 0)
+				pos++;
+		}
+		path[depth] = node;
+		ppos[depth++] = pos;
+		node = node->child[pos];
+	}
+
+	pos = bt_bound(idx, node, key, data, 0);
+	if (pos < node->n && idx_entcmp(idx, node->ent[pos].key, node->ent[pos].data, key, data) == 0)
+		return PBS_IDX_RET_FAIL;
+	bt_put(node, pos, &ent, NULL);
+	idx->version++;
+
+	/* a new first entry of a subtree is the new separator above it */
+	while (pos == 0 && depth > 0) {
+		depth--;
+		path[depth]->ent[ppos[depth]] = ent;
+		pos = ppos[depth];
+	}
+	return PBS_IDX_RET_OK;
+}
+
+static int
+bt_remove(idx_desc *idx, void *key, void *data, idx_ent *out)
+{
+	bt_node *root = idx->root;
+
+	if (root == NULL || bt_delete(idx, root, key, data, out) != PBS_IDX_RET_OK)
+		return PBS_IDX_RET_FAIL;
+	idx->version++;
+	if (!root->leaf && root->n == 1) {
+		idx->root = root->child[0];
+		free(root);
+	} else if (root->leaf && root->n == 0) {
+		idx->root = NULL;
+		free(root);
+	}
+	return PBS_IDX_RET_OK;
+}
+
+/* locate the first entry >= (key, data), or > if strict */
+static int
+bt_seek(idx_desc *idx, void *key, void *data, int strict, bt_node **leaf, int *pos)
+{
+	bt_node *node = idx->root;
+	int i;
+
+	if (node == NULL)
+		return PBS_IDX_RET_FAIL;
+	while (!node->leaf)
+		node = node->child[bt_route(idx, node, key, data, 1)];
+	i = bt_bound(idx, node, key, data, strict);
+	if (i >= node->n) {
+		if ((node = node->next) == NULL)
+			return PBS_IDX_RET_FAIL;
+		i = 0;
+	}
+	*leaf = node;
+	*pos = i;
+	return PBS_IDX_RET_OK;
+}
+
+/* merge sort of entries, qsort() has no way to pass the index */
+static void
+ent_sort(idx_desc *idx, idx_ent *ents, idx_ent *tmp, size_t n)
+{
+	size_t half = n / 2;
+	size_t i = 0;
+	size_t j = half;
+	size_t k = 0;
+
+	if (n < 2)
+		return;
+	ent_sort(idx, ents, tmp, half);
+	ent_sort(idx, ents + half, tmp, n - half);
+	while (i < half && j < n) {
+		if (idx_keycmp(idx, ents[i].key, ents[j].key) <= 0)
+			tmp[k++] = ents[i++];
+		else
+			tmp[k++] = ents[j++];
+	}
+	while (i < half)
+		tmp[k++] = ents[i++];
+	memcpy(ents, tmp, k * sizeof(idx_ent));
+}
+
+/**
+ * @brief
+ *	build one B+tree level over n nodes (or entries when nodes is NULL),
+ *	filling each new node 3/4 full so that later inserts rarely split
+ *
+ * @return bt_node **
+ * @retval array of the new nodes, count in *nout
+ * @retval NULL - out of memory
+ */
+static bt_node **
+bt_build_level(idx_ent *ents, bt_node **nodes, size_t n, size_t *nout)
+{
+	size_t fill = IDX_BT_ORDER * 3 / 4;
+	size_t cnt = (n + fill - 1) / fill;
+	bt_node **level;
+	size_t i;
+	size_t j;
+	size_t from = 0;
+	size_t take;
+
+	if ((level = calloc(cnt, sizeof(bt_node *))) == NULL)
+		return NULL;
+	for (i = 0; i < cnt; i++) {
+		if ((level[i] = bt_alloc(nodes == NULL)) == NULL) {
+			while (i-- > 0)
+				free(level[i]);
+			free(level);
+			return NULL;
+		}
+		/* spread the remainder so that no node is left nearly empty */
+		take = n / cnt + (i < n % cnt);
+		for (j = 0; j < take; j++, from++) {
+			if (nodes == NULL)
+				level[i]->ent[j] = ents[from];
+			else {
+				level[i]->ent[j] = nodes[from]->ent[0];
+				level[i]->child[j] = nodes[from];
+			}
+		}
+		level[i]->n = take;
+		if (nodes == NULL && i > 0)
+			level[i - 1]->next = level[i];
+	}
+	*nout = cnt;
+	return level;
+}
+
+/**
+ * @brief
+ *	build the B+tree of a hash-only index, on the first ordered access
+ *
+ * @return int
+ * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_FAIL - out of memory
+ */
+static int
+idx_make_ordered(idx_desc *idx)
+{
+	idx_ent *ents = NULL;
+	idx_ent *tmp = NULL;
+	bt_node **level = NULL;
+	bt_node **upper;
+	size_t n = 0;
+	size_t i;
+	int rc = PBS_IDX_RET_FAIL;
+
+	if (idx->flags & PBS_IDX_DUPS_OK)
+		return PBS_IDX_RET_OK;
+
+	pthread_mutex_lock(&idx->bt_lock);
+	if (idx->ordered) {
+		pthread_mutex_unlock(&idx->bt_lock);
+		return PBS_IDX_RET_OK;
+	}
+
+	if (idx->count == 0) {
+		idx->ordered = 1;
+		pthread_mutex_unlock(&idx->bt_lock);
+		return PBS_IDX_RET_OK;
+	}
+
+	ents = malloc(idx->count * sizeof(idx_ent));
+	tmp = malloc(idx->count * sizeof(idx_ent));
+	if (ents == NULL || tmp == NULL)
+		goto done;
+	for (i = 0; i < idx->size; i++) {
+		if (idx->slots[i].key != NULL) {
+			ents[n].key = idx->slots[i].key;
+			ents[n++].data = idx->slots[i].data;
+		}
+	}
+	ent_sort(idx, ents, tmp, n);
+
+	if ((level = bt_build_level(ents, NULL, n, &n)) == NULL)
+		goto done;
+	while (n > 1) {
+		if ((upper = bt_build_level(NULL, level, n, &n)) == NULL) {
+			for (i = 0; i < n; i++)
+				bt_free(level[i], 0);
+			goto done;
+		}
+		free(level);
+		level = upper;
+	}
+	idx->root = level[0];
+	idx->version++;
+	idx->ordered = 1;
+	rc = PBS_IDX_RET_OK;
+
+done:
+	free(level);
+	free(ents);
+	free(tmp);
+	pthread_mutex_unlock(&idx->bt_lock);
+	return rc;
+}
+
+/* position ctx on entry pos of leaf */
+static int
+ctx_set(iter_ctx *pctx, bt_node *leaf, int pos)
+{
+	idx_desc *idx = pctx->idx;
+	size_t ksize = idx->keylen ? (size_t) idx->keylen : strlen(leaf->ent[pos].key) + 1;
+
+	if (ksize > pctx->keysize) {
+		void *k = realloc(pctx->key, ksize);
+		if (k == NULL)
+			return PBS_IDX_RET_FAIL;
+		pctx->key = k;
+		pctx->keysize = ksize;
+	}
+	memcpy(pctx->key, leaf->ent[pos].key, ksize);
+	pctx->data = leaf->ent[pos].data;
+	pctx->leaf = leaf;
+	pctx->pos = pos;
+	pctx->version = idx->version;
+	return PBS_IDX_RET_OK;
+}
+
 /**
  * @brief
  *	Create an empty index
@@ -64,16 +728,18 @@ typedef struct _iter_ctx {
 void *
 pbs_idx_create(int flags, int keylen)
 {
-	void *idx = NULL;
+	idx_desc *idx;
 
-	idx = malloc(sizeof(AVL_IX_DESC));
+	idx = calloc(1, sizeof(idx_desc));
 	if (idx == NULL)
 		return NULL;
 
-	if (avl_create_index(idx, flags, keylen)) {
-		free(idx);
-		return NULL;
-	}
+	idx->flags = flags;
+	idx->keylen = keylen;
+	/* duplicate keys live in the B+tree only */
+	if (flags & PBS_IDX_DUPS_OK)
+		idx->ordered = 1;
+	pthread_mutex_init(&idx->bt_lock, NULL);
 
 	return idx;
 }
@@ -90,10 +756,20 @@ pbs_idx_create(int flags, int keylen)
 void
 pbs_idx_destroy(void *idx)
 {
-	if (idx != NULL) {
-		avl_destroy_index(idx);
-		free(idx);
-		idx = NULL;
+	idx_desc *pidx = (idx_desc *) idx;
+	size_t i;
+
+	if (pidx != NULL) {
+		if (pidx->flags & PBS_IDX_DUPS_OK)
+			bt_free(pidx->root, 1);
+		else {
+			bt_free(pidx->root, 0);
+			for (i = 0; i < pidx->size; i++)
+				free(pidx->slots[i].key);
+			free(pidx->slots);
+		}
+		pthread_mutex_destroy(&pidx->bt_lock);
+		free(pidx);
 	}
 }
 
@@ -113,21 +789,36 @@ pbs_idx_destroy(void *idx)
 int
 pbs_idx_insert(void *idx, void *key, void *data)
 {
-	AVL_IX_REC *pkey;
+	idx_desc *pidx = (idx_desc *) idx;
+	unsigned int h;
+	void *k;
 
-	if (idx == NULL || key == NULL)
+	if (pidx == NULL || key == NULL)
 		return PBS_IDX_RET_FAIL;
 
-	pkey = avlkey_create(idx, key);
-	if (pkey == NULL)
-		return PBS_IDX_RET_FAIL;
+	if (pidx->flags & PBS_IDX_DUPS_OK) {
+		if ((k = idx_key_dup(pidx, key)) == NULL)
+			return PBS_IDX_RET_FAIL;
+		if (bt_add(pidx, k, data) != PBS_IDX_RET_OK) {
+			free(k);
+			return PBS_IDX_RET_FAIL;
+		}
+		return PBS_IDX_RET_OK;
+	}
 
-	pkey->recptr = data;
-	if (avl_add_key(pkey, idx) != AVL_IX_OK) {
-		free(pkey);
+	h = idx_hash(pidx, key);
+	if (hash_find(pidx, key, h) != -1)
+		return PBS_IDX_RET_FAIL;
+	if (hash_reserve(pidx) != PBS_IDX_RET_OK)
+		return PBS_IDX_RET_FAIL;
+	if ((k = idx_key_dup(pidx, key)) == NULL)
+		return PBS_IDX_RET_FAIL;
+	if (pidx->ordered && bt_add(pidx, k, data) != PBS_IDX_RET_OK) {
+		free(k);
 		return PBS_IDX_RET_FAIL;
 	}
-	free(pkey);
+	hash_place(pidx->slots, pidx->size, h, k, data);
+	pidx->count++;
 	return PBS_IDX_RET_OK;
 }
 
@@ -139,25 +830,34 @@ pbs_idx_insert(void *idx, void *key, void *data)
  * @param[in] - key - key of entry
  *
  * @return int
- * @retval PBS_IDX_RET_OK   - success
+ * @retval PBS_IDX_RET_OK   - success (also when key is not in index)
  * @retval PBS_IDX_RET_FAIL - failure
  *
  */
 int
 pbs_idx_delete(void *idx, void *key)
 {
-	AVL_IX_REC *pkey;
+	idx_desc *pidx = (idx_desc *) idx;
+	idx_ent ent;
+	long i;
 
-	if (idx == NULL || key == NULL)
+	if (pidx == NULL || key == NULL)
 		return PBS_IDX_RET_FAIL;
 
-	pkey = avlkey_create(idx, key);
-	if (pkey == NULL)
-		return PBS_IDX_RET_FAIL;
+	if (pidx->flags & PBS_IDX_DUPS_OK) {
+		/* only an entry with NULL data matches a bare key */
+		if (bt_remove(pidx, key, NULL, &ent) == PBS_IDX_RET_OK)
+			free(ent.key);
+		return PBS_IDX_RET_OK;
+	}
 
-	pkey->recptr = NULL;
-	avl_delete_key(pkey, idx);
-	free(pkey);
+	if ((i = hash_find(pidx, key, idx_hash(pidx, key))) == -1)
+		return PBS_IDX_RET_OK;
+	ent.key = pidx->slots[i].key;
+	if (pidx->ordered)
+		bt_remove(pidx, ent.key, pidx->slots[i].data, &ent);
+	hash_remove(pidx, (size_t) i);
+	free(ent.key);
 	return PBS_IDX_RET_OK;
 }
 
@@ -177,11 +877,27 @@ int
 pbs_idx_delete_byctx(void *ctx)
 {
 	iter_ctx *pctx = (iter_ctx *) ctx;
+	idx_desc *pidx;
+	idx_ent ent;
+	long i;
 
-	if (pctx == NULL || pctx->idx == NULL || pctx->pkey == NULL)
+	if (pctx == NULL || pctx->idx == NULL || pctx->key == NULL)
 		return PBS_IDX_RET_FAIL;
+	pidx = pctx->idx;
+
+	if (pidx->flags & PBS_IDX_DUPS_OK) {
+		if (bt_remove(pidx, pctx->key, pctx->data, &ent) != PBS_IDX_RET_OK)
+			return PBS_IDX_RET_FAIL;
+		free(ent.key);
+		return PBS_IDX_RET_OK;
+	}
 
-	avl_delete_key(pctx->pkey, pctx->idx);
+	if ((i = hash_find(pidx, pctx->key, idx_hash(pidx, pctx->key))) == -1)
+		return PBS_IDX_RET_FAIL;
+	ent.key = pidx->slots[i].key;
+	bt_remove(pidx, ent.key, pidx->slots[i].data, &ent);
+	hash_remove(pidx, (size_t) i);
+	free(ent.key);
 	return PBS_IDX_RET_OK;
 }
 
@@ -206,70 +922,93 @@ pbs_idx_delete_byctx(void *ctx)
  *
  * @note
  * 	ctx should be free'd after use, using pbs_idx_free_ctx()
+ *	The index may be changed while iterating, the next call continues
+ *	after the last entry returned.
  *
  */
 int
 pbs_idx_find(void *idx, void **key, void **data, void **ctx)
 {
+	idx_desc *pidx = (idx_desc *) idx;
 	iter_ctx *pctx;
-	AVL_IX_REC *pkey;
-	int rc = AVL_IX_FAIL;
+	bt_node *leaf;
+	int pos;
+	long i;
 
-	if (idx == NULL || data == NULL)
+	if (pidx == NULL || data == NULL)
 		return PBS_IDX_RET_FAIL;
 
+	*data = NULL;
 	if (ctx != NULL && *ctx != NULL) {
 		pctx = (iter_ctx *) *ctx;
 
-		*data = NULL;
 		if (key)
 			*key = NULL;
 
-		if (pctx->idx != idx || pctx->pkey == NULL)
+		if (pctx->idx != pidx || pctx->key == NULL)
 			return PBS_IDX_RET_FAIL;
 
-		if (avl_next_key(pctx->pkey, pctx->idx) != AVL_IX_OK)
+		if (pctx->version == pidx->version) {
+			leaf = pctx->leaf;
+			pos = pctx->pos + 1;
+			if (pos >= leaf->n) {
+				if ((leaf = leaf->next) == NULL)
+					return PBS_IDX_RET_FAIL;
+				pos = 0;
+			}
+		} else if (bt_seek(pidx, pctx->key, pctx->data, 1, &leaf, &pos) != PBS_IDX_RET_OK)
 			return PBS_IDX_RET_FAIL;
 
-		*data = pctx->pkey->recptr;
+		if (ctx_set(pctx, leaf, pos) != PBS_IDX_RET_OK)
+			return PBS_IDX_RET_FAIL;
+		*data = pctx->data;
 		if (key)
-			*key = &pctx->pkey->key;
+			*key = pctx->key;
 
 		return PBS_IDX_RET_OK;
-	} else {
-		*data = NULL;
-		pkey = avlkey_create(idx, key ? *key : NULL);
-		if (pkey == NULL)
+	}
+
+	if (key != NULL && *key != NULL && ctx == NULL && !(pidx->flags & PBS_IDX_DUPS_OK)) {
+		/* plain lookup, the common case */
+		if ((i = hash_find(pidx, *key, idx_hash(pidx, *key))) == -1)
 			return PBS_IDX_RET_FAIL;
+		*data = pidx->slots[i].data;
+		return PBS_IDX_RET_OK;
+	}
 
-		if (key != NULL && *key != NULL) {
-			rc = avl_find_key(pkey, idx);
-		} else {
-			avl_first_key(idx);
-			rc = avl_next_key(pkey, idx);
-		}
+	if (idx_make_ordered(pidx) != PBS_IDX_RET_OK)
+		return PBS_IDX_RET_FAIL;
 
-		if (rc == AVL_IX_OK) {
-			*data = pkey->recptr;
-			if (key != NULL && *key == NULL)
-				*key = &pkey->key;
-			if (ctx != NULL) {
-				pctx = (iter_ctx *) malloc(sizeof(iter_ctx));
-				if (pctx == NULL) {
-					free(pkey);
-					return PBS_IDX_RET_FAIL;
-				}
-				pctx->idx = idx;
-				pctx->pkey = pkey;
-				*ctx = (void *) pctx;
+	if (key != NULL && *key != NULL) {
+		if (bt_seek(pidx, *key, NULL, 0, &leaf, &pos) != PBS_IDX_RET_OK)
+			return PBS_IDX_RET_FAIL;
+		if (idx_keycmp(pidx, leaf->ent[pos].key, *key) != 0)
+			return PBS_IDX_RET_FAIL;
+	} else {
+		if ((leaf = pidx->root) == NULL)
+			return PBS_IDX_RET_FAIL;
+		while (!leaf->leaf)
+			leaf = leaf->child[0];
+		pos = 0;
+	}
 
-				return PBS_IDX_RET_OK;
-			}
+	if (ctx != NULL) {
+		pctx = (iter_ctx *) calloc(1, sizeof(iter_ctx));
+		if (pctx == NULL)
+			return PBS_IDX_RET_FAIL;
+		pctx->idx = pidx;
+		if (ctx_set(pctx, leaf, pos) != PBS_IDX_RET_OK) {
+			free(pctx);
+			return PBS_IDX_RET_FAIL;
 		}
-		free(pkey);
-	}
+		*ctx = (void *) pctx;
+		if (key != NULL && *key == NULL)
+			*key = pctx->key;
+	} else if (key != NULL && *key == NULL)
+		*key = leaf->ent[pos].key;
 
-	return rc == AVL_IX_OK ? PBS_IDX_RET_OK : PBS_IDX_RET_FAIL;
+	*data = leaf->ent[pos].data;
+	return PBS_IDX_RET_OK;
 }
 
 /**
@@ -286,7 +1025,7 @@ pbs_idx_free_ctx(void *ctx)
 {
 	if (ctx != NULL) {
 		iter_ctx *pctx = (iter_ctx *) ctx;
-		free(pctx->pkey);
+		free(pctx->key);
 		free(ctx);
 		ctx = NULL;
 	}
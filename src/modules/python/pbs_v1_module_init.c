@@ -97,27 +97,27 @@ PyInit__pbs_v1(void) {
 			 "get_fullhostname() failed to acqiure the server host name");
 	}
 
-	if ((job_attr_idx = cr_attrdef_idx(job_attr_def, JOB_ATR_LAST)) == NULL) {
+	if ((job_attr_idx = cr_attrdef_idx(job_attr_def, JOB_ATR_LAST, &job_attr_def_phash)) == NULL) {
 		return PyErr_Format(PyExc_Exception,
 			"Failed creating job attribute search index");
 	}
-	if ((node_attr_idx = cr_attrdef_idx(node_attr_def, ND_ATR_LAST)) == NULL) {
+	if ((node_attr_idx = cr_attrdef_idx(node_attr_def, ND_ATR_LAST, &node_attr_def_phash)) == NULL) {
 		return PyErr_Format(PyExc_Exception,
 			"Failed creating node attribute search index");
 	}
-	if ((que_attr_idx = cr_attrdef_idx(que_attr_def, QA_ATR_LAST)) == NULL) {
+	if ((que_attr_idx = cr_attrdef_idx(que_attr_def, QA_ATR_LAST, &que_attr_def_phash)) == NULL) {
 		return PyErr_Format(PyExc_Exception,
 			"Failed creating queue attribute search index");
 	}
-	if ((svr_attr_idx = cr_attrdef_idx(svr_attr_def, SVR_ATR_LAST)) == NULL) {
+	if ((svr_attr_idx = cr_attrdef_idx(svr_attr_def, SVR_ATR_LAST, &svr_attr_def_phash)) == NULL) {
 		return PyErr_Format(PyExc_Exception,
 			"Failed creating server attribute search index");
 	}
-	if ((sched_attr_idx = cr_attrdef_idx(sched_attr_def, SCHED_ATR_LAST)) == NULL) {
+	if ((sched_attr_idx = cr_attrdef_idx(sched_attr_def, SCHED_ATR_LAST, &sched_attr_def_phash)) == NULL) {
 		return PyErr_Format(PyExc_Exception,
 			"Failed creating sched attribute search index");
 	}
-	if ((resv_attr_idx = cr_attrdef_idx(resv_attr_def, RESV_ATR_LAST)) == NULL) {
+	if ((resv_attr_idx = cr_attrdef_idx(resv_attr_def, RESV_ATR_LAST, &resv_attr_def_phash)) == NULL) {
 		return PyErr_Format(PyExc_Exception,
 			"Failed creating resv attribute search index");
 	}
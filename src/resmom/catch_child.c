@@ -950,9 +950,12 @@ void
 init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 {
 	DIR		*dir;
-	int		i, sisters;
+	int		i, n, sisters;
 	struct dirent	*pdirent;
 	job		*pj = NULL;
+	char		**jobfiles = NULL;
+	int		njobfiles = 0;
+	int		jobfiles_sz = 0;
 	char		*job_suffix = JOB_FILE_SUFFIX;
 	int		job_suf_len = strlen(job_suffix);
 	char		*psuffix;
@@ -971,6 +974,7 @@ init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 			msg_daemonname, "Jobs directory not found");
 		exit(1);
 	}
+	/* collect the job files first, so they can be read ahead in parallel */
 	while (errno = 0, (pdirent = readdir(dir)) != NULL) {
 		if ((i = strlen(pdirent->d_name)) <= job_suf_len)
 			continue;
@@ -978,10 +982,38 @@ init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 		psuffix = pdirent->d_name + i - job_suf_len;
 		if (strcmp(psuffix, job_suffix))
 			continue;
-		pj = job_recov(pdirent->d_name);
+		if (njobfiles == jobfiles_sz) {
+			char **tmp;
+
+			jobfiles_sz = jobfiles_sz ? jobfiles_sz * 2 : 64;
+			tmp = realloc(jobfiles, jobfiles_sz * sizeof(char *));
+			if (tmp == NULL) {
+				log_err(ENOMEM, __func__, "out of memory");
+				exit(1);
+			}
+			jobfiles = tmp;
+		}
+		if ((jobfiles[njobfiles] = strdup(pdirent->d_name)) == NULL) {
+			log_err(ENOMEM, __func__, "out of memory");
+			exit(1);
+		}
+		njobfiles++;
+	}
+	if (errno != 0 && errno != ENOENT) {
+		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ALERT,
+			msg_daemonname, "Jobs directory cannot be read");
+		(void)closedir(dir);
+		exit(1);
+	}
+	(void)closedir(dir);
+
+	job_recov_prefetch_fs(jobfiles, njobfiles);
+
+	for (n = 0; n < njobfiles; n++) {
+		pj = job_recov(jobfiles[n]);
 		if (pj == NULL) {
 			(void)strcpy(path, path_jobs);
-			(void)strcat(path, pdirent->d_name);
+			(void)strcat(path, jobfiles[n]);
 			(void)unlink(path);
 			psuffix = path + strlen(path) - job_suf_len;
 			strcpy(psuffix, JOB_TASKDIR_SUFFIX);
@@ -1141,13 +1173,9 @@ init_abort_jobs(int recover, pbs_list_head *multinode_jobs)
 			}
 		}
 	}
-	if (errno != 0 && errno != ENOENT) {
-		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ALERT,
-			msg_daemonname, "Jobs directory cannot be read");
-		(void)closedir(dir);
-		exit(1);
-	}
-	(void)closedir(dir);
+	for (n = 0; n < njobfiles; n++)
+		free(jobfiles[n]);
+	free(jobfiles);
 
 	/*
 	 ** Go through spool dir and remove files that match
@@ -1386,6 +1414,9 @@ del_job_resc(job *pjob)
 			pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
 #endif
 		(void)unlink(file);
+		/* whatever $nodefile_compact is now, the job may have one */
+		(void)strcat(file, NODEFILE_COMPACT_SUFFIX);
+		(void)unlink(file);
 	}
 
 	/* TMPDIR removed in job_purge so files are available for staging */
@@ -47,9 +47,16 @@
  *
  *	The data is recorded in a file whose name is the job_id.
  *
+ *	Once a full image of the job has been written, later saves which
+ *	change attributes append a journal record holding only the changed
+ *	attributes.  The file is rewritten in full (compacted) after
+ *	JOB_JOURNAL_MAXRECS such records.
+ *
  *	The following public functions are provided:
  *		job_save_fs() -		save the disk image
  *		job_recov_fs() -		recover (read) job from disk
+ *		job_recov_prefetch_fs() -	read job files ahead of recovery
+ *		job_save_fs_sync() -	sync job files written since last call
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
@@ -80,15 +87,20 @@
 #include "svrfunc.h"
 #include <memory.h>
 #include "libutil.h"
+#ifndef WIN32
+#include <pthread.h>
+#endif
 
 
 #define MAX_SAVE_TRIES 3
+#define MAX_PREFETCH_THREADS 8
 
 /* global data items */
 
 extern char  *path_jobs;
 extern time_t time_now;
 extern char   pbs_recov_filename[];
+extern pbs_list_head svr_alljobs;
 
 /* data global only to this file */
 
@@ -96,18 +108,95 @@ static const size_t fixedsize = sizeof(struct jobfix);
 static const size_t extndsize = sizeof(union jobextend);
 
 
+/**
+ * @brief
+ *		Record which attributes of the job are set, as of a full save
+ *		or recovery, for later journal records.
+ *
+ * @param[in]	pjob - Pointer to the job structure
+ */
+static void
+job_journal_reset(job *pjob)
+{
+	int i;
+
+	for (i = 0; i < JOB_ATR_LAST; i++)
+		pjob->ji_journal_set[i] = is_jattr_set(pjob, i) ? 1 : 0;
+	pjob->ji_journal_recs = 0;
+}
+
+/**
+ * @brief
+ *		Append the changed attributes of a job to its job file
+ *
+ *		The fixed portion is rewritten in place, as for a quick save,
+ *		and a journal record of the changed attributes is appended.
+ *
+ * @param[in]	pjob - Pointer to the job structure to save
+ * @param[in]	filename - the job file holding a full image of the job
+ * @param[in]	pmode - file mode
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure, the file must be rewritten in full
+ */
+static int
+job_journal_fs(job *pjob, char *filename, int pmode)
+{
+	int	fds;
+	int	rc = -1;
+
+	fds = open(filename, O_WRONLY, pmode);
+	if (fds < 0) {
+		log_errf(errno, __func__, "Failed to open %s file", filename);
+		return (-1);
+	}
+#ifdef WIN32
+	setmode(fds, O_BINARY);
+#endif
+
+	save_setup(fds);
+	if ((save_struct((char *)&pjob->ji_qs, fixedsize) == 0) &&
+		(save_struct((char *)&pjob->ji_extended, extndsize) == 0) &&
+		(save_flush() == 0)) {
+		if (lseek(fds, (off_t)0, SEEK_END) < 0) {
+			log_err(errno, __func__, "error lseek");
+		} else {
+			save_setup(fds);
+			if (save_attr_journal_fs(job_attr_def, pjob->ji_wattr,
+				(int)JOB_ATR_LAST, pjob->ji_journal_set) == 0)
+				rc = 0;
+			if (save_flush() != 0)
+				rc = -1;
+		}
+	} else
+		(void)save_flush();
+	(void)close(fds);
+
+	if (rc != 0) {
+		log_err(errno, __func__, "error appending journal record");
+		return (-1);
+	}
+	pjob->ji_journal_recs++;
+	pjob->ji_flags |= MOM_JOB_UNSYNCED;
+	return (0);
+}
+
 /**
  * @brief
  *		Saves (or updates) a job structure image on disk
  *
  *		Save does either - a quick update for state changes only,
- *			 - a full update for an existing file, or
+ *			 - a journal record of changed attributes appended
+ *			   to an existing file,
+ *			 - a full update (compaction) of an existing file, or
  *			 - a full write for a new job
  *
  *		For a quick update, the data written is less than a disk block
  *		size and no size change occurs.
  *
  *		No need of O_SYNC flag as this will improve the performance.
+ *		Written files are instead synced in batches by job_save_fs_sync().
  *		This might lead to data loss from file system in case of system
  *		crash. This is not an issue as data is mostly recovered from the
  *		database.
@@ -135,6 +224,7 @@ job_save_fs(job *pjob)
 	int	redo;
 	int	pmode;
 	int quick = 1;
+	int journal = 1;
 
 #ifdef WIN32
 	pmode = _S_IWRITE | _S_IREAD;
@@ -156,6 +246,7 @@ job_save_fs(job *pjob)
 		/* version of job structure changed, force full write */
 		pjob->ji_qs.ji_jsversion = JSVERSION;
 		quick = 0;
+		journal = 0;
 	}
 
 	for (i = 0; i < JOB_ATR_LAST; i++) {
@@ -185,6 +276,7 @@ job_save_fs(job *pjob)
 			(save_struct((char *)&pjob->ji_extended, extndsize) == 0) &&
 			(save_flush() == 0)) {
 			(void)close(fds);
+			pjob->ji_flags |= MOM_JOB_UNSYNCED;
 		} else {
 			log_err(errno, "job_save", "error quickwrite");
 			(void)close(fds);
@@ -195,6 +287,15 @@ job_save_fs(job *pjob)
 		/* an attribute changed,  update mtime */
 		set_jattr_l_slim(pjob, JOB_ATR_mtime, time_now, SET);
 
+		/*
+		 * if the file already holds a full image of the job, just
+		 * append the changed attributes unless it is time to compact
+		 */
+		if (journal && (pjob->ji_flags & MOM_JOB_SAVED) &&
+			(pjob->ji_journal_recs < JOB_JOURNAL_MAXRECS) &&
+			(job_journal_fs(pjob, namebuf1, pmode) == 0))
+			return (0);
+
 		/*
 		 * write the whole structure to the file.
 		 * For a update, this is done to a new file to protect the
@@ -274,8 +375,12 @@ job_save_fs(job *pjob)
 				PBS_EVENTCLASS_JOB, LOG_ERR,
 				pjob->ji_qs.ji_jobid,
 				"rename in job_save failed");
+			pjob->ji_flags &= ~MOM_JOB_SAVED;
+			return (0);
 		}
 #endif
+		job_journal_reset(pjob);
+		pjob->ji_flags |= (MOM_JOB_SAVED | MOM_JOB_UNSYNCED);
 	}
 	return (0);
 }
@@ -308,6 +413,7 @@ job_recov_fs(char *filename)
 	job		*pj;
 	char		*pn;
 	char		*psuffix;
+	int		 nrec;
 
 
 	pj = job_alloc();	/* allocate & initialize job structure space */
@@ -443,6 +549,15 @@ job_recov_fs(char *filename)
 		(void)close(fds);
 		return NULL;
 	}
+
+	/* replay attribute changes journaled since the last full save */
+
+	nrec = recov_attr_journal_fs(fds, pj, job_attr_idx, job_attr_def,
+		pj->ji_wattr, (int)JOB_ATR_LAST, (int)JOB_ATR_UNKN);
+	job_journal_reset(pj);
+	pj->ji_flags |= MOM_JOB_SAVED;
+	/* a damaged journal tail forces a full rewrite on the next save */
+	pj->ji_journal_recs = (nrec < 0) ? JOB_JOURNAL_MAXRECS : nrec;
 	(void)close(fds);
 
 #if defined(WIN32)
@@ -470,3 +585,125 @@ job_recov_fs(char *filename)
 
 	return (pj);
 }
+
+#ifndef WIN32
+struct prefetch_arg {
+	char	**names;	/* job file names, relative to path_jobs */
+	int	  count;	/* number of names */
+	int	  first;	/* first name handled by this thread */
+	int	  stride;	/* number of threads */
+};
+
+/**
+ * @brief
+ *		Thread routine: read a share of the job files so they are in
+ *		the page cache when job_recov_fs() reads them.
+ *
+ * @param[in]	arg - struct prefetch_arg describing this thread's share
+ *
+ * @return	NULL
+ */
+static void *
+job_prefetch_thread(void *arg)
+{
+	struct prefetch_arg *pa = (struct prefetch_arg *)arg;
+	char	path[MAXPATHLEN+1];
+	char	buf[8192];
+	int	fds;
+	int	i;
+
+	for (i = pa->first; i < pa->count; i += pa->stride) {
+		snprintf(path, sizeof(path), "%s%s", path_jobs, pa->names[i]);
+		if ((fds = open(path, O_RDONLY, 0)) < 0)
+			continue;
+		while (read(fds, buf, sizeof(buf)) > 0)
+			;
+		(void)close(fds);
+	}
+	return NULL;
+}
+#endif
+
+/**
+ * @brief
+ *		Read a set of job files in parallel ahead of their recovery.
+ *
+ *		Decoding a job in job_recov_fs() uses process wide state and so
+ *		remains serial; this only overlaps the file reads, which is
+ *		where a MoM restarting with many jobs spends its time.
+ *
+ * @param[in]	names - job file names, relative to path_jobs
+ * @param[in]	count - number of names
+ *
+ * @return	void
+ */
+void
+job_recov_prefetch_fs(char **names, int count)
+{
+#ifndef WIN32
+	pthread_t		threads[MAX_PREFETCH_THREADS];
+	struct prefetch_arg	args[MAX_PREFETCH_THREADS];
+	int			nthreads;
+	int			started = 0;
+	int			i;
+
+	nthreads = count / 16 + 1;
+	if (nthreads > MAX_PREFETCH_THREADS)
+		nthreads = MAX_PREFETCH_THREADS;
+	if (nthreads < 2)
+		return;
+
+	for (i = 0; i < nthreads; i++) {
+		args[i].names = names;
+		args[i].count = count;
+		args[i].first = i;
+		args[i].stride = nthreads;
+		if (pthread_create(&threads[i], NULL, job_prefetch_thread, &args[i]) != 0) {
+			log_err(errno, __func__, "could not start prefetch thread");
+			break;
+		}
+		started++;
+	}
+	for (i = 0; i < started; i++)
+		(void)pthread_join(threads[i], NULL);
+#endif
+}
+
+/**
+ * @brief
+ *		Sync to disk the job files written since the previous call.
+ *
+ *		Called periodically from the main loop, so that the cost of
+ *		syncing is paid once per interval rather than on every save.
+ *
+ * @return	void
+ */
+void
+job_save_fs_sync(void)
+{
+	job	*pjob;
+	int	fds;
+	char	namebuf[MAXPATHLEN+1];
+
+	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob != NULL;
+		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
+		if ((pjob->ji_flags & MOM_JOB_UNSYNCED) == 0)
+			continue;
+		pjob->ji_flags &= ~MOM_JOB_UNSYNCED;
+
+		(void)strcpy(namebuf, path_jobs);
+		if (*pjob->ji_qs.ji_fileprefix != '\0')
+			(void)strcat(namebuf, pjob->ji_qs.ji_fileprefix);
+		else
+			(void)strcat(namebuf, pjob->ji_qs.ji_jobid);
+		(void)strcat(namebuf, JOB_FILE_SUFFIX);
+
+#ifndef WIN32
+		if ((fds = open(namebuf, O_RDONLY, 0)) < 0)
+			continue;
+		if (fsync(fds) == -1)
+			log_errf(errno, __func__, "fsync of %s failed", namebuf);
+		(void)close(fds);
+#endif
+	}
+}
@@ -42,6 +42,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 #include <errno.h>
@@ -50,11 +51,12 @@
 #include "batch_request.h"
 #include "job.h"
 #include "log.h"
-#include "mock_run.h"
 #include "mom_func.h"
+#include "mock_run.h"
 #include "pbs_error.h"
 #include "resource.h"
 #include "mom_server.h"
+#include "placementsets.h"
 
 #if defined(PBS_SECURITY) && (PBS_SECURITY == KRB5)
 #include "renew_creds.h"
@@ -64,6 +66,308 @@ extern time_t time_now;
 extern time_t time_resc_updated;
 extern int min_check_poll;
 extern int next_sample_time;
+extern vnl_t *vnlp;
+extern char mom_short_name[];
+extern callfunc_t vn_callback;
+
+/* how long a mock job runs, set by $mock_run_runtime */
+enum mock_runtime {
+	MOCK_RUNTIME_WALLTIME,	/* the walltime the job asked for */
+	MOCK_RUNTIME_FIXED,	/* mock_runtime_min seconds */
+	MOCK_RUNTIME_UNIFORM	/* mock_runtime_min to mock_runtime_max seconds */
+};
+
+static enum mock_runtime mock_runtime = MOCK_RUNTIME_WALLTIME;
+static long mock_runtime_min = 0;
+static long mock_runtime_max = 0;
+static int mock_fail_pct = 0;		/* $mock_run_fail_pct */
+static int mock_vnodes = 0;		/* $mock_run_vnodes */
+static int mock_vnodes_added = 0;	/* mock vnodes now in vnlp */
+static int mock_vnode_ncpus = 4;
+static char mock_vnode_mem[64] = "8gb";
+
+/**
+ * @brief	reset the mock run config parameters to their defaults
+ *		before the config files are (re)read
+ *
+ * @return void
+ */
+void
+mock_run_reset_config(void)
+{
+	mock_runtime = MOCK_RUNTIME_WALLTIME;
+	mock_runtime_min = 0;
+	mock_runtime_max = 0;
+	mock_fail_pct = 0;
+	mock_vnodes = 0;
+	mock_vnode_ncpus = 4;
+	strcpy(mock_vnode_mem, "8gb");
+}
+
+/**
+ * @brief	config handler for $mock_run_runtime: "walltime", a number
+ *		of seconds, or "uniform:<min>:<max>" seconds
+ *
+ * @param[in]	value - value of the config parameter
+ *
+ * @return	handler_ret_t
+ * @retval	HANDLER_SUCCESS	success
+ * @retval	HANDLER_FAIL	bad value
+ */
+handler_ret_t
+mock_run_set_runtime(char *value)
+{
+	long	min, max;
+	char	*endp;
+
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		"mock_run_runtime", value);
+
+	if (strcmp(value, "walltime") == 0) {
+		mock_runtime = MOCK_RUNTIME_WALLTIME;
+		return HANDLER_SUCCESS;
+	}
+	if (sscanf(value, "uniform:%ld:%ld", &min, &max) == 2) {
+		if ((min < 0) || (max < min))
+			return HANDLER_FAIL;
+		mock_runtime = MOCK_RUNTIME_UNIFORM;
+		mock_runtime_min = min;
+		mock_runtime_max = max;
+		return HANDLER_SUCCESS;
+	}
+	min = strtol(value, &endp, 10);
+	if ((*endp != '\0') || (endp == value) || (min < 0))
+		return HANDLER_FAIL;
+	mock_runtime = MOCK_RUNTIME_FIXED;
+	mock_runtime_min = min;
+	return HANDLER_SUCCESS;
+}
+
+/**
+ * @brief	config handler for $mock_run_fail_pct, the percentage of
+ *		mock jobs that end with a non-zero exit status
+ *
+ * @param[in]	value - value of the config parameter
+ *
+ * @return	handler_ret_t
+ * @retval	HANDLER_SUCCESS	success
+ * @retval	HANDLER_FAIL	bad value
+ */
+handler_ret_t
+mock_run_set_fail_pct(char *value)
+{
+	long	i;
+	char	*endp;
+
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		"mock_run_fail_pct", value);
+	i = strtol(value, &endp, 10);
+	if ((*endp != '\0') || (endp == value) || (i < 0) || (i > 100))
+		return HANDLER_FAIL;
+	mock_fail_pct = (int)i;
+	return HANDLER_SUCCESS;
+}
+
+/**
+ * @brief	config handler for $mock_run_vnodes: "<count> [<ncpus> [<mem>]]",
+ *		the number of vnodes this MoM reports in mock run mode and
+ *		the resources of each
+ *
+ * @param[in]	value - value of the config parameter
+ *
+ * @return	handler_ret_t
+ * @retval	HANDLER_SUCCESS	success
+ * @retval	HANDLER_FAIL	bad value
+ */
+handler_ret_t
+mock_run_set_vnodes(char *value)
+{
+	int	count;
+	int	ncpus = 4;
+	char	mem[sizeof(mock_vnode_mem)] = "8gb";
+
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_NOTICE,
+		"mock_run_vnodes", value);
+	if (sscanf(value, "%d %d %63s", &count, &ncpus, mem) < 1)
+		return HANDLER_FAIL;
+	if ((count < 0) || (ncpus < 0))
+		return HANDLER_FAIL;
+	mock_vnodes = count;
+	mock_vnode_ncpus = ncpus;
+	strcpy(mock_vnode_mem, mem);
+	return HANDLER_SUCCESS;
+}
+
+/**
+ * @brief	index of a mock vnode from its name, "<mom>[<index>]"
+ *
+ * @param[in]	id - vnode name
+ *
+ * @return	int
+ * @retval	>=0	index of the mock vnode
+ * @retval	-1	not a mock vnode
+ */
+static int
+mock_vnode_index(char *id)
+{
+	size_t	len = strlen(mom_short_name);
+	char	*endp;
+	long	i;
+
+	if ((strncmp(id, mom_short_name, len) != 0) || (id[len] != '['))
+		return -1;
+	i = strtol(id + len + 1, &endp, 10);
+	if ((endp == id + len + 1) || (strcmp(endp, "]") != 0) || (i < 0))
+		return -1;
+	return (int)i;
+}
+
+/**
+ * @brief	remove the mock vnodes from index 'count' on from the vnode
+ *		list, after $mock_run_vnodes was lowered.  With no mock vnodes
+ *		left, the natural vnode gets back the ncpus it had given up.
+ *		The server marks the vnodes no longer reported as stale.
+ *
+ * @param[in]	count - number of mock vnodes to keep
+ *
+ * @return void
+ */
+static void
+mock_run_drop_vnodes(int count)
+{
+	vnl_t	*nv = NULL;
+	int	i, j;
+
+	if (vnl_alloc(&nv) == NULL)
+		return;
+
+	for (i = 0; i < vnlp->vnl_used; i++) {
+		vnal_t	*vnalp = VNL_NODENUM(vnlp, i);
+
+		if (mock_vnode_index(vnalp->vnal_id) >= count)
+			continue;
+		for (j = 0; j < vnalp->vnal_used; j++) {
+			vna_t	*vnap = VNAL_NODENUM(vnalp, j);
+
+			if ((count == 0) &&
+				(strcmp(vnalp->vnal_id, mom_short_name) == 0) &&
+				(strcmp(vnap->vna_name, ATTR_rescavail ".ncpus") == 0))
+				continue;
+			if (vn_addvnr(nv, vnalp->vnal_id, vnap->vna_name,
+				vnap->vna_val, vnap->vna_type, vnap->vna_flag,
+				NULL) != 0) {
+				log_err(PBSE_SYSTEM, __func__, "vn_addvnr failed");
+				vnl_free(nv);
+				return;
+			}
+		}
+	}
+	nv->vnl_modtime = time(NULL);
+	vnl_free(vnlp);
+	vnlp = nv;
+
+	sprintf(log_buffer, "mock run no longer reporting vnodes %d to %d",
+		count, mock_vnodes_added - 1);
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO, __func__, log_buffer);
+}
+
+/**
+ * @brief	add the $mock_run_vnodes vnodes to the vnode list reported
+ *		to the server.  Each vnode has its own resources_available.host,
+ *		so the server and scheduler see one host per vnode.
+ *
+ * @par Limitation
+ *	The vnodes are not separate MoMs.  They all belong to this MoM and
+ *	share its one TPP identity, so the server keeps a single stream and
+ *	a single mom state for all of them.  A job spanning several of them
+ *	has no sister MoMs, no inter-MoM (IM) traffic and no per-host
+ *	down/up handling.  To load pbs_comm or the server's MoM handling
+ *	with many streams, run several mock MoMs on different ports instead.
+ *
+ * @return void
+ */
+void
+mock_run_vnodes(void)
+{
+	vnl_t	*vtp = NULL;
+	char	vname[PBS_MAXHOSTNAME + 16];
+	char	host[PBS_MAXHOSTNAME + 16];
+	char	ncpus[16];
+	int	i;
+
+	/* the config is read again on HUP and may ask for fewer vnodes */
+	if ((mock_vnodes < mock_vnodes_added) && (vnlp != NULL)) {
+		mock_run_drop_vnodes(mock_vnodes);
+		mock_vnodes_added = mock_vnodes;
+	}
+
+	if (mock_vnodes <= 0)
+		return;
+
+	if (vnl_alloc(&vtp) == NULL)
+		return;
+
+	/* jobs go to the mock vnodes, not the natural one */
+	if (vn_addvnr(vtp, mom_short_name, ATTR_rescavail ".ncpus", "0",
+		0, 0, NULL) != 0)
+		goto err;
+
+	sprintf(ncpus, "%d", mock_vnode_ncpus);
+	for (i = 0; i < mock_vnodes; i++) {
+		sprintf(vname, "%s[%d]", mom_short_name, i);
+		sprintf(host, "%s-%d", mom_short_name, i);
+		if ((vn_addvnr(vtp, vname, ATTR_rescavail ".ncpus", ncpus, 0, 0, NULL) != 0) ||
+			(vn_addvnr(vtp, vname, ATTR_rescavail ".mem", mock_vnode_mem, 0, 0, NULL) != 0) ||
+			(vn_addvnr(vtp, vname, ATTR_rescavail ".host", host, 0, 0, NULL) != 0))
+			goto err;
+	}
+	vtp->vnl_modtime = time(NULL);
+
+	if (vnlp == NULL)
+		vnlp = vtp;
+	else {
+		vn_merge(vnlp, vtp, vn_callback);
+		vnl_free(vtp);
+	}
+	mock_vnodes_added = mock_vnodes;
+
+	sprintf(log_buffer, "mock run reporting %d vnodes", mock_vnodes);
+	log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, LOG_INFO, __func__, log_buffer);
+	return;
+
+err:
+	log_err(PBSE_SYSTEM, __func__, "vn_addvnr failed");
+	vnl_free(vtp);
+}
+
+/**
+ * @brief	how long a mock job runs, per $mock_run_runtime, never
+ *		beyond the walltime it asked for
+ *
+ * @param[in]	walltime - walltime requested, 0 if none
+ *
+ * @return	long - run time in seconds
+ */
+static long
+mock_run_runtime(long walltime)
+{
+	long runtime;
+
+	switch (mock_runtime) {
+		case MOCK_RUNTIME_FIXED:
+			runtime = mock_runtime_min;
+			break;
+		case MOCK_RUNTIME_UNIFORM:
+			runtime = mock_runtime_min +
+				random() % (mock_runtime_max - mock_runtime_min + 1);
+			break;
+		default:
+			return walltime;
+	}
+	if ((walltime > 0) && (runtime > walltime))
+		runtime = walltime;
+	return runtime;
+}
 
 void
 mock_run_finish_exec(job *pjob)
@@ -82,7 +386,7 @@ mock_run_finish_exec(job *pjob)
 	time_now = time(NULL);
 
 	/* Add a work task that runs when the job is supposed to end */
-	set_task(WORK_Timed, time_now + walltime, mock_run_end_job_task, pjob);
+	set_task(WORK_Timed, time_now + mock_run_runtime(walltime), mock_run_end_job_task, pjob);
 
 	sprintf(log_buffer, "Started mock run of job");
 	log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB,
@@ -133,7 +437,11 @@ mock_run_end_job_task(struct work_task *ptask)
 	set_job_state(pjob, JOB_STATE_LTR_EXITING);
 	set_job_substate(pjob, JOB_SUBSTATE_EXITING);
 
-	pjob->ji_qs.ji_un.ji_momt.ji_exitstat = JOB_EXEC_OK;
+	/* $mock_run_fail_pct of the jobs fail */
+	if ((mock_fail_pct > 0) && ((random() % 100) < mock_fail_pct))
+		pjob->ji_qs.ji_un.ji_momt.ji_exitstat = 1;
+	else
+		pjob->ji_qs.ji_un.ji_momt.ji_exitstat = JOB_EXEC_OK;
 
 	scan_for_exiting();
 }
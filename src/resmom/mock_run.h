@@ -59,6 +59,16 @@ int mock_run_mom_set_use(job *pjob);
 
 void mock_run_job_purge(job *pjob);
 
+void mock_run_reset_config(void);
+
+handler_ret_t mock_run_set_runtime(char *value);
+
+handler_ret_t mock_run_set_fail_pct(char *value);
+
+handler_ret_t mock_run_set_vnodes(char *value);
+
+void mock_run_vnodes(void);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -111,6 +111,7 @@ extern char mom_short_name[];
 extern unsigned int pbs_mom_port;
 extern unsigned int pbs_rm_port;
 extern int gen_nodefile_on_sister_mom;
+extern int nodefile_compact;
 extern int nsvrs;
 
 extern int mom_net_up;
@@ -3158,7 +3159,16 @@ im_request(int stream, int version)
 			if (gen_nodefile_on_sister_mom) {
 				char varlist[(2 * MAXPATHLEN) + 1] = "PBS_NODEFILE=";
 				char buf[MAXPATHLEN + 1];
-				if (generate_pbs_nodefile(pjob, buf, sizeof(buf) - 1, log_buffer, LOG_BUF_SIZE - 1) == 0) {
+				if (nodefile_compact) {
+					/* the expanded form is written by the task, see finish_pbs_nodefile() */
+					if (generate_pbs_nodefile_compact(pjob, buf, sizeof(buf) - 1, log_buffer, LOG_BUF_SIZE - 1) == 0) {
+						snprintf(varlist, sizeof(varlist), "PBS_NODEFILE_COMPACT=%s", buf);
+						set_jattr_generic(pjob, JOB_ATR_variables, varlist, NULL, INCR);
+						snprintf(varlist, sizeof(varlist), "PBS_NODEFILE=%s/aux/%s",
+							pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
+						set_jattr_generic(pjob, JOB_ATR_variables, varlist, NULL, INCR);
+					}
+				} else if (generate_pbs_nodefile(pjob, buf, sizeof(buf) - 1, log_buffer, LOG_BUF_SIZE - 1) == 0) {
 					strcat(varlist, buf);
 					set_jattr_generic(pjob, JOB_ATR_variables, varlist, NULL, INCR);
 				}
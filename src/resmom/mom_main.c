@@ -118,6 +118,7 @@
 #include	"work_task.h"
 #include	"pbs_share.h"
 #include	"mom_server.h"
+#include	"mock_run.h"
 #if	MOM_ALPS
 #include	"mom_mach.h"
 #endif	/* MOM_ALPS */
@@ -290,6 +291,7 @@ int cycle_harvester = 0;		/* MOM configured for cycle harvesting */
 int restrict_user = 0;			/* kill non PBS user procs */
 int restrict_user_maxsys = 999; /* largest system user id */
 int gen_nodefile_on_sister_mom = TRUE;
+int nodefile_compact = FALSE;		/* write PBS_NODEFILE_COMPACT */
 int vnode_additive = 1;
 momvmap_t **mommap_array = NULL;
 int mommap_array_size = 0;
@@ -475,6 +477,7 @@ static handler_ret_t set_restrict_user(char *);
 static handler_ret_t set_restrict_user_maxsys(char *);
 static handler_ret_t set_restrict_user_exceptions(char *);
 static handler_ret_t set_gen_nodefile_on_sister_mom(char *);
+static handler_ret_t set_nodefile_compact(char *);
 static handler_ret_t set_suspend_signal(char *);
 static handler_ret_t set_tmpdir(char *);
 static handler_ret_t set_vnode_additive(char *);
@@ -543,6 +546,10 @@ static struct	specials {
 	{ "restrict_user_maxsysid",	set_restrict_user_maxsys },
 	{ "restricted",			restricted },
 	{ "gen_nodefile_on_sister_mom",  set_gen_nodefile_on_sister_mom},
+	{ "mock_run_runtime",		mock_run_set_runtime },
+	{ "mock_run_fail_pct",		mock_run_set_fail_pct },
+	{ "mock_run_vnodes",		mock_run_set_vnodes },
+	{ "nodefile_compact",  set_nodefile_compact},
 #ifdef NAS /* localmod 015 */
 	/*
 	 * spool size limit
@@ -2330,6 +2337,12 @@ do_mom_action_script(int ae,	      /* index into action table */
 		/* PBS_NODEFILE */
 		sprintf(buf, "%s/aux/%s", pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
 		bld_env_variables(&vtable, variables_else[11], buf);
+		/* PBS_NODEFILE_COMPACT */
+		if (nodefile_compact) {
+			sprintf(buf, "%s/aux/%s%s", pbs_conf.pbs_home_path,
+				pjob->ji_qs.ji_jobid, NODEFILE_COMPACT_SUFFIX);
+			bld_env_variables(&vtable, variables_else[16], buf);
+		}
 		/* PBS_SID */
 		sprintf(buf, "%d", ptask->ti_qs.ti_sid);
 		bld_env_variables(&vtable, "PBS_SID", buf);
@@ -3525,6 +3538,26 @@ set_gen_nodefile_on_sister_mom(char *value)
 	return (set_boolean(__func__, value, &gen_nodefile_on_sister_mom));
 }
 
+/**
+ * @brief
+ *      sets value for nodefile_compact, which makes job start write
+ *      the "host:count" PBS_NODEFILE_COMPACT and leaves the expanded
+ *      PBS_NODEFILE to be written from the main loop
+ *
+ * @param[in] value - value for nodefile_compact
+ *
+ * @return      handler_ret_t
+ * @retval      HANDLER_SUCCESS         success
+ * @retval      HANDLER_FAIL            Failure
+ *
+ */
+
+static handler_ret_t
+set_nodefile_compact(char *value)
+{
+	return (set_boolean(__func__, value, &nodefile_compact));
+}
+
 /**
  * @brief
  *	Set the configuration flag that defines whether to get rid of
@@ -4026,6 +4059,8 @@ read_config(char *file)
 	restrict_user = 0;
 	restrict_user_maxsys = 999;
 	gen_nodefile_on_sister_mom = TRUE;
+	nodefile_compact = FALSE;
+	mock_run_reset_config();
 	for (j=0; j < NUM_RESTRICT_USER_EXEMPT_UIDS; j++)
 		if (restrict_user_exempt_uids[j] != 0)
 			restrict_user_exempt_uids[j] = 0;
@@ -4074,6 +4109,9 @@ read_config(char *file)
 
 	addconfig_ret = do_addconfigs();
 
+	if (mock_run)
+		mock_run_vnodes();
+
 	/* check for any bad combinations */
 	if (min_check_poll > max_check_poll) {
 		sprintf(log_buffer, "min_check_poll(%u) > max_check_poll(%u)",
@@ -7379,7 +7417,7 @@ main(int argc, char *argv[])
 
 #endif /* !WIN32 */
 
-	if ((job_attr_idx = cr_attrdef_idx(job_attr_def, JOB_ATR_LAST)) == NULL) {
+	if ((job_attr_idx = cr_attrdef_idx(job_attr_def, JOB_ATR_LAST, &job_attr_def_phash)) == NULL) {
 		log_err(errno, __func__, "Failed creating job attribute search index");
 		return (-1);
 	}
@@ -8466,6 +8504,9 @@ main(int argc, char *argv[])
 		if (time_now > time_state_update) {
 			time_state_update = time_now + STATE_UPDATE_TIME;
 
+			/* sync the job files written since the last update */
+			job_save_fs_sync();
+
 			/*
 			 * If required, update node state info to Server
 			 * check if loadave means we should be "busy"
@@ -8479,8 +8520,10 @@ main(int argc, char *argv[])
 
 		/*
 		 * if needed, update server with my state change can be changed in
-		 * check_busy() or query_adp()
+		 * check_busy() or query_adp(), or with vnode changes
 		 */
+		if (vnl_report_pending())
+			internal_state_update = UPDATE_MOM_STATE;
 		if (internal_state_update) {
 			state_to_server(UPDATE_VNODES, 0);
 
@@ -8848,6 +8891,8 @@ main(int argc, char *argv[])
 	while ((pjob = (job *)GET_NEXT(mom_deadjobs)) != NULL)
 		job_purge_mom(pjob);
 
+	job_save_fs_sync();
+
 	{
 		int csret;
 		if ((csret = CS_close_app()) != CS_SUCCESS) {
@@ -131,6 +131,10 @@ extern	int	report_hook_checksums;
 
 int nsvrs = 0;
 
+static vnl_t	*vnlp_reported = NULL;	/* vnlp as last sent to the server */
+static unsigned long vnlp_reported_changes;	/* vnl_changes of vnlp when sent */
+static int	server_takes_delta = 0;	/* server accepts IS_UPDATE_DELTA */
+
 /*
  * Tree search generalized from Knuth (6.2.2) Algorithm T just like
  * the AT&T man page says.
@@ -702,6 +706,17 @@ is_request(int stream, int version)
 			if (ret != DIS_SUCCESS)
 				goto err;
 
+			/*
+			 * A server asking for the inventory has none of the vnodes
+			 * we reported, and says whether it takes deltas.  One that
+			 * does not ask still holds what we last reported to it.
+			 */
+			if (need_inv != IS_NEED_INV_NONE) {
+				server_takes_delta = (need_inv == IS_NEED_INV_DELTA);
+				vnl_free(vnlp_reported);
+				vnlp_reported = NULL;
+			}
+
 			nsvrs = disrsi(stream, &ret);
 			if (ret != DIS_SUCCESS)
 				goto err;
@@ -1117,6 +1132,51 @@ hook_requests_to_server_err:
 	return (ret);
 }
 
+/**
+ * @brief
+ *	Remember the vnode list as the server now has it, the base of the
+ *	next IS_UPDATE_DELTA.
+ *
+ * @param[in]	vnl - vnode list just sent in full, or with all its changes
+ *
+ * @return void
+ */
+static void
+vnl_reported(vnl_t *vnl)
+{
+	vnl_t	*copy = NULL;
+
+	vnl_free(vnlp_reported);
+	vnlp_reported = NULL;
+
+	if (vnl_alloc(&copy) == NULL)
+		return;
+	if (vn_merge(copy, vnl, NULL) == NULL) {
+		vnl_free(copy);
+		return;
+	}
+	copy->vnl_modtime = vnl->vnl_modtime;
+	vnlp_reported = copy;
+	vnlp_reported_changes = vnl->vnl_changes;
+}
+
+/**
+ * @brief
+ *	Tell whether the vnode list changed since it was last reported, so
+ *	the change can be sent without waiting for a MoM state change.
+ *
+ * @return int
+ * @retval	1: vnlp was modified after the last report
+ * @retval	0: no change, or the server is not taking deltas
+ */
+int
+vnl_report_pending(void)
+{
+	if (!server_takes_delta || (vnlp == NULL) || (vnlp_reported == NULL))
+		return 0;
+	return (vnlp->vnl_changes != vnlp_reported_changes);
+}
+
 /**
  * @brief
  * 	state_to_server() - if UPDATE_MOM_STATE is set, send state update message to
@@ -1128,7 +1188,10 @@ hook_requests_to_server_err:
  * @param[in]	combine_msg	- combine message in the caller.
  *
  *	If we have placement set information to send, we use IS_UPDATE2;
- *	otherwise, we fall back to IS_UPDATE.
+ *	otherwise, we fall back to IS_UPDATE.  Once the server holds a full
+ *	IS_UPDATE2 from this session, and said at hello it takes them,
+ *	IS_UPDATE_DELTA carries only the vnode attributes changed since;
+ *	a vnode or attribute going away still needs a full IS_UPDATE2.
  *
  * @return int
  * @retval	0: success
@@ -1144,6 +1207,7 @@ state_to_server(int what_to_update, int combine_msg)
 	char			*pv;
 	int			use_UPDATE2 = 0;
 	int			cmd = IS_UPDATE;
+	vnl_t			*delta = NULL;
 
 	if (internal_state_update == 0)
 		return 0;
@@ -1165,6 +1229,10 @@ state_to_server(int what_to_update, int combine_msg)
 	if ((vnlp != NULL) && (what_to_update == UPDATE_VNODES)) {
 		use_UPDATE2 = 1;
 		cmd = IS_UPDATE2;
+		if (!combine_msg && server_takes_delta && (vnlp_reported != NULL)) {
+			if ((delta = vn_delta(vnlp_reported, vnlp)) != NULL)
+				cmd = IS_UPDATE_DELTA;
+		}
 	}
 
 	if (!combine_msg)
@@ -1205,7 +1273,7 @@ state_to_server(int what_to_update, int combine_msg)
 		vnlp->vnl_modtime = time(0);
 #endif	/* MOM_ALPS */
 
-		if ((ret = vn_encode_DIS(server_stream, vnlp)) != DIS_SUCCESS)	/* vnode list */
+		if ((ret = vn_encode_DIS(server_stream, (delta != NULL) ? delta : vnlp)) != DIS_SUCCESS)	/* vnode list */
 			goto err;
 	}
 
@@ -1215,9 +1283,18 @@ state_to_server(int what_to_update, int combine_msg)
 	if (!combine_msg)
 		dis_flush(server_stream);
 	internal_state_update = 0;
+
+	if (use_UPDATE2 && server_takes_delta) {
+		if ((delta == NULL) || (delta->vnl_used > 0))
+			vnl_reported(vnlp);
+		else
+			vnlp_reported_changes = vnlp->vnl_changes;
+	}
+	vnl_free(delta);
 	return 0;
 
 err:
+	vnl_free(delta);
 	log_err(errno, "state_to_server", (char *)dis_emsg[ret]);
 	tpp_close(server_stream);
 	server_stream = -1;
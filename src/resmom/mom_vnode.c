@@ -481,6 +481,7 @@ resadj(vnl_t *vp, const char *vnid, const char *res, enum res_op op,
 				if (vna_newval != NULL) {
 					free(vnap->vna_val);
 					vnap->vna_val = vna_newval;
+					vnl_changed(vp);
 				} else
 					log_err(PBSE_SYSTEM, __func__, "vna_newval strdup failed");
 				return;
@@ -53,6 +53,7 @@
 #include <pwd.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
+#include <spawn.h>
 #include "libpbs.h"
 #include "list_link.h"
 #include "server_limits.h"
@@ -70,6 +71,7 @@ static pid_t	child;
 static int	run_exit;
 
 extern int pe_input(char *jobid);
+extern char **environ;
 
 /**
  * @brief
@@ -163,6 +165,30 @@ int sig;
 	run_exit = -4;
 }
 
+/**
+ * @brief
+ *	pelog_fd - move a descriptor for the script above the standard ones,
+ *	so they can all be put in place in the new process without one
+ *	overwriting another.
+ *
+ * @param[in] fd - file descriptor, or -1
+ *
+ * @return int
+ * @retval the descriptor to use, -1 if none
+ *
+ */
+static int
+pelog_fd(int fd)
+{
+	int nfd;
+
+	if ((fd < 0) || (fd > STDERR_FILENO))
+		return (fd);
+	nfd = fcntl(fd, F_DUPFD, STDERR_FILENO + 1);
+	(void)close(fd);
+	return (nfd);
+}
+
 /**
  * @brief
  *	run_pelog() - Run the Prologue/Epilogue script
@@ -216,6 +242,11 @@ int   pe_io_type;
 	int		fd_input;
 	int		waitst;
 	char	 buf[MAXNAMLEN + MAXPATHLEN + 2];
+	int		fds1 = -1;
+	int		fds2 = -1;
+	int		rc;
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t spattr;
 
 	if (stat(pelog, &sbuf) == -1) {
 		if (errno == ENOENT)
@@ -236,176 +267,174 @@ int   pe_io_type;
 			"no pro/epilogue input file"));
 	}
 
-	run_exit = 0;
-	child = fork();
-	if (child > 0) {	/* parent */
-		(void)close(fd_input);
-		sprintf(log_buffer, "running %s",
-			which == PE_PROLOGUE ? "prologue" : "epilogue");
-		log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO,
-			pjob->ji_qs.ji_jobid, log_buffer);
-
-		act.sa_handler = pelogalm;
-		sigemptyset(&act.sa_mask);
-		act.sa_flags = 0;
-		sigaction(SIGALRM, &act, 0);
-		alarm(pe_alarm_time);
-		while (wait(&waitst) < 0) {
-			if (errno != EINTR) {	/* continue loop on signal */
-				run_exit = -3;
-				break;
-			}
-			kill(-child, SIGKILL);
-		}
-		alarm(0);
-		act.sa_handler = SIG_DFL;
-		sigaction(SIGALRM, &act, 0);
-		kill(-child, SIGKILL);
-		if (run_exit == 0) {
-			if (WIFEXITED(waitst)) {
-				run_exit = WEXITSTATUS(waitst);
-			} else if (WIFSIGNALED(waitst)) {
-				run_exit = -3;
-			}
-		} else {
-			sprintf(log_buffer, "completed %s, exit=%d",
-				which == PE_PROLOGUE ? "prologue" : "epilogue",
-				run_exit);
-			log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO,
-				pjob->ji_qs.ji_jobid, log_buffer);
-		}
-
-	} else {		/* child */
-		/*
-		 * For sanity sake we make sure the following are defined.
-		 * They should have been defined in unistd.h
-		 */
-#ifndef STDIN_FILENO
-#define STDIN_FILENO 0
-#endif
-#ifndef STDOUT_FILENO
-#define STDOUT_FILENO 1
-#endif
-#ifndef STDERR_FILENO
-#define STDERR_FILENO 2
-#endif
-
-		/*
-		 ** As these fd variabes (fds1(2)) are used in the child
-		 ** process, define here only.
-		 */
-		int	fds1 = -1;
-		int	fds2 = -1;
-
-		if (fd_input != 0) {
-			(void)close(STDIN_FILENO);
-			(void)dup(fd_input);
-			(void)close(fd_input);
-		}
-
-		/* unprotect from kernel killers (such as oom) */
-		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
-
+	/*
+	 * If PE_IO_TYPE_ASIS, leave stdout/stderr alone as they
+	 * are already open to job. Otherwise, open the files which
+	 * become FDs 1 and 2 of the script, being careful to join
+	 * them where necessary.
+	 */
+	if (pe_io_type == PE_IO_TYPE_NULL) {
+		/* No output, force to /dev/null */
+		fds1 = open("/dev/null", O_WRONLY, 0600);
+		fds2 = dup(fds1);
+	} else if (pe_io_type == PE_IO_TYPE_STD) {
+		int join_method;
 		/*
-		 * If PE_IO_TYPE_ASIS, leave stdout/stderr alone as they
-		 * are already open to job. Otherwise, set FDs 1 and 2
-		 * appropriately being careful to join them where
-		 * necessary.
+		 * Do not open an output file unless it will be used.
+		 * Otherwise, it will be left behind in spool.
 		 */
-		if (pe_io_type == PE_IO_TYPE_NULL) {
-			/* Close any existing stdout/stderr. */
-			(void)close(STDOUT_FILENO);
-			(void)close(STDERR_FILENO);
-			/* No output, force to /dev/null */
-			fds1 = open("/dev/null", O_WRONLY, 0600);
+		join_method = is_joined(pjob);
+		/* Open job stdout/stderr. */
+		if (join_method < 0) {		/* joined as stderr */
+			fds2 = open_std_file(pjob, StdErr, O_WRONLY | O_APPEND,
+				pjob->ji_qs.ji_un.ji_momt.ji_exgid);
+			fds1 = dup(fds2);
+		} else if (join_method > 0) {	/* joined as stdout */
+			fds1 = open_std_file(pjob, StdOut, O_WRONLY | O_APPEND,
+				pjob->ji_qs.ji_un.ji_momt.ji_exgid);
 			fds2 = dup(fds1);
-		} else if (pe_io_type == PE_IO_TYPE_STD) {
-			int join_method;
-			/* Close any existing stdout/stderr. */
-			(void)close(STDOUT_FILENO);
-			(void)close(STDERR_FILENO);
-			/*
-			 * Do not open an output file unless it will be used.
-			 * Otherwise, it will be left behind in spool.
-			 */
-			join_method = is_joined(pjob);
-			/* Open job stdout/stderr. */
-			if (join_method < 0) {		/* joined as stderr */
-				fds1 = open("/dev/null", O_WRONLY, 0600);
-				fds2 = open_std_file(pjob, StdErr, O_WRONLY | O_APPEND,
-					pjob->ji_qs.ji_un.ji_momt.ji_exgid);
-				(void)close(fds1);
-				fds1 = dup(fds2);
-			} else if (join_method > 0) {	/* joined as stdout */
-				fds1 = open_std_file(pjob, StdOut, O_WRONLY | O_APPEND,
-					pjob->ji_qs.ji_un.ji_momt.ji_exgid);
-				fds2 = dup(fds1);
-			} else {			/* not joined */
-				fds1 = open_std_file(pjob, StdOut, O_WRONLY | O_APPEND,
-					pjob->ji_qs.ji_un.ji_momt.ji_exgid);
-				fds2 = open_std_file(pjob, StdErr, O_WRONLY | O_APPEND,
-					pjob->ji_qs.ji_un.ji_momt.ji_exgid);
-			}
-			if (fds1 == -1 || fds2 == -1) {
-				log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_WARNING,
-					pjob->ji_qs.ji_jobid, "problem opening job output file(s)");
-			}
+		} else {			/* not joined */
+			fds1 = open_std_file(pjob, StdOut, O_WRONLY | O_APPEND,
+				pjob->ji_qs.ji_un.ji_momt.ji_exgid);
+			fds2 = open_std_file(pjob, StdErr, O_WRONLY | O_APPEND,
+				pjob->ji_qs.ji_un.ji_momt.ji_exgid);
 		}
+		if (fds1 == -1 || fds2 == -1) {
+			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_WARNING,
+				pjob->ji_qs.ji_jobid, "problem opening job output file(s)");
+		}
+	}
+	fd_input = pelog_fd(fd_input);
+	fds1 = pelog_fd(fds1);
+	fds2 = pelog_fd(fds2);
+
+	/* for both prologue and epilogue */
+
+	arg[0] = pelog;
+	arg[1] = pjob->ji_qs.ji_jobid;
+	arg[2] = get_jattr_str(pjob, JOB_ATR_euser);
+	arg[3] = get_jattr_str(pjob, JOB_ATR_egroup);
+
+	/* for epilogue only */
+
+	if (which == PE_EPILOGUE) {
+		arg[4] = get_jattr_str(pjob, JOB_ATR_jobname);
+		sprintf(sid, "%ld", get_jattr_long(pjob, JOB_ATR_session_id));
+		arg[5] = sid;
+		arg[6] = resc_to_string(pjob, JOB_ATR_resource, resc_list, 2048);
+		arg[7] = resc_to_string(pjob, JOB_ATR_resc_used, resc_used, 2048);
+		arg[8] = get_jattr_str(pjob, JOB_ATR_in_queue);
+		if ((is_jattr_set(pjob, JOB_ATR_account)) && (strlen(get_jattr_str(pjob, JOB_ATR_account)) > 0))
+			arg[9] = get_jattr_str(pjob, JOB_ATR_account);
+		else
+			arg[9] = "null";
+		sprintf(exitcode, "%d", pjob->ji_qs.ji_un.ji_momt.ji_exitstat);
+		arg[10] = exitcode;
+		arg[11] = 0;
 
-		/* for both prologue and epilogue */
-
-		arg[0] = pelog;
-		arg[1] = pjob->ji_qs.ji_jobid;
-		arg[2] = get_jattr_str(pjob, JOB_ATR_euser);
-		arg[3] = get_jattr_str(pjob, JOB_ATR_egroup);
-
-		/* for epilogue only */
-
-		if (which == PE_EPILOGUE) {
-			arg[4] = get_jattr_str(pjob, JOB_ATR_jobname);
-			sprintf(sid, "%ld", get_jattr_long(pjob, JOB_ATR_session_id));
-			arg[5] = sid;
-			arg[6] = resc_to_string(pjob, JOB_ATR_resource, resc_list, 2048);
-			arg[7] = resc_to_string(pjob, JOB_ATR_resc_used, resc_used, 2048);
-			arg[8] = get_jattr_str(pjob, JOB_ATR_in_queue);
-			if ((is_jattr_set(pjob, JOB_ATR_account)) && (strlen(get_jattr_str(pjob, JOB_ATR_account)) > 0))
-				arg[9] = get_jattr_str(pjob, JOB_ATR_account);
-			else
-				arg[9] = "null";
-			sprintf(exitcode, "%d", pjob->ji_qs.ji_un.ji_momt.ji_exitstat);
-			arg[10] = exitcode;
-			arg[11] = 0;
-
-		} else {
+	} else {
 #ifdef NAS /* localmod 095 */
-			arg[4] = resc_to_string(pjob, JOB_ATR_resource, resc_list, 2048);
-			arg[5] = NULL;
+		arg[4] = resc_to_string(pjob, JOB_ATR_resource, resc_list, 2048);
+		arg[5] = NULL;
 #else
-			arg[4] = NULL;
+		arg[4] = NULL;
 #endif /* localmod 095 */
-		}
+	}
 
-		(void)setsid();
-
-		/* Add PBS_JOBDIR to the current process environement */
-		if (pjob->ji_grpcache) {
-			if ((is_jattr_set(pjob, JOB_ATR_sandbox)) && (strcasecmp(get_jattr_str(pjob, JOB_ATR_sandbox), "PRIVATE") == 0)) {
-				/* set PBS_JOBDIR to the per-job staging and execution directory*/
-				sprintf(buf, "PBS_JOBDIR=%s",
-					jobdirname(pjob->ji_qs.ji_jobid,
-					pjob->ji_grpcache->gc_homedir));
-			} else {
-				/* set PBS_JOBDIR to user HOME*/
-				sprintf(buf, "PBS_JOBDIR=%s", pjob->ji_grpcache->gc_homedir);
-			}
-			if (setenv("PBS_JOBDIR", pjob->ji_grpcache->gc_homedir, 1) != 0)
-				log_err(-1, "run_pelog", "set environment variable PBS_JOBDIR");
+	/*
+	 * Add PBS_JOBDIR to the current process environement, it is passed
+	 * on to the script.  run_pelog() is only called from a child of MoM,
+	 * the job starter or the end of job process, so MoM is not affected.
+	 */
+	if (pjob->ji_grpcache) {
+		if ((is_jattr_set(pjob, JOB_ATR_sandbox)) && (strcasecmp(get_jattr_str(pjob, JOB_ATR_sandbox), "PRIVATE") == 0)) {
+			/* set PBS_JOBDIR to the per-job staging and execution directory*/
+			sprintf(buf, "PBS_JOBDIR=%s",
+				jobdirname(pjob->ji_qs.ji_jobid,
+				pjob->ji_grpcache->gc_homedir));
+		} else {
+			/* set PBS_JOBDIR to user HOME*/
+			sprintf(buf, "PBS_JOBDIR=%s", pjob->ji_grpcache->gc_homedir);
 		}
+		if (setenv("PBS_JOBDIR", pjob->ji_grpcache->gc_homedir, 1) != 0)
+			log_err(-1, "run_pelog", "set environment variable PBS_JOBDIR");
+	}
 
-		execv(pelog, arg);
+	/*
+	 * Start the script with posix_spawn() rather than fork() and exec.
+	 * The caller is a copy of MoM, so this avoids copying its page
+	 * tables just to exec the script.  The script runs in a session of
+	 * its own, with the input file and the files opened above as its
+	 * standard input, output and error.
+	 */
+	(void)posix_spawn_file_actions_init(&actions);
+	(void)posix_spawnattr_init(&spattr);
+#ifdef POSIX_SPAWN_SETSID
+	(void)posix_spawnattr_setflags(&spattr, POSIX_SPAWN_SETSID);
+#else
+	(void)posix_spawnattr_setflags(&spattr, POSIX_SPAWN_SETPGROUP);
+	(void)posix_spawnattr_setpgroup(&spattr, 0);
+#endif
+	(void)posix_spawn_file_actions_adddup2(&actions, fd_input, STDIN_FILENO);
+	if (pe_io_type != PE_IO_TYPE_ASIS) {
+		if (fds1 != -1)
+			(void)posix_spawn_file_actions_adddup2(&actions, fds1, STDOUT_FILENO);
+		else
+			(void)posix_spawn_file_actions_addclose(&actions, STDOUT_FILENO);
+		if (fds2 != -1)
+			(void)posix_spawn_file_actions_adddup2(&actions, fds2, STDERR_FILENO);
+		else
+			(void)posix_spawn_file_actions_addclose(&actions, STDERR_FILENO);
+	}
+
+	run_exit = 0;
+	rc = posix_spawn(&child, pelog, &actions, &spattr, arg, environ);
+	(void)posix_spawn_file_actions_destroy(&actions);
+	(void)posix_spawnattr_destroy(&spattr);
+	(void)close(fd_input);
+	if (fds1 != -1)
+		(void)close(fds1);
+	if (fds2 != -1)
+		(void)close(fds2);
+	if (rc != 0)
+		return (pelog_err(pjob, pelog, -2, "cannot start"));
+
+	/* unprotect from kernel killers (such as oom) */
+	daemon_protect(child, PBS_DAEMON_PROTECT_OFF);
+
+	sprintf(log_buffer, "running %s",
+		which == PE_PROLOGUE ? "prologue" : "epilogue");
+	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO,
+		pjob->ji_qs.ji_jobid, log_buffer);
 
-		log_err(errno, "run_pelog", "execle of prologue failed");
-		exit(255);
+	act.sa_handler = pelogalm;
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = 0;
+	sigaction(SIGALRM, &act, 0);
+	alarm(pe_alarm_time);
+	while (wait(&waitst) < 0) {
+		if (errno != EINTR) {	/* continue loop on signal */
+			run_exit = -3;
+			break;
+		}
+		kill(-child, SIGKILL);
+	}
+	alarm(0);
+	act.sa_handler = SIG_DFL;
+	sigaction(SIGALRM, &act, 0);
+	kill(-child, SIGKILL);
+	if (run_exit == 0) {
+		if (WIFEXITED(waitst)) {
+			run_exit = WEXITSTATUS(waitst);
+		} else if (WIFSIGNALED(waitst)) {
+			run_exit = -3;
+		}
+	} else {
+		sprintf(log_buffer, "completed %s, exit=%d",
+			which == PE_PROLOGUE ? "prologue" : "epilogue",
+			run_exit);
+		log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_INFO,
+			pjob->ji_qs.ji_jobid, log_buffer);
 	}
 
 	if (run_exit)
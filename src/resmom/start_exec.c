@@ -60,6 +60,7 @@
 #include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/wait.h>
+#include <spawn.h>
 #include <netinet/in.h>
 #include <fcntl.h>
 
@@ -126,6 +127,7 @@ extern	time_t		time_resc_updated;
 extern char		*path_hooks_workdir;
 extern	long		joinjob_alarm_time;
 extern	long		job_launch_delay;
+extern	int		nodefile_compact;
 int              mom_reader_go;		/* see catchinter() & mom_writer() */
 
 extern int x11_reader_go;
@@ -171,7 +173,8 @@ char *variables_else[] = {	/* variables to add, value computed */
 	"OMP_NUM_THREADS",
 	"PBS_ACCOUNT",
 	"PBS_ARRAY_INDEX",
-	"PBS_ARRAY_ID"
+	"PBS_ARRAY_ID",
+	"PBS_NODEFILE_COMPACT"
 };
 
 static	int num_var_else = sizeof(variables_else) / sizeof(char *);
@@ -1040,8 +1043,8 @@ mkjobdir(char *jobid, char *jobdir, uid_t uid, gid_t gid)
 /**
  * @brief
  * 	rmtmpdir - remove the temporary directory
- *	This may take awhile so the task is forked and execed to another
- *	process.
+ *	This may take awhile so it is handed to an rm process started
+ *	with posix_spawn(), which unlike fork() does not copy MoM.
  *
  * @param[in] jobid - job id
  *
@@ -1059,6 +1062,10 @@ rmtmpdir(char *jobid)
 	char	*rf = "-rf";
 	char	*tmpdir;
 	char	*newdir = rmdir;
+	char	*argv[4];
+	sigset_t	mask;
+	posix_spawnattr_t	spattr;
+	int	rc;
 
 	/* Hello, is any body there? */
 	tmpdir = tmpdirname(jobid);
@@ -1080,20 +1087,19 @@ rmtmpdir(char *jobid)
 		newdir = tmpdir;
 	}
 
-	/* fork and exec the cleantmp process */
-	pid = fork();
-	if (pid < 0) {
-		log_err(errno, __func__, "fork");
-		return;
-	}
-
-	if (pid > 0)		/* parent */
-		return;
-
-	tpp_terminate();
-	execl(rm, "pbs_cleandir", rf, newdir, NULL);
-	log_err(errno, __func__, "execl");
-	exit(21);
+	/* spawn the cleantmp process, TPP descriptors are close-on-exec */
+	argv[0] = "pbs_cleandir";
+	argv[1] = rf;
+	argv[2] = newdir;
+	argv[3] = NULL;
+	(void)sigemptyset(&mask);
+	(void)posix_spawnattr_init(&spattr);
+	(void)posix_spawnattr_setsigmask(&spattr, &mask);
+	(void)posix_spawnattr_setflags(&spattr, POSIX_SPAWN_SETSIGMASK);
+	rc = posix_spawn(&pid, rm, NULL, &spattr, argv, environ);
+	(void)posix_spawnattr_destroy(&spattr);
+	if (rc != 0)
+		log_joberr(rc, __func__, "posix_spawn", jobid);
 }
 
 /**
@@ -1828,31 +1834,73 @@ record_finish_exec(int sd)
 
 /**
  * @brief
- *	Regenerate the PBS_NODEFILE of a job based on internal
- *	nodes-related data.
- * @param[in]	pjob	- the job whose PBS_NODEFILE is to be generated.
- * @param[out]	nodefile- buffer to hold the path to PBS_NODEFILE
- *			  that got regenerated.
- *			  NOTE: OK for this to be NULL, which means
- *			  don't save nodefile path.
+ *	Return the name written into PBS_NODEFILE for an entry of the job's
+ *	vnode table: the vnode's host name if set, else the short name of
+ *	its host.
  *
- * @param[in] nodefile_sz - size of the 'nodefile' buffer.
- * @param[out] err_msg	- buffer to hold the error message if this
+ * @param[in]	pjob	- the job
+ * @param[in]	j	- index into pjob->ji_vnods
+ * @param[out]	len	- length of the name
+ *
+ * @return char *
+ * @retval	the name, not null terminated at 'len'
+ */
+static char *
+nodefile_entry(job *pjob, int j, int *len)
+{
+	char *name;
+	char *pdot;
+
+	if ((name = pjob->ji_vnods[j].vn_hname) != NULL) {
+		*len = strlen(name);
+		return (name);
+	}
+
+	/* we want to write just the short name of the host */
+	name = pjob->ji_vnods[j].vn_host->hn_host;
+	if ((pdot = strchr(name, '.')) != NULL)
+		*len = (int)(pdot - name);
+	else
+		*len = strlen(name);
+	return (name);
+}
+
+/**
+ * @brief
+ *	Write a nodefile of a job.
+ *
+ *	The expanded form holds one line per entry of the job's vnode table.
+ *	The compact form holds "host:count" lines, one per run of consecutive
+ *	entries with the same name, so expanding it in order gives the
+ *	expanded form.  The file is written under a temporary name and
+ *	renamed into place, so a reader never sees a partial file.
+ *
+ * @param[in]	pjob	- the job whose nodefile is to be generated.
+ * @param[in]	compact	- non-zero for the compact form
+ * @param[out]	nodefile- buffer to hold the path to the file,
+ *			  may be NULL.
+ * @param[in]	nodefile_sz - size of the 'nodefile' buffer.
+ * @param[out]	err_msg	- buffer to hold the error message if this
  *			 functions returns a failure.
  * @param[in]	err_msg_sz - size of the 'err_msg' buffer.
  *
  * @return int
  * @retval  0	success
  * @retval < 0	failure
- *
  */
-int
-generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
+static int
+write_pbs_nodefile(job *pjob, int compact, char *nodefile, int nodefile_sz,
 					char *err_msg, int err_msg_sz)
 {
 	FILE			*nhow;
 	int	   		j, vnodenum;
 	char			pbs_nodefile[MAXPATHLEN+1];
+	char			tmp_nodefile[MAXPATHLEN+1];
+	char			*name;
+	char			*prev = NULL;
+	int			len;
+	int			prevlen = 0;
+	int			count = 0;
 
 	if (pjob == NULL) {
 		snprintf(err_msg, err_msg_sz, "bad pjob param");
@@ -1862,13 +1910,17 @@ generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
 	if ((err_msg != NULL) && (err_msg_sz > 0))
 		err_msg[0] = '\0';
 
-	snprintf(pbs_nodefile, sizeof(pbs_nodefile)-1, "%s/aux/%s",
-		pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
+	snprintf(pbs_nodefile, sizeof(pbs_nodefile)-1, "%s/aux/%s%s",
+		pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid,
+		compact ? NODEFILE_COMPACT_SUFFIX : "");
+	/* task children of a job may write the file at the same time */
+	snprintf(tmp_nodefile, sizeof(tmp_nodefile)-1, "%s.tmp%d", pbs_nodefile,
+		(int)getpid());
 
-	if ((nhow = fopen(pbs_nodefile, "w")) == NULL) {
+	if ((nhow = fopen(tmp_nodefile, "w")) == NULL) {
 		if ((err_msg != NULL) && (err_msg_sz > 0)) {
 			snprintf(err_msg, err_msg_sz,
-					"cannot open %s", pbs_nodefile);
+					"cannot open %s", tmp_nodefile);
 		}
 		return (-1);
 	}
@@ -1880,31 +1932,51 @@ generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
 	if (fchmod(fileno(nhow), 0644) == -1) {
 		if ((err_msg != NULL) && (err_msg_sz > 0)) {
 			snprintf(err_msg, err_msg_sz, "cannot chmod %s",
-							pbs_nodefile);
+							tmp_nodefile);
 		}
 		fclose(nhow);
-		(void)unlink(pbs_nodefile);
+		(void)unlink(tmp_nodefile);
 		return (-1);
 	}
 
 	/* write each node name out once per vnod and entry */
 	vnodenum = pjob->ji_numvnod;
 	for (j = 0; j < vnodenum; j++) {
-		if (pjob->ji_vnods[j].vn_hname == NULL) {
-			size_t len;
-			char  *pdot;
+		name = nodefile_entry(pjob, j, &len);
+		if (!compact) {
+			fprintf(nhow, "%.*s\n", len, name);
+			continue;
+		}
+		if ((prev != NULL) && (len == prevlen) &&
+			(strncmp(name, prev, len) == 0)) {
+			count++;
+			continue;
+		}
+		if (prev != NULL)
+			fprintf(nhow, "%.*s:%d\n", prevlen, prev, count);
+		prev = name;
+		prevlen = len;
+		count = 1;
+	}
+	if (prev != NULL)
+		fprintf(nhow, "%.*s:%d\n", prevlen, prev, count);
 
-			/* we want to write just the short name of the host */
-			if ((pdot = strchr(pjob->ji_vnods[j].vn_host->hn_host, '.')) != NULL)
-				len = (size_t)(pdot - pjob->ji_vnods[j].vn_host->hn_host);
-			else
-				len = strlen(pjob->ji_vnods[j].vn_host->hn_host);
-			fprintf(nhow, "%.*s\n", (int)len,
-				pjob->ji_vnods[j].vn_host->hn_host);
-		} else
-			fprintf(nhow, "%s\n", pjob->ji_vnods[j].vn_hname);
+	if (fclose(nhow) != 0) {
+		if ((err_msg != NULL) && (err_msg_sz > 0)) {
+			snprintf(err_msg, err_msg_sz, "cannot write %s",
+							tmp_nodefile);
+		}
+		(void)unlink(tmp_nodefile);
+		return (-1);
+	}
+	if (rename(tmp_nodefile, pbs_nodefile) == -1) {
+		if ((err_msg != NULL) && (err_msg_sz > 0)) {
+			snprintf(err_msg, err_msg_sz, "cannot rename %s",
+							tmp_nodefile);
+		}
+		(void)unlink(tmp_nodefile);
+		return (-1);
 	}
-	fclose(nhow);
 
 	if ((nodefile != NULL) && (nodefile_sz > 0))
 		pbs_strncpy(nodefile, pbs_nodefile, nodefile_sz);
@@ -1912,6 +1984,91 @@ generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
 	return (0);
 }
 
+/**
+ * @brief
+ *	Regenerate the PBS_NODEFILE of a job based on internal
+ *	nodes-related data.  With $nodefile_compact set, the compact
+ *	form is regenerated as well.
+ * @param[in]	pjob	- the job whose PBS_NODEFILE is to be generated.
+ * @param[out]	nodefile- buffer to hold the path to PBS_NODEFILE
+ *			  that got regenerated.
+ *			  NOTE: OK for this to be NULL, which means
+ *			  don't save nodefile path.
+ *
+ * @param[in] nodefile_sz - size of the 'nodefile' buffer.
+ * @param[out] err_msg	- buffer to hold the error message if this
+ *			 functions returns a failure.
+ * @param[in]	err_msg_sz - size of the 'err_msg' buffer.
+ *
+ * @return int
+ * @retval  0	success
+ * @retval < 0	failure
+ *
+ */
+int
+generate_pbs_nodefile(job *pjob, char *nodefile, int nodefile_sz,
+					char *err_msg, int err_msg_sz)
+{
+	if (nodefile_compact &&
+		(write_pbs_nodefile(pjob, 1, NULL, 0, err_msg, err_msg_sz) != 0))
+		return (-1);
+	return (write_pbs_nodefile(pjob, 0, nodefile, nodefile_sz, err_msg, err_msg_sz));
+}
+
+/**
+ * @brief
+ *	Generate the compact form of the PBS_NODEFILE of a job, with
+ *	"host:count" lines.
+ *
+ * @param[in]	pjob	- the job whose nodefile is to be generated.
+ * @param[out]	nodefile- buffer to hold the path to the file, may be NULL.
+ * @param[in] nodefile_sz - size of the 'nodefile' buffer.
+ * @param[out] err_msg	- buffer to hold the error message if this
+ *			 functions returns a failure.
+ * @param[in]	err_msg_sz - size of the 'err_msg' buffer.
+ *
+ * @return int
+ * @retval  0	success
+ * @retval < 0	failure
+ */
+int
+generate_pbs_nodefile_compact(job *pjob, char *nodefile, int nodefile_sz,
+					char *err_msg, int err_msg_sz)
+{
+	return (write_pbs_nodefile(pjob, 1, nodefile, nodefile_sz, err_msg, err_msg_sz));
+}
+
+/**
+ * @brief
+ *	Write the expanded PBS_NODEFILE of a job if only its compact form
+ *	has been written.  With $nodefile_compact set, MoM itself writes only
+ *	the compact form; the job starter and task children call this before
+ *	they exec, so the expanded form is written outside the MoM main loop
+ *	and is in place before anything in the job can read it.
+ *
+ * @param[in]	pjob	- the job
+ *
+ * @return void
+ */
+static void
+finish_pbs_nodefile(job *pjob)
+{
+	char	path[MAXPATHLEN + 1];
+	char	msg[LOG_BUF_SIZE];
+
+	snprintf(path, sizeof(path), "%s/aux/%s",
+		pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
+	if ((access(path, F_OK) == 0) || (errno != ENOENT))
+		return;
+	snprintf(path, sizeof(path), "%s/aux/%s%s", pbs_conf.pbs_home_path,
+		pjob->ji_qs.ji_jobid, NODEFILE_COMPACT_SUFFIX);
+	if (access(path, F_OK) != 0)
+		return;
+	if (write_pbs_nodefile(pjob, 0, NULL, 0, msg, sizeof(msg)) != 0)
+		log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, LOG_NOTICE,
+			pjob->ji_qs.ji_jobid, msg);
+}
+
 /**
  * @brief
  *	Read a piece of data from 'downfds' pipe of size 'data_size'.
@@ -3137,7 +3294,10 @@ finish_exec(job *pjob)
 	pjob->ji_sampletim  = time_now;
 
 	/*
-	 * Fork the child process that will become the job.
+	 * Fork the child process that will become the job.  This stays a
+	 * fork(), not posix_spawn(): before it execs, the child sets the job
+	 * up (credentials, cpusets, hooks, std files, environment) from MoM's
+	 * in-memory job, host and task tables.
 	 */
 	cpid = fork_me(-1);
 	if (cpid > 0) {
@@ -3540,7 +3700,17 @@ finish_exec(job *pjob)
 
 	/* PBS_NODEFILE */
 
-	if (generate_pbs_nodefile(pjob, buf, sizeof(buf)-1, log_buffer, LOG_BUF_SIZE - 1) == 0)
+	if (nodefile_compact) {
+		if (generate_pbs_nodefile_compact(pjob, buf, sizeof(buf)-1, log_buffer, LOG_BUF_SIZE - 1) == 0) {
+			bld_env_variables(&(pjob->ji_env), variables_else[16], buf);
+			sprintf(buf, "%s/aux/%s", pbs_conf.pbs_home_path, pjob->ji_qs.ji_jobid);
+			bld_env_variables(&(pjob->ji_env), variables_else[11], buf);
+			finish_pbs_nodefile(pjob);
+		} else {
+			log_err(errno, __func__, log_buffer);
+			starter_return(upfds, downfds, JOB_EXEC_FAIL1, &sjr);
+		}
+	} else if (generate_pbs_nodefile(pjob, buf, sizeof(buf)-1, log_buffer, LOG_BUF_SIZE - 1) == 0)
 		bld_env_variables(&(pjob->ji_env), variables_else[11], buf);
 	else {
 		log_err(errno, __func__, log_buffer);
@@ -4965,6 +5135,8 @@ start_process(task *ptask, char **argv, char **envp, bool nodemux)
 				LOG_INFO, "",
 				"execjob_launch hook event: accept req by default");
 	}
+	finish_pbs_nodefile(pjob);
+
 	if (set_credential(pjob, NULL, &the_argv) == -1) {
 		starter_return(kid_write, kid_read,
 			JOB_EXEC_FAIL2, &sjr);		/* exits */
@@ -728,12 +728,13 @@ create_subjob(job *parent, char *newjid, int *rc)
 	CLEAR_HEAD(attrl);
 	for (i = 0; attrs_to_copy[i] != JOB_ATR_LAST; i++) {
 		j    = (int)attrs_to_copy[i];
-		ppar = get_jattr(parent, j);
-		psub = get_jattr(subj, j);
+		if ((ppar = find_jattr(parent, j)) == NULL)
+			continue;
 		pdef = &job_attr_def[j];
 
 		if (pdef->at_encode(ppar, &attrl, pdef->at_name, NULL,
 			ATR_ENCODE_MOM, &psatl) > 0) {
+			psub = get_jattr(subj, j);
 			for (psatl = (svrattrl *)GET_NEXT(attrl); psatl;
 				psatl = ((svrattrl *)GET_NEXT(psatl->al_link))) {
 				set_attr_generic(psub, pdef, psatl->al_value, psatl->al_resc, INTERNAL);
@@ -759,10 +760,7 @@ create_subjob(job *parent, char *newjid, int *rc)
 	 */
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) == 1) {
 
-		eligibletime = get_jattr_long(parent, JOB_ATR_eligible_time);
-
-		if (get_jattr_long(parent, JOB_ATR_accrue_type) == JOB_ELIGIBLE)
-			eligibletime += get_jattr_long(subj, JOB_ATR_sample_starttime) - get_jattr_long(parent, JOB_ATR_sample_starttime);
+		eligibletime = get_eligible_time(parent);
 
 		set_jattr_l_slim(subj, JOB_ATR_eligible_time, eligibletime, SET);
 	}
@@ -283,6 +283,126 @@ save_attr_fs(attribute_def *padef, attribute *pattr, int numattr)
 }
 
 
+/**
+ * @brief
+ *	 	Append the changed attributes of an object to its disk file
+ *
+ * @par	Functionality:
+ *		Writes a journal record behind a full image previously written by
+ *		save_attr_fs().  Only attributes flagged ATR_VFLAG_MODIFY, or which
+ *		were set at the previous save and are no longer set, are encoded.
+ *		An attribute which is no longer set is recorded as an entry with an
+ *		empty value and without ATR_VFLAG_SET.  The record is closed with
+ *		the same ENDATTRIBUTES dummy entry as the full image, and is read
+ *		back by recov_attr_journal_fs().
+ *
+ * @param[in]	padef - Address of parent's attribute definition array
+ * @param[in]	pattr - Address of the parent objects attribute array
+ * @param[in]	numattr - Number of attributes in the list
+ * @param[in,out] psaved - per attribute, non-zero if it was set when last
+ *			  saved; updated to reflect what this record holds
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ */
+int
+save_attr_journal_fs(attribute_def *padef, attribute *pattr, int numattr, char *psaved)
+{
+	svrattrl	 dummy;
+	int		 errct = 0;
+	pbs_list_head 	 lhead;
+	int		 i;
+	svrattrl	*pal;
+	int		 rc;
+
+	CLEAR_HEAD(lhead);
+
+	for (i = 0; i < numattr; i++) {
+
+		if ((padef+i)->at_type == ATR_TYPE_ACL)
+			continue;
+		if (!((pattr+i)->at_flags & ATR_VFLAG_MODIFY) &&
+			((psaved[i] == 0) || ((pattr+i)->at_flags & ATR_VFLAG_SET)))
+			continue;
+
+		rc = (padef+i)->at_encode(pattr+i, &lhead, (padef+i)->at_name,
+			NULL, ATR_ENCODE_SAVE, NULL);
+		if (rc < 0)
+			errct++;
+
+		(pattr+i)->at_flags &= ~ATR_VFLAG_MODIFY;
+
+		if ((GET_NEXT(lhead) == NULL) && psaved[i]) {
+			/* no longer set, record that so recovery clears it */
+			pal = attrlist_create((padef+i)->at_name, NULL, 0);
+			if (pal == NULL)
+				return (-1);
+			append_link(&lhead, &pal->al_link, pal);
+		}
+		psaved[i] = ((pattr+i)->at_flags & ATR_VFLAG_SET) ? 1 : 0;
+
+		while ((pal = (svrattrl *)GET_NEXT(lhead)) != NULL) {
+			if (save_struct((char *)pal, pal->al_tsize) < 0)
+				errct++;
+			delete_link(&pal->al_link);
+			(void)free(pal);
+		}
+	}
+
+#ifdef DEBUG
+	(void)memset(&dummy, 0, sizeof(dummy));
+#endif
+	dummy.al_tsize = ENDATTRIBUTES;
+	if (save_struct((char *)&dummy, sizeof(dummy)) < 0)
+		errct++;
+
+	if (errct)
+		return (-1);
+	else
+		return (0);
+}
+
+
+/**
+ * @brief
+ *		decode one recovered attribute entry into its attribute
+ *
+ * @param[in] 	parent - void pointer to one of the PBS objects
+ *					  to whom the attribute belongs
+ * @param[in]	padef - Address of parent's attribute definition array
+ * @param[in]	pattr - Address of the parent objects attribute array
+ * @param[in]	index - index of the attribute the entry belongs to
+ * @param[in]	pal - the recovered entry
+ */
+static void
+recov_attr_apply(void *parent, attribute_def *padef, attribute *pattr, int index, svrattrl *pal)
+{
+	/*
+	 * In the normal case we just decode the attribute directly
+	 * into the real attribute since there will be one entry only
+	 * for that attribute.
+	 *
+	 * However, "entity limits" are special and may have multiple,
+	 * the first of which is "SET" and the following are "INCR".
+	 * For the SET case, we do it directly as for the normal attrs.
+	 * For the INCR,  we have to decode into a temp attr and then
+	 * call set_entity to do the INCR.
+	 */
+
+	if (((padef+index)->at_type != ATR_TYPE_ENTITY) || (pal->al_atopl.op != INCR)) {
+		int rc = set_attr_generic(pattr+index, padef+index, pal->al_value, pal->al_resc, INTERNAL);
+		if (! rc) {
+			if ((padef+index)->at_action)
+				(void)(padef+index)->at_action(pattr+index, parent, ATR_ACTION_RECOV);
+		}
+	} else {
+		/* for INCR case of entity limit, decode locally */
+		set_attr_generic(pattr+index, padef+index, pal->al_value, pal->al_resc, INCR);
+	}
+	(pattr+index)->at_flags = pal->al_flags & ~ATR_VFLAG_MODIFY;
+}
+
 /**
  * @brief
  *		read attributes from disk file
@@ -415,31 +535,135 @@ recov_attr_fs(int fd, void *parent, void *padef_idx, attribute_def *padef, attri
 			}
 		}
 
-		/*
-		 * In the normal case we just decode the attribute directly
-		 * into the real attribute since there will be one entry only
-		 * for that attribute.
-		 *
-		 * However, "entity limits" are special and may have multiple,
-		 * the first of which is "SET" and the following are "INCR".
-		 * For the SET case, we do it directly as for the normal attrs.
-		 * For the INCR,  we have to decode into a temp attr and then
-		 * call set_entity to do the INCR.
-		 */
-
-		if (((padef+index)->at_type != ATR_TYPE_ENTITY) || (pal->al_atopl.op != INCR)) {
-			int rc = set_attr_generic(pattr+index, padef+index, pal->al_value, pal->al_resc, INTERNAL);
-			if (! rc) {
-				if ((padef+index)->at_action)
-					(void)(padef+index)->at_action(pattr+index, parent, ATR_ACTION_RECOV);
-			}
-		} else {
-			/* for INCR case of entity limit, decode locally */
-			set_attr_generic(pattr+index, padef+index, pal->al_value, pal->al_resc, INCR);
-		}
-		(pattr+index)->at_flags = pal->al_flags & ~ATR_VFLAG_MODIFY;
+		recov_attr_apply(parent, padef, pattr, index, pal);
 	}
 
 	(void)free(pal);
 	return (0);
 }
+
+/**
+ * @brief
+ *		read one attribute entry of a journal record
+ *
+ * @param[in]	fd - The file descriptor of the file to read from
+ * @param[out]	ppal - the entry read, NULL at the end of the record
+ *
+ * @return	int
+ * @retval	 0 - an entry, or the end of the record, was read
+ * @retval	-1 - end of file, or the record is incomplete
+ */
+static int
+read_journal_entry(int fd, svrattrl **ppal)
+{
+	svrattrl	 hdr;
+	svrattrl	*pal;
+	int		 amt;
+
+	*ppal = NULL;
+	if (read(fd, (char *)&hdr, sizeof(svrattrl)) != sizeof(svrattrl))
+		return (-1);
+	if (hdr.al_tsize == ENDATTRIBUTES)
+		return (0);
+	amt = hdr.al_tsize - sizeof(svrattrl);
+	if (amt < 1)
+		return (-1);
+	if ((pal = (svrattrl *)malloc(hdr.al_tsize)) == NULL)
+		return (-1);
+	*pal = hdr;
+	if (read(fd, (char *)pal + sizeof(svrattrl), amt) != amt) {
+		free(pal);
+		return (-1);
+	}
+
+	CLEAR_LINK(pal->al_link);
+	pal->al_name = (char *)pal + sizeof(svrattrl);
+	if (pal->al_rescln)
+		pal->al_resc = pal->al_name + pal->al_nameln;
+	else
+		pal->al_resc = NULL;
+	if (pal->al_valln)
+		pal->al_value = pal->al_name + pal->al_nameln + pal->al_rescln;
+	else
+		pal->al_value = NULL;
+	pal->al_refct = 1;
+
+	*ppal = pal;
+	return (0);
+}
+
+/**
+ * @brief
+ *		replay the journal records which follow a full attribute image
+ *
+ *		Reads the records appended by save_attr_journal_fs() after the
+ *		image read by recov_attr_fs(), up to end of file.  A record is
+ *		only applied once it has been read completely, so a record torn
+ *		by a crash is ignored.  Every attribute named in a record replaces
+ *		the value it had before that record.
+ *
+ * @param[in]	fd - The file descriptor of the file, positioned just past
+ *		     the full image
+ * @param[in] 	parent - void pointer to one of the PBS objects
+ *					  to whom these attributes belong
+ * @param[in]   padef_idx - Search index of this attribute definition array
+ * @param[in]	padef - Address of parent's attribute definition array
+ * @param[in]	pattr - Address of the parent objects attribute array
+ * @param[in]	limit - Index of the last attribute
+ * @param[in]	unknown - Index of the start of the unknown attribute list
+ *
+ * @return	int
+ * @retval	>=0 - number of records applied
+ * @retval	 -1 - the file ends in an incomplete record (complete
+ *		      records before it were applied)
+ */
+int
+recov_attr_journal_fs(int fd, void *parent, void *padef_idx, attribute_def *padef, attribute *pattr, int limit, int unknown)
+{
+	pbs_list_head	 record;
+	svrattrl	*pal;
+	char		*cleared;
+	int		 index;
+	int		 nrec = 0;
+
+	if ((cleared = malloc(limit)) == NULL)
+		return (-1);
+	CLEAR_HEAD(record);
+	resc_access_perm = ATR_DFLAG_ACCESS;
+
+	while (read_journal_entry(fd, &pal) == 0) {
+		if (pal != NULL) {
+			append_link(&record, &pal->al_link, pal);
+			continue;
+		}
+
+		/* complete record read, apply it */
+		memset(cleared, 0, limit);
+		while ((pal = (svrattrl *)GET_NEXT(record)) != NULL) {
+			delete_link(&pal->al_link);
+			index = find_attr(padef_idx, padef, pal->al_name);
+			if ((index < 0) && (unknown > 0))
+				index = unknown;
+			if (index >= 0) {
+				if (!cleared[index]) {
+					if ((padef+index)->at_free)
+						(padef+index)->at_free(pattr+index);
+					cleared[index] = 1;
+				}
+				if (pal->al_flags & ATR_VFLAG_SET)
+					recov_attr_apply(parent, padef, pattr, index, pal);
+			}
+			free(pal);
+		}
+		nrec++;
+	}
+
+	free(cleared);
+	if (GET_NEXT(record) != NULL) {
+		free_attrlist(&record);
+		log_errf(-1, __func__, "incomplete journal record in %s ignored",
+			pbs_recov_filename);
+		return (-1);
+	}
+	return (nrec);
+}
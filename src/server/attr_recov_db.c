@@ -121,6 +121,35 @@ encode_single_attr_db(attribute_def *padef, attribute *pattr, pbs_db_attr_list_t
 	return 0;
 }
 
+/**
+ * @brief
+ *	Encode an attribute to the database structure if it was modified
+ *	since the last save
+ *
+ * @param[in]	padef - Address of the attribute's definition
+ * @param[in]	pattr - Address of the attribute
+ * @param[out]	db_attr_list - pointer to the structure of type pbs_db_attr_list_t for storing in DB
+ * @param[in]	all  - Encode even the attributes not normally saved
+ *
+ * @return  error code
+ * @retval   -1 - Failure
+ * @retval    0 - Success
+ */
+static int
+encode_modified_attr_db(attribute_def *padef, attribute *pattr, pbs_db_attr_list_t *db_attr_list, int all)
+{
+	if (!(pattr->at_flags & ATR_VFLAG_MODIFY))
+		return 0;
+
+	if (((padef->at_flags & ATR_DFLAG_NOSAVM) == 0) || all) {
+		if (encode_single_attr_db(padef, pattr, db_attr_list) != 0)
+			return -1;
+
+		pattr->at_flags &= ~ATR_VFLAG_MODIFY;
+	}
+	return 0;
+}
+
 /**
  * @brief
  *	Encode the given attributes to the database structure of type pbs_db_attr_list_t
@@ -145,28 +174,56 @@ encode_attr_db(attribute_def *padef, attribute *pattr, int numattr, pbs_db_attr_
 	CLEAR_HEAD(db_attr_list->attrs);
 
 	for (i = 0; i < numattr; i++) {
-		if (!((pattr + i)->at_flags & ATR_VFLAG_MODIFY))
-			continue;
+		if (encode_modified_attr_db(padef + i, pattr + i, db_attr_list, all) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Encode the attributes held in a sparse container to the database
+ *	structure of type pbs_db_attr_list_t, see encode_attr_db()
+ *
+ * @param[in]	padef - Address of parent's attribute definition array
+ * @param[in]	psparse - the parent object's sparse attribute storage
+ * @param[in]	numattr - Number of attributes in the list
+ * @param[in]	all  - Encode all attributes
+ *
+ * @return  error code
+ * @retval   -1 - Failure
+ * @retval    0 - Success
+ */
+int
+encode_attr_sparse_db(attribute_def *padef, attr_sparse *psparse, int numattr, pbs_db_attr_list_t *db_attr_list, int all)
+{
+	int i;
+	attribute *pattr;
 
-		if ((((padef + i)->at_flags & ATR_DFLAG_NOSAVM) == 0) || all) {
-			if (encode_single_attr_db((padef + i), (pattr + i), db_attr_list) != 0)
-				return -1;
+	db_attr_list->attr_count = 0;
 
-			(pattr+i)->at_flags &= ~ATR_VFLAG_MODIFY;
-		}
+	CLEAR_HEAD(db_attr_list->attrs);
+
+	for (i = 0; i < numattr; i++) {
+		if ((pattr = attr_sparse_find(psparse, i)) == NULL)
+			continue;
+		if (encode_modified_attr_db(padef + i, pattr, db_attr_list, all) != 0)
+			return -1;
 	}
 	return 0;
 }
 
 /**
  * @brief
- *	Decode the list of attributes from the database to the regular attribute structure
+ *	Decode the list of attributes from the database to the regular attribute
+ *	structure, either a plain array or a sparse container
  *
  * @param[in]	  parent - pointer to parent object
  * @param[in]	  attr_list - recovered/to be decoded attribute list
  * @param[in]     padef_idx - Search index of this attribute array
  * @param[in]	  padef - Address of parent's attribute definition array
- * @param[in,out] pattr - Address of the parent objects attribute array
+ * @param[in,out] pattr - Address of the parent objects attribute array, or NULL
+ * @param[in,out] psparse - the parent object's sparse attribute storage if pattr is NULL
  * @param[in]	  limit - Number of attributes in the list
  * @param[in]	  unknown	- The index of the unknown attribute if any
  *
@@ -176,10 +233,11 @@ encode_attr_db(attribute_def *padef, attribute *pattr, int numattr, pbs_db_attr_
  *
  *
  */
-int
-decode_attr_db(void *parent, pbs_list_head *attr_list, void *padef_idx, struct attribute_def *padef, struct attribute *pattr, int limit, int unknown)
+static int
+decode_attrs_db(void *parent, pbs_list_head *attr_list, void *padef_idx, struct attribute_def *padef, struct attribute *pattr, attr_sparse *psparse, int limit, int unknown)
 {
 	int index;
+	attribute *pa;
 	svrattrl *pal = (svrattrl *)0;
 	svrattrl *tmp_pal = (svrattrl *)0;
 	void **palarray = NULL;
@@ -250,33 +308,28 @@ decode_attr_db(void *parent, pbs_list_head *attr_list, void *padef_idx, struct a
 		 *
 		 */
 		pal = palarray[index];
+		if (pal == NULL)
+			continue;
+		if (pattr != NULL)
+			pa = &pattr[index];
+		else if ((pa = attr_sparse_get(psparse, padef, index, limit)) == NULL) {
+			log_err(-1, __func__, "Out of memory");
+			goto err;
+		}
 		while (pal) {
-			if ((padef[index].at_type == ATR_TYPE_ENTITY) && is_attr_set(&pattr[index])) {
+			if ((padef[index].at_type == ATR_TYPE_ENTITY) && is_attr_set(pa)) {
 				/* for INCR case of entity limit, decode locally */
-				set_attr_generic(&pattr[index], &padef[index], pal->al_value, pal->al_resc, INCR);
+				set_attr_generic(pa, &padef[index], pal->al_value, pal->al_resc, INCR);
 			} else {
-				set_attr_generic(&pattr[index], &padef[index], pal->al_value, pal->al_resc, INTERNAL);
+				set_attr_generic(pa, &padef[index], pal->al_value, pal->al_resc, INTERNAL);
 				int act_rc = 0;
 				if (padef[index].at_action)
-					if ((act_rc = (padef[index].at_action(&pattr[index], parent, ATR_ACTION_RECOV)))) {
+					if ((act_rc = (padef[index].at_action(pa, parent, ATR_ACTION_RECOV)))) {
 						log_errf(act_rc, __func__, "Action function failed for %s attr, errn %d", (padef+index)->at_name, act_rc);
-						for ( index++; index <= limit; index++) {
-							while (pal) {
-								tmp_pal = pal->al_sister;
-								free(pal);
-								pal = tmp_pal;
-							}
-							if (index < limit)
-								pal = palarray[index];
-						}
-						free(palarray);
-						/* bailing out from this function */
-						/* any previously allocated attrs will be */
-						/* freed by caller (parent obj recov function) */
-						return -1;
+						goto err;
 					}
 			}
-			(pattr+index)->at_flags = (pal->al_flags & ~ATR_VFLAG_MODIFY) | ATR_VFLAG_MODCACHE;
+			pa->at_flags = (pal->al_flags & ~ATR_VFLAG_MODIFY) | ATR_VFLAG_MODCACHE;
 
 			tmp_pal = pal->al_sister;
 			pal = tmp_pal;
@@ -285,4 +338,65 @@ decode_attr_db(void *parent, pbs_list_head *attr_list, void *padef_idx, struct a
 	(void)free(palarray);
 
 	return 0;
+
+err:
+	for ( index++; index <= limit; index++) {
+		while (pal) {
+			tmp_pal = pal->al_sister;
+			free(pal);
+			pal = tmp_pal;
+		}
+		if (index < limit)
+			pal = palarray[index];
+	}
+	free(palarray);
+	/* bailing out from this function */
+	/* any previously allocated attrs will be */
+	/* freed by caller (parent obj recov function) */
+	return -1;
+}
+
+/**
+ * @brief
+ *	Decode the list of attributes from the database to the regular attribute structure
+ *
+ * @param[in]	  parent - pointer to parent object
+ * @param[in]	  attr_list - recovered/to be decoded attribute list
+ * @param[in]     padef_idx - Search index of this attribute array
+ * @param[in]	  padef - Address of parent's attribute definition array
+ * @param[in,out] pattr - Address of the parent objects attribute array
+ * @param[in]	  limit - Number of attributes in the list
+ * @param[in]	  unknown	- The index of the unknown attribute if any
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ */
+int
+decode_attr_db(void *parent, pbs_list_head *attr_list, void *padef_idx, struct attribute_def *padef, struct attribute *pattr, int limit, int unknown)
+{
+	return decode_attrs_db(parent, attr_list, padef_idx, padef, pattr, NULL, limit, unknown);
+}
+
+/**
+ * @brief
+ *	Decode the list of attributes from the database into a sparse
+ *	container, see decode_attr_db()
+ *
+ * @param[in]	  parent - pointer to parent object
+ * @param[in]	  attr_list - recovered/to be decoded attribute list
+ * @param[in]     padef_idx - Search index of this attribute array
+ * @param[in]	  padef - Address of parent's attribute definition array
+ * @param[in,out] psparse - the parent object's sparse attribute storage
+ * @param[in]	  limit - Number of attributes in the list
+ * @param[in]	  unknown	- The index of the unknown attribute if any
+ *
+ * @return      Error code
+ * @retval	 0  - Success
+ * @retval	-1  - Failure
+ */
+int
+decode_attr_sparse_db(void *parent, pbs_list_head *attr_list, void *padef_idx, struct attribute_def *padef, attr_sparse *psparse, int limit, int unknown)
+{
+	return decode_attrs_db(parent, attr_list, padef_idx, padef, NULL, psparse, limit, unknown);
 }
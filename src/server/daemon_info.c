@@ -74,6 +74,8 @@ init_daemon_info(ulong *pul, uint port, struct machine_info *pmi)
 	dmn_info->dmn_state =INUSE_UNKNOWN | INUSE_DOWN | INUSE_NEEDS_HELLOSVR;
 	dmn_info->dmn_stream  = -1;
 	CLEAR_HEAD(dmn_info->dmn_deferred_cmds);
+	CLEAR_HEAD(dmn_info->dmn_jsend_active);
+	CLEAR_HEAD(dmn_info->dmn_jsend_wait);
 	dmn_info->dmn_addrs = pul;
 
 	while (*pul) {
@@ -94,12 +96,22 @@ delete_daemon_info(struct machine_info *pmi)
 {
 	dmn_info_t *pdmninfo;
 	ulong *up;
+	struct work_task *ptask;
 
 	if (!pmi || !pmi->mi_dmn_info)
 		return;
 
 	pdmninfo = pmi->mi_dmn_info;
 
+	/*
+	 * unhook job sends tied to this daemon, they stay on their job's
+	 * task list and find the daemon gone when they next run
+	 */
+	while ((ptask = GET_NEXT(pdmninfo->dmn_jsend_active)) != NULL)
+		delete_link(&ptask->wt_linkobj2);
+	while ((ptask = GET_NEXT(pdmninfo->dmn_jsend_wait)) != NULL)
+		delete_link(&ptask->wt_linkobj2);
+
 	/* take stream out of tree */
 	tpp_close(pdmninfo->dmn_stream);
 	tdelete2((unsigned long)pdmninfo->dmn_stream , 0, &streams);
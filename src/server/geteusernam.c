@@ -231,14 +231,22 @@ determine_egroup(void *pobj, int objtype, attribute *pattr)
  *
  * @param[in]	objtype - object type
  * @param[in]	pobj -  ptr to object to link in
- * @param[in]	pattr - pointer to attribute structure
- * 						which contains group_List attributes and User_List attributes
+ * @param[in]	attrry - pointer to attribute array which contains group_List
+ * 						and User_List attributes, NULL to use the object's own
  *
  * @returns	 int
  * @retval	 0	- if everything got determined and set appropriately else,
  * @retval	non-zero	- error number if something went awry
  */
 
+static attribute *
+objexid_attr(void *pobj, int objtype, int idx)
+{
+	if (objtype == JOB_OBJECT)
+		return get_jattr(pobj, idx);
+	return get_rattr(pobj, idx);
+}
+
 int
 set_objexid(void *pobj, int objtype, attribute *attrry)
 {
@@ -252,7 +260,6 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 	int idx_owner, idx_euser, idx_egroup;
 	int idx_acct;
 	int bad_euser, bad_egrp;
-	attribute *objattrs;
 	attribute_def *obj_attr_def;
 	attribute *paclRoot; /*future: aclRoot resv != aclRoot job*/
 	char **pmem;
@@ -269,7 +276,6 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 		idx_egroup = (int)JOB_ATR_egroup;
 		idx_acct = (int)JOB_ATR_account;
 		obj_attr_def = job_attr_def;
-		objattrs = ((job *)pobj)->ji_wattr;
 		owner = get_jattr_str(pobj, idx_owner);
 		paclRoot = get_sattr(SVR_ATR_AclRoot);
 		bad_euser = PBSE_BADUSER;
@@ -282,7 +288,6 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 		idx_egroup = (int)RESV_ATR_egroup;
 		idx_acct = (int)RESV_ATR_account;
 		obj_attr_def = resv_attr_def;
-		objattrs = ((resc_resv *)pobj)->ri_wattr;
 		owner = get_rattr_str(pobj, idx_owner);
 		paclRoot = get_sattr(SVR_ATR_AclRoot);
 		bad_euser = PBSE_R_UID;
@@ -295,10 +300,10 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 	 * actually be the same as what is passed into this function
 	 */
 
-	if ((attrry + idx_ul)->at_flags & ATR_VFLAG_SET)
+	if (attrry != NULL && is_attr_set(attrry + idx_ul))
 		pattr = attrry + idx_ul;
 	else
-		pattr = &objattrs[idx_ul];
+		pattr = objexid_attr(pobj, objtype, idx_ul);
 
 	if ((puser = determine_euser(pobj, objtype, pattr, &isowner)) == NULL)
 		return (bad_euser);
@@ -319,14 +324,14 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 			return (bad_euser);
 	}
 
-	pattr = &objattrs[idx_euser];
+	pattr = objexid_attr(pobj, objtype, idx_euser);
 	free_attr(obj_attr_def, pattr, idx_euser);
 	set_attr_generic(pattr, &obj_attr_def[idx_euser], puser, NULL, INTERNAL);
 
 	if (pwent != NULL) {
 		/* if account (qsub -A) is not specified, set to empty string */
 
-		pattr = &objattrs[idx_acct];
+		pattr = objexid_attr(pobj, objtype, idx_acct);
 		if (!is_attr_set(pattr))
 			set_attr_generic(pattr, &obj_attr_def[idx_acct], "\0", NULL, INTERNAL);
 
@@ -341,10 +346,10 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 		 * be same as what was passed
 		 */
 
-		if (is_attr_set(attrry + idx_gl))
+		if (attrry != NULL && is_attr_set(attrry + idx_gl))
 			pattr = attrry + idx_gl;
 		else
-			pattr = &objattrs[idx_gl];
+			pattr = objexid_attr(pobj, objtype, idx_gl);
 		if ((pgrpn = determine_egroup(pobj, objtype, pattr)) != NULL) {
 
 			/* user specified a group, group must exists and either	   */
@@ -398,7 +403,10 @@ set_objexid(void *pobj, int objtype, attribute *attrry)
 
 	}
 
-	pattr = attrry + idx_egroup;
+	if (attrry != NULL)
+		pattr = attrry + idx_egroup;
+	else
+		pattr = objexid_attr(pobj, objtype, idx_egroup);
 	free_attr(obj_attr_def, pattr, idx_egroup);
 
 	if (addflags != 0) {
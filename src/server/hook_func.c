@@ -94,6 +94,9 @@
  * mom_hooks_seen_count
  * uc_delete_mom_hooks
  * get_hook_rescdef_checksum
+ * periodic_hook_changed
+ * periodic_hook_objs_changed
+ * run_periodic_hook
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
@@ -113,6 +116,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include "pbs_ifl.h"
 #include "libpbs.h"
 #include "list_link.h"
@@ -143,6 +148,7 @@
 #include "pbs_sched.h"
 #include "dis.h"
 #include "acct.h"
+#include "pbs_db.h"
 
 /* External functions */
 extern void disable_svr_prov();
@@ -762,6 +768,9 @@ mgr_hook_create(struct batch_request *preq)
 	char		*hook_fail_action_val = NULL;
 	char		*hook_freq_val = NULL;
 
+	/* the periodic hook helper's copy of the hooks goes stale */
+	periodic_hook_changed();
+
 	if (strlen(preq->rq_ind.rq_manager.rq_objname) == 0) {
 		reply_text(preq, PBSE_HOOKERROR, "no hook name specified");
 		return;
@@ -953,6 +962,8 @@ mgr_hook_delete(struct batch_request *preq)
 	char hookname[PBS_MAXSVRJOBID + 1] = {'\0'};
 	char hook_msg[HOOK_MSG_SIZE] = {'\0'};
 
+	periodic_hook_changed();
+
 	if (strlen(preq->rq_ind.rq_manager.rq_objname) == 0) {
 		reply_text(preq, PBSE_HOOKERROR, "no hook name specified");
 		return;
@@ -1111,6 +1122,8 @@ mgr_hook_import(struct batch_request *preq)
 
 	hook_obj = preq->rq_ind.rq_manager.rq_objtype;
 
+	periodic_hook_changed();
+
 	if (strlen(preq->rq_ind.rq_manager.rq_objname) == 0) {
 		reply_text(preq, PBSE_HOOKERROR, "no hook name specified");
 		return;
@@ -1713,6 +1726,8 @@ mgr_hook_set(struct batch_request *preq)
 
 	hook_obj = preq->rq_ind.rq_manager.rq_objtype;
 
+	periodic_hook_changed();
+
 	if (strlen(preq->rq_ind.rq_manager.rq_objname) == 0) {
 		reply_text(preq, PBSE_HOOKERROR, "no hook name specified");
 		return;
@@ -2115,6 +2130,8 @@ mgr_hook_unset(struct batch_request *preq)
 
 	hook_obj = preq->rq_ind.rq_manager.rq_objtype;
 
+	periodic_hook_changed();
+
 	if (strlen(preq->rq_ind.rq_manager.rq_objname) == 0) {
 		reply_text(preq, PBSE_HOOKERROR, "no hook name specified");
 		return;
@@ -3705,12 +3722,13 @@ get_resv_list(void) {
 
 	while (presv != NULL) {
 		for (index = 0; index < RESV_ATR_LAST; index++) {
-			if ((padef+index)->at_flags & ATR_VFLAG_SET) {
+			if (((padef+index)->at_flags & ATR_VFLAG_SET) &&
+				(find_rattr(presv, index) != NULL)) {
 				strncpy(name_str_buf, presv->ri_qs.ri_resvID, STRBUF);
 				strcat(name_str_buf, ".");
 				strncat(name_str_buf, (padef+index)->at_name, (STRBUF - strlen(name_str_buf)));
 				if ((padef+index)->at_encode(
-						get_rattr(presv, index),
+						find_rattr(presv, index),
 						&resv_attr_list, name_str_buf,
 						NULL, ATR_ENCODE_HOOK, NULL) < 0) {
 					char *msgbuf;
@@ -6752,108 +6770,744 @@ get_hook_results_end:
 	return (rc);
 }
 
+/*
+ * Server periodic hooks run in one long lived helper process rather than
+ * in a fork of the whole Server per occurrence.  The helper is forked when
+ * first needed; for each run the Server sends it the hook name and a
+ * snapshot of the vnode and reservation lists the periodic event carries,
+ * and the helper answers with the hook's result and how long it ran.  The
+ * rest of the helper's view of the Server (pbs.server() and its jobs and
+ * queues) is as old as the helper.  The helper is replaced before its next
+ * run once hooks or resources have changed.  Jobs, vnodes and the like
+ * change all the time, so a change to them only replaces a helper that has
+ * served PERIODIC_HELPER_LAG seconds: what a hook sees through pbs.server()
+ * may miss changes made in the last PERIODIC_HELPER_LAG seconds, and the
+ * Server forks at most once per PERIODIC_HELPER_LAG seconds for them.  Any
+ * helper is replaced after PERIODIC_HELPER_LIFE seconds.  A run is written to the helper without
+ * blocking; what the pipe does not take is written from a work task.  A
+ * hook has at most one run queued or running; an occurrence that comes due
+ * before that run ends is skipped.
+ */
+
+#define PERIODIC_HELPER_LIFE	300	/* seconds a helper serves before it is replaced */
+#define PERIODIC_HELPER_LAG	30	/* most seconds of object changes a run may miss */
+#define PERIODIC_HELPER_WAIT	30	/* seconds the helper has to take a run */
+
+/* a periodic hook waiting for the helper */
+typedef struct periodic_due {
+	pbs_list_link	pd_link;
+	char		*pd_name;
+} periodic_due;
+
+static int	periodic_helper_wfd = -1;	/* runs to the helper */
+static int	periodic_helper_rfd = -1;	/* replies from the helper */
+static pid_t	periodic_helper_pid = -1;
+static time_t	periodic_helper_since;		/* when the helper was forked */
+static int	periodic_helper_stale = 0;	/* hooks or resources changed since */
+static int	periodic_helper_behind = 0;	/* Server objects changed since */
+static char	*periodic_running = NULL;	/* hook the helper is running */
+static pbs_list_head periodic_due_list;		/* hooks waiting for the helper */
+
+/* frame being built for, or written to, the helper */
+static char	*periodic_obuf = NULL;
+static size_t	periodic_osize = 0;
+static size_t	periodic_olen = 0;
+static size_t	periodic_ooff = 0;		/* bytes of the frame written */
+static time_t	periodic_odeadline;		/* when to give up on writing it */
+static struct work_task *periodic_owt = NULL;	/* task to write the rest */
+
+static void periodic_hook_next(void);
+static void periodic_helper_retire(void);
+
 /**
  * @brief
- *		Callback function for reaping server periodic hook child.
- * @param[in]	ptask	- work task pointer
+ *		Act on the result of a server periodic hook run.
+ *
+ * @param[in]	phook	- the hook that ran
+ * @param[in]	ret	- server_process_hooks() result, 0 if the hook rejected
+ * @param[in]	pid	- process that ran the hook, names its results file
  *
  * @return	void
  */
 static void
-post_server_periodic_hook(struct work_task *ptask)
+post_server_periodic_hook(hook *phook, int ret, pid_t pid)
 {
-
-	int	stat;
-	hook	*phook;
-	pid_t	mypid;
 	char	hook_outfile[MAXPATHLEN + 1];
+	char	reject_msg[HOOK_MSG_SIZE + 1] = {'\0'};
+	char	*next_time_str;
 	time_t	next_time;
 	int	accept_flag = 1;
 	int	reject_flag = 0;
-	stat = ptask->wt_aux;
-	phook = (hook *)ptask->wt_parm1;
-	mypid = ptask->wt_event;
+	int	hook_error_flag = 0;
 
-	if (phook == NULL) {
-		log_err(-1, __func__, "A periodic hook disappeared");
-		return;
+	/* Check hook exit status */
+	if (ret == 0) {
+		snprintf(log_buffer, LOG_BUF_SIZE,
+			"Hook got rejected");
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
+			LOG_ERR, phook->hook_name, log_buffer);
+		hook_error_flag = 1;	/* hook results are invalid */
 	}
-	if (WIFEXITED(stat)) {
-		char reject_msg[HOOK_MSG_SIZE + 1] = {'\0'};
-		char *next_time_str;
-		int hook_error_flag = 0;
 
-		/* Check hook exit status */
-		if (stat == 0) {
-			snprintf(log_buffer, LOG_BUF_SIZE,
-				"Hook got rejected");
+	/* hook results path */
+	snprintf(hook_outfile, MAXPATHLEN, FMT_HOOK_OUTFILE,
+		path_hooks_workdir, HOOKSTR_PERIODIC,
+		phook->hook_name, pid);
+
+	if (hook_error_flag == 0) {
+		/* hook ran to completion, get results from file  */
+		if (get_server_hook_results(hook_outfile, &accept_flag, &reject_flag,
+			reject_msg, sizeof(reject_msg), NULL, phook, NULL) != 0) {
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
+				LOG_ERR, phook->hook_name,
+				"Failed getting hook results");
+			/* error getting results, do not accept results */
+			hook_error_flag = 1;
+		}
+	}
+
+	if ((hook_error_flag == 1) || (accept_flag == 0)) {
+		snprintf(log_buffer, sizeof(log_buffer),
+			"%s request rejected by '%s'",
+			"periodic", phook->hook_name);
+		log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
+			LOG_ERR, phook->hook_name, log_buffer);
+		if (reject_msg[0] != '\0') {
+			snprintf(log_buffer, sizeof(log_buffer), "%s",
+				reject_msg);
+			/* log also the custom reject message */
 			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
 				LOG_ERR, phook->hook_name, log_buffer);
-			hook_error_flag = 1;	/* hook results are invalid */
 		}
+	}
 
-		/* hook results path */
-		snprintf(hook_outfile, MAXPATHLEN, FMT_HOOK_OUTFILE,
-			path_hooks_workdir, HOOKSTR_PERIODIC,
-			phook->hook_name, mypid);
+	if (hook_error_flag == 0) {
+		/* No hook error means data is communicated to */
+		/* the server and actions are done to jobs.    */
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
+			LOG_INFO, phook->hook_name, "periodic hook accepted");
 
-		if (hook_error_flag == 0) {
-			/* hook exited normally, get results from file  */
-			if (get_server_hook_results(hook_outfile, &accept_flag, &reject_flag,
-				reject_msg, sizeof(reject_msg), NULL, phook, NULL) != 0) {
-				log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
-					LOG_ERR, phook->hook_name,
-					"Failed getting hook results");
-				/* error getting results, do not accept results */
-				hook_error_flag = 1;
-			}
-		}
+		/* remove the processed results file, note that if  */
+		/* there was an error, it is left for debugging use */
+		if (!phook->debug)
+			(void)unlink(hook_outfile);	/* remove file */
+	}
 
-		if ((hook_error_flag == 1) || (accept_flag == 0)) {
-			snprintf(log_buffer, sizeof(log_buffer),
-				"%s request rejected by '%s'",
-				"periodic", phook->hook_name);
-			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
-				LOG_ERR, phook->hook_name, log_buffer);
-			if ((reject_msg != NULL) && (reject_msg[0] != '\0')) {
-				snprintf(log_buffer, sizeof(log_buffer), "%s",
-					reject_msg);
-				/* log also the custom reject message */
-				log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK,
-					LOG_ERR, phook->hook_name, log_buffer);
+	next_time = time_now + phook->freq;
+	next_time_str = ctime(&next_time);
+	if ((next_time_str != NULL) && (next_time_str[0] != '\0')) {
+		next_time_str[strlen(next_time_str)-1] = '\0'; /* remove newline */
+		snprintf(log_buffer, sizeof(log_buffer), "will run on %s",
+			next_time_str);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
+			LOG_ERR, phook->hook_name, log_buffer);
+	}
+
+	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_INFO,
+		__func__, "Server periodic hook ran successfully");
+}
+
+/**
+ * @brief
+ *		Rebuild in the helper a list of svrattrl sent by
+ *		periodic_obuf_list().
+ *
+ * @param[in]	data	- the records, followed by a null byte
+ * @param[in]	len	- length of the records
+ * @param[out]	phead	- list to append to
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	-1	: malformed records or out of memory
+ */
+static int
+periodic_helper_list(char *data, size_t len, pbs_list_head *phead)
+{
+	char	*end = data + len;
+	char	*name;
+	char	*resc;
+	char	*value;
+
+	while (data < end) {
+		name = data;
+		data += strlen(data) + 1;
+		resc = data;
+		data += strlen(data) + 1;
+		value = data;
+		data += strlen(data) + 1;
+		if (data > end)
+			return -1;
+		if (add_to_svrattrl_list(phead, name,
+			(*resc == '+') ? resc + 1 : NULL, value, 0, NULL) != 0)
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		Main loop of the periodic hook helper.  Reads runs of the form
+ *		"<hook name>\n<vnode bytes> <resv bytes>\n<records>", runs the hook
+ *		and writes back "<result> <wall ms> <cpu ms>\n".  Exits when the
+ *		Server closes its end.
+ *
+ * @param[in]	rfd	- read end of the run pipe
+ * @param[in]	wfd	- write end of the reply pipe
+ *
+ * @return	does not return
+ */
+static void
+periodic_helper_main(int rfd, int wfd)
+{
+	FILE		*in;
+	char		name[MAXPATHLEN + 1];
+	char		lens[64];
+	char		reply[80];
+	char		hook_msg[HOOK_MSG_SIZE];
+	char		*data;
+	char		*pc;
+	unsigned long	vlen;
+	unsigned long	rlen;
+	long		wall_ms;
+	long		cpu_ms;
+	int		ret;
+	int		num_run;
+	int		event_initialized;
+	hook		*phook;
+	hook_input_param_t req_ptr;
+	pbs_list_head	vnodes;
+	pbs_list_head	resvs;
+	struct timeval	t0, t1;
+	struct rusage	r0, r1;
+
+	(void)signal(SIGPIPE, SIG_IGN);
+	(void)signal(SIGHUP, SIG_IGN);
+	(void)signal(SIGTERM, SIG_DFL);
+	(void)signal(SIGCHLD, SIG_DFL);
+
+	if ((in = fdopen(rfd, "r")) == NULL)
+		exit(1);
+
+	CLEAR_HEAD(vnodes);
+	CLEAR_HEAD(resvs);
+	while ((fgets(name, sizeof(name), in) != NULL) &&
+		(fgets(lens, sizeof(lens), in) != NULL)) {
+		if ((pc = strchr(name, '\n')) != NULL)
+			*pc = '\0';
+		if (sscanf(lens, "%lu %lu", &vlen, &rlen) != 2)
+			exit(1);
+		if ((data = malloc(vlen + rlen + 1)) == NULL)
+			exit(1);
+		if (fread(data, 1, vlen + rlen, in) != vlen + rlen)
+			exit(1);
+		data[vlen + rlen] = '\0';
+		if ((periodic_helper_list(data, vlen, &vnodes) != 0) ||
+			(periodic_helper_list(data + vlen, rlen, &resvs) != 0))
+			exit(1);
+
+		time_now = time(NULL);
+		(void)gettimeofday(&t0, NULL);
+		(void)getrusage(RUSAGE_SELF, &r0);
+		ret = -1;
+		if ((phook = find_hook(name)) != NULL) {
+			hook_input_param_init(&req_ptr);
+			req_ptr.vns_list = &vnodes;
+			req_ptr.resv_list = &resvs;
+			num_run = 0;
+			event_initialized = 0;
+			hook_msg[0] = '\0';
+			ret = server_process_hooks(PBS_BATCH_HookPeriodic, NULL, NULL, phook,
+						HOOK_EVENT_PERIODIC, NULL, &req_ptr, hook_msg,
+						sizeof(hook_msg), pbs_python_set_interrupt, &num_run, &event_initialized);
+			if (ret == 0)
+				log_event(PBSE_HOOKERROR, PBS_EVENTCLASS_HOOK, LOG_ERR, __func__, hook_msg);
+		}
+		(void)gettimeofday(&t1, NULL);
+		(void)getrusage(RUSAGE_SELF, &r1);
+		wall_ms = (t1.tv_sec - t0.tv_sec) * 1000 +
+			(t1.tv_usec - t0.tv_usec) / 1000;
+		cpu_ms = (r1.ru_utime.tv_sec - r0.ru_utime.tv_sec +
+			r1.ru_stime.tv_sec - r0.ru_stime.tv_sec) * 1000 +
+			(r1.ru_utime.tv_usec - r0.ru_utime.tv_usec +
+			r1.ru_stime.tv_usec - r0.ru_stime.tv_usec) / 1000;
+
+		free_attrlist(&vnodes);
+		free_attrlist(&resvs);
+		free(data);
+
+		snprintf(reply, sizeof(reply), "%d %ld %ld\n", ret, wall_ms, cpu_ms);
+		if (write(wfd, reply, strlen(reply)) == -1)
+			exit(1);
+	}
+	exit(0);
+}
+
+/**
+ * @brief
+ *		Append bytes to the frame being built for the helper.
+ *
+ * @param[in]	data	- bytes to append
+ * @param[in]	len	- number of bytes
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	-1	: out of memory
+ */
+static int
+periodic_obuf_add(const char *data, size_t len)
+{
+	char	*pc;
+	size_t	size;
+
+	if (periodic_olen + len > periodic_osize) {
+		size = 2 * (periodic_olen + len) + 1024;
+		if ((pc = realloc(periodic_obuf, size)) == NULL)
+			return -1;
+		periodic_obuf = pc;
+		periodic_osize = size;
+	}
+	memcpy(periodic_obuf + periodic_olen, data, len);
+	periodic_olen += len;
+	return 0;
+}
+
+/**
+ * @brief
+ *		Append a list of svrattrl to the frame for the helper.  Each entry
+ *		becomes three null terminated fields: its name, its resource
+ *		prefixed by '+' (empty if it has none) and its value.
+ *
+ * @param[in]	phead	- the list
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	-1	: out of memory
+ */
+static int
+periodic_obuf_list(pbs_list_head *phead)
+{
+	svrattrl	*pal;
+	char		*resc;
+	char		*value;
+
+	for (pal = (svrattrl *)GET_NEXT(*phead); pal != NULL;
+		pal = (svrattrl *)GET_NEXT(pal->al_link)) {
+		resc = pal->al_resc ? pal->al_resc : "";
+		value = pal->al_value ? pal->al_value : "";
+		if ((periodic_obuf_add(pal->al_name, strlen(pal->al_name) + 1) != 0) ||
+			(periodic_obuf_add("+", pal->al_resc ? 1 : 0) != 0) ||
+			(periodic_obuf_add(resc, strlen(resc) + 1) != 0) ||
+			(periodic_obuf_add(value, strlen(value) + 1) != 0))
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		Free the frame being written to the helper and cancel the task
+ *		that writes the rest of it.
+ *
+ * @return	void
+ */
+static void
+periodic_obuf_free(void)
+{
+	if (periodic_owt != NULL) {
+		delete_task(periodic_owt);
+		periodic_owt = NULL;
+	}
+	/* the snapshot can be large, do not hold on to it between runs */
+	free(periodic_obuf);
+	periodic_obuf = NULL;
+	periodic_osize = 0;
+	periodic_olen = 0;
+	periodic_ooff = 0;
+}
+
+static void periodic_helper_write_task(struct work_task *ptask);
+
+/**
+ * @brief
+ *		Write as much of the frame to the helper as its pipe takes
+ *		without blocking.  If some is left, a work task tries again a
+ *		second later, until PERIODIC_HELPER_WAIT seconds have passed.
+ *
+ * @return	int
+ * @retval	0	: the whole frame is written or the rest is pending
+ * @retval	-1	: write failed or the helper is not reading
+ */
+static int
+periodic_helper_write(void)
+{
+	ssize_t	n;
+
+	while (periodic_ooff < periodic_olen) {
+		n = write(periodic_helper_wfd, periodic_obuf + periodic_ooff,
+			periodic_olen - periodic_ooff);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+				log_err(errno, __func__, "write to periodic hook helper failed");
+				return -1;
 			}
+			if (time_now >= periodic_odeadline) {
+				log_err(-1, __func__, "periodic hook helper is not reading");
+				return -1;
+			}
+			periodic_owt = set_task(WORK_Timed, time_now + 1,
+				periodic_helper_write_task, NULL);
+			if (periodic_owt == NULL) {
+				log_err(errno, __func__, msg_err_malloc);
+				return -1;
+			}
+			return 0;
 		}
+		periodic_ooff += n;
+	}
+	periodic_obuf_free();
+	return 0;
+}
 
-		if (hook_error_flag == 0) {
-			/* No hook error means data is communicated to */
-			/* the server and actions are done to jobs.    */
-			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
-				LOG_INFO, phook->hook_name, "periodic hook accepted");
+/**
+ * @brief
+ *		Work task to write the rest of a frame to the helper.
+ *
+ * @param[in]	ptask	- work task
+ *
+ * @return	void
+ */
+static void
+periodic_helper_write_task(struct work_task *ptask)
+{
+	periodic_owt = NULL;
+	if ((periodic_obuf == NULL) || (periodic_helper_wfd == -1))
+		return;
+	if (periodic_helper_write() != 0) {
+		periodic_helper_retire();
+		periodic_hook_next();
+	}
+}
 
-			/* remove the processed results file, note that if  */
-			/* there was an error, it is left for debugging use */
-			if (!phook->debug)
-				(void)unlink(hook_outfile);	/* remove file */
+/**
+ * @brief
+ *		Send a run of a periodic hook to the helper, along with the vnode
+ *		and reservation lists for its event.
+ *
+ * @param[in]	phook	- hook to run
+ *
+ * @return	int
+ * @retval	0	: sent, or the rest of it is pending
+ * @retval	-1	: error
+ */
+static int
+periodic_helper_send(hook *phook)
+{
+	char	*hdr = NULL;
+	char	*pc;
+	size_t	vlen;
+	size_t	hlen;
+	int	rc;
+
+	periodic_obuf_free();
+	rc = periodic_obuf_list(get_vnode_list());
+	vlen = periodic_olen;
+	if (rc == 0)
+		rc = periodic_obuf_list(get_resv_list());
+	free_attrlist(&vnode_attr_list);
+	free_attrlist(&resv_attr_list);
+
+	/* put the header in front of the lists */
+	if ((rc != 0) || (pbs_asprintf(&hdr, "%s\n%lu %lu\n", phook->hook_name,
+		(unsigned long)vlen, (unsigned long)(periodic_olen - vlen)) == -1) ||
+		((pc = realloc(periodic_obuf, periodic_olen + strlen(hdr))) == NULL)) {
+		log_err(errno, __func__, msg_err_malloc);
+		free(hdr);
+		periodic_obuf_free();
+		return -1;
+	}
+	hlen = strlen(hdr);
+	if (periodic_olen > 0)
+		memmove(pc + hlen, pc, periodic_olen);
+	memcpy(pc, hdr, hlen);
+	free(hdr);
+	periodic_obuf = pc;
+	periodic_olen += hlen;
+	periodic_osize = periodic_olen;
+
+	periodic_odeadline = time_now + PERIODIC_HELPER_WAIT;
+	return periodic_helper_write();
+}
+
+/**
+ * @brief
+ *		Forget the helper, closing the Server's ends of its pipes.  A run
+ *		it had not answered is logged as failed.
+ *
+ * @return	void
+ */
+static void
+periodic_helper_reset(void)
+{
+	if (periodic_helper_rfd != -1)
+		close_conn(periodic_helper_rfd);
+	if (periodic_helper_wfd != -1)
+		(void)close(periodic_helper_wfd);
+	periodic_helper_rfd = -1;
+	periodic_helper_wfd = -1;
+	periodic_helper_pid = -1;
+	periodic_obuf_free();
+
+	if (periodic_running != NULL) {
+		snprintf(log_buffer, sizeof(log_buffer),
+			"Server periodic hook encountered errors: helper lost while running %s",
+			periodic_running);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_INFO,
+			__func__, log_buffer);
+		free(periodic_running);
+		periodic_running = NULL;
+	}
+}
+
+/**
+ * @brief
+ *		Stop the helper and forget it.
+ *
+ * @return	void
+ */
+static void
+periodic_helper_retire(void)
+{
+	if (periodic_helper_pid != -1)
+		(void)kill(periodic_helper_pid, SIGTERM);
+	periodic_helper_reset();
+}
+
+/**
+ * @brief
+ *		Work task for the exit of a periodic hook helper.
+ *
+ * @param[in]	ptask	- work task, wt_event is the pid that exited
+ *
+ * @return	void
+ */
+static void
+periodic_helper_exit(struct work_task *ptask)
+{
+	if ((pid_t)ptask->wt_event == periodic_helper_pid) {
+		periodic_helper_reset();
+		periodic_hook_next();
+	}
+}
+
+/**
+ * @brief
+ *		Read a reply from the helper and finish the run it answers.
+ *
+ * @param[in]	fd	- read end of the reply pipe
+ *
+ * @return	void
+ */
+static void
+periodic_helper_reply(int fd)
+{
+	char	buf[80];
+	char	*name;
+	ssize_t	n;
+	int	ret;
+	long	wall_ms;
+	long	cpu_ms;
+	hook	*phook;
+
+	n = read(fd, buf, sizeof(buf) - 1);
+	if ((n == -1) && ((errno == EINTR) || (errno == EAGAIN)))
+		return;
+	if (n > 0)
+		buf[n] = '\0';
+	if ((n <= 0) || (periodic_running == NULL) ||
+		(sscanf(buf, "%d %ld %ld", &ret, &wall_ms, &cpu_ms) != 3)) {
+		/* the helper is gone or out of step with us */
+		periodic_helper_retire();
+		periodic_hook_next();
+		return;
+	}
+
+	name = periodic_running;
+	periodic_running = NULL;
+	if ((phook = find_hook(name)) != NULL) {
+		phook->periodic_runs++;
+		phook->periodic_total_ms += wall_ms;
+		if (wall_ms > phook->periodic_max_ms)
+			phook->periodic_max_ms = wall_ms;
+
+		post_server_periodic_hook(phook, ret, periodic_helper_pid);
+
+		snprintf(log_buffer, sizeof(log_buffer),
+			"run took %ld ms (%ld ms cpu); %ld runs, average %ld ms, "
+			"longest %ld ms, %ld occurrences skipped",
+			wall_ms, cpu_ms, phook->periodic_runs,
+			phook->periodic_total_ms / phook->periodic_runs,
+			phook->periodic_max_ms, phook->periodic_skipped);
+		log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
+			LOG_INFO, phook->hook_name, log_buffer);
+	}
+	free(name);
+	periodic_hook_next();
+}
+
+/**
+ * @brief
+ *		Fork the periodic hook helper and connect its pipes.
+ *
+ * @return	int
+ * @retval	0	: helper started
+ * @retval	-1	: error
+ */
+static int
+periodic_helper_start(void)
+{
+	int	tofds[2];
+	int	fromfds[2];
+	int	flags;
+	pid_t	pid;
+	conn_t	*conn;
+
+	if (pipe(tofds) == -1) {
+		log_err(errno, __func__, "pipe failed");
+		return -1;
+	}
+	if (pipe(fromfds) == -1) {
+		log_err(errno, __func__, "pipe failed");
+		(void)close(tofds[0]);
+		(void)close(tofds[1]);
+		return -1;
+	}
+
+	pid = fork();
+	if (pid == -1) {
+		log_err(errno, __func__, "fork failed");
+		(void)close(tofds[0]);
+		(void)close(tofds[1]);
+		(void)close(fromfds[0]);
+		(void)close(fromfds[1]);
+		return -1;
+	}
+
+	if (pid == 0) {
+		(void)close(tofds[1]);
+		(void)close(fromfds[0]);
+		/* Close all server connections */
+		net_close(-1);
+		tpp_terminate();
+		pbs_db_close_fds(svr_db_conn);
+		/* Unprotect child from being killed by kernel */
+		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+		periodic_helper_main(tofds[0], fromfds[1]);
+	}
+
+	(void)close(tofds[0]);
+	(void)close(fromfds[1]);
+	(void)fcntl(tofds[1], F_SETFD, FD_CLOEXEC);
+	(void)fcntl(fromfds[0], F_SETFD, FD_CLOEXEC);
+	if ((flags = fcntl(tofds[1], F_GETFL)) != -1)
+		(void)fcntl(tofds[1], F_SETFL, flags | O_NONBLOCK);
+	if ((flags = fcntl(fromfds[0], F_GETFL)) != -1)
+		(void)fcntl(fromfds[0], F_SETFL, flags | O_NONBLOCK);
+
+	conn = add_conn(fromfds[0], ChildPipe, (pbs_net_t)0, 0, NULL,
+		periodic_helper_reply);
+	if (conn == NULL) {
+		log_err(-1, __func__, "could not add periodic hook helper connection");
+		(void)close(tofds[1]);
+		(void)close(fromfds[0]);
+		(void)kill(pid, SIGTERM);
+		return -1;
+	}
+	conn->cn_authen |= PBS_NET_CONN_AUTHENTICATED;
+
+	periodic_helper_wfd = tofds[1];
+	periodic_helper_rfd = fromfds[0];
+	periodic_helper_pid = pid;
+	periodic_helper_since = time_now;
+	periodic_helper_stale = 0;
+	periodic_helper_behind = 0;
+	(void)set_task(WORK_Deferred_Child, (long)pid, periodic_helper_exit, NULL);
+	return 0;
+}
+
+/**
+ * @brief
+ *		Hand the next waiting periodic hook to the helper if it is idle,
+ *		replacing or starting the helper first as needed.
+ *
+ * @return	void
+ */
+static void
+periodic_hook_next(void)
+{
+	periodic_due	*pdue;
+	hook		*phook;
+
+	if (periodic_due_list.ll_next == NULL)
+		return;
+
+	while ((periodic_running == NULL) &&
+		((pdue = (periodic_due *)GET_NEXT(periodic_due_list)) != NULL)) {
+		delete_link(&pdue->pd_link);
+		phook = find_hook(pdue->pd_name);
+		if ((phook == NULL) || !(phook->event & HOOK_EVENT_PERIODIC)) {
+			free(pdue->pd_name);
+			free(pdue);
+			continue;
 		}
 
-		next_time = time_now + phook->freq;
-		next_time_str = ctime(&next_time);
-		if ((next_time_str != NULL) && (next_time_str[0] != '\0')) {
-			next_time_str[strlen(next_time_str)-1] = '\0'; /* remove newline */
-			snprintf(log_buffer, sizeof(log_buffer), "will run on %s",
-				next_time_str);
-			log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
-				LOG_ERR, phook->hook_name, log_buffer);
+		if ((periodic_helper_pid != -1) && (periodic_helper_stale ||
+			(periodic_helper_behind &&
+			(time_now - periodic_helper_since >= PERIODIC_HELPER_LAG)) ||
+			(time_now - periodic_helper_since >= PERIODIC_HELPER_LIFE)))
+			periodic_helper_retire();
+		if ((periodic_helper_pid == -1) && (periodic_helper_start() != 0)) {
+			log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_HOOK, LOG_ERR,
+				phook->hook_name, "could not start periodic hook helper, skipping run");
+			free(pdue->pd_name);
+			free(pdue);
+			return;
 		}
 
-		sprintf(log_buffer, "Server periodic hook ran successfully");
-	} else
-		sprintf(log_buffer, "Server periodic hook encountered errors: %d", stat);
+		periodic_running = pdue->pd_name;
+		free(pdue);
+		if (periodic_helper_send(phook) != 0)
+			periodic_helper_retire();
+	}
+}
 
-	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_INFO,
-		__func__, log_buffer);
+/**
+ * @brief
+ *		Note that hooks or resources changed, so the periodic hook helper's
+ *		copy of them is out of date and it is replaced before its next run.
+ *
+ * @return	void
+ */
+void
+periodic_hook_changed(void)
+{
+	periodic_helper_stale = 1;
+}
 
-	return;
+/**
+ * @brief
+ *		Note that a job, reservation, vnode, queue or the Server itself
+ *		changed.  This is called on every save, so it only marks the
+ *		periodic hook helper as behind; the helper is replaced once it has
+ *		served PERIODIC_HELPER_LAG seconds.
+ *
+ * @return	void
+ */
+void
+periodic_hook_objs_changed(void)
+{
+	periodic_helper_behind = 1;
 }
 
 /**
@@ -6866,16 +7520,10 @@ post_server_periodic_hook(struct work_task *ptask)
 void
 run_periodic_hook(struct work_task *ptask)
 {
-	char hook_msg[HOOK_MSG_SIZE] = {'\0'};
-	int ret;
-	int num_run = 0;
-	hook *phook;
-	hook_input_param_t req_ptr;
-	pid_t pid;
-	int event_initialized = 0;
+	hook		*phook;
+	periodic_due	*pdue;
 
 	phook = (hook *)ptask->wt_parm1;
-	hook_input_param_init(&req_ptr);
 	if (phook == NULL) {
 		log_err(-1, __func__, "A periodic hook disappeared");
 		return;
@@ -6886,74 +7534,40 @@ run_periodic_hook(struct work_task *ptask)
 		log_err(-1,__func__,log_buffer);
 	}
 
-	if (has_task_by_parm1(phook) == 1) {
-		/* There is already a task present related to
-		 * post processing for previously running hook.
-		 * Don't run hook this time, just register a
-		 * timed task for it's next occurance
-		 */
-		(void)set_task(WORK_Timed, time_now + phook->freq, run_periodic_hook, phook);
-		return;
-	}
+	/* Set a timed task for next occurance of this hook */
+	(void)set_task(WORK_Timed, time_now + phook->freq,
+		run_periodic_hook, phook);
 
-	pid = fork();
+	if (periodic_due_list.ll_next == NULL)
+		CLEAR_HEAD(periodic_due_list);
 
-	if (pid == -1) {	/* Error on fork */
-		log_err(errno, __func__, "fork failed\n");
-		pbs_errno = PBSE_SYSTEM;
-		return;
-	}
-
-	if (pid != 0) {		/* The parent (main server) */
-		/* Set a task for post processing of the running hook */
-		struct  work_task *ptask;
-		ptask = set_task(WORK_Deferred_Child, (long)pid,
-			post_server_periodic_hook, phook);
-		if (!ptask) {
-			log_err(errno, __func__, msg_err_malloc);
-			return;
+	/* do not let runs of a slow hook pile up behind each other */
+	if ((periodic_running != NULL) &&
+		(strcmp(periodic_running, phook->hook_name) == 0))
+		pdue = NULL;
+	else {
+		for (pdue = (periodic_due *)GET_NEXT(periodic_due_list); pdue != NULL;
+			pdue = (periodic_due *)GET_NEXT(pdue->pd_link)) {
+			if (strcmp(pdue->pd_name, phook->hook_name) == 0)
+				break;
 		}
-		/* Set a timed task for next occurance of this hook */
-		(void)set_task(WORK_Timed, time_now + phook->freq,
-			run_periodic_hook, phook);
-	} else {
-		/* Close all server connections */
-		net_close(-1);
-		tpp_terminate();
-		/* Unprotect child from being killed by kernel */
-		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
-
-		/* set vnodes and reservation list to hook input parameter */
-		req_ptr.vns_list = (pbs_list_head *)get_vnode_list();
-		req_ptr.resv_list = (pbs_list_head *)get_resv_list();
-
-		ret = server_process_hooks(PBS_BATCH_HookPeriodic, NULL, NULL, phook,
-					HOOK_EVENT_PERIODIC, NULL, &req_ptr, hook_msg,
-					sizeof(hook_msg), pbs_python_set_interrupt, &num_run, &event_initialized);
-		if (ret == 0)
-			log_event(PBSE_HOOKERROR, PBS_EVENTCLASS_HOOK, LOG_ERR, __func__, hook_msg);
-
-#if defined(DEBUG)
-		/* for valgrind, clear some stuff up */
-		{
-			hook *phook = (hook *) GET_NEXT(svr_allhooks);
-			while (phook) {
-				hook *tmp;
-				free(phook->hook_name);
-				if (phook->script) {
-					struct python_script *scr = phook->script;
-					free(scr->path);
-					free(scr->py_code_obj);
-				}
-				free(phook->script);
-				tmp = phook;
-				phook = (hook *) GET_NEXT(phook->hi_allhooks);
-				free(tmp);
+		if (pdue == NULL) {
+			if (((pdue = malloc(sizeof(periodic_due))) == NULL) ||
+				((pdue->pd_name = strdup(phook->hook_name)) == NULL)) {
+				log_err(errno, __func__, msg_err_malloc);
+				free(pdue);
+				return;
 			}
+			CLEAR_LINK(pdue->pd_link);
+			append_link(&periodic_due_list, &pdue->pd_link, pdue);
+			periodic_hook_next();
+			return;
 		}
-#endif
-
-		exit(ret);
 	}
-	return;
+
+	phook->periodic_skipped++;
+	snprintf(log_buffer, sizeof(log_buffer),
+		"previous run has not finished, skipping this occurrence");
+	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_HOOK,
+		LOG_INFO, phook->hook_name, log_buffer);
 }
@@ -37,23 +37,85 @@
  * subject to Altair's trademark licensing policies.
  */
 
+#include <stdlib.h>
+#include <errno.h>
 #include "job.h"
+#include "log.h"
+
+extern char *msg_err_malloc;
+
+#ifndef PBS_MOM
+/**
+ * @brief	Slot of a job attribute, allocated the first time it is asked
+ *		for.  Callers of get_jattr() use the result without checking
+ *		it, so running out of memory here is fatal.
+ *
+ * @param[in] pjob     - pointer to job struct
+ * @param[in] attr_idx - attribute index
+ *
+ * @return attribute * - pointer to attribute struct
+ */
+static attribute *
+job_attr_slot(const job *pjob, int attr_idx)
+{
+	attribute *pattr;
+
+	pattr = attr_sparse_get((attr_sparse *)&pjob->ji_wattr, job_attr_def, attr_idx, JOB_ATR_LAST);
+	if (pattr == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		exit(1);
+	}
+	return pattr;
+}
+#endif
 
 /**
  * @brief	Get attribute of job based on given attr index
  *
+ * @par	On the server the job only stores the attributes which were
+ *	touched, so this hands out (and keeps) a cleared slot the first
+ *	time an attribute is asked for.  Use find_jattr() or the typed
+ *	getters below to read an attribute without that cost.
+ *
  * @param[in] pjob     - pointer to job struct
  * @param[in] attr_idx - attribute index
  *
  * @return attribute *
- * @retval NULL  - failure
+ * @retval NULL  - no job given
  * @retval !NULL - pointer to attribute struct
  */
 attribute *
 get_jattr(const job *pjob, int attr_idx)
 {
 	if (pjob != NULL)
+#ifdef PBS_MOM
+		return _get_attr_by_idx((attribute *)pjob->ji_wattr, attr_idx);
+#else
+		return job_attr_slot(pjob, attr_idx);
+#endif
+	return NULL;
+}
+
+/**
+ * @brief	Get attribute of job based on given attr index, if the job
+ *		holds one
+ *
+ * @param[in] pjob     - pointer to job struct
+ * @param[in] attr_idx - attribute index
+ *
+ * @return attribute *
+ * @retval NULL  - no such attribute stored, i.e. it is not set
+ * @retval !NULL - pointer to attribute struct
+ */
+attribute *
+find_jattr(const job *pjob, int attr_idx)
+{
+	if (pjob != NULL)
+#ifdef PBS_MOM
 		return _get_attr_by_idx((attribute *)pjob->ji_wattr, attr_idx);
+#else
+		return attr_sparse_find(&pjob->ji_wattr, attr_idx);
+#endif
 	return NULL;
 }
 
@@ -113,8 +175,12 @@ check_job_substate(const job *pjob, int substate)
 char
 get_job_state(const job *pjob)
 {
+	attribute *pattr;
+
 	if (pjob != NULL) {
-		return get_attr_c(get_jattr(pjob, JOB_ATR_state));
+		if ((pattr = find_jattr(pjob, JOB_ATR_state)) == NULL)
+			return 0;
+		return get_attr_c(pattr);
 	}
 
 	return JOB_STATE_LTR_UNKNOWN;
@@ -138,7 +204,7 @@ get_job_state_num(const job *pjob)
 	if (pjob == NULL)
 		return -1;
 
-	statec = get_attr_c(get_jattr(pjob, JOB_ATR_state));
+	statec = get_job_state(pjob);
 	if (statec == -1)
 		return -1;
 
@@ -159,9 +225,8 @@ get_job_state_num(const job *pjob)
 long
 get_job_substate(const job *pjob)
 {
-	if (pjob != NULL) {
-		return get_attr_l(get_jattr(pjob, JOB_ATR_substate));
-	}
+	if (pjob != NULL)
+		return get_jattr_long(pjob, JOB_ATR_substate);
 
 	return -1;
 }
@@ -180,7 +245,7 @@ char *
 get_jattr_str(const job *pjob, int attr_idx)
 {
 	if (pjob != NULL)
-		return get_attr_str(get_jattr(pjob, attr_idx));
+		return get_attr_str(find_jattr(pjob, attr_idx));
 
 	return NULL;
 }
@@ -198,8 +263,10 @@ get_jattr_str(const job *pjob, int attr_idx)
 struct array_strings *
 get_jattr_arst(const job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		return get_attr_arst(get_jattr(pjob, attr_idx));
+	attribute *pattr;
+
+	if ((pattr = find_jattr(pjob, attr_idx)) != NULL)
+		return get_attr_arst(pattr);
 
 	return NULL;
 }
@@ -216,7 +283,13 @@ get_jattr_arst(const job *pjob, int attr_idx)
 pbs_list_head
 get_jattr_list(const job *pjob, int attr_idx)
 {
-	return get_attr_list(get_jattr(pjob, attr_idx));
+	static pbs_list_head empty = {(pbs_list_link *)&empty, (pbs_list_link *)&empty, NULL};
+	attribute *pattr;
+
+	if ((pattr = find_jattr(pjob, attr_idx)) != NULL)
+		return get_attr_list(pattr);
+
+	return empty;
 }
 
 /**
@@ -232,8 +305,13 @@ get_jattr_list(const job *pjob, int attr_idx)
 long
 get_jattr_long(const job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		return get_attr_l(get_jattr(pjob, attr_idx));
+	attribute *pattr;
+
+	if (pjob != NULL) {
+		if ((pattr = find_jattr(pjob, attr_idx)) == NULL)
+			return 0;
+		return get_attr_l(pattr);
+	}
 
 	return -1;
 }
@@ -251,8 +329,13 @@ get_jattr_long(const job *pjob, int attr_idx)
 long long
 get_jattr_ll(const job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		return get_attr_ll(get_jattr(pjob, attr_idx));
+	attribute *pattr;
+
+	if (pjob != NULL) {
+		if ((pattr = find_jattr(pjob, attr_idx)) == NULL)
+			return 0;
+		return get_attr_ll(pattr);
+	}
 
 	return -1;
 }
@@ -270,8 +353,10 @@ get_jattr_ll(const job *pjob, int attr_idx)
 svrattrl *
 get_jattr_usr_encoded(const job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		return (get_jattr(pjob, attr_idx))->at_user_encoded;
+	attribute *pattr;
+
+	if ((pattr = find_jattr(pjob, attr_idx)) != NULL)
+		return pattr->at_user_encoded;
 
 	return NULL;
 }
@@ -289,8 +374,10 @@ get_jattr_usr_encoded(const job *pjob, int attr_idx)
 svrattrl *
 get_jattr_priv_encoded(const job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		return (get_jattr(pjob, attr_idx))->at_priv_encoded;
+	attribute *pattr;
+
+	if ((pattr = find_jattr(pjob, attr_idx)) != NULL)
+		return pattr->at_priv_encoded;
 
 	return NULL;
 }
@@ -475,10 +562,7 @@ set_jattr_c_slim(job *pjob, int attr_idx, char val, enum batch_op op)
 int
 is_jattr_set(const job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		return is_attr_set(get_jattr(pjob, attr_idx));
-
-	return 0;
+	return is_attr_set(find_jattr(pjob, attr_idx));
 }
 
 /**
@@ -492,10 +576,11 @@ is_jattr_set(const job *pjob, int attr_idx)
 void
 mark_jattr_not_set(job *pjob, int attr_idx)
 {
-	if (pjob != NULL) {
-		attribute *attr = get_jattr(pjob, attr_idx);
+	attribute *attr;
+
+	/* an attribute the job holds no slot for is already unset */
+	if ((attr = find_jattr(pjob, attr_idx)) != NULL)
 		ATR_UNSET(attr);
-	}
 }
 
 /**
@@ -524,6 +609,5 @@ mark_jattr_set(job *pjob, int attr_idx)
 void
 free_jattr(job *pjob, int attr_idx)
 {
-	if (pjob != NULL)
-		free_attr(job_attr_def, get_jattr(pjob, attr_idx), attr_idx);
+	free_attr(job_attr_def, find_jattr(pjob, attr_idx), attr_idx);
 }
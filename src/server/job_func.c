@@ -363,6 +363,7 @@ job_alloc(void)
 	pj->ji_pmt_preq = NULL;
 	CLEAR_HEAD(pj->ji_svrtask);
 	CLEAR_HEAD(pj->ji_rejectdest);
+	CLEAR_LINK(pj->ji_histjobs);
 	pj->ji_terminated = 0;
 	pj->ji_deletehistory = 0;
 	pj->ji_script = NULL;
@@ -419,6 +420,9 @@ free_job_work_tasks(job *pj)
 {
 	struct work_task *pwt;
 	struct batch_request *tbr = NULL;
+
+	/* reply to and release the job's sends to its mom first */
+	jsend_cancel(pj);
 	/*
 	* Delete any work task entries associated with the job.
 	* mom deferred tasks via TPP are also hooked into the
@@ -466,9 +470,8 @@ free_job_work_tasks(job *pj)
 void
 job_free(job *pj)
 {
-	int i;
-
 #ifdef PBS_MOM
+	int i;
 
 #ifdef WIN32
 	if (is_jattr_set(pj,  JOB_ATR_altid)) {
@@ -501,8 +504,12 @@ job_free(job *pj)
 
 	/* remove any malloc working attribute space */
 
+#ifdef PBS_MOM
 	for (i = 0; i < (int)JOB_ATR_LAST; i++)
 		free_jattr(pj, i);
+#else
+	attr_sparse_free(&pj->ji_wattr, job_attr_def, JOB_ATR_LAST);
+#endif
 
 #ifndef PBS_MOM
 	{
@@ -510,6 +517,7 @@ job_free(job *pj)
 		badplace		*bp;
 
 		free_job_work_tasks(pj);
+		delete_link(&pj->ji_histjobs);
 
 		/* free any bad destination structs */
 
@@ -616,11 +624,16 @@ job_free(job *pj)
 static void
 job_init_wattr(job *pj)
 {
+#ifdef PBS_MOM
 	int	i;
 
 	for (i=0; i<(int)JOB_ATR_LAST; i++) {
 		clear_attr(get_jattr(pj, i), &job_attr_def[i]);
 	}
+#else
+	/* the server's storage starts empty, get_jattr() clears each slot */
+	memset(&pj->ji_wattr, 0, sizeof(pj->ji_wattr));
+#endif
 }
 
 
@@ -1677,7 +1690,6 @@ update_resources_list_error:
 resc_resv *
 resv_alloc(char *resvid)
 {
-	int i;
 	resc_resv *resvp;
 	char *dot = NULL;
 	char *svr_inst_id = NULL;
@@ -1693,12 +1705,10 @@ resv_alloc(char *resvid)
 	CLEAR_HEAD(resvp->ri_rejectdest);
 	resvp->newobj = 1;
 
-	/* set the reservation structure's version number and
-	 * the working attributes to "unspecified"
+	/* set the reservation structure's version number, the working
+	 * attributes start out empty, i.e. "unspecified"
 	 */
 	resvp->ri_qs.ri_rsversion = RSVERSION;
-	for (i = 0; i < RESV_ATR_LAST; i++)
-		clear_rattr(resvp, i);
 
 	if ((dot = strchr(resvid, (int)'.')) != 0)
 		*dot = '\0';
@@ -1708,8 +1718,7 @@ resv_alloc(char *resvid)
 		free(resvp);
 		return NULL;
 	}
-	set_attr_generic(&resvp->ri_wattr[RESV_ATR_server_inst_id],
-			 &resv_attr_def[RESV_ATR_server_inst_id], svr_inst_id, NULL, INTERNAL);
+	set_rattr_str_slim(resvp, RESV_ATR_server_inst_id, svr_inst_id, NULL);
 
 	/*
 	 * ignore first char in given id as it can change, see req_resvSub()
@@ -1718,6 +1727,7 @@ resv_alloc(char *resvid)
 	if (pbs_idx_insert(resvs_idx, (void *)(resvid + 1), (void *)resvp) != PBS_IDX_RET_OK) {
 		*dot = '.';
 		log_errf(-1, __func__, "Failed to add resv %s into index", resvid);
+		attr_sparse_free(&resvp->ri_wattr, resv_attr_def, RESV_ATR_LAST);
 		free(resvp);
 		return NULL;
 	}
@@ -1743,7 +1753,6 @@ resv_alloc(char *resvid)
 void
 resv_free(resc_resv *presv)
 {
-	int			 i;
 	struct work_task	*pwt;
 	badplace		*bp;
 	char *dot = NULL;
@@ -1751,8 +1760,7 @@ resv_free(resc_resv *presv)
 
 	/* remove any malloc working attribute space */
 
-	for (i=0; i < (int)RESV_ATR_LAST; i++)
-		free_rattr(presv, i);
+	attr_sparse_free(&presv->ri_wattr, resv_attr_def, RESV_ATR_LAST);
 
 	/* delete any work task entries associated with the resv */
 
@@ -64,6 +64,7 @@
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
+#include "hook_func.h"
 
 
 #define MAX_SAVE_TRIES 3
@@ -104,7 +105,7 @@ job_to_db(job *pjob, pbs_db_job_info_t *dbjob)
 	if (check_job_state(pjob, JOB_STATE_LTR_FINISHED))
 		save_all_attrs = 1;
 
-	if ((encode_attr_db(job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, &dbjob->db_attr_list, save_all_attrs)) != 0)
+	if ((encode_attr_sparse_db(job_attr_def, &pjob->ji_wattr, JOB_ATR_LAST, &dbjob->db_attr_list, save_all_attrs)) != 0)
 		return -1;
 
 	if (pjob->newobj) /* object was never saved/loaded before */
@@ -205,7 +206,7 @@ db_to_job(job *pjob,  pbs_db_job_info_t *dbjob)
 	strcpy(pjob->ji_extended.ji_ext.ji_jid, dbjob->ji_jid);
 	pjob->ji_extended.ji_ext.ji_credtype = dbjob->ji_credtype;
 
-	if ((decode_attr_db(pjob, &dbjob->db_attr_list.attrs, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, JOB_ATR_UNKN)) != 0)
+	if ((decode_attr_sparse_db(pjob, &dbjob->db_attr_list.attrs, job_attr_idx, job_attr_def, &pjob->ji_wattr, JOB_ATR_LAST, JOB_ATR_UNKN)) != 0)
 		return -1;
 
 	compare_obj_hash(&pjob->ji_qs, sizeof(pjob->ji_qs), pjob->qs_hash);
@@ -249,8 +250,10 @@ job_save_db(job *pjob)
 
 	/* update mtime before save, so the same value gets to the DB as well */
 	set_jattr_l_slim(pjob, JOB_ATR_mtime, time_now, SET);
-	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0)
+	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0) {
 		pjob->newobj = 0;
+		periodic_hook_objs_changed();
+	}
 
 done:
 	free_db_attr_list(&dbjob.db_attr_list);
@@ -370,7 +373,7 @@ resv_to_db(resc_resv *presv,  pbs_db_resv_info_t *dbresv)
 
 	strcpy(dbresv->ri_resvid, presv->ri_qs.ri_resvID);
 
-	if ((encode_attr_db(resv_attr_def, presv->ri_wattr, (int)RESV_ATR_LAST, &(dbresv->db_attr_list), 0)) != 0)
+	if ((encode_attr_sparse_db(resv_attr_def, &presv->ri_wattr, (int)RESV_ATR_LAST, &(dbresv->db_attr_list), 0)) != 0)
 		return -1;
 
 	if (presv->newobj) /* object was never saved or loaded before */
@@ -415,7 +418,7 @@ db_to_resv(resc_resv *presv, pbs_db_resv_info_t *dbresv)
 	presv->ri_qs.ri_svrflags = dbresv->ri_svrflags;
 	presv->ri_qs.ri_tactive = dbresv->ri_tactive;
 
-	if ((decode_attr_db(presv, &dbresv->db_attr_list.attrs, resv_attr_idx, resv_attr_def, presv->ri_wattr, RESV_ATR_LAST, RESV_ATR_UNKN)) != 0)
+	if ((decode_attr_sparse_db(presv, &dbresv->db_attr_list.attrs, resv_attr_idx, resv_attr_def, &presv->ri_wattr, RESV_ATR_LAST, RESV_ATR_UNKN)) != 0)
 		return -1;
 
 	compare_obj_hash(&presv->ri_qs, sizeof(presv->ri_qs), presv->qs_hash);
@@ -466,8 +469,10 @@ resv_save_db(resc_resv *presv)
 
 	/* update mtime before save, so the same value gets to the DB as well */
 	set_rattr_l_slim(presv, RESV_ATR_mtime, time_now, SET);
-	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0)
+	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0) {
 		presv->newobj = 0;
+		periodic_hook_objs_changed();
+	}
 
 done:
 	free_db_attr_list(&dbresv.db_attr_list);
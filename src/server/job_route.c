@@ -49,6 +49,7 @@
  *	is_bad_dest()	- Check the job for a match of dest in the list of rejected destinations.
  *	default_router()	- basic function for "routing" jobs.
  *	queue_route()	- route any "ready" jobs in a specific queue
+ *	queue_route_changed() - note a change that may unblock routing jobs
  */
 
 #include <pbs_config.h>   /* the master config generated by configure */
@@ -90,6 +91,7 @@ extern char	*msg_routexceed;
 extern char	*msg_routebad;
 extern char	*msg_err_malloc;
 extern time_t	 time_now;
+extern pbs_list_head svr_queues;
 
 /**
  * @brief
@@ -329,17 +331,72 @@ job_route(job *jobp)
 }
 
 
+/**
+ * @brief
+ * 		route_next_time - fold the next time queue_route() must look at a
+ *		job that is still sitting in a routing queue into next
+ *
+ *		Jobs held back by their state, a stopped queue or the queue's
+ *		max_running limit need no time; the state change, queue change or
+ *		end of transit that unblocks them sets qu_route_pending.
+ *
+ * @param[in]	pjob - job left in the routing queue
+ * @param[in]	pque - the routing queue
+ * @param[in]	next - earliest time found so far, 0 if none
+ *
+ * @return	time_t
+ * @retval	earliest of next and the job's own time, 0 if neither
+ */
+static time_t
+route_next_time(job *pjob, pbs_queue *pque, time_t next)
+{
+	time_t when = 0;
+
+	switch (get_job_state(pjob)) {
+		case JOB_STATE_LTR_QUEUED:
+		case JOB_STATE_LTR_HELD:
+		case JOB_STATE_LTR_WAITING:
+			break;
+		default:
+			return next;	/* in transit or history */
+	}
+
+	if (pjob->ji_qs.ji_un.ji_routet.ji_rteretry > time_now)
+		when = pjob->ji_qs.ji_un.ji_routet.ji_rteretry;
+	else if (check_job_state(pjob, JOB_STATE_LTR_QUEUED) &&
+		 get_qattr_long(pque, QA_ATR_Started) != 0 &&
+		 !(is_qattr_set(pque, QA_ATR_MaxRun) &&
+		   get_qattr_long(pque, QA_ATR_MaxRun) <= pque->qu_njstate[JOB_STATE_TRANSIT]))
+		when = time_now + 1;	/* left by a router without a retry time */
+
+	if (is_qattr_set(pque, QR_ATR_RouteLifeTime)) {
+		time_t life = pjob->ji_qs.ji_un.ji_routet.ji_quetime +
+			get_qattr_long(pque, QR_ATR_RouteLifeTime) + 1;
+		if (when == 0 || life < when)
+			when = life;
+	}
+
+	if (when != 0 && (next == 0 || when < next))
+		next = when;
+	return next;
+}
+
 /**
  * @brief
  * 		queue_route - route any "ready" jobs in a specific queue
  *
  *		look for any job in the queue whose route retry time has
- *		passed.
+ *		passed, or any job at all after a change to one of the queue's
+ *		destinations (qu_route_force).
 
  *		If the queue is "started" and if the number of jobs in the
  *		Transiting state is less than the max_running limit, then
  *		attempt to route it.
  *
+ *		The pass records in qu_route_next when a job left in the queue
+ *		is next due, main() calls again only then or after an event set
+ *		qu_route_pending.
+ *
  * @see
  * 		main
  *
@@ -354,17 +411,84 @@ queue_route(pbs_queue *pque)
 	job *nxjb;
 	job *pjob;
 	int  rc;
+	int  force = pque->qu_route_force;
+	time_t next = 0;
 
+	pque->qu_route_pending = 0;
+	pque->qu_route_force = 0;
 
 	pjob = (job *)GET_NEXT(pque->qu_jobs);
 	while (pjob) {
 		nxjb = (job *)GET_NEXT(pjob->ji_jobque);
-		if (pjob->ji_qs.ji_un.ji_routet.ji_rteretry <= time_now) {
-			if ((rc = job_route(pjob)) == PBSE_ROUTEREJ)
+		if (force || pjob->ji_qs.ji_un.ji_routet.ji_rteretry <= time_now) {
+			if ((rc = job_route(pjob)) == PBSE_ROUTEREJ) {
 				job_abt(pjob, msg_routebad);
-			else if (rc == PBSE_ROUTEEXPD)
+				pjob = nxjb;
+				continue;
+			} else if (rc == PBSE_ROUTEEXPD) {
 				job_abt(pjob, msg_routexceed);
+				pjob = nxjb;
+				continue;
+			}
 		}
+		if (pjob->ji_qhdr == pque)
+			next = route_next_time(pjob, pque, next);
 		pjob = nxjb;
 	}
+	pque->qu_route_next = next;
+}
+
+/**
+ * @brief
+ * 		queue_route_changed - note a change that may let jobs in routing
+ *		queues move, so queue_route() looks at them on the next pass
+ *
+ *		A change to a routing queue itself (started, limits, destinations)
+ *		marks it pending.  A change to a queue listed in the
+ *		route_destinations of a routing queue, or to the server when pque
+ *		is NULL, also retries the jobs waiting out their retry time since
+ *		the destination may take them now.
+ *
+ * @see
+ * 		mgr_queue_set, mgr_queue_unset, mgr_server_set, mgr_server_unset
+ *
+ * @param[in]	pque	- queue that changed, NULL for the server
+ *
+ * @return	void
+ */
+
+void
+queue_route_changed(pbs_queue *pque)
+{
+	pbs_queue *prq;
+	struct array_strings *dests;
+	size_t len;
+	int i;
+
+	if (pque != NULL && pque->qu_qs.qu_type == QTYPE_RoutePush)
+		pque->qu_route_pending = 1;
+
+	for (prq = (pbs_queue *)GET_NEXT(svr_queues); prq != NULL;
+	     prq = (pbs_queue *)GET_NEXT(prq->qu_link)) {
+		if (prq->qu_qs.qu_type != QTYPE_RoutePush)
+			continue;
+		if (pque == NULL) {
+			prq->qu_route_pending = 1;
+			prq->qu_route_force = 1;
+			continue;
+		}
+		if (!is_qattr_set(prq, QR_ATR_RouteDestin))
+			continue;
+		dests = get_qattr_arst(prq, QR_ATR_RouteDestin);
+		for (i = 0; i < dests->as_usedptr; i++) {
+			/* "queue" or "queue@server", only the queue name matters */
+			len = strcspn(dests->as_string[i], "@");
+			if (strlen(pque->qu_qs.qu_name) == len &&
+			    strncmp(dests->as_string[i], pque->qu_qs.qu_name, len) == 0) {
+				prq->qu_route_pending = 1;
+				prq->qu_route_force = 1;
+				break;
+			}
+		}
+	}
 }
@@ -861,13 +861,17 @@ save_nodes_db(int changemodtime, void *p)
 			goto db_err;
 	}
 
-	if (pmom) {
-		if (save_nodes_db_mom(pmom) == -1)
-			goto db_err;
-	} else {
-		if (save_nodes_db_inner() == -1)
-			goto db_err;
+	/* queue the node saves so they cost one round trip per batch */
+	pbs_db_begin_pipeline(svr_db_conn);
+	if (pmom)
+		i = save_nodes_db_mom(pmom);
+	else
+		i = save_nodes_db_inner();
+	if (pbs_db_end_pipeline(svr_db_conn) != 0 || i == -1) {
+		node_save_db_done(0);
+		goto db_err;
 	}
+	node_save_db_done(1);
 
 	/*
 	 * Clear the ATR_VFLAG_MODIFY bit on each node attribute
@@ -1224,8 +1224,10 @@ set_vnode_state(struct pbsnode *pnode, unsigned long state_bits, enum vnode_stat
 	if (pnode->nd_state != get_nattr_long(pnode, ND_ATR_state))
 		set_nattr_l_slim(pnode, ND_ATR_state, pnode->nd_state, SET);
 
-	if (vnode_o->nd_state != pnode->nd_state)
+	if (vnode_o->nd_state != pnode->nd_state) {
 		set_nattr_l_slim(pnode, ND_ATR_last_state_change_time, time_int_val, SET);
+		periodic_hook_objs_changed();
+	}
 
 	/* Write the vnode state change event to server log */
 	last_time_int = (int)vnode_o->nd_attr[(int)ND_ATR_last_state_change_time].at_val.at_long;
@@ -3116,10 +3118,10 @@ mcast_msg(struct work_task *ptask)
 
 		case IS_REPLYHELLO:
 			if (mtfd_replyhello != -1)
-				if ((ret = reply_hellosvr(mtfd_replyhello, 1)) != DIS_SUCCESS)
+				if ((ret = reply_hellosvr(mtfd_replyhello, IS_NEED_INV_DELTA)) != DIS_SUCCESS)
 					close_streams(mtfd_replyhello, ret);
 			if (mtfd_replyhello_noinv != -1)
-				if ((ret = reply_hellosvr(mtfd_replyhello_noinv, 0)) != DIS_SUCCESS)
+				if ((ret = reply_hellosvr(mtfd_replyhello_noinv, IS_NEED_INV_NONE)) != DIS_SUCCESS)
 					close_streams(mtfd_replyhello_noinv, ret);
 
 			tpp_mcast_close(mtfd_replyhello);
@@ -3338,6 +3340,8 @@ cross_link_mom_vnode(struct pbsnode *pnode, mominfo_t *pmom)
  * @param[out] from_hook - set non-zero if request coming from hook
  *			  Normally set to 1 for regular vnoded request;
  *			  2 for qmgr-like (non-vnoded) request.
+ * @param[in]  delta	- true if pvnal holds only the changed attributes
+ *			  (IS_UPDATE_DELTA), so those not listed are kept
  *
  * @return int
  * @retval	zero	- ok
@@ -3346,7 +3350,7 @@ cross_link_mom_vnode(struct pbsnode *pnode, mominfo_t *pmom)
  * @par MT-safe: No
  */
 static int
-update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from_hook)
+update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from_hook, int delta)
 {
 	int bad;
 	int i;
@@ -3513,7 +3517,7 @@ update2_to_vnode(vnal_t *pvnal, int new, mominfo_t *pmom, int *madenew, int from
 	 *	the default setting if Mom no longer sends anything
 	 */
 
-	if (!from_hook) {
+	if (!from_hook && !delta) {
 		for (i = 0; i < ND_ATR_LAST; ++i) {
 			/* if this vnode has been updated earlier in this update2 */
 			/* then don't free anything but topology */
@@ -4350,6 +4354,7 @@ found:
 
 		case IS_UPDATE:
 		case IS_UPDATE2:
+		case IS_UPDATE_DELTA:
 
 			if (psvrmom->msr_vnode_pool != 0) {
 				sprintf(log_buffer, "POOL: IS_UPDATE%c received",
@@ -4493,6 +4498,46 @@ found:
 				}
 			}
 
+			/* UPDATE_DELTA message - the changed vnode attributes only */
+			if (command == IS_UPDATE_DELTA) {
+				vnlp = vn_decode_DIS(stream, &ret);
+				if (ret != DIS_SUCCESS)
+					goto err;
+				if (vnlp == NULL) {
+					sprintf(log_buffer, "vn_decode_DIS vn failed");
+					log_err(-1, __func__, log_buffer);
+				} else if (vnlp->vnl_modtime >= pmom->mi_modtime) {
+					int	i;
+
+					/* unlike UPDATE2, vnodes not listed are not stale */
+					if (vnlp->vnl_modtime > pmom->mi_modtime)
+						cr_node = 1;
+					pmom->mi_modtime = vnlp->vnl_modtime;
+
+					if (vnlp->vnl_used > 0) {
+						sprintf(log_buffer, "Mom reporting changes to %lu vnodes", vnlp->vnl_used);
+						log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_NODE, LOG_INFO, pmom->mi_host, log_buffer);
+					}
+
+					for (i = 0; i < vnlp->vnl_used; i++) {
+						vnal_t	*vnrlp;
+						char	*pnames;
+
+						vnrlp = VNL_NODENUM(vnlp, i);
+						(void)update2_to_vnode(vnrlp, cr_node, pmom, &made_new_vnodes, 0, 1);
+						if ((pnames = attr_exist(vnrlp, VNATTR_PNAMES)) != NULL)
+							setup_pnames(pnames);
+					}
+
+					if (made_new_vnodes || cr_node) {
+						save_nodes_db(1, pmom); /* update the node database */
+						propagate_licenses_to_vnodes(pmom);
+					}
+				}
+				vnl_free(vnlp);
+				vnlp = NULL;
+			}
+
 			/* UPDATE2 message - multiple vnoded system */
 			if (command == IS_UPDATE2) {
 				vnlp = vn_decode_DIS(stream, &ret);
@@ -4531,7 +4576,7 @@ found:
 						vnal_t	*vnrlp;
 						vnrlp = VNL_NODENUM(vnlp, i);
 						/* create vnode */
-						(void)update2_to_vnode(vnrlp, cr_node, pmom, &made_new_vnodes, 0);
+						(void)update2_to_vnode(vnrlp, cr_node, pmom, &made_new_vnodes, 0, 0);
 						for (j = 0; j < vnrlp->vnal_used; j++) {
 							vna_t	*psrp;
 
@@ -4955,7 +5000,7 @@ found:
 				vnrlp = VNL_NODENUM(vnlp, i);
 				/* update vnode */
 				made_new_vnodes = 0;
-				if (update2_to_vnode(vnrlp, cr_node, pmom, &made_new_vnodes, (command == IS_UPDATE_FROM_HOOK2)?2:1) == PBSE_PERM) {
+				if (update2_to_vnode(vnrlp, cr_node, pmom, &made_new_vnodes, (command == IS_UPDATE_FROM_HOOK2)?2:1, 0) == PBSE_PERM) {
 					break; /* encountered a bad permission */
 				}
 			}
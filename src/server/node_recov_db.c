@@ -82,6 +82,7 @@
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
+#include "hook_func.h"
 
 struct pbsnode *recov_node_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 struct pbsnode *pbsd_init_node(pbs_db_node_info_t *dbnode, int type);
@@ -334,6 +335,7 @@ node_save_db(struct pbsnode *pnode)
 	void *conn = (void *) svr_db_conn;
 	char *conn_db_err = NULL;
 	int savetype;
+	int pipelined;
 	int rc = -1;
 
 	if ((savetype = node_to_db(pnode, &dbnode))  == -1)
@@ -342,13 +344,29 @@ node_save_db(struct pbsnode *pnode)
 	obj.pbs_db_obj_type = PBS_DB_NODE;
 	obj.pbs_db_un.pbs_db_node = &dbnode;
 
-	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) != 0) {
+	/*
+	 * A node created since the last save is inserted straight away; an
+	 * update that finds no row is only reported synchronously, so it
+	 * cannot be relied on when the save is queued in a pipeline.
+	 */
+	if (pnode->nd_svrflags & NODE_NEWOBJ)
+		savetype |= OBJ_SAVE_NEW;
+	pipelined = pbs_db_in_pipeline(conn);
+
+	rc = pbs_db_save_obj(conn, &obj, savetype);
+	if (rc != 0 && !(savetype & OBJ_SAVE_NEW) && !pipelined) {
 		savetype |= (OBJ_SAVE_NEW | OBJ_SAVE_QS);
 		rc = pbs_db_save_obj(conn, &obj, savetype);
 	}
 
-	if (rc == 0)
-		pnode->nd_svrflags &= ~NODE_NEWOBJ;
+	if (rc == 0) {
+		/* a queued insert is only known to be stored by node_save_db_done() */
+		if (pipelined)
+			pnode->nd_svrflags |= NODE_SAVEQUEUED;
+		else
+			pnode->nd_svrflags &= ~NODE_NEWOBJ;
+		periodic_hook_objs_changed();
+	}
 
 done:
 	free_db_attr_list(&dbnode.db_attr_list);
@@ -364,6 +382,34 @@ done:
 
 
 
+/**
+ * @brief
+ *	Settle the nodes whose saves were queued in a datastore pipeline,
+ *	once pbs_db_end_pipeline has said whether they were stored.  A new
+ *	node stays new until its insert is known to be stored, so that a
+ *	segment of the pipeline which was rolled back inserts it again next
+ *	time rather than updating a row which does not exist.
+ *
+ * @param[in]	ok - the pipeline succeeded
+ *
+ * @return	void
+ */
+void
+node_save_db_done(int ok)
+{
+	int i;
+
+	for (i = 0; i < svr_totnodes; i++) {
+		struct pbsnode *np = pbsndlist[i];
+
+		if (!(np->nd_svrflags & NODE_SAVEQUEUED))
+			continue;
+		np->nd_svrflags &= ~NODE_SAVEQUEUED;
+		if (ok)
+			np->nd_svrflags &= ~NODE_NEWOBJ;
+	}
+}
+
 /**
  * @brief
  *	Delete a node from the database
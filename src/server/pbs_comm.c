@@ -62,7 +62,6 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <signal.h>
-#include <avltree.h>
 
 #include <grp.h>
 #include <sys/resource.h>
@@ -530,9 +529,6 @@ main(int argc, char **argv)
 	pbs_close_stdfiles();
 #endif
 
-	/* comm runs 1 + tpp_conf.nuthreads threads - these might use avltree functionality */
-	avl_set_maxthreads(numthreads + 1);
-
 	sigemptyset(&act.sa_mask);
 	act.sa_flags = 0;
 	act.sa_handler = hup_me;
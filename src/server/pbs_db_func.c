@@ -89,7 +89,6 @@
 #include "pbs_nodes.h"
 #include "tracking.h"
 #include "provision.h"
-#include "avltree.h"
 #include "svrfunc.h"
 #include "acct.h"
 #include "pbs_version.h"
@@ -461,6 +460,21 @@ connect_to_db(int background) {
 	pid_t sid = -1;
 #endif
 	int db_delay = 0;
+	char *backend;
+
+	if ((backend = pbs_db_backend_name()) == NULL) {
+		log_errf(-1, __func__, "Unknown %s value \"%s\"", PBS_CONF_DATA_SERVICE_BACKEND, pbs_conf.pbs_data_service_backend);
+		fprintf(stderr, "pbs_server: Unknown %s value \"%s\"\n", PBS_CONF_DATA_SERVICE_BACKEND, pbs_conf.pbs_data_service_backend);
+		return 1;
+	}
+	/* a held datastore lock means another server, waiting will not help */
+	if (strcmp(backend, PBS_DB_BACKEND_EMBEDDED) == 0 &&
+		pbs_status_db(conn_db_host, pbs_conf.pbs_data_service_port) == 2) {
+		log_errf(-1, __func__, "PBS datastore is in use by another process, is another pbs_server running?");
+		fprintf(stderr, "pbs_server: PBS datastore is in use by another process, is another pbs_server running?\n");
+		return 1;
+	}
+
 try_db_again:
 	fprintf(stdout, "Connecting to PBS dataservice.");
 
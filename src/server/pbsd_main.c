@@ -177,6 +177,7 @@ struct batch_request	*saved_takeover_req;
 int svr_unsent_qrun_req = 0;	/* Set to 1 for scheduling unsent qrun requests */
 
 void *jobs_idx;
+void *users_jobstates_idx;
 void *queues_idx;
 void *resvs_idx;
 
@@ -875,6 +876,7 @@ main(int argc, char **argv)
 	CLEAR_HEAD(task_list_event);
 	CLEAR_HEAD(svr_queues);
 	CLEAR_HEAD(svr_alljobs);
+	CLEAR_HEAD(svr_histjobs);
 	CLEAR_HEAD(svr_newjobs);
 	CLEAR_HEAD(svr_allresvs);
 	CLEAR_HEAD(svr_deferred_req);
@@ -1407,11 +1409,13 @@ main(int argc, char **argv)
 			}
 		}
 
-		/* any jobs to route today */
+		/* any jobs to route today, only where an event or timer is due */
 
 		pque = (pbs_queue *)GET_NEXT(svr_queues);
 		while (pque) {
-			if (pque->qu_qs.qu_type == QTYPE_RoutePush)
+			if ((pque->qu_qs.qu_type == QTYPE_RoutePush) &&
+			    (pque->qu_route_pending ||
+			     (pque->qu_route_next != 0 && pque->qu_route_next <= time_now)))
 				queue_route(pque);
 			pque = (pbs_queue *)GET_NEXT(pque->qu_link);
 		}
@@ -1505,6 +1509,7 @@ main(int argc, char **argv)
 	/* Shut down interpreter now before closing network connections */
 	pbs_python_ext_shutdown_interpreter(&svr_interp_data); /* stop python if started */
 
+	svr_mail_shutdown();	/* hand off any mail still queued */
 	shutdown_ack();
 	net_close(-1);		/* close all network connections */
 	tpp_shutdown();
@@ -1513,6 +1518,7 @@ main(int argc, char **argv)
 	 * SERVER is going to be shutdown, destroy indexes
 	 */
 	pbs_idx_destroy(jobs_idx);
+	pbs_idx_destroy(users_jobstates_idx);
 	pbs_idx_destroy(queues_idx);
 	pbs_idx_destroy(resvs_idx);
 
@@ -1614,9 +1620,28 @@ next_task()
 
 	time_t		   tilwhen;
 	pbs_sched	   *psched;
+	pbs_queue	   *pque;
 
 	tilwhen = default_next_task();
 
+	/* wake up in time for the next job due in a routing queue */
+
+	for (pque = (pbs_queue *) GET_NEXT(svr_queues); pque; pque = (pbs_queue *) GET_NEXT(pque->qu_link)) {
+		time_t delay;
+		if (pque->qu_qs.qu_type != QTYPE_RoutePush)
+			continue;
+		if (pque->qu_route_pending)
+			delay = 0;
+		else if (pque->qu_route_next != 0)
+			delay = pque->qu_route_next - time_now;
+		else
+			continue;
+		if (delay < 0)
+			delay = 0;
+		if (delay < tilwhen)
+			tilwhen = delay;
+	}
+
 	/* should the scheduler be run?  If so, adjust the delay time  */
 
 	for (psched = (pbs_sched*) GET_NEXT(svr_allscheds); psched; psched = (pbs_sched*) GET_NEXT(psched->sc_link)) {
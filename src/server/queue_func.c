@@ -80,6 +80,7 @@
 #include "pbs_nodes.h"
 #include "pbs_sched.h"
 #include "pbs_idx.h"
+#include "svrfunc.h"
 
 /* Global Data */
 
@@ -166,6 +167,9 @@ que_free(pbs_queue *pq)
 		free(pkvp);
 	}
 
+	/* free the compiled admission limits */
+	free_que_rules(pq);
+
 	/* now free the main structure */
 	server.sv_qs.sv_numque--;
 	delete_link(&pq->qu_link);
@@ -69,6 +69,7 @@
 #include "pbs_nodes.h"
 #include "svrfunc.h"
 #include "pbs_db.h"
+#include "hook_func.h"
 
 
 #ifndef PBS_MOM
@@ -163,8 +164,10 @@ que_save_db(pbs_queue *pque)
 	obj.pbs_db_obj_type = PBS_DB_QUEUE;
 	obj.pbs_db_un.pbs_db_que = &dbque;
 
-	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0)
+	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0) {
 		pque->newobj = 0;
+		periodic_hook_objs_changed();
+	}
 
 done:
 	free_db_attr_list(&dbque.db_attr_list);
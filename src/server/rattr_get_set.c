@@ -37,26 +37,74 @@
  * subject to Altair's trademark licensing policies.
  */
 
+#include <stdlib.h>
+#include <errno.h>
 #include "attribute.h"
 #include "job.h"
 #include "reservation.h"
 #include "resv_node.h"
+#include "log.h"
+
+extern char *msg_err_malloc;
+
+/**
+ * @brief	Slot of a reservation attribute, allocated the first time it
+ *		is asked for.  Callers of get_rattr() use the result without
+ *		checking it, so running out of memory here is fatal.
+ *
+ * @param[in] presv    - pointer to reservation struct
+ * @param[in] attr_idx - attribute index
+ *
+ * @return attribute * - pointer to attribute struct
+ */
+static attribute *
+resv_attr_slot(const resc_resv *presv, int attr_idx)
+{
+	attribute *pattr;
+
+	pattr = attr_sparse_get((attr_sparse *)&presv->ri_wattr, resv_attr_def, attr_idx, RESV_ATR_LAST);
+	if (pattr == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		exit(1);
+	}
+	return pattr;
+}
 
 /**
- * @brief	Get attribute of reservation based on given attr index
+ * @brief	Get attribute of reservation based on given attr index,
+ *		handing out a cleared slot the first time it is asked for
  *
  * @param[in] presv    - pointer to node struct
  * @param[in] attr_idx - attribute index
  *
  * @return attribute *
- * @retval NULL  - failure
+ * @retval NULL  - no reservation given
  * @retval !NULL - pointer to attribute struct
  */
 attribute *
 get_rattr(const resc_resv *presv, int attr_idx)
 {
 	if (presv != NULL)
-		return _get_attr_by_idx((attribute *)presv->ri_wattr, attr_idx);
+		return resv_attr_slot(presv, attr_idx);
+	return NULL;
+}
+
+/**
+ * @brief	Get attribute of reservation based on given attr index, if
+ *		the reservation holds one
+ *
+ * @param[in] presv    - pointer to node struct
+ * @param[in] attr_idx - attribute index
+ *
+ * @return attribute *
+ * @retval NULL  - no such attribute stored, i.e. it is not set
+ * @retval !NULL - pointer to attribute struct
+ */
+attribute *
+find_rattr(const resc_resv *presv, int attr_idx)
+{
+	if (presv != NULL)
+		return attr_sparse_find(&presv->ri_wattr, attr_idx);
 	return NULL;
 }
 
@@ -73,10 +121,7 @@ get_rattr(const resc_resv *presv, int attr_idx)
 char *
 get_rattr_str(const resc_resv *presv, int attr_idx)
 {
-	if (presv != NULL)
-		return get_attr_str(get_rattr(presv, attr_idx));
-
-	return NULL;
+	return get_attr_str(find_rattr(presv, attr_idx));
 }
 
 /**
@@ -92,8 +137,10 @@ get_rattr_str(const resc_resv *presv, int attr_idx)
 struct array_strings *
 get_rattr_arst(const resc_resv *presv, int attr_idx)
 {
-	if (presv != NULL)
-		return get_attr_arst(get_rattr(presv, attr_idx));
+	attribute *pattr;
+
+	if ((pattr = find_rattr(presv, attr_idx)) != NULL)
+		return get_attr_arst(pattr);
 
 	return NULL;
 }
@@ -110,7 +157,13 @@ get_rattr_arst(const resc_resv *presv, int attr_idx)
 pbs_list_head
 get_rattr_list(const resc_resv *presv, int attr_idx)
 {
-	return get_attr_list(get_rattr(presv, attr_idx));
+	static pbs_list_head empty = {(pbs_list_link *)&empty, (pbs_list_link *)&empty, NULL};
+	attribute *pattr;
+
+	if ((pattr = find_rattr(presv, attr_idx)) != NULL)
+		return get_attr_list(pattr);
+
+	return empty;
 }
 
 /**
@@ -126,8 +179,13 @@ get_rattr_list(const resc_resv *presv, int attr_idx)
 long
 get_rattr_long(const resc_resv *presv, int attr_idx)
 {
-	if (presv != NULL)
-		return get_attr_l(get_rattr(presv, attr_idx));
+	attribute *pattr;
+
+	if (presv != NULL) {
+		if ((pattr = find_rattr(presv, attr_idx)) == NULL)
+			return 0;
+		return get_attr_l(pattr);
+	}
 
 	return -1;
 }
@@ -258,10 +316,7 @@ set_rattr_c_slim(resc_resv *presv, int attr_idx, char val, enum batch_op op)
 int
 is_rattr_set(const resc_resv *presv, int attr_idx)
 {
-	if (presv != NULL)
-		return is_attr_set(get_rattr(presv, attr_idx));
-
-	return 0;
+	return is_attr_set(find_rattr(presv, attr_idx));
 }
 
 /**
@@ -275,8 +330,7 @@ is_rattr_set(const resc_resv *presv, int attr_idx)
 void
 free_rattr(resc_resv *presv, int attr_idx)
 {
-	if (presv != NULL)
-		free_attr(resv_attr_def, get_rattr(presv, attr_idx), attr_idx);
+	free_attr(resv_attr_def, find_rattr(presv, attr_idx), attr_idx);
 }
 
 /**
@@ -290,5 +344,9 @@ free_rattr(resc_resv *presv, int attr_idx)
 void
 clear_rattr(resc_resv *presv, int attr_idx)
 {
-	clear_attr(get_rattr(presv, attr_idx), &resv_attr_def[attr_idx]);
+	attribute *pattr;
+
+	/* an attribute the reservation holds no slot for is already clear */
+	if ((pattr = find_rattr(presv, attr_idx)) != NULL)
+		clear_attr(pattr, &resv_attr_def[attr_idx]);
 }
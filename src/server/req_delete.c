@@ -81,6 +81,7 @@
 #include "svrfunc.h"
 
 #define QDEL_BREAKER_SECS 5
+#define QDEL_BREAKER_JOBS 1000	/* jobs of a delete list handled before yielding */
 
 /* Global Data Items: */
 
@@ -458,6 +459,21 @@ req_deletejob(struct batch_request *preq)
 		start_jobid = preq->rq_ind.rq_deletejoblist.jobid_to_resume;
 
 	for (j = start_jobid; j < count; j++) {
+		/*
+		 * Handle a long delete list in slices so that other requests
+		 * are served in between, resuming at this job in the next slice
+		 */
+		if (j > start_jobid && ((j - start_jobid) % QDEL_BREAKER_JOBS == 0 ||
+			(time(NULL) - begin_time) > QDEL_BREAKER_SECS)) {
+			preq->rq_ind.rq_deletejoblist.jobid_to_resume = j;
+			preq->rq_ind.rq_deletejoblist.subjobid_to_resume = -1;
+			if (set_task(WORK_Interleave, 0, resume_deletion, preq) != NULL) {
+				log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_REQUEST, LOG_DEBUG, preq->rq_user,
+					   "delete job list: %d of %d jobs handled, resuming later", j, count);
+				return;
+			}
+		}
+
 		snprintf(jid, sizeof(jid), "%s", jobids[j]);
 		parent = chk_job_request(jid, preq, &jt, &err);
 		if (parent == NULL) {
@@ -565,7 +581,8 @@ req_deletejob(struct batch_request *preq)
 			++preq->rq_refct;
 			preply->brp_un.brp_deletejoblist.tot_arr_jobs++;
 			
-			if (preq->rq_ind.rq_deletejoblist.rq_resume)
+			if (preq->rq_ind.rq_deletejoblist.rq_resume && j == start_jobid &&
+			    preq->rq_ind.rq_deletejoblist.subjobid_to_resume >= start)
 				start = preq->rq_ind.rq_deletejoblist.subjobid_to_resume;
 
 			/* keep the array from being removed while we are looking at it */
@@ -672,6 +672,9 @@ mgr_set_attr2(attribute *pattr, void *pidx, attribute_def *pdef, int limit, svra
 	if (plist == NULL)
 		return (PBSE_NONE);
 
+	/* limits and defaults precompiled from the old values are stale */
+	que_rules_changed();
+
 	/*
 	 * We have multiple attribute lists in play here.  pre_copy is used
 	 * to copy the attributes into pattr prior to calling the action functions.
@@ -940,6 +943,9 @@ mgr_unset_attr(attribute *pattr, void *pidx, attribute_def *pdef, int limit, svr
 	pbs_db_obj_info_t obj;
 	obj.pbs_db_un.pbs_db_job = NULL;
 
+	/* limits and defaults precompiled from the old values are stale */
+	que_rules_changed();
+
 	/* first check the attribute exists and we have privilege to set */
 	ord = 0;
 	pl = plist;
@@ -1402,6 +1408,7 @@ mgr_server_set(struct batch_request *preq, conn_t *conn)
 		reply_badattr(rc, bad_attr, plist, preq);
 	else {
 		svr_save_db(&server);
+		queue_route_changed(NULL);
 done:
 		if (has_log_events)
 			*log_event_mask = get_sattr_long(SVR_ATR_log_events);
@@ -1574,6 +1581,7 @@ mgr_server_unset(struct batch_request *preq, conn_t *conn)
 				set_sattr_l_slim(SVR_ATR_scheduling, 1, SET);
 		}
 		svr_save_db(&server);
+		queue_route_changed(NULL);
 		log_eventf(PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER, LOG_INFO,
 			msg_daemonname, msg_manager, msg_man_uns,
 			preq->rq_user, preq->rq_host);
@@ -1801,6 +1809,7 @@ mgr_queue_set(struct batch_request *preq)
 			} else {
 				que_save_db(pque);
 				mgr_log_attr(msg_man_set, plist, PBS_EVENTCLASS_QUEUE, pque->qu_qs.qu_name, NULL);
+				queue_route_changed(pque);
 			}
 		}
 		if (allques)
@@ -1891,6 +1900,7 @@ mgr_queue_unset(struct batch_request *preq)
 			mgr_log_attr(msg_man_uns, plist, PBS_EVENTCLASS_QUEUE, pque->qu_qs.qu_name, NULL);
 			if (is_qattr_set(pque, QA_ATR_QType) == 0)
 				pque->qu_qs.qu_type = QTYPE_Unset;
+			queue_route_changed(pque);
 		}
 		if (allques)
 			pque = GET_NEXT(pque->qu_link);
@@ -1900,12 +1910,127 @@ mgr_queue_unset(struct batch_request *preq)
 	reply_ack(preq);
 }
 
+/**
+ * @brief
+ *		Match a vnode name against a pattern in which '*' stands for any
+ *		string and '?' for any one character.
+ *
+ * @param[in]	pat	- pattern
+ * @param[in]	name	- vnode name
+ *
+ * @return	int
+ * @retval	1	- name matches
+ * @retval	0	- no match
+ */
+static int
+node_name_match(const char *pat, const char *name)
+{
+	const char *star = NULL;
+	const char *mark = NULL;
+
+	while (*name) {
+		if (*pat == '*') {
+			star = pat++;
+			mark = name;
+		} else if ((*pat == '?') || (*pat == *name)) {
+			pat++;
+			name++;
+		} else if (star) {
+			pat = star + 1;
+			name = ++mark;
+		} else
+			return 0;
+	}
+	while (*pat == '*')
+		pat++;
+	return (*pat == '\0');
+}
+
+/**
+ * @brief
+ *		Find the vnodes named by a bulk node request.  The object name is a
+ *		comma separated list of vnode names, any of which may be a pattern
+ *		using '*' and '?'.  Vnode names cannot contain these characters, so
+ *		an object name without them names a single vnode.
+ *
+ * @param[in]	names	- object name of the request
+ * @param[out]	pnodes	- malloc'ed array of the vnodes found, each once
+ *
+ * @return	int
+ * @retval	number of vnodes found
+ * @retval	0	- a name matches no vnode
+ * @retval	-1	- memory allocation failure
+ */
+static int
+find_node_list(char *names, struct pbsnode ***pnodes)
+{
+	struct pbsnode **nodes;
+	struct pbsnode *pnode;
+	char *seen;
+	char *buf;
+	char *name;
+	char *save = NULL;
+	int num = 0;
+	int found;
+	int i;
+
+	*pnodes = NULL;
+	if (svr_totnodes == 0)
+		return 0;
+	nodes = malloc(svr_totnodes * sizeof(struct pbsnode *));
+	seen = calloc(svr_totnodes, sizeof(char));
+	buf = strdup(names);
+	if (nodes == NULL || seen == NULL || buf == NULL) {
+		log_err(ENOMEM, __func__, "out of memory");
+		free(nodes);
+		free(seen);
+		free(buf);
+		return -1;
+	}
+
+	for (name = strtok_r(buf, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save)) {
+		found = 0;
+		if (strpbrk(name, "*?") == NULL) {
+			if ((pnode = find_nodebyname(name)) != NULL) {
+				found = 1;
+				if (!seen[pnode->nd_arr_index]) {
+					seen[pnode->nd_arr_index] = 1;
+					nodes[num++] = pnode;
+				}
+			}
+		} else {
+			for (i = 0; i < svr_totnodes; i++) {
+				pnode = pbsndlist[i];
+				if ((pnode->nd_state & INUSE_DELETED) || !node_name_match(name, pnode->nd_name))
+					continue;
+				found = 1;
+				if (!seen[i]) {
+					seen[i] = 1;
+					nodes[num++] = pnode;
+				}
+			}
+		}
+		if (!found) {
+			num = 0;
+			break;
+		}
+	}
+	free(seen);
+	free(buf);
+	if (num == 0)
+		free(nodes);
+	else
+		*pnodes = nodes;
+	return num;
+}
+
 /**
  * @brief
  *		Set vnode attributes
  *
- * 		Finds the set of vnodes, either one specified, all for a host or all.
- * 		Sets the request attributes on that set.
+ * 		Finds the set of vnodes, either one specified, a list or pattern of
+ * 		vnodes, all for a host or all.  Sets the request attributes on that
+ * 		set and saves the vnodes once for the whole set.
  * 		returns a reply to the sender of the batch_request
  *
  * 		Note the use of the ':' to indicate a port number as part of a host name
@@ -1932,6 +2057,7 @@ mgr_node_set(struct batch_request *preq)
 	mominfo_t *pmom = NULL;
 	mom_svrinfo_t *psvrmom = NULL;
 	struct pbsnode *pnode;
+	struct pbsnode **nodes = NULL; /* vnodes of a list or pattern */
 	int rc;
 	int i, j, len;
 	int problem_cnt = 0;
@@ -1992,6 +2118,14 @@ mgr_node_set(struct batch_request *preq)
 			req_reject(PBSE_UNKNODE, 0, preq);
 			return;
 		}
+	} else if (strpbrk(nodename, ",*?") != NULL) {
+		/* a list or pattern of vnodes, all set in this one request */
+		numnodes = find_node_list(nodename, &nodes);
+		if (numnodes < 0) {
+			req_reject(PBSE_SYSTEM, 0, preq);
+			return;
+		}
+		pnode = numnodes ? nodes[0] : NULL;
 	} else {
 		/* Else one and only one vnode */
 		pnode = find_nodebyname(nodename);
@@ -2024,6 +2158,7 @@ mgr_node_set(struct batch_request *preq)
 		problem_nodes = (struct pbsnode **)malloc(numnodes * sizeof(struct pbsnode *));
 		if (problem_nodes == NULL) {
 			log_err(ENOMEM, __func__, "out of memory");
+			free(nodes);
 			return;
 		}
 		problem_cnt = 0;
@@ -2034,6 +2169,7 @@ mgr_node_set(struct batch_request *preq)
 	if (warn_nodes == NULL) {
 		log_err(ENOMEM, __func__, "out of memory");
 		free(problem_nodes);
+		free(nodes);
 		return;
 	}
 	warnings_update(WARN_ngrp_init, warn_nodes, &warn_idx, pnode);
@@ -2093,6 +2229,7 @@ mgr_node_set(struct batch_request *preq)
 								req_reject(rc, 0, preq);
 						}
 						free(warn_nodes);
+						free(nodes);
 						free_attrlist(&unsetlist);
 						free_attrlist(&setlist);
 						return;
@@ -2138,6 +2275,10 @@ mgr_node_set(struct batch_request *preq)
 			if (update_mom_only) {
 				break;	/* all done */
 			}
+		} else if (nodes != NULL) {
+			if (++i == numnodes)
+				break;	/* all done */
+			pnode = nodes[i];	/* next vnode in list */
 		} else {
 			if (++i == svr_totnodes)
 				break;	/* all done */
@@ -2198,7 +2339,7 @@ mgr_node_set(struct batch_request *preq)
 
 	free(problem_nodes);
 	free(warn_nodes);
-
+	free(nodes);
 }
 
 
@@ -2229,6 +2370,7 @@ mgr_node_unset(struct batch_request *preq)
 	mominfo_t	*pmom = NULL;
 	mom_svrinfo_t *psvrmom = NULL;
 	struct pbsnode  *pnode;
+	struct pbsnode  **nodes = NULL;	/* vnodes of a list or pattern */
 	int		 rc;
 	int		 unset_que = 0;
 
@@ -2293,6 +2435,14 @@ mgr_node_unset(struct batch_request *preq)
 			pnode = NULL;
 		}
 
+	} else if (strpbrk(nodename, ",*?") != NULL) {
+		/* a list or pattern of vnodes, all unset in this one request */
+		numnodes = find_node_list(nodename, &nodes);
+		if (numnodes < 0) {
+			req_reject(PBSE_SYSTEM, 0, preq);
+			return;
+		}
+		pnode = numnodes ? nodes[0] : NULL;
 	} else {
 		pnode = find_nodebyname(nodename);
 	}
@@ -2317,6 +2467,7 @@ mgr_node_unset(struct batch_request *preq)
 			((plist->al_resc == NULL) ||
 			(strcasecmp(plist->al_resc, "host") == 0)))) {
 			reply_badattr(PBSE_BADNDATVAL, bad, plist, preq);
+			free(nodes);
 			return;
 		}
 
@@ -2338,6 +2489,7 @@ mgr_node_unset(struct batch_request *preq)
 		problem_nodes = (struct pbsnode **)malloc(numnodes * sizeof(struct pbsnode *));
 		if (problem_nodes == NULL) {
 			log_err(ENOMEM, __func__, "out of memory");
+			free(nodes);
 			return;
 		}
 		problem_cnt = 0;
@@ -2348,6 +2500,7 @@ mgr_node_unset(struct batch_request *preq)
 	if (warn_nodes == NULL) {
 		log_err(ENOMEM, __func__, "out of memory");
 		free(problem_nodes);
+		free(nodes);
 		return;
 	}
 	warnings_update(WARN_ngrp_init, warn_nodes, &warn_idx, pnode);
@@ -2395,6 +2548,7 @@ mgr_node_unset(struct batch_request *preq)
 							req_reject(rc, 0, preq);
 					}
 					free(warn_nodes);
+					free(nodes);
 					return;
 				}
 
@@ -2446,6 +2600,10 @@ mgr_node_unset(struct batch_request *preq)
 			if (++momidx >= psvrmom->msr_numvnds)
 				break;
 			pnode = psvrmom->msr_children[momidx];
+		} else if (nodes != NULL) {
+			if (++i == numnodes)
+				break;
+			pnode = nodes[i];
 		} else {
 			if (++i == svr_totnodes)
 				break;
@@ -2503,6 +2661,7 @@ mgr_node_unset(struct batch_request *preq)
 
 	free(problem_nodes);
 	free(warn_nodes);
+	free(nodes);
 }
 
 /**
@@ -3327,55 +3486,65 @@ mgr_sched_create(struct batch_request *preq)
 
 /**
  * @brief
- *		mgr_node_create - process request to create a node
+ *		check_node_create_name - check the name of a vnode to be created
  *
- *		Creates pbsnode and calls mgr_set_attr to set
- *      any associated node attributes also specified in the
- *      request.
+ *  @param[in]	nodename	- name of the vnode
  *
- *  @param[in]	preq	- Pointer to a batch request structure
+ *  @return	int
+ *  @retval	PBSE_NONE	- name can be used
+ *  @retval	PBSE_BADNDATVAL	- name contains an invalid character
+ *  @retval	PBSE_NODENBIG	- name is too long
  */
+static int
+check_node_create_name(char *nodename)
+{
+	char *vnp; /* Temp storage to validate (v)node name */
 
-void
-mgr_node_create(preq)
-struct batch_request *preq;
+	/*
+	 * Before creating the (v)node, validate the (v)node name using
+	 * legal_vnode_char() to check if it contains any invalid character.
+	 */
+	for (vnp = nodename; *vnp && legal_vnode_char(*vnp, 1); vnp++)
+		;
+	if (*vnp)
+		return PBSE_BADNDATVAL;
+	/* Condition to make sure that node name should not exceed
+	 * PBS_MAXHOSTNAME i.e. 64 characters. This is because the
+	 * corresponding column nd_name in the database table pbs.node
+	 * is defined as string of length 64.
+	 */
+	if (strlen(nodename) > PBS_MAXHOSTNAME)
+		return PBSE_NODENBIG;
+	return PBSE_NONE;
+}
+
+/**
+ * @brief
+ *		create_mgr_node - create one vnode of a create node request
+ *
+ *		Creates the pbsnode with the attributes of the request and links it
+ *		into its vnode pool.  The caller notifies the Moms and saves the
+ *		vnodes once it has created all of the vnodes of the request.
+ *
+ *  @param[in]	preq	- Pointer to a batch request structure
+ *  @param[in]	nodename	- name of the vnode to create
+ *  @param[out]	bad	- index of the bad attribute on an attribute error
+ *
+ *  @return	int
+ *  @retval	PBSE_NONE	- vnode created
+ *  @retval	PBS error	- error creating the vnode
+ */
+static int
+create_mgr_node(struct batch_request *preq, char *nodename, int *bad)
 {
-	int		 bad;
 	svrattrl	*plist;
 	int		 rc;
-	char 		*vnp; /* Temp storage to validate (v)node name */
 	long		 vn_pool;
 	struct pbsnode	*pnode;
 	mominfo_t	*mymom;
 	struct		sockaddr_in check_ip;
 	int		is_node_ip;
-	char *nodename;
-
-	nodename = preq->rq_ind.rq_manager.rq_objname;
 
-	/*
-	 * Before creating the (v)node, validate the (v)node name using
-	 * legal_vnode_char() to check if it contains any invalid character.
-	 * If any invalid char found, then reject the batch req with
-	 * PBSE_BADNDATVAL.
-	 */
-	if ((vnp = nodename) != NULL) {
-		for (; *vnp && legal_vnode_char(*vnp, 1); vnp++)
-			;
-		if (*vnp) {
-			req_reject(PBSE_BADNDATVAL, 0, preq);
-			return;
-		}
-		/* Condition to make sure that node name should not exceed
-		 * PBS_MAXHOSTNAME i.e. 64 characters. This is because the
-		 * corresponding column nd_name in the database table pbs.node
-		 * is defined as string of length 64.
-		 */
-		if (strlen(nodename) > PBS_MAXHOSTNAME) {
-			req_reject(PBSE_NODENBIG, 0, preq);
-			return;
-		}
-	}
 	is_node_ip = inet_pton(AF_INET, nodename, &(check_ip.sin_addr));
 	if (is_node_ip > 0) {
 		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, LOG_INFO, nodename,
@@ -3383,27 +3552,9 @@ struct batch_request *preq;
 	}
 	plist = (svrattrl *)GET_NEXT(preq->rq_ind.rq_manager.rq_attr);
 	rc = create_pbs_node(nodename,
-		plist, preq->rq_perm, &bad, &pnode, TRUE);
-
-	if (rc != 0) {
-
-		switch (rc) {
-			case PBSE_INTERNAL:
-			case PBSE_SYSTEM:
-				req_reject(rc, bad, preq);
-				break;
-
-			case PBSE_NOATTR:
-			case PBSE_ATTRRO:
-			case PBSE_MUTUALEX:
-			case PBSE_BADNDATVAL:
-				reply_badattr(rc, bad, plist, preq);
-				break;
-
-			default:  req_reject(rc, 0, preq);
-		}
-		return;
-	}
+		plist, preq->rq_perm, bad, &pnode, TRUE);
+	if (rc != 0)
+		return rc;
 
 	mymom   = pnode->nd_moms[0];
 	if (is_nattr_set(pnode, ND_ATR_vnode_pool) && ((vn_pool = get_nattr_long(pnode, ND_ATR_vnode_pool)) > 0)) {
@@ -3433,11 +3584,124 @@ struct batch_request *preq;
 	}
 	mgr_log_attr(msg_man_set, plist,
 		PBS_EVENTCLASS_NODE, nodename, NULL);
+	return PBSE_NONE;
+}
+
+/**
+ * @brief
+ *		mgr_node_create - process request to create a node
+ *
+ *		Creates pbsnode and calls mgr_set_attr to set
+ *      any associated node attributes also specified in the
+ *      request.
+ *
+ *		The object name may be a comma separated list of vnode names, all
+ *		created with the same attributes.  The names are all checked before
+ *		any vnode is created, and the Moms are notified and the vnodes saved
+ *		once for the whole list rather than once per vnode.  Should one of
+ *		the vnodes fail to be created, those already created by the request
+ *		are deleted again, so either all of the vnodes are created or none.
+ *
+ *  @param[in]	preq	- Pointer to a batch request structure
+ */
 
-	setup_notification();	    /*set mechanism for notifying */
-	/*other nodes of new member   */
+void
+mgr_node_create(preq)
+struct batch_request *preq;
+{
+	int		 bad = 0;
+	svrattrl	*plist;
+	int		 rc = PBSE_NONE;
+	int		 created = 0;
+	int		 numnames = 0;
+	char		*names;
+	char		*nodename;
+	char		*save = NULL;
+	void		*seen;
+	void		*pkey;
+	void		*pdup;
+	struct pbsnode	*pnode;
 
-	save_nodes_db(1, NULL);
+	if ((names = strdup(preq->rq_ind.rq_manager.rq_objname)) == NULL) {
+		req_reject(PBSE_SYSTEM, 0, preq);
+		return;
+	}
+	if ((seen = pbs_idx_create(0, 0)) == NULL) {
+		free(names);
+		req_reject(PBSE_SYSTEM, 0, preq);
+		return;
+	}
+
+	/* check all of the names, including against each other, before creating any vnode */
+	for (nodename = strtok_r(names, ",", &save); nodename != NULL && rc == PBSE_NONE;
+			nodename = strtok_r(NULL, ",", &save)) {
+		rc = check_node_create_name(nodename);
+		pkey = nodename;
+		if (rc == PBSE_NONE && (find_nodebyname(nodename) != NULL ||
+				pbs_idx_find(seen, &pkey, &pdup, NULL) == PBS_IDX_RET_OK))
+			rc = PBSE_NODEEXIST;
+		if (rc == PBSE_NONE && pbs_idx_insert(seen, nodename, nodename) != PBS_IDX_RET_OK)
+			rc = PBSE_SYSTEM;
+		numnames++;
+	}
+	pbs_idx_destroy(seen);
+	if (numnames == 0)
+		rc = PBSE_UNKNODE;
+	if (rc != PBSE_NONE) {
+		free(names);
+		req_reject(rc, 0, preq);
+		return;
+	}
+	strcpy(names, preq->rq_ind.rq_manager.rq_objname);
+
+	save = NULL;
+	for (nodename = strtok_r(names, ",", &save); nodename != NULL;
+			nodename = strtok_r(NULL, ",", &save)) {
+		if ((rc = create_mgr_node(preq, nodename, &bad)) != PBSE_NONE)
+			break;
+		created++;
+	}
+
+	if (rc != PBSE_NONE && created) {
+		/* all or none, delete the vnodes this request did create */
+		strcpy(names, preq->rq_ind.rq_manager.rq_objname);
+		save = NULL;
+		for (nodename = strtok_r(names, ",", &save); nodename != NULL && created > 0;
+				nodename = strtok_r(NULL, ",", &save), created--) {
+			if ((pnode = find_nodebyname(nodename)) != NULL)
+				effective_node_delete(pnode);
+		}
+		created = 0;
+	}
+	free(names);
+
+	if (created) {
+		setup_notification();	    /*set mechanism for notifying */
+		/*other nodes of new member   */
+
+		save_nodes_db(1, NULL);
+	}
+
+	if (rc != 0) {
+		plist = (svrattrl *)GET_NEXT(preq->rq_ind.rq_manager.rq_attr);
+
+		switch (rc) {
+			case PBSE_INTERNAL:
+			case PBSE_SYSTEM:
+				req_reject(rc, bad, preq);
+				break;
+
+			case PBSE_NOATTR:
+			case PBSE_ATTRRO:
+			case PBSE_MUTUALEX:
+			case PBSE_BADNDATVAL:
+				reply_badattr(rc, bad, plist, preq);
+				break;
+
+			default:  req_reject(rc, 0, preq);
+		}
+		return;
+	}
 
 	reply_ack(preq);	    /*create completely successful*/
 }
@@ -3628,6 +3892,10 @@ mgr_resource_create(struct batch_request *preq)
 	int flag_ir = 0;
 	resource_def *prdef;
 
+	/* resource definitions and lists change, drop precompiled queue limits */
+	que_rules_changed();
+	periodic_hook_changed();
+
 	if ((resc = preq->rq_ind.rq_manager.rq_objname) == NULL) {
 		req_reject(PBSE_BADATVAL, 0 , preq);
 		return;
@@ -3723,6 +3991,10 @@ mgr_resource_delete(struct batch_request *preq)
 	int bad;
 	int updatedb;	/* set to 1 if a db update is needed */
 
+	/* resource definitions and lists change, drop precompiled queue limits */
+	que_rules_changed();
+	periodic_hook_changed();
+
 	if ((resc = preq->rq_ind.rq_manager.rq_objname) == NULL) {
 		req_reject(PBSE_BADATVAL, 0 , preq);
 		return;
@@ -3932,6 +4204,10 @@ mgr_resource_set(struct batch_request *preq)
 	struct resc_type_map *p_resc_type_map = NULL;
 
 
+	/* resource definitions and lists change, drop precompiled queue limits */
+	que_rules_changed();
+	periodic_hook_changed();
+
 	if ((preq->rq_perm & PERM_MANAGER) == 0) {
 		req_reject(PBSE_PERM, 0, preq);
 		return;
@@ -4162,6 +4438,10 @@ mgr_resource_unset(struct batch_request *preq)
 	attribute *q_attr = NULL;
 	int q_count = 0;
 
+	/* resource definitions and lists change, drop precompiled queue limits */
+	que_rules_changed();
+	periodic_hook_changed();
+
 	if ((preq->rq_perm & PERM_MANAGER) == 0) {
 		req_reject(PBSE_PERM, 0, preq);
 		return;
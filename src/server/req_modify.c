@@ -442,6 +442,7 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 	attribute *pre_copy;
 	attribute *attr_save;
 	attribute *pattr;
+	attr_sparse *psparse;
 	resource  *prc;
 	int	   rc;
 	char	   newstate = -1;
@@ -453,18 +454,18 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 	else
 		allow_unkn = (int)JOB_ATR_UNKN;
 
-	pattr = pjob->ji_wattr;
+	psparse = &pjob->ji_wattr;
 
 	/* call attr_atomic_set to decode and set a copy of the attributes.
-	 * We need 2 copies: 1 for copying to pattr and 1 for calling the action functions
-	 * We can't use the same copy for the action functions because copying to pattr
+	 * We need 2 copies: 1 for copying to the job and 1 for calling the action functions
+	 * We can't use the same copy for the action functions because copying to the job
 	 * is a shallow copy and array pointers will be cleared during the copy.
 	 */
 
 	newattr = calloc(JOB_ATR_LAST, sizeof(attribute));
 	if (newattr == NULL)
 		return PBSE_SYSTEM;
-	rc = attr_atomic_set(plist, pattr, newattr, job_attr_idx, job_attr_def, JOB_ATR_LAST, allow_unkn, perm, bad);
+	rc = attr_atomic_set_sparse(plist, psparse, newattr, job_attr_idx, job_attr_def, JOB_ATR_LAST, allow_unkn, perm, bad);
 	if (rc) {
 		attr_atomic_kill(newattr, job_attr_def, JOB_ATR_LAST);
 		return rc;
@@ -484,7 +485,7 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 		return PBSE_SYSTEM;
 	}
 
-	attr_atomic_copy(attr_save, pattr, job_attr_def, JOB_ATR_LAST);
+	attr_atomic_copy_from_sparse(attr_save, psparse, job_attr_def, JOB_ATR_LAST);
 
 	/* If resource limits are being changed ... */
 
@@ -561,7 +562,7 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 		if ((hold_e == NULL) ||
 			((hold_e->al_flags & ATR_VFLAG_HOOK) == 0)) {
 			i = newattr[(int)JOB_ATR_hold].at_val.at_long ^
-				(pattr+(int)JOB_ATR_hold)->at_val.at_long;
+				get_jattr_long(pjob, JOB_ATR_hold);
 			rc = chk_hold_priv(i, perm);
 		}
 	}
@@ -601,16 +602,17 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 			 */
 			if (i == JOB_ATR_accrue_type)
 				continue;
-			free_attr(job_attr_def, &pattr[i], i);
+			pattr = get_jattr(pjob, i);
+			free_attr(job_attr_def, pattr, i);
 			if ((pre_copy[i].at_type == ATR_TYPE_LIST) ||
 				(pre_copy[i].at_type == ATR_TYPE_RESC)) {
 				list_move(&pre_copy[i].at_val.at_list,
-					  &pattr[i].at_val.at_list);
+					  &pattr->at_val.at_list);
 			} else {
-				pattr[i] = pre_copy[i];
+				*pattr = pre_copy[i];
 			}
 			/* ATR_VFLAG_MODCACHE will be included if set */
-			pattr[i].at_flags = pre_copy[i].at_flags;
+			pattr->at_flags = pre_copy[i].at_flags;
 		}
 	}
 
@@ -634,7 +636,7 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 		}
 	}
 	if (rc) {
-		attr_atomic_copy(pjob->ji_wattr, attr_save, job_attr_def, JOB_ATR_LAST);
+		attr_atomic_copy_to_sparse(psparse, attr_save, job_attr_def, JOB_ATR_LAST);
 		free(pre_copy);
 		attr_atomic_kill(newattr, job_attr_def, JOB_ATR_LAST);
 		attr_atomic_kill(attr_save, job_attr_def, JOB_ATR_LAST);
@@ -644,7 +646,8 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 	/* The action functions may have modified the attributes, need to set them to newattr2 */
 	for (i = 0; i < JOB_ATR_LAST; i++) {
 		if (newattr[i].at_flags & ATR_VFLAG_MODIFY) {
-			free_attr(job_attr_def, &pattr[i], i);
+			pattr = get_jattr(pjob, i);
+			free_attr(job_attr_def, pattr, i);
 			switch (i) {
 				case JOB_ATR_state:
 					newstate = get_attr_c(&newattr[i]);
@@ -659,13 +662,13 @@ modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
 					if ((newattr[i].at_type == ATR_TYPE_LIST) ||
 					    (newattr[i].at_type == ATR_TYPE_RESC)) {
 						list_move(&newattr[i].at_val.at_list,
-							  &pattr[i].at_val.at_list);
+							  &pattr->at_val.at_list);
 					} else {
-						pattr[i] = newattr[i];
+						*pattr = newattr[i];
 					}
 			}
 			/* ATR_VFLAG_MODCACHE will be included if set */
-			pattr[i].at_flags = newattr[i].at_flags;
+			pattr->at_flags = newattr[i].at_flags;
 		}
 	}
 
@@ -1328,11 +1331,10 @@ modify_resv_attr(resc_resv *presv, svrattrl *plist, int perm, int *bad)
 		return PBSE_INTERNAL;
 
 	allow_unkn = -1;
-	pattr = presv->ri_wattr;
 
 	/* call attr_atomic_set to decode and set a copy of the attributes */
 
-	rc = attr_atomic_set(plist, pattr, newattr, resv_attr_idx, resv_attr_def, RESV_ATR_LAST, allow_unkn, perm, bad);
+	rc = attr_atomic_set_sparse(plist, &presv->ri_wattr, newattr, resv_attr_idx, resv_attr_def, RESV_ATR_LAST, allow_unkn, perm, bad);
 	if (rc == 0) {
 		for (i = 0; i < RESV_ATR_LAST; i++) {
 			if (newattr[i].at_flags & ATR_VFLAG_MODIFY) {
@@ -1348,7 +1350,7 @@ modify_resv_attr(resc_resv *presv, svrattrl *plist, int perm, int *bad)
 			((newattr[(int)RESV_ATR_userlst].at_flags & ATR_VFLAG_MODIFY) ||
 			(newattr[(int)RESV_ATR_grouplst].at_flags & ATR_VFLAG_MODIFY))) {
 			/* Need to reset execution uid and gid */
-			rc = set_objexid((void *)presv, JOB_OBJECT, newattr);
+			rc = set_objexid((void *)presv, RESC_RESV_OBJECT, newattr);
 		}
 
 	}
@@ -1362,14 +1364,15 @@ modify_resv_attr(resc_resv *presv, svrattrl *plist, int perm, int *bad)
 
 	for (i = 0; i < RESV_ATR_LAST; i++) {
 		if (newattr[i].at_flags & ATR_VFLAG_MODIFY) {
-			resv_attr_def[i].at_free(pattr+i);
+			pattr = get_rattr(presv, i);
+			resv_attr_def[i].at_free(pattr);
 			if ((newattr[i].at_type == ATR_TYPE_LIST) || (newattr[i].at_type == ATR_TYPE_RESC)) {
-				list_move(&newattr[i].at_val.at_list, &(pattr+i)->at_val.at_list);
+				list_move(&newattr[i].at_val.at_list, &pattr->at_val.at_list);
 			} else {
-				*(pattr+i) = newattr[i];
+				*pattr = newattr[i];
 			}
 			/* ATR_VFLAG_MODCACHE will be included if set */
-			(pattr+i)->at_flags = newattr[i].at_flags;
+			pattr->at_flags = newattr[i].at_flags;
 		}
 	}
 
@@ -1818,8 +1818,13 @@ req_commit_now(struct batch_request *preq,  job *pj)
 	}
 	account_jobstr(pj, PBS_ACCT_QUEUE);
 
-	/* Make things faster by writing job only once here  - at commit time */
+	/*
+	 * Make things faster by writing job only once here  - at commit time.
+	 * The job and its script go out together in one pipeline round trip.
+	 */
+	pbs_db_begin_pipeline(conn);
 	if (job_save_db(pj)) {
+		(void) pbs_db_end_pipeline(conn);
 		job_purge(pj);
 		req_reject(PBSE_SAVE_ERR, 0, preq);
 		return;
@@ -1832,10 +1837,28 @@ req_commit_now(struct batch_request *preq,  job *pj)
 		obj.pbs_db_un.pbs_db_jobscr = &jobscr;
 
 		if (pbs_db_save_obj(conn, &obj, OBJ_SAVE_NEW) != 0) {
+			(void) pbs_db_end_pipeline(conn);
 			job_purge(pj);
 			req_reject(PBSE_SYSTEM, 0, preq);
 			return;
 		}
+	}
+
+	if (pbs_db_end_pipeline(conn) != 0) {
+		char *conn_db_err = NULL;
+
+		pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
+		log_errf(PBSE_INTERNAL, __func__, "Failed to save job %s %s", pj->ji_qs.ji_jobid, conn_db_err ? conn_db_err : "");
+		/* a duplicate job id is the client's problem, anything else is the datastore's */
+		if (conn_db_err == NULL || strstr(conn_db_err, "duplicate key value") == NULL)
+			panic_stop_db();
+		free(conn_db_err);
+		job_purge(pj);
+		req_reject(PBSE_SAVE_ERR, 0, preq);
+		return;
+	}
+
+	if (pj->ji_script) {
 		free(pj->ji_script);
 		pj->ji_script = NULL;
 	}
@@ -2500,7 +2523,7 @@ req_resvSub(struct batch_request *preq)
 
 	/* determine values for the "euser" and "egroup" attributes */
 
-	if ((rc = set_objexid((void *)presv, RESC_RESV_OBJECT, presv->ri_wattr))) {
+	if ((rc = set_objexid((void *)presv, RESC_RESV_OBJECT, NULL))) {
 		resv_free(presv);
 		req_reject(rc, 0, preq);
 		return;
@@ -3020,6 +3043,7 @@ act_resv_add_owner(attribute *pattr, void *pobj, int amode)
 	dumarst.as_bufsize = strlen(ps) + len;
 	dumarst.as_buf = ps;
 	dumarst.as_next = ps + len;
+	dumarst.as_acl = NULL;
 	dumarst.as_string[0] = ps;
 
 	/*"at_set" function returns 0 on success and NZ on failure*/
@@ -55,6 +55,7 @@
  * 	req_stat_svr()
  * 	req_stat_sched()
  * 	update_state_ct()
+ * 	update_user_state_ct()
  * 	update_license_ct()
  * 	req_stat_resv()
  * 	status_resv()
@@ -69,6 +70,9 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
 #include "libpbs.h"
 #include <ctype.h>
 #include "server_limits.h"
@@ -91,6 +95,7 @@
 #include "pbs_sched.h"
 #include "liblicense.h"
 #include "ifl_internal.h"
+#include "pbs_idx.h"
 
 /* Global Data Items: */
 
@@ -112,6 +117,7 @@ extern pbs_license_counts license_counts;
 /* Extern Functions */
 
 extern int status_attrib(svrattrl *, void *, attribute_def *, attribute *, int, int, pbs_list_head *, int *);
+extern int status_attrib_sparse(svrattrl *, void *, attribute_def *, attr_sparse *, int, int, pbs_list_head *, int *);
 extern int status_nodeattrib(svrattrl *, struct pbsnode *, int, int, pbs_list_head *, int *);
 
 extern int svr_chk_histjob(job *);
@@ -274,6 +280,297 @@ stat_a_jobidname(struct batch_request *preq, char *name, int dohistjobs, int dos
 	}
 }
 
+/* most sort keys accepted in one job status request */
+#define MAX_STAT_SORTKEYS 8
+
+/* one sort key of a job status request */
+struct stat_sortkey {
+	int sk_index;			/* index of the job attribute */
+	resource_def *sk_rescdef;	/* resource, if sorting on a resource list entry */
+	int sk_desc;			/* sort in descending order */
+};
+
+/* sort, limit and offset options of a job status request */
+struct stat_jobopts {
+	int so_nkeys;
+	struct stat_sortkey so_keys[MAX_STAT_SORTKEYS];
+	long so_limit;			/* -1 for no limit */
+	long so_offset;
+};
+
+/* a job to status and its position in the job list, to keep the sort stable */
+struct stat_sortjob {
+	job *sj_job;
+	int sj_pos;
+};
+
+static struct stat_jobopts *stat_sortopts;
+
+/**
+ * @brief
+ * 	Parse the sort keys of a job status request, a comma separated list of
+ * 	job attribute names, each optionally prefixed by '-' for descending order.
+ * 	An entry of a resource list is given as <attribute>.<resource>.
+ *
+ * @param[in]     preq  - the stat job batch request
+ * @param[in,out] value - list of sort keys, modified by the parse
+ * @param[out]    popts - options to add the keys to
+ *
+ * @return int
+ * @retval PBSE_NONE    - keys parsed
+ * @retval PBSE_IVALREQ - too many keys, or a key of a type that has no order
+ * @retval PBSE_NOATTR  - unknown or unreadable attribute or resource
+ */
+static int
+parse_stat_sortkeys(struct batch_request *preq, char *value, struct stat_jobopts *popts)
+{
+	char *name;
+	char *pc;
+	struct stat_sortkey *pkey;
+	attribute_def *pdef;
+
+	while ((name = parse_comma_string_r(&value)) != NULL) {
+		if (popts->so_nkeys >= MAX_STAT_SORTKEYS)
+			return PBSE_IVALREQ;
+		pkey = &popts->so_keys[popts->so_nkeys];
+		pkey->sk_desc = 0;
+		pkey->sk_rescdef = NULL;
+		if (*name == '-') {
+			pkey->sk_desc = 1;
+			name++;
+		}
+		if ((pc = strchr(name, '.')) != NULL)
+			*pc++ = '\0';
+		pkey->sk_index = find_attr(job_attr_idx, job_attr_def, name);
+		if (pkey->sk_index < 0)
+			return PBSE_NOATTR;
+		pdef = &job_attr_def[pkey->sk_index];
+		/* queue rank order is the order jobs are listed in anyway */
+		if ((pkey->sk_index != JOB_ATR_qrank) &&
+			((pdef->at_flags & preq->rq_perm & ATR_DFLAG_RDACC) == 0))
+			return PBSE_NOATTR;
+		if (pc != NULL) {
+			if (pdef->at_type != ATR_TYPE_RESC)
+				return PBSE_IVALREQ;
+			if ((pkey->sk_rescdef = find_resc_def(svr_resc_def, pc)) == NULL)
+				return PBSE_NOATTR;
+		} else {
+			switch (pdef->at_type) {
+				case ATR_TYPE_LONG:
+				case ATR_TYPE_CHAR:
+				case ATR_TYPE_STR:
+				case ATR_TYPE_SIZE:
+				case ATR_TYPE_LL:
+				case ATR_TYPE_SHORT:
+				case ATR_TYPE_BOOL:
+				case ATR_TYPE_FLOAT:
+					break;
+				default:
+					return PBSE_IVALREQ;
+			}
+		}
+		popts->so_nkeys++;
+	}
+	return PBSE_NONE;
+}
+
+/**
+ * @brief
+ * 	Parse the options which follow the extend characters of a job status
+ * 	request: ":sort=<keys>", ":limit=<n>" and ":offset=<n>".
+ *
+ * @param[in]  preq  - the stat job batch request
+ * @param[in]  opts  - options, starting at the first separator
+ * @param[out] popts - parsed options
+ *
+ * @return int
+ * @retval PBSE_NONE    - options parsed
+ * @retval !PBSE_NONE   - PBS error code to return to client
+ */
+static int
+parse_stat_jobopts(struct batch_request *preq, char *opts, struct stat_jobopts *popts)
+{
+	char *buf;
+	char *tok;
+	char *value;
+	char *endp;
+	char *saveptr = NULL;
+	char sep[2] = {STATJOB_OPT_SEP, '\0'};
+	int rc = PBSE_NONE;
+
+	if ((buf = strdup(opts)) == NULL)
+		return PBSE_SYSTEM;
+
+	for (tok = strtok_r(buf, sep, &saveptr); tok != NULL && rc == PBSE_NONE; tok = strtok_r(NULL, sep, &saveptr)) {
+		if ((value = strchr(tok, '=')) == NULL) {
+			rc = PBSE_IVALREQ;
+			break;
+		}
+		*value++ = '\0';
+		if (strcmp(tok, STATJOB_SORT) == 0)
+			rc = parse_stat_sortkeys(preq, value, popts);
+		else if (strcmp(tok, STATJOB_LIMIT) == 0 || strcmp(tok, STATJOB_OFFSET) == 0) {
+			long n;
+
+			n = strtol(value, &endp, 10);
+			if (*value == '\0' || *endp != '\0' || n < 0) {
+				rc = PBSE_IVALREQ;
+				break;
+			}
+			if (n > INT_MAX / 2)
+				n = INT_MAX / 2;	/* keep offset + limit within an int */
+			if (strcmp(tok, STATJOB_LIMIT) == 0)
+				popts->so_limit = n;
+			else
+				popts->so_offset = n;
+		} else
+			rc = PBSE_IVALREQ;
+	}
+	free(buf);
+	return rc;
+}
+
+/**
+ * @brief
+ * 	Compare the values of one sort key of two jobs.  Unset values sort
+ * 	after set ones whatever the direction.
+ *
+ * @return int
+ * @retval <0, 0, >0 as for qsort()
+ */
+static int
+cmp_stat_sortkey(job *pj1, job *pj2, struct stat_sortkey *pkey)
+{
+	attribute *pa1 = get_jattr(pj1, pkey->sk_index);
+	attribute *pa2 = get_jattr(pj2, pkey->sk_index);
+	int (*comp)(attribute *, attribute *) = job_attr_def[pkey->sk_index].at_comp;
+	int set1;
+	int set2;
+	int rc;
+
+	if (pkey->sk_rescdef != NULL) {
+		resource *pr1 = is_attr_set(pa1) ? find_resc_entry(pa1, pkey->sk_rescdef) : NULL;
+		resource *pr2 = is_attr_set(pa2) ? find_resc_entry(pa2, pkey->sk_rescdef) : NULL;
+
+		pa1 = (pr1 != NULL) ? &pr1->rs_value : NULL;
+		pa2 = (pr2 != NULL) ? &pr2->rs_value : NULL;
+		comp = pkey->sk_rescdef->rs_comp;
+	}
+	set1 = (pa1 != NULL) && is_attr_set(pa1);
+	set2 = (pa2 != NULL) && is_attr_set(pa2);
+	if (!set1 || !set2)
+		return set2 - set1;
+
+	rc = comp(pa1, pa2);
+	return pkey->sk_desc ? -rc : rc;
+}
+
+/**
+ * @brief
+ * 	qsort() compare function for the jobs of a sorted job status request,
+ * 	falling back to job list order between jobs which compare equal.
+ */
+static int
+cmp_stat_jobs(const void *v1, const void *v2)
+{
+	const struct stat_sortjob *psj1 = v1;
+	const struct stat_sortjob *psj2 = v2;
+	int i;
+	int rc;
+
+	for (i = 0; i < stat_sortopts->so_nkeys; i++) {
+		rc = cmp_stat_sortkey(psj1->sj_job, psj2->sj_job, &stat_sortopts->so_keys[i]);
+		if (rc != 0)
+			return rc;
+	}
+	return psj1->sj_pos - psj2->sj_pos;
+}
+
+/**
+ * @brief
+ * 	Collect the jobs of a queue or the server to return for a job status
+ * 	request with sort, limit or offset options.  Only jobs the client would
+ * 	be sent status for are counted toward the offset and limit, and no
+ * 	status is built for the jobs outside of them.
+ *
+ * @par
+ * 	The job lists are kept in queue rank order, so a request sorted on
+ * 	queue_rank alone, or not sorted at all, walks the list in the wanted
+ * 	direction and stops as soon as the limit is reached.
+ *
+ * @param[in]  preq       - the stat job batch request
+ * @param[in]  pque       - queue whose jobs are statused, NULL for the server
+ * @param[in]  dohistjobs - flag to include history jobs
+ * @param[in]  popts      - sort, limit and offset options
+ * @param[out] pnjobs     - number of jobs returned
+ *
+ * @return struct stat_sortjob *
+ * @retval array of *pnjobs jobs to status, to be freed by the caller
+ * @retval NULL on a memory allocation failure
+ */
+static struct stat_sortjob *
+collect_stat_jobs(struct batch_request *preq, pbs_queue *pque, int dohistjobs, struct stat_jobopts *popts, int *pnjobs)
+{
+	struct stat_sortjob *sjobs;
+	job *pjob;
+	int max;
+	int n = 0;
+	int start;
+	int end;
+	int listorder;
+	int reverse = 0;
+	long want = -1;
+
+	listorder = (popts->so_nkeys == 0) ||
+		((popts->so_nkeys == 1) && (popts->so_keys[0].sk_index == JOB_ATR_qrank));
+	if (listorder) {
+		reverse = popts->so_nkeys ? popts->so_keys[0].sk_desc : 0;
+		if (popts->so_limit >= 0)
+			want = popts->so_offset + popts->so_limit;
+	}
+
+	max = pque ? pque->qu_numjobs : server.sv_qs.sv_numjobs;
+	if (want >= 0 && want < max)
+		max = want;
+	if ((sjobs = malloc((max + 1) * sizeof(struct stat_sortjob))) == NULL)
+		return NULL;
+
+	if (pque)
+		pjob = (job *) (reverse ? GET_PRIOR(pque->qu_jobs) : GET_NEXT(pque->qu_jobs));
+	else
+		pjob = (job *) (reverse ? GET_PRIOR(svr_alljobs) : GET_NEXT(svr_alljobs));
+	while (pjob && n < max) {
+		if ((dohistjobs || !(check_job_state(pjob, JOB_STATE_LTR_FINISHED) ||
+				check_job_state(pjob, JOB_STATE_LTR_MOVED))) &&
+			((pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob) == 0) &&
+			(get_sattr_long(SVR_ATR_query_others) || svr_authorize_jobreq(preq, pjob) == 0)) {
+			sjobs[n].sj_job = pjob;
+			sjobs[n].sj_pos = n;
+			n++;
+		}
+		if (pque)
+			pjob = (job *) (reverse ? GET_PRIOR(pjob->ji_jobque) : GET_NEXT(pjob->ji_jobque));
+		else
+			pjob = (job *) (reverse ? GET_PRIOR(pjob->ji_alljobs) : GET_NEXT(pjob->ji_alljobs));
+	}
+
+	if (!listorder && n > 1) {
+		stat_sortopts = popts;
+		qsort(sjobs, n, sizeof(struct stat_sortjob), cmp_stat_jobs);
+		stat_sortopts = NULL;
+	}
+
+	start = (popts->so_offset < n) ? popts->so_offset : n;
+	end = n;
+	if (popts->so_limit >= 0 && popts->so_limit < end - start)
+		end = start + popts->so_limit;
+
+	if (start > 0)
+		memmove(sjobs, sjobs + start, (end - start) * sizeof(struct stat_sortjob));
+	*pnjobs = end - start;
+	return sjobs;
+}
+
 /**
  * @brief
  * 	Service the Status Job Request
@@ -304,23 +601,35 @@ req_stat_job(struct batch_request *preq)
 	int rc = 0;
 	int type = 0;
 	char *pnxtjid = NULL;
+	char *opts = NULL;
+	struct stat_jobopts jobopts;
 
 	/* check for any extended flag in the batch request. 't' for
 	 * the sub jobs. If 'x' is there, then check if the server is
 	 * configured for history job info. If not set or set to FALSE,
 	 * return with PBSE_JOBHISTNOTSET error. Otherwise select history
-	 * jobs.
+	 * jobs.  Any sort, limit and offset options follow the flags.
 	 */
+	memset(&jobopts, 0, sizeof(jobopts));
+	jobopts.so_limit = -1;
 	if (preq->rq_extend) {
-		if (strchr(preq->rq_extend, (int) 't'))
+		size_t nflags;
+
+		opts = strchr(preq->rq_extend, STATJOB_OPT_SEP);
+		nflags = opts ? (size_t)(opts - preq->rq_extend) : strlen(preq->rq_extend);
+		if (memchr(preq->rq_extend, (int) 't', nflags))
 			dosubjobs = 1; /* status sub jobs of an Array Job */
-		if (strchr(preq->rq_extend, (int) 'x')) {
+		if (memchr(preq->rq_extend, (int) 'x', nflags)) {
 			if (svr_history_enable == 0) {
 				req_reject(PBSE_JOBHISTNOTSET, 0, preq);
 				return;
 			}
 			dohistjobs = 1; /* status history jobs */
 		}
+		if (opts && (rc = parse_stat_jobopts(preq, opts, &jobopts)) != PBSE_NONE) {
+			req_reject(rc, 0, preq);
+			return;
+		}
 	}
 
 	/*
@@ -388,6 +697,32 @@ req_stat_job(struct batch_request *preq)
 			req_reject(rc, 0, preq);
 		return;
 
+	} else if (opts) {
+		struct stat_sortjob *sjobs;
+		int njobs;
+		int i;
+
+		sjobs = collect_stat_jobs(preq, type == 2 ? pque : NULL, dohistjobs, &jobopts, &njobs);
+		if (sjobs == NULL) {
+			req_reject(PBSE_SYSTEM, 0, preq);
+			return;
+		}
+		for (i = 0; i < njobs; i++) {
+			rc = do_stat_of_a_job(preq, sjobs[i].sj_job, dohistjobs, dosubjobs);
+			if (rc != PBSE_NONE) {
+				free(sjobs);
+				req_reject(rc, bad, preq);
+				return;
+			}
+			if (preply->brp_count >= MAX_JOBS_PER_REPLY && i + 1 < njobs) {
+				rc = reply_send_status_part(preq);
+				if (rc != PBSE_NONE) {
+					free(sjobs);
+					return;
+				}
+			}
+		}
+		free(sjobs);
 	} else {
 		pjob = (job *) GET_NEXT(type == 2 ? pque->qu_jobs : svr_alljobs);
 		while (pjob) {
@@ -750,6 +1085,12 @@ req_stat_svr(struct batch_request *preq)
 	/* update count and state counts from sv_numjobs and sv_jobstates */
 	set_sattr_l_slim(SVR_ATR_TotalJobs, server.sv_qs.sv_numjobs, SET);
 	update_state_ct(get_sattr(SVR_ATR_JobsByState), server.sv_jobstates, &svr_attr_def[SVR_ATR_JobsByState]);
+	/* like their jobs, other users' counts are only shown if query_other_jobs */
+	if (get_sattr_long(SVR_ATR_query_others) ||
+		(preq->rq_perm & (ATR_DFLAG_MGRD | ATR_DFLAG_OPRD)))
+		update_user_state_ct(get_sattr(SVR_ATR_JobsByUser), &svr_attr_def[SVR_ATR_JobsByUser], NULL);
+	else
+		update_user_state_ct(get_sattr(SVR_ATR_JobsByUser), &svr_attr_def[SVR_ATR_JobsByUser], preq->rq_user);
 
 	update_license_ct();
 
@@ -984,6 +1325,70 @@ update_state_ct(attribute *pattr, int *ct_array, attribute_def *attr_def)
 	set_attr_generic(pattr, attr_def, buf, NULL, INTERNAL);
 }
 
+/**
+ * @brief
+ * 		update_user_state_ct - update the count of jobs per state of each user
+ *		with jobs at the server, one "<user> <state>:<count> ..." entry per
+ *		user listing only the states the user has jobs in.
+ *
+ * @param[out]	pattr	-	server attribute
+ * @param[in] attr_def - attribute def of pattr
+ * @param[in]	user	-	only report this user, NULL for all users
+ *
+ * @par MT-safe: No
+ */
+
+void
+update_user_state_ct(attribute *pattr, attribute_def *attr_def, char *user)
+{
+	static char *statename[] = { "Transit", "Queued", "Held", "Waiting",
+		"Running", "Exiting", "Expired", "Begun",
+		"Moved", "Finished" };
+	struct user_jobstates *puj = NULL;
+	void *pkey = NULL;
+	void *ctx = NULL;
+	char *list = NULL;
+	int listsz = 0;
+	char buf[BUF_SIZE];
+	int index;
+
+	attr_def->at_free(pattr);
+	if (users_jobstates_idx == NULL)
+		return;
+
+	while (pbs_idx_find(users_jobstates_idx, &pkey, (void **)&puj, &ctx) == PBS_IDX_RET_OK) {
+		int nstates = 0;
+
+		if ((user != NULL) && (strcmp(puj->uj_user, user) != 0))
+			continue;
+		strcpy(buf, puj->uj_user);
+		for (index=0; index < (PBS_NUMJOBSTATE); index++) {
+			if ((index == JOB_STATE_EXPIRED) ||
+				(index == JOB_STATE_MOVED) ||
+				(index == JOB_STATE_FINISHED))
+				continue;	/* skip over Expired/Moved/Finished */
+			if (puj->uj_njstate[index] == 0)
+				continue;
+			sprintf(buf+strlen(buf), " %s:%d", statename[index],
+				puj->uj_njstate[index]);
+			nstates++;
+		}
+		if (nstates == 0)
+			continue;	/* only history jobs left */
+		if ((list != NULL && pbs_strcat(&list, &listsz, ",") == NULL) ||
+			pbs_strcat(&list, &listsz, buf) == NULL) {
+			log_err(errno, __func__, "Failed to build user state counts");
+			break;
+		}
+	}
+	pbs_idx_free_ctx(ctx);
+
+	if (list != NULL) {
+		set_attr_generic(pattr, attr_def, list, NULL, INTERNAL);
+		free(list);
+	}
+}
+
 /**
  * @brief
  * 	update_license_ct - update the # of licenses (counters) in 'license_count' server attribute.
@@ -1112,7 +1517,7 @@ status_resv(resc_resv *presv, struct batch_request *preq, pbs_list_head *pstathd
 	bad = 0;	/*global: record ordinal position where got error*/
 	pal = (svrattrl *) GET_NEXT(preq->rq_ind.rq_status.rq_attr);
 
-	if (status_attrib(pal, resv_attr_idx, resv_attr_def, presv->ri_wattr,
+	if (status_attrib_sparse(pal, resv_attr_idx, resv_attr_def, &presv->ri_wattr,
 		RESV_ATR_LAST, preq->rq_perm, &pstat->brp_attr, &bad) == 0)
 		return (0);
 	else
@@ -355,6 +355,8 @@ expand_resc_array(char *rname, int rtype, int rflag)
 	pnew->rs_type  = rtype;
 	pnew->rs_entlimflg = 0;
 	pnew->rs_next  = NULL;
+	/* no id before cr_rescdef_idx() numbered the built-in definitions */
+	pnew->rs_id    = (svr_resc_next_id > 0) ? svr_resc_next_id : -1;
 
 	if (pbs_idx_insert(resc_attrdef_idx, pnew->rs_name, pnew) != PBS_IDX_RET_OK) {
 		free(pnew->rs_name);
@@ -364,6 +366,8 @@ expand_resc_array(char *rname, int rtype, int rflag)
 
 	pold->rs_next  = pnew;
 	svr_resc_size++;
+	if (pnew->rs_id >= 0)
+		svr_resc_next_id++;
 
 	return 0;
 }
@@ -48,6 +48,7 @@
  * Included funtions are:
  *	svrcached()
  *	status_attrib()
+ *	status_attrib_sparse()
  *	status_job()
  *	status_subjob()
  *
@@ -178,12 +179,14 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
 }
 
 /*
- * status_attrib - add each requested or all attributes to the status reply
+ * status_attrs - add each requested or all attributes to the status reply,
+ *	from either a plain attribute array or a sparse container
  *
  * @param[in,out]	pal 	-	specific attributes to status
  * @param[in]		pidx 	-	Search index of the attribute array
  * @param[in]		padef	-	attribute definition structure
- * @param[in,out]	pattr	-	attribute structure
+ * @param[in,out]	pattr	-	attribute structure, or NULL
+ * @param[in,out]	psparse	-	sparse attribute storage if pattr is NULL
  * @param[in]		limit	-	limit on size of def array
  * @param[in]		priv	-	user-client privilege
  * @param[in,out]	phead	-	pbs_list_head
@@ -194,11 +197,12 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
  * @retval	-1	: on error (bad attribute)
  */
 
-int
-status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr, int limit, int priv, pbs_list_head *phead, int *bad)
+static int
+status_attrs(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr, attr_sparse *psparse, int limit, int priv, pbs_list_head *phead, int *bad)
 {
 	int   index;
 	int   nth = 0;
+	attribute *pa;
 
 	priv &= (ATR_DFLAG_RDACC | ATR_DFLAG_SvWR);  /* user-client privilege */
 	resc_access_perm = priv;  /* pass privilege to encode_resc()	*/
@@ -214,20 +218,73 @@ status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr,
 				return (-1);
 			}
 			if ((padef+index)->at_flags & priv) {
-				svrcached(pattr+index, phead, padef+index);
+				/* an attribute without a sparse slot is not set */
+				pa = pattr ? pattr + index : attr_sparse_find(psparse, index);
+				if (pa != NULL)
+					svrcached(pa, phead, padef+index);
 			}
 			pal = (svrattrl *)GET_NEXT(pal->al_link);
 		}
 	} else {	/* non specified, return all readable attributes */
 		for (index = 0; index < limit; index++) {
 			if ((padef+index)->at_flags & priv) {
-				svrcached(pattr+index, phead, padef+index);
+				/* an attribute without a sparse slot is not set */
+				pa = pattr ? pattr + index : attr_sparse_find(psparse, index);
+				if (pa != NULL)
+					svrcached(pa, phead, padef+index);
 			}
 		}
 	}
 	return (0);
 }
 
+/*
+ * status_attrib - add each requested or all attributes to the status reply
+ *
+ * @param[in,out]	pal 	-	specific attributes to status
+ * @param[in]		pidx 	-	Search index of the attribute array
+ * @param[in]		padef	-	attribute definition structure
+ * @param[in,out]	pattr	-	attribute structure
+ * @param[in]		limit	-	limit on size of def array
+ * @param[in]		priv	-	user-client privilege
+ * @param[in,out]	phead	-	pbs_list_head
+ * @param[out]		bad 	-	RETURN: index of first bad attribute
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	-1	: on error (bad attribute)
+ */
+
+int
+status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr, int limit, int priv, pbs_list_head *phead, int *bad)
+{
+	return status_attrs(pal, pidx, padef, pattr, NULL, limit, priv, phead, bad);
+}
+
+/*
+ * status_attrib_sparse - status_attrib() for an object keeping its
+ *	attributes in a sparse container
+ *
+ * @param[in,out]	pal 	-	specific attributes to status
+ * @param[in]		pidx 	-	Search index of the attribute array
+ * @param[in]		padef	-	attribute definition structure
+ * @param[in,out]	psparse	-	the object's sparse attribute storage
+ * @param[in]		limit	-	limit on size of def array
+ * @param[in]		priv	-	user-client privilege
+ * @param[in,out]	phead	-	pbs_list_head
+ * @param[out]		bad 	-	RETURN: index of first bad attribute
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	-1	: on error (bad attribute)
+ */
+
+int
+status_attrib_sparse(svrattrl *pal, void *pidx, attribute_def *padef, attr_sparse *psparse, int limit, int priv, pbs_list_head *phead, int *bad)
+{
+	return status_attrs(pal, pidx, padef, NULL, psparse, limit, priv, phead, bad);
+}
+
 /**
  * @brief
  * 		status_job - Build the status reply for a single job, regular or Array,
@@ -251,10 +308,12 @@ int
 status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *pstathd, int *bad, int dosubjobs)
 {
 	struct brp_status *pstat;
+	attribute *pelig = NULL;
 	long oldtime = 0;
 	int old_elig_flags = 0;
 	int old_atyp_flags = 0;
 	int revert_state_r = 0;
+	int rc;
 
 	/* see if the client is authorized to status this job */
 
@@ -262,12 +321,18 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 		if (svr_authorize_jobreq(preq, pjob))
 			return (PBSE_PERM);
 
-	/* calc eligible time on the fly and return, don't save. */
+	/*
+	 * calc eligible time on the fly and return, don't save.  The value is
+	 * swapped in without marking the attribute modified, so a stat never
+	 * leaves the job needing a save.
+	 */
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) == TRUE) {
 		if (get_jattr_long(pjob, JOB_ATR_accrue_type) == JOB_ELIGIBLE) {
-			oldtime = get_jattr_long(pjob, JOB_ATR_eligible_time);
-			set_jattr_l_slim(pjob, JOB_ATR_eligible_time,
-					time_now - get_jattr_long(pjob, JOB_ATR_sample_starttime), INCR);
+			pelig = get_jattr(pjob, JOB_ATR_eligible_time);
+			oldtime = pelig->at_val.at_long;
+			old_elig_flags = pelig->at_flags;
+			pelig->at_val.at_long = get_eligible_time(pjob);
+			pelig->at_flags |= ATR_VFLAG_SET | ATR_VFLAG_MODCACHE;
 		}
 	} else {
 		/* eligible_time_enable is off so, clear set flag so that eligible_time and accrue type dont show */
@@ -309,14 +374,16 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	/* add attributes to the status reply */
 
 	*bad = 0;
-	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, bad))
-		return (PBSE_NOATTR);
+	rc = status_attrib_sparse(pal, job_attr_idx, job_attr_def, &pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, bad);
 
 	/* reset eligible time, it was calctd on the fly, real calctn only when accrue_type changes */
 
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) != 0) {
-		if (get_jattr_long(pjob, JOB_ATR_accrue_type) == JOB_ELIGIBLE)
-			set_jattr_l_slim(pjob, JOB_ATR_eligible_time, oldtime, SET);
+		if (pelig != NULL) {
+			pelig->at_val.at_long = oldtime;
+			/* the cached encoding holds the value shown, not the stored one */
+			pelig->at_flags = old_elig_flags | ATR_VFLAG_MODCACHE;
+		}
 	} else {
 		/* reset the set flags */
 		get_jattr(pjob, JOB_ATR_eligible_time)->at_flags = old_elig_flags;
@@ -327,6 +394,8 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	if (revert_state_r)
 		set_job_state(pjob, JOB_STATE_LTR_RUNNING);
 
+	if (rc)
+		return (PBSE_NOATTR);
 	return (0);
 }
 
@@ -461,7 +530,7 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 		mark_jattr_not_set(pjob, JOB_ATR_accrue_type);
 	}
 
-	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, limit, preq->rq_perm, &pstat->brp_attr, bad))
+	if (status_attrib_sparse(pal, job_attr_idx, job_attr_def, &pjob->ji_wattr, limit, preq->rq_perm, &pstat->brp_attr, bad))
 		rc =  PBSE_NOATTR;
 
 	/* Set the parent state back to what it really is */
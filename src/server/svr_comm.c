@@ -408,6 +408,8 @@ ps_process_discard_job(int c)
 	discard_job(pjob, "Discard request for non local job", 1);
 
 end:
+	if (pjob != NULL)
+		attr_sparse_free(&pjob->ji_wattr, job_attr_def, JOB_ATR_LAST);
 	free(pjob);
 	free(exechost);
 	free(execvnode);
@@ -6000,6 +6000,7 @@ start_vnode_provisioning(struct prov_vnode_info * prov_vnode_info)
 		/* standard tpp closure and net close */
 		net_close(-1);
 		tpp_terminate();
+		pbs_db_close_fds(svr_db_conn);
 
 		/* Reset signal actions for most to SIG_DFL */
 		sigemptyset(&act.sa_mask);
@@ -55,7 +55,6 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
-#include <math.h>
 #include <netdb.h>
 #include <signal.h>
 #include <sys/types.h>
@@ -90,6 +89,7 @@
 #include "libsec.h"
 #include "pbs_license.h"
 #include "pbs_reliable.h"
+#include "hook_func.h"
 #include <sys/wait.h>
 
 #define MIN_WALLTIME_LIMIT 0
@@ -112,10 +112,13 @@ static void handle_qmgr_reply_to_startORenable(struct work_task *);
 static void delete_occurrence_jobs(resc_resv *presv);
 static void Time4occurrenceFinish(resc_resv *);
 static void running_jobs_count(struct work_task *);
+static void svr_histjob_link(job *);
+static void svr_histjob_compact(job *);
 
 /* Global Data Items: */
 extern char *msg_noloopbackif;
 extern char *msg_mombadmodify;
+extern char *msg_err_malloc;
 
 extern struct server server;
 extern int  pbs_mom_port;
@@ -187,6 +190,105 @@ tickle_for_reply(void)
 	(void)set_task(WORK_Timed, time_now + 10, 0, NULL);
 }
 
+/**
+ * @brief
+ * 		svr_user_jobstate - move one job of its owner from one state count
+ *		to another in the per-user job state counts.
+ *
+ * @par
+ *		The counts are kept up to date with the server and queue state
+ *		counts so that a stat of the server can report the jobs of each
+ *		user without walking the job list.  An entry is dropped once the
+ *		user has no jobs left.
+ *
+ * @param[in]	pjob	-	job whose owner's counts are updated
+ * @param[in]	oldstatenum	-	state the job leaves, -1 if none
+ * @param[in]	newstatenum	-	state the job enters, -1 if none
+ *
+ * @par MT-safe: No
+ */
+void
+svr_user_jobstate(job *pjob, int oldstatenum, int newstatenum)
+{
+	char user[PBS_MAXUSER + 1];
+	char *owner;
+	char *pc;
+	void *pkey;
+	struct user_jobstates *puj = NULL;
+	int i;
+
+	if (users_jobstates_idx == NULL || oldstatenum == newstatenum)
+		return;
+	if ((owner = get_jattr_str(pjob, JOB_ATR_job_owner)) == NULL)
+		return;
+	pbs_strncpy(user, owner, sizeof(user));
+	if ((pc = strchr(user, '@')) != NULL)
+		*pc = '\0';
+
+	pkey = user;
+	if (pbs_idx_find(users_jobstates_idx, &pkey, (void **)&puj, NULL) != PBS_IDX_RET_OK) {
+		if (newstatenum == -1)
+			return;
+		if ((puj = calloc(1, sizeof(struct user_jobstates))) == NULL) {
+			log_err(errno, __func__, msg_err_malloc);
+			return;
+		}
+		pbs_strncpy(puj->uj_user, user, sizeof(puj->uj_user));
+		if (pbs_idx_insert(users_jobstates_idx, puj->uj_user, puj) != PBS_IDX_RET_OK) {
+			free(puj);
+			return;
+		}
+	}
+
+	if (oldstatenum != -1 && puj->uj_njstate[oldstatenum] > 0)
+		puj->uj_njstate[oldstatenum]--;
+	if (newstatenum != -1)
+		puj->uj_njstate[newstatenum]++;
+
+	for (i = 0; i < PBS_NUMJOBSTATE; i++) {
+		if (puj->uj_njstate[i] != 0)
+			return;
+	}
+	pbs_idx_delete(users_jobstates_idx, puj->uj_user);
+	free(puj);
+}
+
+/**
+ * @brief
+ * 		link_alljobs_by_rank - link a job into the server's job list in
+ *		order of queue rank, starting at the end.
+ *
+ * @par
+ *		Every job, including a history job whose queue is gone, is linked
+ *		this way, so that svr_alljobs is always in queue rank order.
+ *		A job status request sorted on queue rank relies on it.
+ *
+ * @param[in]	pjob	-	job to link
+ *
+ * @par MT-safe: No
+ */
+static void
+link_alljobs_by_rank(job *pjob)
+{
+	job *pjcur;
+
+	pjcur = (job *)GET_PRIOR(svr_alljobs);
+	while (pjcur) {
+		if (get_jattr_ll(pjob, JOB_ATR_qrank) >= get_jattr_ll(pjcur, JOB_ATR_qrank))
+			break;
+		pjcur = (job *)GET_PRIOR(pjcur->ji_alljobs);
+	}
+	if (pjcur == 0) {
+		/* link first in server's list */
+		insert_link(&svr_alljobs, &pjob->ji_alljobs, pjob,
+			LINK_INSET_AFTER);
+	} else {
+		/* link after 'current' job in server's list */
+		insert_link(&pjcur->ji_alljobs, &pjob->ji_alljobs, pjob,
+			LINK_INSET_AFTER);
+	}
+}
+
 /**
  * @brief
  * 		svr_enquejob	-	Enqueue the job into specified queue.
@@ -234,11 +336,13 @@ svr_enquejob(job *pjob, char *selectspec)
 					log_joberr(PBSE_INTERNAL, __func__, "Failed add history job in index", pjob->ji_qs.ji_jobid);
 					return PBSE_INTERNAL;
 				}
-				append_link(&svr_alljobs, &pjob->ji_alljobs, pjob);
+				link_alljobs_by_rank(pjob);
 			}
+			svr_histjob_link(pjob);
 			server.sv_qs.sv_numjobs++;
 			if (state_num != -1)
 				server.sv_jobstates[state_num]++;
+			svr_user_jobstate(pjob, -1, state_num);
 			return (0);
 		} else {
 			return (PBSE_UNKQUE);
@@ -260,25 +364,13 @@ svr_enquejob(job *pjob, char *selectspec)
 		return PBSE_INTERNAL;
 	}
 
-	pjcur = (job *)GET_PRIOR(svr_alljobs);
-	while (pjcur) {
-		if (get_jattr_ll(pjob, JOB_ATR_qrank) >= get_jattr_ll(pjcur, JOB_ATR_qrank))
-			break;
-		pjcur = (job *)GET_PRIOR(pjcur->ji_alljobs);
-	}
-	if (pjcur == 0) {
-		/* link first in server's list */
-		insert_link(&svr_alljobs, &pjob->ji_alljobs, pjob,
-			LINK_INSET_AFTER);
-	} else {
-		/* link after 'current' job in server's list */
-		insert_link(&pjcur->ji_alljobs, &pjob->ji_alljobs, pjob,
-			LINK_INSET_AFTER);
-	}
+	link_alljobs_by_rank(pjob);
+	svr_histjob_link(pjob);
 
 	server.sv_qs.sv_numjobs++;
 	if (state_num != -1)
 		server.sv_jobstates[state_num]++;
+	svr_user_jobstate(pjob, -1, state_num);
 
 	/* place into queue in order of queue rank starting at end */
 
@@ -420,6 +512,7 @@ svr_enquejob(job *pjob, char *selectspec)
 		pjob->ji_qs.ji_un_type = JOB_UNION_TYPE_ROUTE;
 		pjob->ji_qs.ji_un.ji_routet.ji_quetime = time_now;
 		pjob->ji_qs.ji_un.ji_routet.ji_rteretry = 0;
+		pque->qu_route_pending = 1;
 	}
 	return (0);
 }
@@ -440,6 +533,7 @@ svr_dequejob(job *pjob)
 
 	/* remove job from server's all job list and reduce server counts */
 
+	delete_link(&pjob->ji_histjobs);
 	if (is_linked(&svr_alljobs, &pjob->ji_alljobs)) {
 		int state_num;
 
@@ -453,6 +547,7 @@ svr_dequejob(job *pjob)
 		state_num = get_job_state_num(pjob);
 		if (state_num != -1 && --server.sv_jobstates[state_num] < 0)
 			bad_ct = 1;
+		svr_user_jobstate(pjob, state_num, -1);
 	}
 
 	if ((pque = pjob->ji_qhdr) != NULL) {
@@ -471,6 +566,11 @@ svr_dequejob(job *pjob)
 			state_num = get_job_state_num(pjob);
 			if (state_num != -1 && --pque->qu_njstate[state_num] < 0)
 				bad_ct = 1;
+
+			/* a job done transiting frees a max_running slot */
+			if (pque->qu_qs.qu_type == QTYPE_RoutePush &&
+			    check_job_state(pjob, JOB_STATE_LTR_TRANSIT))
+				pque->qu_route_pending = 1;
 		}
 		pjob->ji_qhdr = NULL;
 	}
@@ -538,6 +638,7 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 				server.sv_jobstates[oldstatenum]--;
 			if (newstatenum != -1)
 				server.sv_jobstates[newstatenum]++;
+			svr_user_jobstate(pjob, oldstatenum, newstatenum);
 			if (pque != NULL) {
 				if (oldstatenum != -1)
 					pque->qu_njstate[oldstatenum]--;
@@ -569,6 +670,18 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 					free_jattr(pjob, JOB_ATR_etime);
 					/* TODO: remove attr etime from database */
 				}
+
+				/*
+				 * if routing queue, a job that may be routable again
+				 * or one leaving transit has queue_route() look again
+				 */
+
+				if ((pque->qu_qs.qu_type == QTYPE_RoutePush) &&
+					((oldstate == JOB_STATE_LTR_TRANSIT) ||
+					(newstate == JOB_STATE_LTR_QUEUED) ||
+					(newstate == JOB_STATE_LTR_HELD) ||
+					(newstate == JOB_STATE_LTR_WAITING)))
+					pque->qu_route_pending = 1;
 			}
 			/* if subjob, update parent Array Job */
 			if (pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob) {
@@ -581,6 +694,7 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 	/* set the states accordingly */
 	set_job_state(pjob, newstate);
 	set_job_substate(pjob, newsubstate);
+	periodic_hook_objs_changed();
 
 	/* eligible_time_enable */
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) == 1) {
@@ -763,12 +877,249 @@ lookup_variable(void *pobj, int objtype, char *variable)
 	return (pc);
 }
 
+/*
+ * Admission limits of a queue, compiled from the queue's and the server's
+ * resources_max, resources_min and resources_default.  The entries point
+ * into those attributes, so the rules are rebuilt by que_rules_get() as soon
+ * as que_rules_gen moves on, which que_rules_changed() does for every qmgr
+ * change of an attribute or resource definition.
+ *
+ * Any new code that sets, unsets or frees resources_max, resources_min or
+ * resources_default of a queue or the server, or that adds or deletes a
+ * resource definition, must call que_rules_changed() as well, else the
+ * compiled rules go on using freed resource entries.
+ */
+struct que_rules {
+	long qr_gen;		/* que_rules_gen the rules were built for */
+	int qr_size;		/* slots in qr_max */
+	resource **qr_max;	/* maximum by rs_id, the queue's else the server's */
+	resource *qr_wtmin;	/* queue resources_min.walltime */
+	int qr_ndflt;		/* entries in qr_dflt */
+	resource **qr_dflt;	/* defaults to apply, by precedence, one per resource */
+};
+
+static long que_rules_gen = 1;
+static struct que_rules *svr_rules;	/* server only rules, for no queue */
+
+/**
+ * @brief
+ * 		que_rules_changed - invalidate the compiled admission limits of
+ *		all queues
+ */
+void
+que_rules_changed(void)
+{
+	que_rules_gen++;
+}
+
+/**
+ * @brief
+ * 		free_rules - free a compiled admission rule object
+ *
+ * @param[in]	prules	-	rules to free, may be NULL
+ */
+static void
+free_rules(struct que_rules *prules)
+{
+	if (prules == NULL)
+		return;
+	free(prules->qr_max);
+	free(prules->qr_dflt);
+	free(prules);
+}
+
+/**
+ * @brief
+ * 		free_que_rules - free the compiled admission limits of a queue
+ *
+ * @param[in,out]	pque	-	queue
+ */
+void
+free_que_rules(pbs_queue *pque)
+{
+	free_rules(pque->qu_rules);
+	pque->qu_rules = NULL;
+}
+
+/**
+ * @brief
+ * 		rules_add_max - record the set maxima of a resource list that have
+ *		no higher precedence maximum yet
+ *
+ * @param[in,out]	prules	-	rules being built
+ * @param[in]	plimit	-	resources_max attribute
+ */
+static void
+rules_add_max(struct que_rules *prules, attribute *plimit)
+{
+	resource *pr;
+
+	if (!is_attr_set(plimit))
+		return;
+	for (pr = (resource *)GET_NEXT(plimit->at_val.at_list); pr;
+	     pr = (resource *)GET_NEXT(pr->rs_link)) {
+		int id = pr->rs_defin->rs_id;
+
+		if (is_attr_set(&pr->rs_value) && id >= 0 && id < prules->qr_size &&
+		    prules->qr_max[id] == NULL)
+			prules->qr_max[id] = pr;
+	}
+}
+
+/**
+ * @brief
+ * 		rules_add_dflt - append the set defaults of a resource list that no
+ *		list of higher precedence provides, in the order set_deflt_resc()
+ *		would apply them
+ *
+ * @param[in,out]	prules	-	rules being built
+ * @param[in]	pdflt	-	resources_default or resources_max attribute
+ * @param[in]	selflg	-	if set, select/place may be taken from the list
+ * @param[in,out]	seen	-	rs_id already provided by an earlier list
+ */
+static void
+rules_add_dflt(struct que_rules *prules, attribute *pdflt, int selflg, char *seen)
+{
+	resource *pr;
+
+	if (!is_attr_set(pdflt))
+		return;
+	for (pr = (resource *)GET_NEXT(pdflt->at_val.at_list); pr;
+	     pr = (resource *)GET_NEXT(pr->rs_link)) {
+		int id = pr->rs_defin->rs_id;
+
+		if (!selflg && ((pr->rs_defin == &svr_resc_def[RESC_SELECT]) ||
+				(pr->rs_defin == &svr_resc_def[RESC_PLACE])))
+			continue; /* dont use select/place */
+		if (!is_attr_set(&pr->rs_value) || id < 0 || id >= prules->qr_size || seen[id])
+			continue;
+		seen[id] = 1;
+		prules->qr_dflt[prules->qr_ndflt++] = pr;
+	}
+}
+
+/**
+ * @brief
+ * 		count_resc - number of entries of a set resource list attribute
+ *
+ * @param[in]	pattr	-	resource list attribute
+ *
+ * @return	int
+ */
+static int
+count_resc(attribute *pattr)
+{
+	resource *pr;
+	int n = 0;
+
+	if (!is_attr_set(pattr))
+		return 0;
+	for (pr = (resource *)GET_NEXT(pattr->at_val.at_list); pr;
+	     pr = (resource *)GET_NEXT(pr->rs_link))
+		n++;
+	return n;
+}
+
+/**
+ * @brief
+ * 		que_rules_get - return the compiled admission limits of a queue,
+ *		or of the server alone when pque is NULL, building them if they
+ *		are missing or out of date
+ *
+ * @param[in,out]	pque	-	queue, or NULL
+ *
+ * @return	struct que_rules *
+ * @retval	the rules
+ * @retval	NULL	: out of memory, callers check the attributes directly
+ */
+static struct que_rules *
+que_rules_get(pbs_queue *pque)
+{
+	struct que_rules **pprules = pque ? &pque->qu_rules : &svr_rules;
+	struct que_rules *prules = *pprules;
+	attribute *qmax = pque ? get_qattr(pque, QA_ATR_ResourceMax) : NULL;
+	attribute *qdflt = pque ? get_qattr(pque, QA_ATR_ResourceDefault) : NULL;
+	attribute *smax = get_sattr(SVR_ATR_ResourceMax);
+	attribute *sdflt = get_sattr(SVR_ATR_resource_deflt);
+	char *seen;
+	int ndflt;
+
+	if (prules != NULL && prules->qr_gen == que_rules_gen)
+		return prules;
+
+	free_rules(prules);
+	*pprules = NULL;
+	if (svr_resc_next_id <= 0)
+		return NULL;
+
+	ndflt = count_resc(sdflt) + count_resc(smax);
+	if (pque)
+		ndflt += count_resc(qdflt) + count_resc(qmax);
+
+	if ((prules = calloc(1, sizeof(struct que_rules))) == NULL)
+		return NULL;
+	prules->qr_size = svr_resc_next_id;
+	prules->qr_max = calloc(prules->qr_size, sizeof(resource *));
+	prules->qr_dflt = malloc((ndflt + 1) * sizeof(resource *));
+	seen = calloc(prules->qr_size, 1);
+	if (prules->qr_max == NULL || prules->qr_dflt == NULL || seen == NULL) {
+		free(seen);
+		free_rules(prules);
+		return NULL;
+	}
+
+	/* a queue maximum takes priority over the server's */
+	if (pque)
+		rules_add_max(prules, qmax);
+	rules_add_max(prules, smax);
+
+	if (pque && is_attr_set(get_qattr(pque, QA_ATR_ResourceMin))) {
+		resource *pr = find_resc_entry(get_qattr(pque, QA_ATR_ResourceMin), &svr_resc_def[RESC_WALLTIME]);
+		if (pr != NULL && is_attr_set(&pr->rs_value))
+			prules->qr_wtmin = pr;
+	}
+
+	/* same precedence as the calls to set_deflt_resc() used to have */
+	if (pque)
+		rules_add_dflt(prules, qdflt, 1, seen);
+	rules_add_dflt(prules, sdflt, 1, seen);
+	if (pque)
+		rules_add_dflt(prules, qmax, 0, seen);
+	rules_add_dflt(prules, smax, 0, seen);
+	free(seen);
+
+	prules->qr_gen = que_rules_gen;
+	*pprules = prules;
+	return prules;
+}
+
+/**
+ * @brief
+ * 		rules_max - effective maximum for a resource
+ *
+ * @param[in]	prules	-	compiled rules
+ * @param[in]	prdef	-	resource definition
+ *
+ * @return	resource *
+ * @retval	the queue's or else the server's set maximum
+ * @retval	NULL if neither limits the resource
+ */
+static resource *
+rules_max(struct que_rules *prules, resource_def *prdef)
+{
+	if (prdef->rs_id < 0 || prdef->rs_id >= prules->qr_size)
+		return NULL;
+	return prules->qr_max[prdef->rs_id];
+}
+
 /**
  * @brief
  * 		compare the job resource limit against the system limit
  * 		unless a queue limit exists, it take priority
  *
  * @param[in]	jobatr	-	job attribute
+ * @param[in]	prules	-	compiled limits of the queue, if NULL the queue
+ *				and server attributes are searched
  * @param[in]	queatr	-	resource (value) entry
  * @param[in]	svratr	-	server attribute.
  * @param[in]	qtype	-	type of queue (not used here)
@@ -778,7 +1129,7 @@ lookup_variable(void *pobj, int objtype, char *variable)
  */
 
 static void
-chk_svr_resc_limit(attribute *jobatr, attribute *queatr,
+chk_svr_resc_limit(attribute *jobatr, struct que_rules *prules, attribute *queatr,
 	attribute *svratr, int qtype)
 {
 	int       rc;
@@ -798,8 +1149,10 @@ chk_svr_resc_limit(attribute *jobatr, attribute *queatr,
 	while (jbrc) {
 		cmpwith = 0;
 		if (is_attr_set(&jbrc->rs_value)) {
-			qurc = find_resc_entry(queatr, jbrc->rs_defin);
-			if ((qurc == 0) ||
+			if (prules != NULL) {
+				/* precompiled: the queue limit if set, else the server's */
+				cmpwith = rules_max(prules, jbrc->rs_defin);
+			} else if (((qurc = find_resc_entry(queatr, jbrc->rs_defin)) == 0) ||
 				((is_attr_set(&qurc->rs_value))==0)) {
 				/* queue limit not set, check server's */
 
@@ -908,12 +1261,13 @@ int
 chk_wt_limits_STF(resource *resc_minwt, resource *resc_maxwt, pbs_queue *pque, attribute *pattr)
 {
 	attribute wt_min_queue_limit;
-	attribute wt_max_queue_limit;
-	attribute wt_max_server_limit;
+	attribute wt_max_limit;
 	resource *new_res = NULL;
+	resource *pr;
 	resource_def *rscdef = NULL;
-	int have_max_queue_limit = 0;
-	int have_max_server_limit = 0;
+	struct que_rules *prules = NULL;
+	int have_max_limit = 0;
+	int have_min_queue_limit = 0;
 
 	if (resc_minwt == NULL)
 		return 0;
@@ -923,47 +1277,51 @@ chk_wt_limits_STF(resource *resc_minwt, resource *resc_maxwt, pbs_queue *pque, a
 	 max_walltime >= resources_min.walltime
 	 max_walltime <= resources_max.walltime
 	 */
-	/* Check against queue maximum */
-	if (pque && get_wt_limit(get_qattr(pque, QA_ATR_ResourceMax), &wt_max_queue_limit) == 0)
-		have_max_queue_limit = 1;
-	/* Check server maximum limit only if queue maximum limit is not present */
-	if (!have_max_queue_limit && pque && get_wt_limit(get_sattr(SVR_ATR_ResourceMax), &wt_max_server_limit) == 0)
-		have_max_server_limit = 1;
+	if (pque)
+		prules = que_rules_get(pque);
+	if (prules) {
+		/* the maximum is precompiled as the queue's, else the server's */
+		if ((pr = rules_max(prules, &svr_resc_def[RESC_WALLTIME])) != NULL) {
+			wt_max_limit = pr->rs_value;
+			have_max_limit = 1;
+		}
+		if (prules->qr_wtmin != NULL) {
+			wt_min_queue_limit = prules->qr_wtmin->rs_value;
+			have_min_queue_limit = 1;
+		}
+	} else if (pque) {
+		/* Check against queue maximum, server maximum only if queue maximum limit is not present */
+		if (get_wt_limit(get_qattr(pque, QA_ATR_ResourceMax), &wt_max_limit) == 0 ||
+			get_wt_limit(get_sattr(SVR_ATR_ResourceMax), &wt_max_limit) == 0)
+			have_max_limit = 1;
+		if (get_wt_limit(get_qattr(pque, QA_ATR_ResourceMin), &wt_min_queue_limit) == 0)
+			have_min_queue_limit = 1;
+	}
 
 #ifndef NAS /* localmod 026 */
 	/* If res_maxwt is NULL and resources_max.walltime is set on either server/queue,
 	 * set resource_list.max_walltime on the server/queue to value of resources_max.walltime.
 	 * If resources_max.walltime is set on both server and queue, set resource_list.max_walltime
 	 * to queue's resources_max.walltime. */
-	if (resc_maxwt == NULL && pattr != NULL
-		&& (have_max_queue_limit || have_max_server_limit)) {
+	if (resc_maxwt == NULL && pattr != NULL && have_max_limit) {
 		rscdef = &svr_resc_def[RESC_MAX_WALLTIME];
 		new_res = add_resource_entry(pattr , rscdef);
-		if (have_max_queue_limit)
-			new_res->rs_defin->rs_set(&new_res->rs_value, &wt_max_queue_limit, SET);
-		else if (have_max_server_limit)
-			new_res->rs_defin->rs_set(&new_res->rs_value, &wt_max_server_limit, SET);
-		mark_attr_set(&new_res->rs_value);
+		if (new_res != NULL) {
+			new_res->rs_defin->rs_set(&new_res->rs_value, &wt_max_limit, SET);
+			mark_attr_set(&new_res->rs_value);
+		}
 	}
 #endif /* localmod 026 */
-	/* Check against queue maximum */
-	if (have_max_queue_limit) {
+	/* Check against queue maximum, or server maximum if the queue has none */
+	if (have_max_limit) {
 		if (PBSE_EXCQRESC == comp_wt_limits_STF(resc_minwt,
-			wt_max_queue_limit, MAX_WALLTIME_LIMIT)
+			wt_max_limit, MAX_WALLTIME_LIMIT)
 			|| PBSE_EXCQRESC == comp_wt_limits_STF(resc_maxwt,
-			wt_max_queue_limit, MAX_WALLTIME_LIMIT))
-			return (PBSE_EXCQRESC);
-	}
-	/* Queue limit not present, check against server maximum */
-	else if (have_max_server_limit) {
-		if ((PBSE_EXCQRESC == comp_wt_limits_STF(resc_maxwt,
-			wt_max_server_limit, MAX_WALLTIME_LIMIT)
-			|| PBSE_EXCQRESC == comp_wt_limits_STF(resc_minwt,
-			wt_max_server_limit, MAX_WALLTIME_LIMIT)))
+			wt_max_limit, MAX_WALLTIME_LIMIT))
 			return (PBSE_EXCQRESC);
 	}
 	/* Check against queue minimum */
-	if (pque && (get_wt_limit(get_qattr(pque, QA_ATR_ResourceMin), &wt_min_queue_limit) == 0)) {
+	if (have_min_queue_limit) {
 		if (PBSE_EXCQRESC == comp_wt_limits_STF(resc_minwt,
 			wt_min_queue_limit, MIN_WALLTIME_LIMIT)
 			|| PBSE_EXCQRESC == comp_wt_limits_STF(resc_maxwt,
@@ -994,10 +1352,10 @@ chk_resc_limits(attribute *pattr, pbs_queue *pque)
 	/* Get resource_list.min_walltime and resource_list.max_walltime if it is a STF job */
 	atresc = (resource *)GET_NEXT(pattr->at_val.at_list);
 	while (atresc != NULL) {
-		if ((strcasecmp(atresc->rs_defin->rs_name, MIN_WALLTIME) == 0)) {
+		if (atresc->rs_defin == &svr_resc_def[RESC_MIN_WALLTIME]) {
 			resc_minwt = atresc;
 		}
-		else if ((strcasecmp(atresc->rs_defin->rs_name, MAX_WALLTIME) == 0)) {
+		else if (atresc->rs_defin == &svr_resc_def[RESC_MAX_WALLTIME]) {
 			resc_maxwt = atresc;
 		}
 		/* No need to traverse further if both min_walltime and max_walltime are set */
@@ -1014,7 +1372,7 @@ chk_resc_limits(attribute *pattr, pbs_queue *pque)
 		return (PBSE_EXCQRESC);
 
 	/* now check individual resources against queue or server maximum */
-	chk_svr_resc_limit(pattr,
+	chk_svr_resc_limit(pattr, que_rules_get(pque),
 		get_qattr(pque, QA_ATR_ResourceMax),
 		get_sattr(SVR_ATR_ResourceMax),
 		pque->qu_qs.qu_type);
@@ -1049,7 +1407,7 @@ svr_chkque(job *pjob, pbs_queue *pque, char *hostname, int mtype)
 	/* if not already set, set up a uid/gid/name */
 
 	if (!is_jattr_set(pjob, JOB_ATR_euser) || !is_jattr_set(pjob, JOB_ATR_egroup)) {
-		if ((i = set_objexid((void*)pjob, JOB_OBJECT, pjob->ji_wattr)) != 0)
+		if ((i = set_objexid((void*)pjob, JOB_OBJECT, NULL)) != 0)
 			return (i);  /* PBSE_BADUSER or GRP */
 	}
 
@@ -2059,6 +2417,38 @@ make_schedselect(attribute *patrl, resource *pselect,
 	return (rc);
 }
 
+/**
+ * @brief
+ * 		set_deflt_entry - set one default resource unless the job already
+ *		has that resource set
+ *
+ *	@param[in,out]	jb	-	is the job resource list attribute
+ *	@param[in]	prescdt	-	the (set) default resource
+ */
+
+static void
+set_deflt_entry(attribute *jb, resource *prescdt)
+{
+	resource       *prescjb;
+
+	/* see if the job already has that resource */
+	prescjb = find_resc_entry(jb, prescdt->rs_defin);
+	if ((prescjb == NULL) ||
+		((prescjb->rs_value.at_flags &
+		ATR_VFLAG_SET) == 0)) {
+
+		if (prescjb == NULL)
+			prescjb = add_resource_entry(jb,
+				prescdt->rs_defin);
+		if (prescjb) {
+			if (prescdt->rs_defin->rs_set(&prescjb->rs_value, &prescdt->rs_value, SET) == 0)
+				prescjb->rs_value.at_flags |= (ATR_VFLAG_SET|ATR_VFLAG_DEFLT);
+			jb->at_flags |= ATR_MOD_MCACHE;
+		}
+
+	}
+}
+
 /**
  * @brief
  * 		set_deflt_resc - set resource attributes based on a set of defaults provided
@@ -2071,7 +2461,6 @@ make_schedselect(attribute *patrl, resource *pselect,
 static void
 set_deflt_resc(attribute *jb, attribute *dflt, int selflg)
 {
-	resource       *prescjb;
 	resource       *prescdt;
 	resource_def   *seldef;
 	resource_def   *plcdef;
@@ -2093,24 +2482,8 @@ set_deflt_resc(attribute *jb, attribute *dflt, int selflg)
 					continue; /* dont use select/place */
 			}
 
-			if (is_attr_set(&prescdt->rs_value)) {
-				/* see if the job already has that resource */
-				prescjb = find_resc_entry(jb, prescdt->rs_defin);
-				if ((prescjb == NULL) ||
-					((prescjb->rs_value.at_flags &
-					ATR_VFLAG_SET) == 0)) {
-
-					if (prescjb == NULL)
-						prescjb = add_resource_entry(jb,
-							prescdt->rs_defin);
-					if (prescjb) {
-						if (prescdt->rs_defin->rs_set(&prescjb->rs_value, &prescdt->rs_value, SET) == 0)
-							prescjb->rs_value.at_flags |= (ATR_VFLAG_SET|ATR_VFLAG_DEFLT);
-						jb->at_flags |= ATR_MOD_MCACHE;
-					}
-
-				}
-			}
+			if (is_attr_set(&prescdt->rs_value))
+				set_deflt_entry(jb, prescdt);
 		}
 	}
 }
@@ -2140,7 +2513,9 @@ set_resc_deflt(void *pobj, int objtype, pbs_queue *pque)
 	resource   *presc;
 	resource_def *prdefsl;
 	resource_def *prdefpc;
+	struct que_rules *prules;
 	int           rc;
+	int           i;
 
 	switch (objtype) {
 		case	JOB_OBJECT:
@@ -2166,23 +2541,29 @@ set_resc_deflt(void *pobj, int objtype, pbs_queue *pque)
 	}
 
 
-	/* set defaults based on the Queue's resources_default */
-	if (pque) {
-		set_deflt_resc(pdest,
-			get_qattr(pque, QA_ATR_ResourceDefault), 1);
-	}
+	if ((prules = que_rules_get(pque)) != NULL) {
+		/* the precompiled defaults already follow the precedence below */
+		for (i = 0; i < prules->qr_ndflt; i++)
+			set_deflt_entry(pdest, prules->qr_dflt[i]);
+	} else {
+		/* set defaults based on the Queue's resources_default */
+		if (pque) {
+			set_deflt_resc(pdest,
+				get_qattr(pque, QA_ATR_ResourceDefault), 1);
+		}
 
-	/* set defaults based on the Server' resources_default */
-	set_deflt_resc(pdest, get_sattr(SVR_ATR_resource_deflt), 1);
+		/* set defaults based on the Server' resources_default */
+		set_deflt_resc(pdest, get_sattr(SVR_ATR_resource_deflt), 1);
 
-	/* set defaults based on the Queue's resources_max */
-	if (pque) {
-		set_deflt_resc(pdest,
-			get_qattr(pque, QA_ATR_ResourceMax), 0);
-	}
+		/* set defaults based on the Queue's resources_max */
+		if (pque) {
+			set_deflt_resc(pdest,
+				get_qattr(pque, QA_ATR_ResourceMax), 0);
+		}
 
-	/* set defaults based on the Server's resources_max */
-	set_deflt_resc(pdest, get_sattr(SVR_ATR_ResourceMax), 0);
+		/* set defaults based on the Server's resources_max */
+		set_deflt_resc(pdest, get_sattr(SVR_ATR_ResourceMax), 0);
+	}
 
 
 	/* if needed, set "select" and "place" from the other resources */
@@ -2300,6 +2681,18 @@ correct_ct(pbs_queue *pqj)
 			pque->qu_njstate[i] = 0;
 	}
 
+	if (users_jobstates_idx != NULL) {
+		void *pkey = NULL;
+		void *ctx = NULL;
+		struct user_jobstates *puj;
+
+		while (pbs_idx_find(users_jobstates_idx, &pkey, (void **)&puj, &ctx) == PBS_IDX_RET_OK)
+			free(puj);
+		pbs_idx_free_ctx(ctx);
+		pbs_idx_destroy(users_jobstates_idx);
+		users_jobstates_idx = pbs_idx_create(0, 0);
+	}
+
 	for (pjob = (job *)GET_NEXT(svr_alljobs); pjob;
 		pjob = (job *)GET_NEXT(pjob->ji_alljobs)) {
 		int state_num;
@@ -2308,6 +2701,7 @@ correct_ct(pbs_queue *pqj)
 		server.sv_qs.sv_numjobs++;
 		if (state_num != -1)
 			server.sv_jobstates[state_num]++;
+		svr_user_jobstate(pjob, -1, state_num);
 		if (pjob->ji_qhdr) {
 			(pjob->ji_qhdr)->qu_numjobs++;
 			if (state_num != -1)
@@ -4424,7 +4818,9 @@ update_eligible_time(long newaccruetype, job *pjob)
 	set_jattr_l_slim(pjob, JOB_ATR_accrue_type, newaccruetype, SET);
 	set_jattr_l_slim(pjob, JOB_ATR_sample_starttime, timestamp, SET);
 
-	/* Prepare and print log message */
+	/* Prepare and print log message, skipped entirely when not logged */
+	if (!will_log_event(PBSEVENT_DEBUG3))
+		return 0;
 	strtime = convert_long_to_time(get_jattr_long(pjob, JOB_ATR_eligible_time));
 	if (strtime == NULL)
 		strtime = errtime;
@@ -4439,6 +4835,36 @@ update_eligible_time(long newaccruetype, job *pjob)
 	return 0;
 }
 
+/**
+ * @brief
+ * 		get_eligible_time - eligible time accrued by a job up to now
+ *
+ *		JOB_ATR_eligible_time only holds the time accrued up to the last
+ *		change of accrue type, JOB_ATR_sample_starttime.  While the job is
+ *		eligible the time since then is added on read, so nothing needs
+ *		to be updated or saved while a job just sits in the queue.
+ *
+ * @param[in]	pjob	-	pointer to job
+ *
+ * @return	long
+ * @retval	eligible time in seconds
+ *
+ * @par MT-Safe: No
+ */
+long
+get_eligible_time(const job *pjob)
+{
+	long elig = get_jattr_long(pjob, JOB_ATR_eligible_time);
+	long since;
+
+	if (get_jattr_long(pjob, JOB_ATR_accrue_type) == JOB_ELIGIBLE) {
+		since = (long) time_now - get_jattr_long(pjob, JOB_ATR_sample_starttime);
+		if (since > 0)
+			elig += since;
+	}
+	return elig;
+}
+
 /**
  * @brief
  * 		alter_eligibletime 	this is action function for eligible_time.
@@ -4557,6 +4983,118 @@ svr_saveorpurge_finjobhist(job *pjob)
 	}
 	set_idle_delete_task(presv);
 }
+/**
+ * @brief
+ *		Check whether a job is a history job that svr_clean_job_history()
+ *		may purge once its history duration is over: a finished or expired
+ *		job, or one moved to another server that has finished there.
+ *
+ * @param[in]	pjob	-	job to check
+ *
+ * @return	int
+ * @retval	1	: purgeable history job
+ * @retval	0	: otherwise
+ */
+static int
+is_purgeable_histjob(job *pjob)
+{
+	return ((check_job_state(pjob, JOB_STATE_LTR_MOVED) && check_job_substate(pjob, JOB_SUBSTATE_FINISHED)) ||
+		(check_job_state(pjob, JOB_STATE_LTR_FINISHED)) ||
+		(check_job_state(pjob, JOB_STATE_LTR_EXPIRED)));
+}
+
+/**
+ * @brief
+ *		Release what only a live job needs once it has become history:
+ *		attributes that are never reported (they are hidden or only read
+ *		by the server and MoM) and the server's transient bookkeeping.
+ *		Everything qstat -x reports is kept, so history jobs are still
+ *		stat'ed the usual way.
+ *
+ * @param[in,out]	pjob	-	history job
+ */
+static void
+svr_histjob_compact(job *pjob)
+{
+	static int runtime_attrs[] = {
+		JOB_ATR_exec_host2,
+		JOB_ATR_resource_orig,
+		JOB_ATR_resource_acct,
+		JOB_ATR_Cookie,
+		JOB_ATR_refresh,
+		JOB_ATR_security,
+		JOB_ATR_sample_starttime,
+		JOB_ATR_prov_vnode,
+		JOB_ATR_sched_preempted
+	};
+	badplace *bp;
+	int i;
+
+	for (i = 0; i < sizeof(runtime_attrs) / sizeof(runtime_attrs[0]); i++) {
+		if (is_jattr_set(pjob, runtime_attrs[i])) {
+			free_jattr(pjob, runtime_attrs[i]);
+			mark_jattr_not_set(pjob, runtime_attrs[i]);
+		}
+	}
+
+	/* free any bad destination structs */
+	while ((bp = (badplace *)GET_NEXT(pjob->ji_rejectdest)) != NULL) {
+		delete_link(&bp->bp_link);
+		free(bp);
+	}
+	free(pjob->ji_acctrec);
+	pjob->ji_acctrec = NULL;
+	free(pjob->ji_clterrmsg);
+	pjob->ji_clterrmsg = NULL;
+	free(pjob->ji_script);
+	pjob->ji_script = NULL;
+}
+
+/**
+ * @brief
+ *		Place a purgeable history job on svr_histjobs, which is kept in
+ *		order of history timestamp so the oldest history is always at the
+ *		head.  Jobs which do not have a timestamp yet (recovered from an
+ *		older server) go first so that svr_clean_job_history() sets one.
+ *		A job already on the list is moved to its new position; the
+ *		search starts at the tail where new history normally goes.
+ *		The job is compacted with svr_histjob_compact() on the way.
+ *
+ * @param[in,out]	pjob	-	job to link
+ */
+static void
+svr_histjob_link(job *pjob)
+{
+	job	*pjcur;
+	long	 stamp = 0;
+
+	delete_link(&pjob->ji_histjobs);
+	if (!is_purgeable_histjob(pjob))
+		return;
+
+	svr_histjob_compact(pjob);
+
+	if (is_jattr_set(pjob, JOB_ATR_history_timestamp))
+		stamp = get_jattr_long(pjob, JOB_ATR_history_timestamp);
+	else {
+		/* no timestamp yet, goes first */
+		insert_link(&svr_histjobs, &pjob->ji_histjobs, pjob, LINK_INSET_AFTER);
+		return;
+	}
+
+	pjcur = (job *)GET_PRIOR(svr_histjobs);
+	while (pjcur) {
+		if (!is_jattr_set(pjcur, JOB_ATR_history_timestamp) ||
+			(stamp >= get_jattr_long(pjcur, JOB_ATR_history_timestamp)))
+			break;
+		pjcur = (job *)GET_PRIOR(pjcur->ji_histjobs);
+	}
+	if (pjcur == NULL)
+		insert_link(&svr_histjobs, &pjob->ji_histjobs, pjob, LINK_INSET_AFTER);
+	else
+		insert_link(&pjcur->ji_histjobs, &pjob->ji_histjobs, pjob, LINK_INSET_AFTER);
+}
+
 /**
  * @brief
  *		Function name: svr_clean_job_history
@@ -4564,7 +5102,13 @@ svr_saveorpurge_finjobhist(job *pjob)
  *		 purge the history jobs whose history duration exceeds the
  *		 configured job_history_duration server attribute.
  * @par Functionality: It is a work_task and reschedule itself after 2 mins if
- *		 and only if job_history_enable is set.
+ *		 and only if job_history_enable is set.  Only svr_histjobs is
+ *		 walked, oldest first, and the walk stops at the first job whose
+ *		 history has not expired, so the cost is in the number of jobs
+ *		 purged rather than the number of jobs in the server.  After
+ *		 SVR_CLEAN_JOBHIST_SLICE jobs the rest is left to an interleaved
+ *		 task, so a large backlog of expired history does not hold up
+ *		 the server.
  *		Output: None
  *
  * @param[in]	pwt	-	work_task structure
@@ -4573,126 +5117,63 @@ void
 svr_clean_job_history(struct work_task *pwt)
 {
 	job 	*pjob;
-	job 	*nxpjob = NULL;
 	int 	walltime_used = 0;
+	int	purged = 0;
 
-	/*
-	 * Keep track of time spent purging jobs, interrupts purge if necessary.
-	 * Timed task in nearby future set if purge took too long.
-	 * Timed task in far future only set if this task completes.
-	 * Autotunes time between job history purges:
-	 * - raised if last purge was short
-	 * - lowered if this purge needs to be interrupted
-	 */
-
-	time_t	begin_time;
-	time_t	end_time;
-	static time_t time_between_tasks = SVR_CLEAN_JOBHIST_TM;
-
-	begin_time = time(NULL);
-	/* Initialize end_time, in case we do not get into the while loop */
-	end_time = begin_time;
-
-	/*
-	 * Traverse through the SERVER job list and find the history
-	 * jobs (job with state JOB_STATE_LTR_MOVED and JOB_STATE_LTR_FINISHED)
-	 * which exceed the configured job_history_duration value and
-	 * purge them immediately.
-	 */
-	pjob = (job *)GET_NEXT(svr_alljobs);
+	pjob = (job *)GET_NEXT(svr_histjobs);
 
 	while (pjob != NULL) {
-		/* save the next job */
-		nxpjob = (job *)GET_NEXT(pjob->ji_alljobs);
-
-		if ((check_job_state(pjob, JOB_STATE_LTR_MOVED) && check_job_substate(pjob, JOB_SUBSTATE_FINISHED)) ||
-			(check_job_state(pjob, JOB_STATE_LTR_FINISHED)) ||
-			(check_job_state(pjob, JOB_STATE_LTR_EXPIRED))) {
-
-			if (!(is_jattr_set(pjob,  JOB_ATR_history_timestamp))) {
-				if (check_job_state(pjob, JOB_STATE_LTR_MOVED))
-					set_jattr_l_slim(pjob, JOB_ATR_history_timestamp, time_now, SET);
-			else {
-					if (((walltime_used = get_used_wall(pjob)) == -1) ||
-						!(is_jattr_set(pjob,  JOB_ATR_stime))) {
-						log_err(-1, "svr_clean_job_history",
-							"Finished job missing start-time/walltime used, cannot clean history");
-						pjob = nxpjob;
-						continue;
-					}
-					set_jattr_l_slim(pjob, JOB_ATR_history_timestamp,
-							get_jattr_long(pjob, JOB_ATR_stime) + walltime_used, SET);
-				}
-				job_save_db(pjob);
-			}
 
-			if (time_now >= (get_jattr_long(pjob,  JOB_ATR_history_timestamp) + svr_history_duration)) {
-				job_purge(pjob);
-				pjob = NULL;
-			}
+		if (!(is_jattr_set(pjob,  JOB_ATR_history_timestamp))) {
+			if (check_job_state(pjob, JOB_STATE_LTR_MOVED))
+				set_jattr_l_slim(pjob, JOB_ATR_history_timestamp, time_now, SET);
+			else if (((walltime_used = get_used_wall(pjob)) == -1) ||
+				!(is_jattr_set(pjob,  JOB_ATR_stime))) {
+				log_err(-1, __func__,
+					"Finished job missing start-time/walltime used, keeping history from now");
+				set_jattr_l_slim(pjob, JOB_ATR_history_timestamp, time_now, SET);
+			} else
+				set_jattr_l_slim(pjob, JOB_ATR_history_timestamp,
+						get_jattr_long(pjob, JOB_ATR_stime) + walltime_used, SET);
+			job_save_db(pjob);
+
+			/* now that it has a timestamp, move it to its place */
+			svr_histjob_link(pjob);
+			pjob = (job *)GET_NEXT(svr_histjobs);
+			continue;
 		}
-		/* restore the saved next in pjob */
-		pjob = nxpjob;
-
-		/* check if we spent too long hogging the pbs_server process here */
-		end_time = time(NULL);
-		if ((end_time - begin_time) > SVR_CLEAN_JOBHIST_SECS) {
-			/* Apparently the interval between history purges is too long.
-			 * reduce it using factor 0.7
-			 */
-			time_between_tasks = (floor((double)time_between_tasks * 0.7));
 
-			/* no use reducing to less than 4 * SVR_CLEAN_JOBHIST_SECS
-			 * since we'll already schedule a continuation task here
-			 */
-			if (time_between_tasks < (4 * SVR_CLEAN_JOBHIST_SECS))
-				time_between_tasks = 4 * SVR_CLEAN_JOBHIST_SECS;
+		/* everything behind this job has more recent history */
+		if (time_now < (get_jattr_long(pjob,  JOB_ATR_history_timestamp) + svr_history_duration))
+			break;
 
-			/* set up another work task in near future,
-			 * but leave as much time as we spent in this routine for other work first
-			 */
-			if (!set_task(WORK_Timed,
-				(end_time + SVR_CLEAN_JOBHIST_SECS),
-				svr_clean_job_history, NULL)) {
-				log_err(errno,
-					"svr_clean_job_history",
-					"Unable to set task for clean job history");
-					/* on error to set task
-					 * just continue purging the history
-					 */
-			} else
-				/* but if we managed to set a task in near future, return;
-				 * that task will continue where we left off
-				 */
-				return;
+		/*
+		 * Purging an array job purges its subjobs too, which may be
+		 * anywhere on the list, so always restart from the head.
+		 */
+		job_purge(pjob);
+		pjob = (job *)GET_NEXT(svr_histjobs);
+
+		if ((++purged >= SVR_CLEAN_JOBHIST_SLICE) && (pjob != NULL)) {
+			if (set_task(WORK_Interleave, 0, svr_clean_job_history, NULL))
+				return;	/* that task will continue where we left off */
+			log_err(errno, __func__, "Unable to set task for clean job history");
+			purged = 0;
 		}
-	} /* end of while loop through jobs */
+	}
 
 	/* We purged everything necessary in this task if we get here.
 	 * set up another work task for next time period.
 	 */
 	if (pwt && svr_history_enable) {
 		if (!set_task(WORK_Timed,
-			(time_now + time_between_tasks),
+			(time_now + SVR_CLEAN_JOBHIST_TM),
 			svr_clean_job_history, NULL)) {
 			log_err(errno,
 				"svr_clean_job_history",
 				"Unable to set task for clean job history");
 		}
 	}
-
-	/* try to move the time between tasks up again
-	 * but only if we spent less than 2/3rds of what we were allowed to spend
-	 * Note the last purge of a chain of purges will often tend to undo part of the lowering
-	 * in the earlier incomplete purges -- that's OK: 0.7*1.1 is still smaller than 1
-	 */
-
-	if ((time_between_tasks < SVR_CLEAN_JOBHIST_TM) &&
-	    ((end_time - begin_time) < floor((double)SVR_CLEAN_JOBHIST_SECS * 2/3))) {
-		time_between_tasks = ceil((double) time_between_tasks * 1.1);
-		if (time_between_tasks > SVR_CLEAN_JOBHIST_TM)
-			time_between_tasks = SVR_CLEAN_JOBHIST_TM;
-	}
 }
 
 /**
@@ -4725,6 +5206,7 @@ svr_histjob_update(job * pjob, char newstate, int newsubstate)
 			server.sv_jobstates[oldstatenum]--;
 		if (newstatenum != -1)
 			server.sv_jobstates[newstatenum]++;
+		svr_user_jobstate(pjob, oldstatenum, newstatenum);
 		if (pque != NULL) {
 			if (oldstatenum != -1)
 				pque->qu_njstate[oldstatenum]--;
@@ -4765,6 +5247,7 @@ svr_histjob_update(job * pjob, char newstate, int newsubstate)
 		}
 	}
 
+	svr_histjob_link(pjob);
 	job_save_db(pjob);
 }
 
@@ -44,15 +44,21 @@
  * 		svr_mail.c - send mail to mail list or owner of job on
  *		job begin, job end, and/or job abort
  *
+ *		Mail is not sent from the event that triggers it.  Each notice is
+ *		queued in the Server under its recipient list and a work task
+ *		hands the queue to a single long lived helper process over a pipe.
+ *		The helper runs the mailer once per recipient batch.  A notice on
+ *		a quiet Server goes out as soon as the current event is handled;
+ *		only notices following it within MAIL_FLUSH_INTERVAL are held and
+ *		batched, so a burst (e.g. the subjobs of a large array ending)
+ *		costs one fork of the Server in total and one message per
+ *		recipient per flush.
+ *
  * 	Included public functions are:
- *		create_socket_and_connect()
- *		read_smtp_reply()
- *		write3_smtp_data()
- *		send_mail()
- *		send_mail_detach()
  *		svr_mailowner_id()
  *		svr_mailowner()
  *		svr_mailownerResv()
+ *		svr_mail_shutdown()
  *
  */
 
@@ -60,10 +66,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include "pbs_ifl.h"
 #include "list_link.h"
 #include "attribute.h"
@@ -73,16 +84,25 @@
 #include "job.h"
 #include "reservation.h"
 #include "server.h"
+#include "work_task.h"
+#include "pbs_idx.h"
+#include "libutil.h"
 #include "tpp.h"
+#include "pbs_db.h"
 
 
 /* External Functions Called */
 
 extern void net_close(int);
 
+/* External Data */
+
+extern void *svr_db_conn;
+
 /* Globol Data */
 
 extern struct server server;
+extern time_t time_now;
 extern char *msg_job_abort;
 extern char *msg_job_start;
 extern char *msg_job_end;
@@ -91,8 +111,54 @@ extern char *msg_resv_start;
 extern char *msg_resv_end;
 extern char *msg_resv_confirm;
 extern char *msg_job_stageinfail;
+extern char *msg_err_malloc;
 
 #define MAIL_ADDR_BUF_LEN 1024
+#define MAIL_FLUSH_INTERVAL 5	/* seconds between flushes while mail keeps coming */
+#define MAIL_FLUSH_BATCHES 50	/* recipient batches handed over per flush */
+#define MAIL_DIGEST_MAX 100	/* notices put into one message */
+
+/*
+ * A frame to the mail helper is MAIL_FRAME_FIELDS fields: the mailer, the
+ * sender, the recipients and the message.  Each field is its length, as a
+ * mail_flen_t in host byte order, followed by that many bytes, so no byte
+ * of a field can be taken for the start of the next one.
+ */
+typedef uint32_t mail_flen_t;
+#define MAIL_FRAME_FIELDS 4
+
+/* one queued notice */
+typedef struct mail_note {
+	struct mail_note *mn_next;
+	char	*mn_subject;	/* subject when sent on its own */
+	char	*mn_head;	/* "PBS Job Id:" and name lines */
+	char	*mn_text;	/* standard message and caller's text */
+} mail_note;
+
+/* all notices queued for one recipient list */
+typedef struct mail_batch {
+	pbs_list_link	 mb_link;
+	char		*mb_mailto;
+	mail_note	*mb_first;
+	mail_note	*mb_last;
+	int		 mb_count;
+} mail_batch;
+
+static pbs_list_head mail_queue;	/* batches in arrival order */
+static void *mail_idx = NULL;		/* batches by recipient list */
+static int mail_queued = 0;		/* notices in all batches */
+static struct work_task *mail_flush_wt = NULL;
+static time_t mail_last_flush = 0;	/* when the queue was last flushed */
+
+static int mail_helper_fd = -1;		/* write end of the helper's pipe */
+static pid_t mail_helper_pid = -1;
+static char *mail_obuf = NULL;		/* frames not yet taken by the helper */
+static size_t mail_osize = 0;
+static size_t mail_olen = 0;
+static size_t mail_ooff = 0;		/* bytes the helper has taken */
+static size_t mail_ofrm = 0;		/* start of the first frame not fully taken */
+
+static void mail_flush_task(struct work_task *);
 
 /**
  * @brief
@@ -103,17 +169,19 @@ extern char *msg_job_stageinfail;
  * @param[in]	mailer - path to sendmail/mailer
  * @param[in]	mailfrom - the sender of the email
  * @param[in]	mailto - the recipient of the email
+ * @param[out]	pid - process id of the mailer
  *
  * @return	FILE *
  * @retval	file descriptor : if fdopen succeed
  * @retval	NULL : failed
  */
 static FILE *
-svr_exec_mailer(char *mailer, char *mailfrom, char *mailto)
+svr_exec_mailer(char *mailer, char *mailfrom, char *mailto, pid_t *pid)
 {
 	char *margs[5];
 	int mfds[2];
 	pid_t mcpid;
+	FILE *outmail;
 
 	/* setup sendmail/mailer command line with -f from_whom */
 
@@ -124,7 +192,7 @@ svr_exec_mailer(char *mailer, char *mailfrom, char *mailto)
 	margs[4] = NULL;
 
 	if (pipe(mfds) == -1)
-		exit(1);
+		return NULL;
 
 	mcpid = fork();
 	if (mcpid == 0) {
@@ -143,13 +211,714 @@ svr_exec_mailer(char *mailer, char *mailfrom, char *mailto)
 	if (mcpid == -1) {/* Error on fork */
 		log_err(errno, __func__, "fork failed\n");
 		(void)close(mfds[0]);
+		(void)close(mfds[1]);
+		return NULL;
+	}
+
+	/* parent (the mail helper) will write body of message on pipe */
+	(void)close(mfds[0]);
+
+	if ((outmail = fdopen(mfds[1], "w")) == NULL)
+		(void)close(mfds[1]);
+	*pid = mcpid;
+	return outmail;
+}
+
+/**
+ * @brief
+ *		Read one field of a frame from the Server, see MAIL_FRAME_FIELDS.
+ *
+ * @param[in]	in - the pipe from the Server
+ * @param[out]	plen - length of the field
+ *
+ * @return	char *
+ * @retval	malloc-ed field, with a NUL added after its bytes
+ * @retval	NULL : end of input or out of memory
+ */
+static char *
+mail_helper_field(FILE *in, size_t *plen)
+{
+	mail_flen_t flen;
+	char	*buf;
+
+	if (fread(&flen, sizeof(flen), 1, in) != 1)
+		return NULL;
+	if ((buf = malloc((size_t)flen + 1)) == NULL)
+		return NULL;
+	if (fread(buf, 1, flen, in) != flen) {
+		free(buf);
+		return NULL;
+	}
+	buf[flen] = '\0';
+	*plen = flen;
+	return buf;
+}
+
+/**
+ * @brief
+ *		Check that a field of a frame is a string fit for the mailer's
+ *		command line: no NUL or control character inside it, and not
+ *		taken for an option.
+ *
+ * @param[in]	fld - the field
+ * @param[in]	len - its length
+ * @param[in]	max - largest length allowed
+ *
+ * @return	int
+ * @retval	1 : fit
+ * @retval	0 : not fit
+ */
+static int
+mail_helper_arg_ok(char *fld, size_t len, size_t max)
+{
+	size_t	i;
+
+	if ((len == 0) || (len > max) || (*fld == '-'))
+		return 0;
+	for (i = 0; i < len; i++) {
+		if ((fld[i] == '\0') || iscntrl((unsigned char)fld[i]))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief
+ *		Main loop of the mail helper.  The Server writes one frame per
+ *		message, see MAIL_FRAME_FIELDS.  The helper runs the mailer for
+ *		each frame and exits when the Server closes the pipe.  A frame
+ *		whose mailer, sender or recipients are not fit for the mailer's
+ *		command line is dropped.
+ *
+ * @param[in]	rfd - read end of the pipe from the Server
+ *
+ * @return	does not return
+ */
+static void
+mail_helper_main(int rfd)
+{
+	FILE	*in;
+	FILE	*outmail;
+	char	*fld[MAIL_FRAME_FIELDS];
+	size_t	 len[MAIL_FRAME_FIELDS];
+	pid_t	 pid;
+	int	 i;
+
+	(void)signal(SIGPIPE, SIG_IGN);
+	(void)signal(SIGCHLD, SIG_DFL);
+	(void)signal(SIGHUP, SIG_IGN);
+
+	(void)fcntl(rfd, F_SETFD, FD_CLOEXEC);
+	if ((in = fdopen(rfd, "r")) == NULL)
 		exit(1);
+
+	for (;;) {
+		for (i = 0; i < MAIL_FRAME_FIELDS; i++) {
+			if ((fld[i] = mail_helper_field(in, &len[i])) == NULL)
+				exit(0);
+		}
+
+		/* the mailer is a path, the others may hold spaces */
+		if ((*fld[0] == '/') &&
+			mail_helper_arg_ok(fld[0], len[0], MAXPATHLEN) &&
+			mail_helper_arg_ok(fld[1], len[1], MAIL_ADDR_BUF_LEN) &&
+			mail_helper_arg_ok(fld[2], len[2], MAIL_ADDR_BUF_LEN) &&
+			((outmail = svr_exec_mailer(fld[0], fld[1], fld[2], &pid)) != NULL)) {
+			(void)fwrite(fld[3], 1, len[3], outmail);
+			fclose(outmail);
+			while ((waitpid(pid, NULL, 0) == -1) && (errno == EINTR))
+				;
+		}
+		for (i = 0; i < MAIL_FRAME_FIELDS; i++)
+			free(fld[i]);
+	}
+}
+
+/**
+ * @brief
+ *		Forget the mail helper.  Frames it had not fully read are kept,
+ *		starting with the one it was part way through, and are handed to
+ *		its successor.
+ */
+static void
+mail_helper_reset(void)
+{
+	if (mail_helper_fd != -1)
+		(void)close(mail_helper_fd);
+	mail_helper_fd = -1;
+	mail_helper_pid = -1;
+	if (mail_ofrm < mail_olen) {
+		log_err(-1, __func__, "mail helper gone, unsent mail kept for its successor");
+		memmove(mail_obuf, mail_obuf + mail_ofrm, mail_olen - mail_ofrm);
+		mail_olen -= mail_ofrm;
+	} else
+		mail_olen = 0;
+	mail_ooff = 0;
+	mail_ofrm = 0;
+	if ((mail_olen > 0) && (mail_flush_wt == NULL))
+		mail_flush_wt = set_task(WORK_Timed, time_now + MAIL_FLUSH_INTERVAL,
+			mail_flush_task, NULL);
+}
+
+/**
+ * @brief
+ *		Work task run when the mail helper process exits.
+ *
+ * @param[in]	ptask - the WORK_Deferred_Child task for the helper
+ */
+static void
+mail_helper_exit(struct work_task *ptask)
+{
+	if ((pid_t)ptask->wt_event == mail_helper_pid)
+		mail_helper_reset();
+}
+
+/**
+ * @brief
+ *		Start the mail helper.  This is the only point at which the
+ *		Server forks for mail.
+ *
+ * @return	int
+ * @retval	0 : helper running
+ * @retval	-1 : failed
+ */
+static int
+mail_helper_start(void)
+{
+	int	mfds[2];
+	pid_t	pid;
+	int	flags;
+
+	if (pipe(mfds) == -1) {
+		log_err(errno, __func__, "pipe failed");
+		return -1;
+	}
+
+	pid = fork();
+	if (pid == -1) { /* Error on fork */
+		log_err(errno, __func__, "fork failed\n");
+		(void)close(mfds[0]);
+		(void)close(mfds[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		/*
+		 * From here on, we are a child process of the server.
+		 * Fix up file descriptors and signal handlers.
+		 */
+		(void)close(mfds[1]);
+		net_close(-1);
+		tpp_terminate();
+		pbs_db_close_fds(svr_db_conn);
+
+		/* Unprotect child from being killed by kernel */
+		daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
+
+		mail_helper_main(mfds[0]);
 	}
 
-	/* parent (not the real server though) will write body of message on pipe */
 	(void)close(mfds[0]);
+	(void)fcntl(mfds[1], F_SETFD, FD_CLOEXEC);
+	if ((flags = fcntl(mfds[1], F_GETFL)) != -1)
+		(void)fcntl(mfds[1], F_SETFL, flags | O_NONBLOCK);
+
+	mail_helper_fd = mfds[1];
+	mail_helper_pid = pid;
+	(void)set_task(WORK_Deferred_Child, (long)pid, mail_helper_exit, NULL);
+	return 0;
+}
 
-	return(fdopen(mfds[1], "w"));
+/**
+ * @brief
+ *		Length of the frame at the start of buf, see MAIL_FRAME_FIELDS.
+ *
+ * @param[in]	buf - start of a frame
+ *
+ * @return	size_t - length of the frame, length headers included
+ */
+static size_t
+mail_frame_len(char *buf)
+{
+	mail_flen_t flen;
+	size_t	 off = 0;
+	int	 i;
+
+	for (i = 0; i < MAIL_FRAME_FIELDS; i++) {
+		memcpy(&flen, buf + off, sizeof(flen));
+		off += sizeof(flen) + flen;
+	}
+	return off;
+}
+
+/**
+ * @brief
+ *		Write as much of the pending frames to the helper as it will take.
+ *
+ * @return	int
+ * @retval	0 : everything written
+ * @retval	1 : the pipe is full, try again later
+ * @retval	-1 : the helper is gone
+ */
+static int
+mail_obuf_drain(void)
+{
+	ssize_t n;
+
+	while (mail_ooff < mail_olen) {
+		if (mail_helper_fd == -1)
+			return -1;
+		n = write(mail_helper_fd, mail_obuf + mail_ooff, mail_olen - mail_ooff);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+				return 1;
+			log_err(errno, __func__, "write to mail helper failed");
+			mail_helper_reset();
+			return -1;
+		}
+		mail_ooff += n;
+		while ((mail_ofrm < mail_ooff) &&
+			(mail_ofrm + mail_frame_len(mail_obuf + mail_ofrm) <= mail_ooff))
+			mail_ofrm += mail_frame_len(mail_obuf + mail_ofrm);
+	}
+	mail_olen = 0;
+	mail_ooff = 0;
+	mail_ofrm = 0;
+	return 0;
+}
+
+/**
+ * @brief
+ *		Append one field, with its length header, to the frames waiting
+ *		for the helper.
+ *
+ * @param[in]	str - the field
+ *
+ * @return	int
+ * @retval	0 : success
+ * @retval	-1 : out of memory, or the field is too long
+ */
+static int
+mail_obuf_field(char *str)
+{
+	size_t	 len = strlen(str);
+	mail_flen_t flen = (mail_flen_t)len;
+	size_t	 need = mail_olen + sizeof(flen) + len;
+	char	*p;
+
+	if ((size_t)flen != len)
+		return -1;
+	if (need > mail_osize) {
+		if ((p = realloc(mail_obuf, need * 2)) == NULL)
+			return -1;
+		mail_obuf = p;
+		mail_osize = need * 2;
+	}
+	memcpy(mail_obuf + mail_olen, &flen, sizeof(flen));
+	memcpy(mail_obuf + mail_olen + sizeof(flen), str, len);
+	mail_olen = need;
+	return 0;
+}
+
+/**
+ * @brief
+ *		Free a queued notice.
+ *
+ * @param[in]	pnote - the notice
+ */
+static void
+mail_note_free(mail_note *pnote)
+{
+	free(pnote->mn_subject);
+	free(pnote->mn_head);
+	free(pnote->mn_text);
+	free(pnote);
+}
+
+/**
+ * @brief
+ *		Build the body text of a notice from the standard message for
+ *		the mail point and the caller's text.
+ *
+ * @param[in]	stdmessage - standard message, may be NULL
+ * @param[in]	text - caller's text, may be NULL
+ *
+ * @return	char *
+ * @retval	malloc-ed text
+ * @retval	NULL : out of memory
+ */
+static char *
+mail_note_text(char *stdmessage, char *text)
+{
+	char	*buf = NULL;
+
+	if (pbs_asprintf(&buf, "%s%s%s%s",
+		stdmessage ? stdmessage : "", stdmessage ? "\n" : "",
+		text ? text : "", text ? "\n" : "") == -1)
+		return NULL;
+	return buf;
+}
+
+/**
+ * @brief
+ *		Queue a notice for a recipient list and make sure a flush is
+ *		scheduled: right away if nothing was flushed in the last
+ *		MAIL_FLUSH_INTERVAL, else at the end of that interval so that the
+ *		notices arriving meanwhile go out together.  The notice is freed
+ *		here if it cannot be queued.
+ *
+ * @param[in]	mailto - recipient list
+ * @param[in]	pnote - the notice
+ */
+static void
+mail_enqueue(char *mailto, mail_note *pnote)
+{
+	mail_batch	*pb = NULL;
+	void		*key = mailto;
+
+	if (mail_idx == NULL) {
+		CLEAR_HEAD(mail_queue);
+		if ((mail_idx = pbs_idx_create(0, 0)) == NULL) {
+			log_err(-1, __func__, "Failed to create mail index");
+			mail_note_free(pnote);
+			return;
+		}
+	}
+
+	if (pbs_idx_find(mail_idx, &key, (void **)&pb, NULL) != PBS_IDX_RET_OK) {
+		if (((pb = calloc(1, sizeof(mail_batch))) == NULL) ||
+			((pb->mb_mailto = strdup(mailto)) == NULL)) {
+			log_err(errno, __func__, msg_err_malloc);
+			free(pb);
+			mail_note_free(pnote);
+			return;
+		}
+		if (pbs_idx_insert(mail_idx, pb->mb_mailto, pb) != PBS_IDX_RET_OK) {
+			log_err(-1, __func__, "Failed to add mail batch to index");
+			free(pb->mb_mailto);
+			free(pb);
+			mail_note_free(pnote);
+			return;
+		}
+		CLEAR_LINK(pb->mb_link);
+		append_link(&mail_queue, &pb->mb_link, pb);
+	}
+
+	if (pb->mb_last)
+		pb->mb_last->mn_next = pnote;
+	else
+		pb->mb_first = pnote;
+	pb->mb_last = pnote;
+	pb->mb_count++;
+	mail_queued++;
+
+	if (mail_flush_wt == NULL) {
+		if (time_now >= mail_last_flush + MAIL_FLUSH_INTERVAL)
+			mail_flush_wt = set_task(WORK_Immed, 0, mail_flush_task, NULL);
+		else
+			mail_flush_wt = set_task(WORK_Timed, mail_last_flush + MAIL_FLUSH_INTERVAL,
+				mail_flush_task, NULL);
+	}
+}
+
+/**
+ * @brief
+ *		Turn up to MAIL_DIGEST_MAX notices of a batch into one message
+ *		and append its frame to the helper's buffer.  A single notice is
+ *		sent exactly as it always was; several become a digest that holds
+ *		each notice in full, its "PBS Job Id:" header included.
+ *
+ * @param[in]	pb - the batch, notices taken are removed from it
+ *
+ * @return	int
+ * @retval	0 : success
+ * @retval	-1 : out of memory
+ */
+static int
+mail_frame_batch(mail_batch *pb)
+{
+	mail_note	*taken;
+	mail_note	*pnote;
+	char		*msg = NULL;
+	int		 msize = 0;
+	char		*line = NULL;
+	char		*mailer;
+	char		*mailfrom;
+	size_t		 olen;
+	int		 count;
+	int		 rc = -1;
+
+	/* detach the notices going into this message */
+	taken = pb->mb_first;
+	pnote = taken;
+	for (count = 1; (count < MAIL_DIGEST_MAX) && pnote->mn_next; count++)
+		pnote = pnote->mn_next;
+	pb->mb_first = pnote->mn_next;
+	if (pb->mb_first == NULL)
+		pb->mb_last = NULL;
+	pnote->mn_next = NULL;
+	pb->mb_count -= count;
+	mail_queued -= count;
+
+	if (pbs_strcat(&msg, &msize, "To: ") == NULL ||
+		pbs_strcat(&msg, &msize, pb->mb_mailto) == NULL ||
+		pbs_strcat(&msg, &msize, "\n") == NULL)
+		goto done;
+
+	if (count == 1) {
+		if (pbs_asprintf(&line, "Subject: %s\n\n", taken->mn_subject) == -1)
+			goto done;
+	} else {
+		if (pbs_asprintf(&line, "Subject: PBS Server on %s: %d notices\n\n",
+			server_host, count) == -1)
+			goto done;
+	}
+	if (pbs_strcat(&msg, &msize, line) == NULL)
+		goto done;
+	free(line);
+	line = NULL;
+
+	for (pnote = taken; pnote; pnote = pnote->mn_next) {
+		if ((pnote != taken && pbs_strcat(&msg, &msize, "\n") == NULL) ||
+			(pnote->mn_head && pbs_strcat(&msg, &msize, pnote->mn_head) == NULL) ||
+			pbs_strcat(&msg, &msize, pnote->mn_text) == NULL)
+			goto done;
+	}
+
+	if (is_sattr_set(SVR_ATR_mailer))
+		mailer = get_sattr_str(SVR_ATR_mailer);
+	else
+		mailer = SENDMAIL_CMD;
+
+	/* Who is mail from, if SVR_ATR_mailfrom not set use default */
+
+	if (is_sattr_set(SVR_ATR_mailfrom))
+		mailfrom = get_sattr_str(SVR_ATR_mailfrom);
+	else
+		mailfrom = PBS_DEFAULT_MAIL;
+
+	/* a frame is only ever appended whole */
+	olen = mail_olen;
+	if (mail_obuf_field(mailer) == 0 && mail_obuf_field(mailfrom) == 0 &&
+		mail_obuf_field(pb->mb_mailto) == 0 && mail_obuf_field(msg) == 0)
+		rc = 0;
+	else
+		mail_olen = olen;
+
+done:
+	if (rc != 0)
+		log_err(errno, __func__, msg_err_malloc);
+	free(line);
+	free(msg);
+	while (taken) {
+		pnote = taken->mn_next;
+		mail_note_free(taken);
+		taken = pnote;
+	}
+	return rc;
+}
+
+/**
+ * @brief
+ *		Hand queued mail to the helper.  At most "limit" recipient batches
+ *		are taken, a batch with more than MAIL_DIGEST_MAX notices goes to
+ *		the back of the queue with the rest.  Nothing is taken while the
+ *		helper has not yet read what it was given last time.
+ *
+ * @param[in]	limit - maximum number of batches to take
+ *
+ * @return	int
+ * @retval	0 : success
+ * @retval	-1 : the helper could not be started or has gone
+ */
+static int
+mail_flush(int limit)
+{
+	mail_batch	*pb;
+	int		 rc;
+	int		 n;
+
+	if ((mail_helper_fd == -1) && (mail_ooff < mail_olen) &&
+		(mail_helper_start() != 0))
+		return -1;
+	if ((rc = mail_obuf_drain()) != 0)
+		return (rc == 1 ? 0 : -1);
+
+	for (n = 0; n < limit; n++) {
+		if ((pb = (mail_batch *)GET_NEXT(mail_queue)) == NULL)
+			break;
+		if ((mail_helper_fd == -1) && (mail_helper_start() != 0))
+			return -1;
+
+		delete_link(&pb->mb_link);
+		(void)mail_frame_batch(pb);
+		if (pb->mb_first) {
+			append_link(&mail_queue, &pb->mb_link, pb);
+		} else {
+			pbs_idx_delete(mail_idx, pb->mb_mailto);
+			free(pb->mb_mailto);
+			free(pb);
+		}
+
+		if ((rc = mail_obuf_drain()) != 0)
+			return (rc == 1 ? 0 : -1);
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		Work task which flushes the mail queue and reschedules itself
+ *		while mail remains.
+ *
+ * @param[in]	ptask - the work task
+ */
+static void
+mail_flush_task(struct work_task *ptask)
+{
+	mail_flush_wt = NULL;
+	mail_last_flush = time_now;
+
+	(void)mail_flush(MAIL_FLUSH_BATCHES);
+
+	if ((mail_flush_wt == NULL) && ((mail_queued > 0) || (mail_ooff < mail_olen)))
+		mail_flush_wt = set_task(WORK_Timed, time_now + MAIL_FLUSH_INTERVAL,
+			mail_flush_task, NULL);
+}
+
+/**
+ * @brief
+ *		Deliver everything still queued and let the mail helper finish,
+ *		called when the Server shuts down.  The rate limit does not apply.
+ */
+void
+svr_mail_shutdown(void)
+{
+	int flags;
+
+	if ((mail_queued > 0) && (mail_helper_fd == -1))
+		(void)mail_helper_start();
+
+	if (mail_helper_fd != -1) {
+		/* block on the helper from here on */
+		if ((flags = fcntl(mail_helper_fd, F_GETFL)) != -1)
+			(void)fcntl(mail_helper_fd, F_SETFL, flags & ~O_NONBLOCK);
+		while (mail_flush(MAIL_FLUSH_BATCHES) == 0) {
+			if (GET_NEXT(mail_queue) == NULL)
+				break;
+		}
+		(void)mail_obuf_drain();
+		(void)close(mail_helper_fd);
+		mail_helper_fd = -1;
+	}
+}
+
+/**
+ * @brief
+ *		Check a mail address from a mail user list.  Mail_Users is not
+ *		checked when it is set, so refuse here what the mailer would take
+ *		for an option or what holds a control character.
+ *
+ * @param[in]	addr - the address
+ *
+ * @return	int
+ * @retval	1 : usable
+ * @retval	0 : not usable
+ */
+static int
+mail_addr_ok(char *addr)
+{
+	if ((*addr == '\0') || (*addr == '-'))
+		return 0;
+	for (; *addr; addr++) {
+		if (iscntrl((unsigned char)*addr))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief
+ *		Build the recipient list of a job or reservation: the mail user
+ *		list if there is one, else the owner.
+ *
+ * @param[out]	mailto - buffer for the list
+ * @param[in]	len - size of mailto
+ * @param[in]	pas - mail user list, may be NULL
+ * @param[in]	owner - owner of the object
+ * @param[in]	objid - id of the object, for log messages
+ */
+static void
+mail_build_to(char *mailto, size_t len, struct array_strings *pas, char *owner, char *objid)
+{
+	int	 i;
+	int	 addmailhost;
+	size_t	 mailaddrlen = 0;
+	char	*pat;
+
+	*mailto = '\0';
+	if (pas != NULL) {
+
+		/* has mail user list, send to them rather than owner */
+
+		for (i = 0; i < pas->as_usedptr; i++) {
+			if (!mail_addr_ok(pas->as_string[i])) {
+				sprintf(log_buffer, "Ignoring bad mail address \"%.77s\"",
+					pas->as_string[i]);
+				for (pat = log_buffer; *pat; pat++) {
+					if (iscntrl((unsigned char)*pat))
+						*pat = '?';
+				}
+				log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, objid, log_buffer);
+				continue;
+			}
+			addmailhost = 0;
+			mailaddrlen += strlen(pas->as_string[i]) + 2;
+			if ((pbs_conf.pbs_mail_host_name)  &&
+			    (strchr(pas->as_string[i], (int)'@') == NULL)) {
+					/* no host specified in address and      */
+					/* pbs_mail_host_name is defined, use it */
+					mailaddrlen += strlen(pbs_conf.pbs_mail_host_name) + 1;
+					addmailhost = 1;
+			}
+			if (mailaddrlen < len) {
+				(void)strcat(mailto, pas->as_string[i]);
+				if (addmailhost) {
+					/* append pbs_mail_host_name */
+					(void)strcat(mailto, "@");
+					(void)strcat(mailto, pbs_conf.pbs_mail_host_name);
+				}
+				(void)strcat(mailto, " ");
+			} else {
+			  	sprintf(log_buffer,"Email list is too long: \"%.77s...\"", mailto);
+				log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, objid, log_buffer);
+				break;
+			}
+		}
+
+	} else {
+
+		/* no mail user list, just send to owner */
+
+		pbs_strncpy(mailto, owner, len);
+		/* if pbs_mail_host_name is set in pbs.conf, then replace the */
+		/* host name with the name specified in pbs_mail_host_name    */
+		if (pbs_conf.pbs_mail_host_name) {
+			if ((pat = strchr(mailto, (int)'@')) != NULL)
+				*pat = '\0';	/* remove existing @host */
+			if ((strlen(mailto) + strlen(pbs_conf.pbs_mail_host_name) + 1) < len) {
+				/* append the pbs_mail_host_name since it fits */
+				strcat(mailto, "@");
+				strcat(mailto, pbs_conf.pbs_mail_host_name);
+			} else {
+				if (pat)
+					*pat = '@';	/* did't fit, restore the "at" sign */
+			  	sprintf(log_buffer,"Email address is too long: \"%.77s...\"", mailto);
+				log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, objid, log_buffer);
+			}
+		}
+	}
 }
 
 /**
@@ -157,8 +926,8 @@ svr_exec_mailer(char *mailer, char *mailfrom, char *mailto)
  * 		Send mail to owner of a job when an event happens that
  *		requires mail, such as the job starts, ends or is aborted.
  *		The event is matched against those requested by the user.
- *		For Unix/Linux, a child is forked to not hold up the Server.  This child
- *		will fork/exec sendmail and pipe the To, Subject and body to it.
+ *		The notice is queued for the mail helper so as not to hold up
+ *		the Server; see the file header.
  *
  * @param[in]	jid	-	the Job ID (string)
  * @param[in]	pjob	-	pointer to the job structure
@@ -171,18 +940,10 @@ svr_exec_mailer(char *mailer, char *mailfrom, char *mailto)
 void
 svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 {
-	int	 addmailhost;
-	int	 i;
-	char    *mailer;
 	char	*mailfrom;
 	char	 mailto[MAIL_ADDR_BUF_LEN];
-	int	 mailaddrlen = 0;
-	struct array_strings *pas;
 	char	*stdmessage = NULL;
-	char	*pat;
-
-	FILE   *outmail;
-	pid_t   mcpid;
+	mail_note *pnote;
 
 
 	/* if force is true, force the mail out regardless of mailpoint */
@@ -214,34 +975,6 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 		}
 	}
 
-	/*
-	 * ok, now we will fork a process to do the mailing to not
-	 * hold up the server's other work.
-	 */
-
-	mcpid = fork();
-	if (mcpid == -1) { /* Error on fork */
-		log_err(errno, __func__, "fork failed\n");
-		return;
-	}
-	if (mcpid > 0)
-		return;		/* its all up to the child now */
-
-	/*
-	 * From here on, we are a child process of the server.
-	 * Fix up file descriptors and signal handlers.
-	 */
-	net_close(-1);
-	tpp_terminate();
-
-	/* Unprotect child from being killed by kernel */
-	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
-
-	if (is_sattr_set(SVR_ATR_mailer))
-		mailer = get_sattr_str(SVR_ATR_mailer);
-	else
-		mailer = SENDMAIL_CMD;
-
 	/* Who is mail from, if SVR_ATR_mailfrom not set use default */
 
 	if (is_sattr_set(SVR_ATR_mailfrom))
@@ -249,86 +982,7 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 	else
 		mailfrom = PBS_DEFAULT_MAIL;
 
-	/* Who does the mail go to?  If mail-list, them; else owner */
-
-	*mailto = '\0';
-	if (pjob != 0) {
-		if (jid == NULL)
-			jid = pjob->ji_qs.ji_jobid;
-
-		if (is_jattr_set(pjob, JOB_ATR_mailuser)) {
-
-			/* has mail user list, send to them rather than owner */
-
-			pas = get_jattr_arst(pjob, JOB_ATR_mailuser);
-			if (pas != NULL) {
-				for (i = 0; i < pas->as_usedptr; i++) {
-					addmailhost = 0;
-					mailaddrlen += strlen(pas->as_string[i]) + 2;
-					if ((pbs_conf.pbs_mail_host_name)  &&
-					    (strchr(pas->as_string[i], (int)'@') == NULL)) {
-							/* no host specified in address and      */
-							/* pbs_mail_host_name is defined, use it */
-							mailaddrlen += strlen(pbs_conf.pbs_mail_host_name) + 1;
-							addmailhost = 1;
-					}
-					if (mailaddrlen < sizeof(mailto)) {
-						(void)strcat(mailto, pas->as_string[i]);
-						if (addmailhost) {
-							/* append pbs_mail_host_name */
-							(void)strcat(mailto, "@");
-							(void)strcat(mailto, pbs_conf.pbs_mail_host_name);
-						}
-						(void)strcat(mailto, " ");
-					} else {
-					  	sprintf(log_buffer,"Email list is too long: \"%.77s...\"", mailto);
-						log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, pjob->ji_qs.ji_jobid, log_buffer);
-						break;
-					}
-				}
-			}
-
-		} else {
-
-			/* no mail user list, just send to owner */
-
-			pbs_strncpy(mailto, get_jattr_str(pjob, JOB_ATR_job_owner), sizeof(mailto));
-			/* if pbs_mail_host_name is set in pbs.conf, then replace the */
-			/* host name with the name specified in pbs_mail_host_name    */
-			if (pbs_conf.pbs_mail_host_name) {
-				if ((pat = strchr(mailto, (int)'@')) != NULL)
-					*pat = '\0';	/* remove existing @host */
-				if ((strlen(mailto) + strlen(pbs_conf.pbs_mail_host_name) + 1) < sizeof(mailto)) {
-					/* append the pbs_mail_host_name since it fits */
-					strcat(mailto, "@");
-					strcat(mailto, pbs_conf.pbs_mail_host_name);
-				} else {
-				  	if (pat)
-						*pat = '@';	/* did't fit, restore the "at" sign */
-				  	sprintf(log_buffer,"Email address is too long: \"%.77s...\"", mailto);
-					log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, pjob->ji_qs.ji_jobid, log_buffer);
-				}
-			}
-		}
-
-	} else {
-		/* send system related mail to "mailfrom" */
-		strcpy(mailto, mailfrom);
-	}
-
-	if ((outmail = svr_exec_mailer(mailer, mailfrom, mailto)) == NULL)
-		exit(1);
-
-	/* Pipe in mail headers: To: and Subject: */
-
-	fprintf(outmail, "To: %s\n", mailto);
-
-	if (pjob)
-		fprintf(outmail, "Subject: PBS JOB %s\n\n", jid);
-	else
-		fprintf(outmail, "Subject: PBS Server on %s\n\n", server_host);
-
-	/* Now pipe in "standard" message */
+	/* "standard" message */
 
 	switch (mailpoint) {
 
@@ -350,26 +1004,49 @@ svr_mailowner_id(char *jid, job *pjob, int mailpoint, int force, char *text)
 
 	}
 
-	if (pjob) {
-		fprintf(outmail, "PBS Job Id: %s\n", jid);
-		fprintf(outmail, "Job Name:   %s\n",
-			get_jattr_str(pjob, JOB_ATR_jobname));
+	if ((pnote = calloc(1, sizeof(mail_note))) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		return;
+	}
+	if ((pnote->mn_text = mail_note_text(stdmessage, text)) == NULL)
+		goto err;
+
+	/* Who does the mail go to?  If mail-list, them; else owner */
+
+	if (pjob != 0) {
+		if (jid == NULL)
+			jid = pjob->ji_qs.ji_jobid;
+
+		mail_build_to(mailto, sizeof(mailto),
+			is_jattr_set(pjob, JOB_ATR_mailuser) ? get_jattr_arst(pjob, JOB_ATR_mailuser) : NULL,
+			get_jattr_str(pjob, JOB_ATR_job_owner), pjob->ji_qs.ji_jobid);
+
+		if (pbs_asprintf(&pnote->mn_subject, "PBS JOB %s", jid) == -1 ||
+			pbs_asprintf(&pnote->mn_head, "PBS Job Id: %s\nJob Name:   %s\n",
+				jid, get_jattr_str(pjob, JOB_ATR_jobname)) == -1)
+			goto err;
+
+	} else {
+		/* send system related mail to "mailfrom" */
+		pbs_strncpy(mailto, mailfrom, sizeof(mailto));
+		if (pbs_asprintf(&pnote->mn_subject, "PBS Server on %s", server_host) == -1)
+			goto err;
 	}
-	if (stdmessage)
-		fprintf(outmail, "%s\n", stdmessage);
-	if (text != NULL)
-		fprintf(outmail, "%s\n", text);
-	fclose(outmail);
 
-	exit(0);
+	mail_enqueue(mailto, pnote);
+	return;
+
+err:
+	log_err(errno, __func__, msg_err_malloc);
+	mail_note_free(pnote);
 }
 /**
  * @brief
  * 		svr_mailowner - Send mail to owner of a job when an event happens that
  *		requires mail, such as the job starts, ends or is aborted.
  *		The event is matched against those requested by the user.
- *		For Unix/Linux, a child is forked to not hold up the Server.  This child
- *		will fork/exec sendmail and pipe the To, Subject and body to it.
+ *		The notice is queued for the mail helper so as not to hold up
+ *		the Server.
  *
  * @param[in]	pjob	-	ptr to job (null for server based mail)
  * @param[in]	mailpoint	-	note, single character
@@ -387,8 +1064,8 @@ svr_mailowner(job *pjob, int mailpoint, int force, char *text)
  * 		Send mail to owner of a reservation when an event happens that
  *		requires mail, such as the reservation starts, ends or is aborted.
  *		The event is matched against those requested by the user.
- *		For Unix/Linux, a child is forked to not hold up the Server.  This child
- *		will fork/exec sendmail and pipe the To, Subject and body to it.
+ *		The notice is queued for the mail helper so as not to hold up
+ *		the Server.
  *
  * @param[in]	presv	-	pointer to the reservation structure
  * @param[in]	mailpoint	-	which mail event is triggering the send
@@ -400,18 +1077,9 @@ svr_mailowner(job *pjob, int mailpoint, int force, char *text)
 void
 svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 {
-	int	 i;
-	int	 addmailhost;
-	char    *mailer;
-	char	*mailfrom;
 	char	 mailto[MAIL_ADDR_BUF_LEN];
-	int	 mailaddrlen = 0;
-	struct array_strings *pas;
-	char	*pat;
 	char	*stdmessage = NULL;
-
-	FILE	*outmail;
-	pid_t	 mcpid;
+	mail_note *pnote;
 
 	if (force != MAIL_FORCE) {
 		/*Not forcing out mail regardless of mailpoint */
@@ -435,109 +1103,13 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 			return;
 	}
 
-	/*
-	 * ok, now we will fork a process to do the mailing to not
-	 * hold up the server's other work.
-	 */
-
-	mcpid = fork();
-	if (mcpid == -1) { /* Error on fork */
-		log_err(errno, __func__, "fork failed\n");
-		return;
-	}
-	if (mcpid > 0)
-		return;		/* its all up to the child now */
-
-	/*
-	 * From here on, we are a child process of the server.
-	 * Fix up file descriptors and signal handlers.
-	 */
-
-	net_close(-1);
-	tpp_terminate();
-
-	/* Unprotect child from being killed by kernel */
-	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
-
-	if (is_sattr_set(SVR_ATR_mailer))
-		mailer = get_sattr_str(SVR_ATR_mailer);
-	else
-		mailer = SENDMAIL_CMD;
-
-	/* Who is mail from, if SVR_ATR_mailfrom not set use default */
-
-	if (is_sattr_set(SVR_ATR_mailfrom))
-		mailfrom = get_sattr_str(SVR_ATR_mailfrom);
-	else
-		mailfrom = PBS_DEFAULT_MAIL;
-
 	/* Who does the mail go to?  If mail-list, them; else owner */
 
-	*mailto = '\0';
-	if (is_rattr_set(presv, RESV_ATR_mailuser)) {
+	mail_build_to(mailto, sizeof(mailto),
+		is_rattr_set(presv, RESV_ATR_mailuser) ? get_rattr_arst(presv, RESV_ATR_mailuser) : NULL,
+		get_rattr_str(presv, RESV_ATR_resv_owner), presv->ri_qs.ri_resvID);
 
-		/* has mail user list, send to them rather than owner */
-
-		pas = get_rattr_arst(presv, RESV_ATR_mailuser);
-		if (pas != NULL) {
-			for (i = 0; i < pas->as_usedptr; i++) {
-				addmailhost = 0;
-				mailaddrlen += strlen(pas->as_string[i]) + 2;
-				if ((pbs_conf.pbs_mail_host_name)  &&
-				    (strchr(pas->as_string[i], (int)'@') == NULL)) {
-						/* no host specified in address and      */
-						/* pbs_mail_host_name is defined, use it */
-						mailaddrlen += strlen(pbs_conf.pbs_mail_host_name) + 1;
-						addmailhost = 1;
-				}
-				if (mailaddrlen < sizeof(mailto)) {
-					(void)strcat(mailto, pas->as_string[i]);
-					if (addmailhost) {
-						/* append pbs_mail_host_name */
-						(void)strcat(mailto, "@");
-						(void)strcat(mailto, pbs_conf.pbs_mail_host_name);
-					} else {
-					  	sprintf(log_buffer,"Email list is too long: \"%.77s...\"", mailto);
-						log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, presv->ri_qs.ri_resvID, log_buffer);
-						break;
-					}
-					(void)strcat(mailto, " ");
-				}
-			}
-		}
-
-	} else {
-
-		/* no mail user list, just send to owner */
-
-		(void)pbs_strncpy(mailto, get_rattr_str(presv, RESV_ATR_resv_owner), sizeof(mailto));
-		/* if pbs_mail_host_name is set in pbs.conf, then replace the */
-		/* host name with the name specified in pbs_mail_host_name    */
-		if (pbs_conf.pbs_mail_host_name) {
-			if ((pat = strchr(mailto, (int)'@')) != NULL)
-				*pat = '\0';	/* remove existing @host */
-			if ((strlen(mailto) + strlen(pbs_conf.pbs_mail_host_name) + 1) < sizeof(mailto)) {
-				/* append the pbs_mail_host_name since it fits */
-				strcat(mailto, "@");
-				strcat(mailto, pbs_conf.pbs_mail_host_name);
-			} else {
-				if (pat)
-					*pat = '@';	/* did't fit, restore the "at" sign */
-			  	sprintf(log_buffer,"Email address is too long: \"%.77s...\"", mailto);
-				log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_WARNING, presv->ri_qs.ri_resvID, log_buffer);
-			}
-		}
-	}
-
-	if ((outmail = svr_exec_mailer(mailer, mailfrom, mailto)) == NULL)
-		exit(1);
-
-	/* Pipe in mail headers: To: and Subject: */
-
-	fprintf(outmail, "To: %s\n", mailto);
-	fprintf(outmail, "Subject: PBS RESERVATION %s\n\n", presv->ri_qs.ri_resvID);
-
-	/* Now pipe in "standard" message */
+	/* "standard" message */
 
 	switch (mailpoint) {
 
@@ -562,13 +1134,18 @@ svr_mailownerResv(resc_resv *presv, int mailpoint, int force, char *text)
 			break;
 	}
 
-	fprintf(outmail, "PBS Reservation Id: %s\n", presv->ri_qs.ri_resvID);
-	fprintf(outmail, "Reservation Name:   %s\n", get_rattr_str(presv, RESV_ATR_resv_name));
-	if (stdmessage)
-		fprintf(outmail, "%s\n", stdmessage);
-	if (text != NULL)
-		fprintf(outmail, "%s\n", text);
-	fclose(outmail);
+	if ((pnote = calloc(1, sizeof(mail_note))) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		return;
+	}
+	if ((pnote->mn_text = mail_note_text(stdmessage, text)) == NULL ||
+		pbs_asprintf(&pnote->mn_subject, "PBS RESERVATION %s", presv->ri_qs.ri_resvID) == -1 ||
+		pbs_asprintf(&pnote->mn_head, "PBS Reservation Id: %s\nReservation Name:   %s\n",
+			presv->ri_qs.ri_resvID, get_rattr_str(presv, RESV_ATR_resv_name)) == -1) {
+		log_err(errno, __func__, msg_err_malloc);
+		mail_note_free(pnote);
+		return;
+	}
 
-	exit(0);
+	mail_enqueue(mailto, pnote);
 }
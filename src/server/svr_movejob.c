@@ -87,6 +87,43 @@
 
 #define	RETRY	3	/* number of times to retry network move */
 
+/* pacing of job files streamed to a mom over TPP */
+#define JSEND_BACKLOG_MAX	(1024 * 1024)	/* pause while this much is queued to the router */
+#define JSEND_PASS_MAX		(1024 * 1024)	/* bytes streamed per pass before yielding */
+#define JSEND_WAIT_POLL		5		/* secs before a waiting send rechecks its stream */
+
+enum jsend_phase {
+	JSEND_SCRIPT,
+	JSEND_CRED,
+	JSEND_STDOUT,
+	JSEND_STDERR,
+	JSEND_CHKPT,
+	JSEND_COMMIT,
+	JSEND_DONE
+};
+
+/*
+ * A job send whose files are streamed to the mom in chunks from work tasks.
+ * It is one allocation, carried in wt_event2 of the task driving it; if the
+ * job is purged mid-stream, jsend_cancel() frees it and hands the mom's
+ * stream to the next waiting send.
+ */
+struct jsend {
+	pbs_net_t	js_momaddr;
+	unsigned int	js_momport;
+	int		js_stream;
+	enum jsend_phase js_phase;
+	int		js_seq;		/* chunk sequence number within the phase */
+	off_t		js_off;		/* bytes of the phase's data sent */
+	int		js_credtype;
+	size_t		js_credlen;
+	size_t		js_scriptlen;
+	char		*js_msgid;	/* msgid of the queuejob request, in js_data */
+	char		*js_cred;	/* in js_data */
+	char		*js_script;	/* in js_data */
+	char		js_data[1];
+};
+
 /* External functions called */
 
 extern void	stat_mom_job(job *);
@@ -97,6 +134,9 @@ int  local_move(job *, struct batch_request *);
 static void post_movejob(struct work_task *);
 static void post_routejob(struct work_task *);
 static int small_job_files(job* pjob);
+static int jsend_start(job *, mominfo_t *, pbs_net_t, unsigned int, int, char *, int, char *, size_t);
+static int jsend_wait(job *, mominfo_t *, struct batch_request *);
+static void jsend_stream(struct work_task *);
 extern int should_retry_route(int err);
 extern int move_job_file(int con, job *pjob, enum job_file which, int prot, char **msgid);
 extern void post_sendmom(struct work_task *pwt);
@@ -507,6 +547,10 @@ post_movejob(struct work_task *pwt)
  * 	Send execution job on connected tpp stream.
  *	Note: Job structure has been loaded with the script by now (ji_script populated)
  *
+ *	If any job file is too big to queue on the stream at once, the files
+ *	are streamed to the mom by jsend_stream() work tasks after this returns.
+ *	While that is going on, other jobs sent to the same mom wait for it.
+ *
  * @param[in]	jobp - pointer to the job being sent
  * @param[in]	hostaddr - the address of host to send job to, host byte order
  * @param[in]	port - the destination port, host byte order
@@ -527,6 +571,7 @@ send_job_exec(job *jobp, pbs_net_t hostaddr, int port, int move_type, struct bat
 	int encode_type;
 	char *destin = jobp->ji_qs.ji_destin;
 	int i;
+	attribute *pattr;
 	size_t credlen = 0;
 	char *credbuf = NULL;
 	char job_id[PBS_MAXSVRJOBID + 1];
@@ -542,7 +587,18 @@ send_job_exec(job *jobp, pbs_net_t hostaddr, int port, int move_type, struct bat
 	void (*post_func)(struct work_task *) = post_sendmom;
 	char *extend_commit = NULL;
 	struct rq_move *rq_move = NULL;
-		
+	int stream_files = 0;
+
+	if (move_type == MOVE_TYPE_Exec) {
+		/*
+		 * the mom matches script chunks to the new job on the stream,
+		 * so nothing else may be sent while another job streams there
+		 */
+		pmom = tfind2(hostaddr, port, &ipaddrs);
+		if (pmom && GET_NEXT(pmom->mi_dmn_info->dmn_jsend_active))
+			return jsend_wait(jobp, pmom, request);
+		stream_files = !small_job_files(jobp);
+	}
 
 	/* saving resc_access_perm global variable as backup */
 	save_resc_access_perm = resc_access_perm;
@@ -584,8 +640,9 @@ send_job_exec(job *jobp, pbs_net_t hostaddr, int port, int move_type, struct bat
 	for (i = 0; i < (int) JOB_ATR_LAST; i++) {
 		if (i == JOB_ATR_server_inst_id)
 			continue;
-		if ((job_attr_def + i)->at_flags & resc_access_perm) {
-			(void)(job_attr_def + i)->at_encode(get_jattr(jobp, i), &attrl,
+		if (((job_attr_def + i)->at_flags & resc_access_perm) &&
+			((pattr = find_jattr(jobp, i)) != NULL)) {
+			(void)(job_attr_def + i)->at_encode(pattr, &attrl,
 				(job_attr_def + i)->at_name, NULL, encode_type, NULL);
 		}
 	}
@@ -626,6 +683,16 @@ send_job_exec(job *jobp, pbs_net_t hostaddr, int port, int move_type, struct bat
 	if (extend)
 		goto done;
 
+	/* big files are streamed from work tasks instead of all queued now */
+	if (stream_files) {
+		rc = jsend_start(jobp, pmom, hostaddr, port, stream, msgid,
+			jobp->ji_extended.ji_ext.ji_credtype, credbuf, credlen);
+		free(credbuf);
+		if (rc != 0)
+			goto send_err;
+		goto done;
+	}
+
 	/* we cannot use the same msgid, since it is not part of the preq,
 	 * make a dup of it, and we can freely free it
 	 */
@@ -710,12 +777,439 @@ send_err:
 	return (-1);
 }
 
+/**
+ * @brief
+ *	Find the deferred reply task of a streamed job send
+ *
+ * @param[in]	pmom - mom the job is sent to
+ * @param[in]	js - the job send
+ *
+ * @return	struct work_task *
+ * @retval	the task waiting for the mom's reply to the send
+ * @retval	NULL if the mom already replied or the stream closed
+ */
+static struct work_task *
+jsend_find_reply(mominfo_t *pmom, struct jsend *js)
+{
+	struct work_task *ptask;
+
+	for (ptask = GET_NEXT(pmom->mi_dmn_info->dmn_deferred_cmds); ptask; ptask = GET_NEXT(ptask->wt_linkobj2)) {
+		if (ptask->wt_event == js->js_stream && ptask->wt_event2 && strcmp(ptask->wt_event2, js->js_msgid) == 0)
+			return ptask;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Set up a work task to run the next pass of a streamed job send
+ *
+ * @param[in]	pjob - job being sent
+ * @param[in]	pmom - mom the job is sent to
+ * @param[in]	js - the job send, owned by the task from now on
+ * @param[in]	backoff - wait a second, the router has enough queued already
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure, js is still owned by the caller
+ */
+static int
+jsend_schedule(job *pjob, mominfo_t *pmom, struct jsend *js, int backoff)
+{
+	struct work_task *ptask;
+
+	if (backoff)
+		ptask = set_task(WORK_Timed, time_now + 1, jsend_stream, pjob);
+	else
+		ptask = set_task(WORK_Interleave, 0, jsend_stream, pjob);
+	if (ptask == NULL)
+		return -1;
+
+	ptask->wt_event2 = (char *) js;
+	append_link(&pjob->ji_svrtask, &ptask->wt_linkobj, ptask);
+	append_link(&pmom->mi_dmn_info->dmn_jsend_active, &ptask->wt_linkobj2, ptask);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Finish a streamed job send and let the next send waiting for the
+ *	stream go ahead
+ *
+ * @param[in]	pmom - mom the job was sent to, may be NULL
+ * @param[in]	js - the job send, freed
+ */
+static void
+jsend_done(mominfo_t *pmom, struct jsend *js)
+{
+	struct work_task *ptask;
+
+	free(js);
+	if (pmom == NULL)
+		return;
+
+	if ((ptask = GET_NEXT(pmom->mi_dmn_info->dmn_jsend_wait)) != NULL) {
+		delete_link(&ptask->wt_linkobj2);
+		convert_work_task(ptask, WORK_Immed);
+	}
+}
+
+/**
+ * @brief
+ *	Send the next chunk of a streamed job send
+ *
+ * @param[in]	pjob - job being sent
+ * @param[in,out]	js - the job send, advanced past what was sent
+ * @param[out]	sent - number of bytes sent
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	!0	PBS error number
+ */
+static int
+jsend_chunk(job *pjob, struct jsend *js, int *sent)
+{
+	char path[MAXPATHLEN + 1];
+	char buf[SCRIPT_CHUNK_Z];
+	char *msgid = js->js_msgid;
+	const char *suffix;
+	enum job_file which;
+	int fd;
+	int cc;
+
+	*sent = 0;
+	switch (js->js_phase) {
+	case JSEND_SCRIPT:
+		if (js->js_off < js->js_scriptlen) {
+			cc = js->js_scriptlen - js->js_off;
+			if (cc > SCRIPT_CHUNK_Z)
+				cc = SCRIPT_CHUNK_Z;
+			if (PBSD_scbuf(js->js_stream, PBS_BATCH_jobscript, js->js_seq++, js->js_script + js->js_off,
+				       cc, NULL, JScript, PROT_TPP, &msgid) != 0)
+				return PBSE_NORELYMOM;
+			js->js_off += cc;
+			*sent = cc;
+		}
+		if (js->js_off >= js->js_scriptlen)
+			js->js_phase = JSEND_CRED;
+		return 0;
+
+	case JSEND_CRED:
+		if (js->js_credlen > 0) {
+			if (PBSD_jcred(js->js_stream, js->js_credtype, js->js_cred, js->js_credlen, PROT_TPP, &msgid) != 0)
+				return PBSE_NORELYMOM;
+			*sent = js->js_credlen;
+		}
+		js->js_phase = JSEND_STDOUT;
+		js->js_seq = 0;
+		js->js_off = 0;
+		return 0;
+
+	case JSEND_STDOUT:
+	case JSEND_STDERR:
+	case JSEND_CHKPT:
+		if (!(pjob->ji_qs.ji_svrflags & JOB_SVFLG_HASRUN) || (js->js_momaddr == pbs_server_addr)) {
+			js->js_phase = JSEND_COMMIT;
+			return 0;
+		}
+		if (js->js_phase == JSEND_STDOUT) {
+			which = StdOut;
+			suffix = JOB_STDOUT_SUFFIX;
+		} else if (js->js_phase == JSEND_STDERR) {
+			which = StdErr;
+			suffix = JOB_STDERR_SUFFIX;
+		} else {
+			which = Chkpt;
+			suffix = JOB_CKPT_SUFFIX;
+		}
+		snprintf(path, sizeof(path), "%s%s%s", path_spool,
+			 *pjob->ji_qs.ji_fileprefix != '\0' ? pjob->ji_qs.ji_fileprefix : pjob->ji_qs.ji_jobid, suffix);
+
+		/* the file is reopened each chunk, so no descriptor outlives the task */
+		if ((fd = open(path, O_RDONLY, 0)) < 0) {
+			if (errno != ENOENT || js->js_off != 0)
+				return PBSE_SYSTEM;
+			cc = 0;
+		} else {
+			if (lseek(fd, js->js_off, SEEK_SET) == (off_t) -1)
+				cc = -1;
+			else
+				cc = read(fd, buf, sizeof(buf));
+			close(fd);
+			if (cc < 0)
+				return PBSE_SYSTEM;
+		}
+		if (cc > 0) {
+			if (PBSD_scbuf(js->js_stream, PBS_BATCH_MvJobFile, js->js_seq++, buf, cc,
+				       pjob->ji_qs.ji_jobid, which, PROT_TPP, &msgid) != 0)
+				return PBSE_NORELYMOM;
+			js->js_off += cc;
+			*sent = cc;
+		}
+		if (cc < (int) sizeof(buf)) {
+			js->js_phase++;
+			js->js_seq = 0;
+			js->js_off = 0;
+		}
+		return 0;
+
+	case JSEND_COMMIT:
+		if (PBSD_commit(js->js_stream, pjob->ji_qs.ji_jobid, PROT_TPP, &msgid, NULL) != 0)
+			return PBSE_NORELYMOM;
+		js->js_phase = JSEND_DONE;
+		return 0;
+
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief
+ *	Work task running one pass of a streamed job send
+ *
+ * @par
+ *	Each pass sends chunks while the TPP router backlog is below
+ *	JSEND_BACKLOG_MAX, up to JSEND_PASS_MAX bytes, then yields to other
+ *	server work.  If the send fails the mom's reply task is run with the
+ *	error, as it would be when the stream breaks.
+ *
+ * @param[in]	ptask - work task, wt_parm1 is the job, wt_event2 the send
+ */
+static void
+jsend_stream(struct work_task *ptask)
+{
+	job *pjob = ptask->wt_parm1;
+	struct jsend *js = (struct jsend *) ptask->wt_event2;
+	struct work_task *preply;
+	mominfo_t *pmom;
+	int budget = JSEND_PASS_MAX;
+	int backlog;
+	int sent;
+	int rc = 0;
+
+	ptask->wt_event2 = NULL; /* js moves on to the next task or is freed */
+
+	pmom = tfind2(js->js_momaddr, js->js_momport, &ipaddrs);
+	if (pmom == NULL || (preply = jsend_find_reply(pmom, js)) == NULL) {
+		/* the mom answered or went away, its reply handler has the job */
+		jsend_done(pmom, js);
+		return;
+	}
+
+	while (js->js_phase != JSEND_DONE && budget > 0) {
+		backlog = tpp_send_backlog();
+		if (backlog > JSEND_BACKLOG_MAX) {
+			if (jsend_schedule(pjob, pmom, js, 1) == 0)
+				return;
+			rc = PBSE_SYSTEM;
+			break;
+		}
+		if ((rc = jsend_chunk(pjob, js, &sent)) != 0)
+			break;
+		budget -= sent;
+	}
+
+	if (rc == 0 && js->js_phase != JSEND_DONE) {
+		if (jsend_schedule(pjob, pmom, js, 0) == 0)
+			return;
+		rc = PBSE_SYSTEM;
+	}
+
+	if (rc != 0) {
+		log_eventf(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid,
+			   "send of job to %s failed error = %d", pjob->ji_qs.ji_destin, rc);
+		jsend_done(pmom, js);
+		preply->wt_aux = rc;
+		pbs_errno = rc;
+		free(preply->wt_event2);
+		preply->wt_event2 = NULL;
+		dispatch_task(preply);
+		return;
+	}
+
+	jsend_done(pmom, js);
+}
+
+/**
+ * @brief
+ *	Start streaming a job's files to the mom after its queuejob request
+ *
+ * @param[in]	pjob - job being sent, its script is taken over
+ * @param[in]	pmom - mom the job is sent to
+ * @param[in]	hostaddr - address of the mom
+ * @param[in]	port - port of the mom
+ * @param[in]	stream - TPP stream to the mom
+ * @param[in]	msgid - msgid of the queuejob request
+ * @param[in]	credtype - type of the job credential
+ * @param[in]	credbuf - job credential, or NULL
+ * @param[in]	credlen - length of credbuf
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	-1	failure (pbs_errno set)
+ */
+static int
+jsend_start(job *pjob, mominfo_t *pmom, pbs_net_t hostaddr, unsigned int port, int stream,
+	    char *msgid, int credtype, char *credbuf, size_t credlen)
+{
+	struct jsend *js;
+	size_t scriptlen = 0;
+	size_t msgidlen = strlen(msgid) + 1;
+
+	if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_SCRIPT) && pjob->ji_script)
+		scriptlen = strlen(pjob->ji_script);
+
+	if ((js = malloc(sizeof(struct jsend) + msgidlen + credlen + scriptlen)) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		pbs_errno = PBSE_SYSTEM;
+		return -1;
+	}
+	js->js_momaddr = hostaddr;
+	js->js_momport = port;
+	js->js_stream = stream;
+	js->js_phase = JSEND_SCRIPT;
+	js->js_seq = 0;
+	js->js_off = 0;
+	js->js_credtype = credtype;
+	js->js_credlen = credlen;
+	js->js_scriptlen = scriptlen;
+	js->js_msgid = js->js_data;
+	js->js_cred = js->js_msgid + msgidlen;
+	js->js_script = js->js_cred + credlen;
+	memcpy(js->js_msgid, msgid, msgidlen);
+	if (credlen > 0)
+		memcpy(js->js_cred, credbuf, credlen);
+	if (scriptlen > 0)
+		memcpy(js->js_script, pjob->ji_script, scriptlen);
+
+	if (jsend_schedule(pjob, pmom, js, 0) != 0) {
+		free(js);
+		pbs_errno = PBSE_SYSTEM;
+		return -1;
+	}
+
+	free(pjob->ji_script);
+	pjob->ji_script = NULL;
+
+	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid,
+		  "big job files, streaming to mom");
+	return 0;
+}
+
+/**
+ * @brief
+ *	Work task retrying a job send that waited for the mom's stream
+ *
+ * @par
+ *	If the retry fails, post_sendmom() is run with the error just as if
+ *	the mom had rejected the send, since send_job() already returned
+ *	success to the caller.
+ *
+ * @param[in]	ptask - work task, wt_parm1 is the request, wt_parm2 the job
+ */
+static void
+jsend_resume(struct work_task *ptask)
+{
+	struct batch_request *preq = ptask->wt_parm1;
+	job *pjob = ptask->wt_parm2;
+	struct work_task *pfail;
+
+	if (send_job(pjob, pjob->ji_qs.ji_un.ji_exect.ji_momaddr, pjob->ji_qs.ji_un.ji_exect.ji_momport,
+		     MOVE_TYPE_Exec, post_sendmom, preq) == 2)
+		return;
+
+	if ((pfail = set_task(WORK_Immed, 0, post_sendmom, preq)) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		return;
+	}
+	pfail->wt_parm2 = pjob;
+	pfail->wt_aux = pbs_errno ? pbs_errno : PBSE_SYSTEM;
+	pfail->wt_aux2 = PROT_TPP;
+	append_link(&pjob->ji_svrtask, &pfail->wt_linkobj, pfail);
+}
+
+/**
+ * @brief
+ *	Queue a job send behind the job streaming to the same mom
+ *
+ * @param[in]	pjob - job to send
+ * @param[in]	pmom - mom the job is sent to
+ * @param[in]	preq - the run request, passed on to post_sendmom()
+ *
+ * @return	int
+ * @retval	2	success, the send is queued
+ * @retval	-1	failure (pbs_errno set)
+ */
+static int
+jsend_wait(job *pjob, mominfo_t *pmom, struct batch_request *preq)
+{
+	struct work_task *ptask;
+
+	if (pjob->ji_script) {
+		free(pjob->ji_script);
+		pjob->ji_script = NULL;
+	}
+
+	/* the timer only matters if the streaming job vanishes without finishing */
+	if ((ptask = set_task(WORK_Timed, time_now + JSEND_WAIT_POLL, jsend_resume, preq)) == NULL) {
+		log_err(errno, __func__, msg_err_malloc);
+		pbs_errno = PBSE_SYSTEM;
+		return -1;
+	}
+	ptask->wt_parm2 = pjob;
+	append_link(&pjob->ji_svrtask, &ptask->wt_linkobj, ptask);
+	append_link(&pmom->mi_dmn_info->dmn_jsend_wait, &ptask->wt_linkobj2, ptask);
+
+	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_INFO, pjob->ji_qs.ji_jobid,
+		  "mom stream busy, job send queued");
+	return 2;
+}
+
+/**
+ * @brief
+ *	Cancel the streamed or queued sends of a job that is being purged or
+ *	moved to history, before its work tasks are deleted
+ *
+ * @par
+ *	A queued send holds the run request, which is rejected here since
+ *	no post_sendmom() will reply to it.  A send in the middle of
+ *	streaming releases the mom's stream to the next queued send.
+ *
+ * @param[in]	pjob - job whose sends to cancel
+ */
+void
+jsend_cancel(job *pjob)
+{
+	struct work_task *ptask;
+	struct work_task *pnext;
+	struct jsend *js;
+	mominfo_t *pmom;
+
+	for (ptask = GET_NEXT(pjob->ji_svrtask); ptask; ptask = pnext) {
+		pnext = GET_NEXT(ptask->wt_linkobj);
+		if (ptask->wt_func == jsend_resume) {
+			if (ptask->wt_parm1 != NULL)
+				req_reject(PBSE_UNKJOBID, 0, (struct batch_request *) ptask->wt_parm1);
+			delete_task(ptask);
+		} else if (ptask->wt_func == jsend_stream && ptask->wt_event2 != NULL) {
+			js = (struct jsend *) ptask->wt_event2;
+			pmom = tfind2(js->js_momaddr, js->js_momport, &ipaddrs);
+			delete_task(ptask);
+			jsend_done(pmom, js);
+		}
+	}
+}
+
 /**
  *
  * @brief
  * 		Send a job over the network to some other server or MOM.
  * @par
- * 		Under Linux/Unix, this starts a child process to do the work.
+ * 		Jobs sent to a MOM, and jobs moved to run on a peer server, are
+ * 		sent in-process over TPP by send_job_exec(); big job files are
+ * 		streamed to the MOM from work tasks.  Moves to other servers
+ * 		start a child process to do the work.
  *		Connect to the destination host and port,
  * 		and go through the protocol to transfer the job.
  * 		Signals are blocked.
@@ -748,6 +1242,7 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 	char *destin = jobp->ji_qs.ji_destin;
 	int encode_type;
 	int i;
+	attribute *pattr;
 	char job_id[PBS_MAXSVRJOBID + 1];
 	pid_t pid;
 	struct attropl *pqjatr; /* list (single) of attropl for quejob */
@@ -769,10 +1264,10 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 		}
 	}
 
-	if ((move_type == MOVE_TYPE_Exec && small_job_files(jobp)) || move_type == MOVE_TYPE_Move_Run)
+	if (move_type == MOVE_TYPE_Exec || move_type == MOVE_TYPE_Move_Run)
 		return send_job_exec(jobp, hostaddr, port, move_type, preq);
 
-	(void)snprintf(log_buffer, sizeof(log_buffer), "big job files, sending via subprocess");
+	(void)snprintf(log_buffer, sizeof(log_buffer), "sending to remote server via subprocess");
 	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_INFO, jobp->ji_qs.ji_jobid, log_buffer);
 
 	script_name[0] = '\0';
@@ -828,6 +1323,7 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 	 */
 	DBPRT(("%s: child started, sending to port %d\n", __func__, port))
 	tpp_terminate();
+	pbs_db_close_fds(svr_db_conn);
 
 	/* Unprotect child from being killed by kernel */
 	daemon_protect(0, PBS_DAEMON_PROTECT_OFF);
@@ -871,8 +1367,9 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 	}
 
 	for (i=0; i < (int)JOB_ATR_LAST; i++) {
-		if ((job_attr_def+i)->at_flags & resc_access_perm) {
-			(void)(job_attr_def+i)->at_encode(get_jattr(jobp, i), &attrl,
+		if (((job_attr_def+i)->at_flags & resc_access_perm) &&
+			((pattr = find_jattr(jobp, i)) != NULL)) {
+			(void)(job_attr_def+i)->at_encode(pattr, &attrl,
 				(job_attr_def+i)->at_name, NULL, encode_type, NULL);
 		}
 	}
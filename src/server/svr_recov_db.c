@@ -73,6 +73,7 @@
 #include "pbs_db.h"
 #include "pbs_sched.h"
 #include "pbs_share.h"
+#include "hook_func.h"
 
 /* Global Data Items: */
 
@@ -276,8 +277,10 @@ svr_save_db(struct server *ps)
 	obj.pbs_db_obj_type = PBS_DB_SVR;
 	obj.pbs_db_un.pbs_db_svr = &dbsvr;
 
-	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0)
+	if ((rc = pbs_db_save_obj(conn, &obj, savetype)) == 0) {
 		ps->newobj = 0;
+		periodic_hook_objs_changed();
+	}
 
 done:
 	free_db_attr_list(&dbsvr.db_attr_list);
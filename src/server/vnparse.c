@@ -504,6 +504,74 @@ vn_merge2(vnl_t *cur, vnl_t *new, char **allow_attribs, callfunc_t callback)
 	return cur;
 }
 
+/**
+ * @brief
+ *		Compute the changes that turn one vnode list (old) into another (new):
+ *		a vnode list holding each attribute of new whose value differs from,
+ *		or is missing in, old.
+ *
+ * @note
+ *		Only additions and changes can be expressed, so NULL is returned when
+ *		new lacks a vnode or an attribute found in old, or has a vnode not in
+ *		old.  The caller is then expected to send new in full.
+ *
+ * @param[in]	old	-	vnode list as last reported
+ * @param[in]	new	-	current vnode list
+ *
+ * @return	vnl_t *
+ * @retval	the changes, possibly empty, to be freed with vnl_free()
+ * @retval	NULL	: the change is structural, or an error occurred
+ */
+vnl_t *
+vn_delta(vnl_t *old, vnl_t *new)
+{
+	unsigned long	i, j;
+	vnl_t		*delta = NULL;
+	unsigned long	nattrs = 0;
+
+	if ((old == NULL) || (new == NULL) || (old->vnl_used != new->vnl_used))
+		return NULL;
+
+	if (vnl_alloc(&delta) == NULL)
+		return NULL;
+	delta->vnl_modtime = new->vnl_modtime;
+
+	for (i = 0; i < new->vnl_used; i++) {
+		vnal_t	*newreslist = VNL_NODENUM(new, i);
+		vnal_t	*oldreslist;
+
+		if ((oldreslist = id2vnrl(old, newreslist->vnal_id)) == NULL)
+			goto structural;
+
+		for (j = 0; j < newreslist->vnal_used; j++) {
+			vna_t	*newres = VNAL_NODENUM(newreslist, j);
+			char	*oldval;
+
+			oldval = attr_exist(oldreslist, newres->vna_name);
+			if ((oldval != NULL) && (strcmp(oldval, newres->vna_val) == 0))
+				continue;
+			if (oldval == NULL)
+				nattrs++;
+			if (vn_addvnr(delta, newreslist->vnal_id,
+				newres->vna_name, newres->vna_val,
+				newres->vna_type, newres->vna_flag,
+				NULL) == -1)
+				goto structural;
+		}
+
+		/* every attribute of old must still be present in new */
+		if (oldreslist->vnal_used + nattrs != newreslist->vnal_used)
+			goto structural;
+		nattrs = 0;
+	}
+
+	return (delta);
+
+structural:
+	vnl_free(delta);
+	return NULL;
+}
+
 /**
  * @brief
  * 		Search for an attribute in a vnode.
@@ -654,9 +722,26 @@ vn_addvnr(vnl_t *vnlp, char *id, char *attr, char *attrval,
 	vnrp->vna_val = newval;
 	vnrp->vna_type = attrtype;
 	vnrp->vna_flag = attrflags;
+	vnl_changed(vnlp);
 	return (0);
 }
 
+/**
+ * @brief
+ *		Give a vnode list a new change serial.  Serials come from one
+ *		counter for all lists, so a list that replaces another never
+ *		repeats the serial of the list it replaces.
+ *
+ * @param[in,out]	vnlp	-	the vnode list that changed
+ */
+void
+vnl_changed(vnl_t *vnlp)
+{
+	static unsigned long	vnl_serial = 0;
+
+	vnlp->vnl_changes = ++vnl_serial;
+}
+
 /**
  * @brief
  *		If a vnal_t entry with the given ID (id) exists, return a pointer
@@ -931,6 +1016,7 @@ vnl_alloc(vnl_t **vp)
 		newchunk->vnl_cur = 0;
 		newchunk->vnl_used = 0;
 		newchunk->vnl_modtime = time(NULL);
+		vnl_changed(newchunk);
 		return (*vp = newchunk);
 	} else {
 		/*
@@ -0,0 +1,365 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ *  @file    pbs_ds_migrate.c
+ *
+ *  @brief
+ *		pbs_ds_migrate - Copy the PBS data from one datastore backend to another.
+ *
+ * Functions included are:
+ * 	copy_obj()
+ * 	copy_cb()
+ * 	copy_job_cb()
+ * 	copy_type()
+ * 	connect_backend()
+ * 	main()
+ */
+#include <pbs_config.h>
+#include <pbs_version.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include "pbs_ifl.h"
+#include <pbs_internal.h>
+#include "list_link.h"
+#include "attribute.h"
+#include "pbs_db.h"
+
+static char *prog = "pbs_ds_migrate";
+static void *from_conn;
+static void *to_conn;
+static int copy_failed;
+
+/**
+ * @brief
+ *		Free the attribute list of a loaded object
+ *
+ * @param[in]	attr_list - attribute list to free
+ */
+static void
+free_obj_attrs(pbs_db_attr_list_t *attr_list)
+{
+	free_attrlist(&attr_list->attrs);
+	attr_list->attr_count = 0;
+}
+
+/**
+ * @brief
+ *		Save an object, as loaded from the source datastore, into the
+ *		target datastore
+ *
+ * @param[in]	obj - object to save
+ * @param[in]	attr_list - attribute list of the object, freed here (may be NULL)
+ * @param[in]	id - object id, used in messages
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure
+ */
+static int
+copy_obj(pbs_db_obj_info_t *obj, pbs_db_attr_list_t *attr_list, char *id)
+{
+	char *db_err = NULL;
+	int rc;
+
+	rc = pbs_db_save_obj(to_conn, obj, OBJ_SAVE_NEW | OBJ_SAVE_QS);
+	if (attr_list)
+		free_obj_attrs(attr_list);
+	if (rc != 0) {
+		pbs_db_get_errmsg(PBS_DB_ERR, &db_err);
+		fprintf(stderr, "%s: Failed to copy %s: %s\n", prog, id, db_err ? db_err : "");
+		free(db_err);
+		copy_failed = 1;
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *		Search callback copying the scheduler, queue, node and
+ *		reservation objects
+ */
+static void
+copy_cb(pbs_db_obj_info_t *obj, int *refreshed)
+{
+	*refreshed = 0;
+	if (copy_failed)
+		return;
+
+	switch (obj->pbs_db_obj_type) {
+		case PBS_DB_SCHED:
+			*refreshed = (copy_obj(obj, &obj->pbs_db_un.pbs_db_sched->db_attr_list, obj->pbs_db_un.pbs_db_sched->sched_name) == 0);
+			break;
+		case PBS_DB_QUEUE:
+			*refreshed = (copy_obj(obj, &obj->pbs_db_un.pbs_db_que->db_attr_list, obj->pbs_db_un.pbs_db_que->qu_name) == 0);
+			break;
+		case PBS_DB_NODE:
+			*refreshed = (copy_obj(obj, &obj->pbs_db_un.pbs_db_node->db_attr_list, obj->pbs_db_un.pbs_db_node->nd_name) == 0);
+			break;
+		case PBS_DB_RESV:
+			*refreshed = (copy_obj(obj, &obj->pbs_db_un.pbs_db_resv->db_attr_list, obj->pbs_db_un.pbs_db_resv->ri_resvid) == 0);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief
+ *		Search callback copying a job and its script
+ */
+static void
+copy_job_cb(pbs_db_obj_info_t *obj, int *refreshed)
+{
+	pbs_db_job_info_t *pj = obj->pbs_db_un.pbs_db_job;
+	pbs_db_jobscr_info_t jobscr;
+	pbs_db_obj_info_t scr_obj;
+	int rc;
+
+	*refreshed = 0;
+	if (copy_failed)
+		return;
+
+	if (copy_obj(obj, &pj->db_attr_list, pj->ji_jobid) != 0)
+		return;
+
+	memset(&jobscr, 0, sizeof(jobscr));
+	pbs_strncpy(jobscr.ji_jobid, pj->ji_jobid, sizeof(jobscr.ji_jobid));
+	scr_obj.pbs_db_obj_type = PBS_DB_JOBSCR;
+	scr_obj.pbs_db_un.pbs_db_jobscr = &jobscr;
+
+	/* jobs that came from another server have no script */
+	rc = pbs_db_load_obj(from_conn, &scr_obj);
+	if (rc == 0) {
+		rc = copy_obj(&scr_obj, NULL, pj->ji_jobid);
+		free(jobscr.script);
+		if (rc != 0)
+			return;
+	} else if (rc == -1) {
+		fprintf(stderr, "%s: Failed to load the script of job %s\n", prog, pj->ji_jobid);
+		copy_failed = 1;
+		return;
+	}
+	*refreshed = 1;
+}
+
+/**
+ * @brief
+ *		Copy all the objects of one type
+ *
+ * @param[in]	obj - object of the type to copy, used as the search buffer
+ * @param[in]	cb - callback doing the copy
+ * @param[in]	what - name of the objects, used in messages
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure
+ */
+static int
+copy_type(pbs_db_obj_info_t *obj, query_cb_t cb, char *what)
+{
+	int count;
+
+	count = pbs_db_search(from_conn, obj, NULL, cb);
+	if (count == -1 || copy_failed) {
+		fprintf(stderr, "%s: Failed to copy the %s\n", prog, what);
+		return -1;
+	}
+	printf("%s: copied %d %s\n", prog, count, what);
+	return 0;
+}
+
+/**
+ * @brief
+ *		Connect to a datastore backend, starting the PostgreSQL data
+ *		service if it is not running yet
+ *
+ * @param[out]	conn - connection handle
+ * @param[in]	backend - backend name
+ * @param[out]	started - set to 1 if the data service was started here
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure
+ */
+static int
+connect_backend(void **conn, char *backend, int *started)
+{
+	char *db_err = NULL;
+	int failcode;
+
+	failcode = pbs_db_connect_backend(conn, backend, NULL, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
+	if (*conn == NULL && strcasecmp(backend, PBS_DB_BACKEND_PGSQL) == 0) {
+		failcode = pbs_start_db(pbs_default(), pbs_conf.pbs_data_service_port);
+		if (failcode == 0) {
+			*started = 1;
+			failcode = pbs_db_connect_backend(conn, backend, NULL, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
+		}
+	}
+	if (*conn == NULL) {
+		pbs_db_get_errmsg(failcode, &db_err);
+		fprintf(stderr, "%s: Could not connect to the %s datastore: %s\n", prog, backend, db_err ? db_err : "");
+		free(db_err);
+		return -1;
+	}
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *from = NULL;
+	char *to = NULL;
+	int errflg = 0;
+	int started = 0;
+	int ret = 1;
+	int i;
+	pbs_db_svr_info_t dbsvr;
+	pbs_db_sched_info_t dbsched;
+	pbs_db_que_info_t dbque;
+	pbs_db_node_info_t dbnode;
+	pbs_db_mominfo_time_t dbmit;
+	pbs_db_resv_info_t dbresv;
+	pbs_db_job_info_t dbjob;
+	pbs_db_obj_info_t obj;
+
+	/*test for real deal or just version and exit*/
+	PRINT_VERSION_AND_EXIT(argc, argv);
+
+	while ((i = getopt(argc, argv, "f:t:")) != EOF) {
+		switch (i) {
+			case 'f':
+				from = optarg;
+				break;
+			case 't':
+				to = optarg;
+				break;
+			default:
+				errflg++;
+		}
+	}
+
+	if (errflg || from == NULL || to == NULL || optind != argc || strcasecmp(from, to) == 0) {
+		fprintf(stderr, "usage:\t%s -f <from backend> -t <to backend>\n", prog);
+		fprintf(stderr, "      \t%s --version\n", prog);
+		fprintf(stderr, "backends: %s, %s\n", PBS_DB_BACKEND_PGSQL, PBS_DB_BACKEND_EMBEDDED);
+		return 1;
+	}
+
+	if ((getuid() != 0) || (geteuid() != 0)) {
+		fprintf(stderr, "%s: Must be run by root\n", prog);
+		return 1;
+	}
+
+	if (pbs_loadconf(0) == 0) {
+		fprintf(stderr, "%s: Could not load pbs configuration\n", prog);
+		return 1;
+	}
+
+	/* pbs_start_db() and pbs_stop_db() below are only needed for pgsql */
+	free(pbs_conf.pbs_data_service_backend);
+	pbs_conf.pbs_data_service_backend = strdup(PBS_DB_BACKEND_PGSQL);
+
+	/* the server must not be running, it owns the embedded datastore */
+	if (connect_backend(&from_conn, from, &started) != 0)
+		goto done;
+	if (connect_backend(&to_conn, to, &started) != 0)
+		goto done;
+
+	/* saving a new server clears the target datastore */
+	memset(&dbsvr, 0, sizeof(dbsvr));
+	obj.pbs_db_obj_type = PBS_DB_SVR;
+	obj.pbs_db_un.pbs_db_svr = &dbsvr;
+	if (pbs_db_load_obj(from_conn, &obj) != 0) {
+		fprintf(stderr, "%s: No server found in the %s datastore\n", prog, from);
+		goto done;
+	}
+	if (copy_obj(&obj, &dbsvr.db_attr_list, "server") != 0)
+		goto done;
+
+	memset(&dbsched, 0, sizeof(dbsched));
+	obj.pbs_db_obj_type = PBS_DB_SCHED;
+	obj.pbs_db_un.pbs_db_sched = &dbsched;
+	if (copy_type(&obj, copy_cb, "schedulers") != 0)
+		goto done;
+
+	memset(&dbque, 0, sizeof(dbque));
+	obj.pbs_db_obj_type = PBS_DB_QUEUE;
+	obj.pbs_db_un.pbs_db_que = &dbque;
+	if (copy_type(&obj, copy_cb, "queues") != 0)
+		goto done;
+
+	memset(&dbnode, 0, sizeof(dbnode));
+	obj.pbs_db_obj_type = PBS_DB_NODE;
+	obj.pbs_db_un.pbs_db_node = &dbnode;
+	if (copy_type(&obj, copy_cb, "nodes") != 0)
+		goto done;
+
+	memset(&dbmit, 0, sizeof(dbmit));
+	obj.pbs_db_obj_type = PBS_DB_MOMINFO_TIME;
+	obj.pbs_db_un.pbs_db_mominfo_tm = &dbmit;
+	if (pbs_db_load_obj(from_conn, &obj) == 0 && copy_obj(&obj, NULL, "mominfo_time") != 0)
+		goto done;
+
+	memset(&dbresv, 0, sizeof(dbresv));
+	obj.pbs_db_obj_type = PBS_DB_RESV;
+	obj.pbs_db_un.pbs_db_resv = &dbresv;
+	if (copy_type(&obj, copy_cb, "reservations") != 0)
+		goto done;
+
+	memset(&dbjob, 0, sizeof(dbjob));
+	obj.pbs_db_obj_type = PBS_DB_JOB;
+	obj.pbs_db_un.pbs_db_job = &dbjob;
+	if (copy_type(&obj, copy_job_cb, "jobs") != 0)
+		goto done;
+
+	ret = 0;
+
+done:
+	if (from_conn)
+		pbs_db_disconnect(from_conn);
+	if (to_conn)
+		pbs_db_disconnect(to_conn);
+	if (started)
+		pbs_stop_db(pbs_default(), pbs_conf.pbs_data_service_port);
+	return ret;
+}
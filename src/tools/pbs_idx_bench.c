@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file pbs_idx_bench.c
+ *
+ * @brief
+ *		pbs_idx_bench - micro-benchmark of pbs_idx against the AVL tree it
+ *		used to be built on. Uses job id like keys and times insert,
+ *		lookup (hits and misses), ordered iteration and delete. The first
+ *		iteration of a pbs_idx includes building its ordered view.
+ *
+ *		usage: pbs_idx_bench [-n number_of_keys]   (default 1000000)
+ *
+ * Functions included are:
+ * 	main()
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "avltree.h"
+#include "pbs_idx.h"
+
+static char **keys;
+static char **miss_keys;
+static int nkeys = 1000000;
+
+/**
+ * @brief
+ *		current time in milliseconds
+ */
+static double
+now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief
+ *		time the AVL tree, the way pbs_idx drove it
+ */
+static void
+bench_avl(double *t)
+{
+	AVL_IX_DESC idx;
+	AVL_IX_REC *pkey;
+	double start;
+	int i;
+	int n;
+	int c;
+
+	avl_create_index(&idx, 0, 0);
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++) {
+		pkey = avlkey_create(&idx, keys[i]);
+		pkey->recptr = keys[i];
+		avl_add_key(pkey, &idx);
+		free(pkey);
+	}
+	t[0] = now_ms() - start;
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++) {
+		pkey = avlkey_create(&idx, keys[i]);
+		if (avl_find_key(pkey, &idx) != AVL_IX_OK || pkey->recptr != keys[i])
+			fprintf(stderr, "avl: lookup of %s failed\n", keys[i]);
+		free(pkey);
+	}
+	t[1] = now_ms() - start;
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++) {
+		pkey = avlkey_create(&idx, miss_keys[i]);
+		avl_find_key(pkey, &idx);
+		free(pkey);
+	}
+	t[2] = now_ms() - start;
+
+	for (c = 3; c <= 4; c++) {
+		start = now_ms();
+		pkey = avlkey_create(&idx, NULL);
+		avl_first_key(&idx);
+		for (n = 0; avl_next_key(pkey, &idx) == AVL_IX_OK; n++)
+			;
+		free(pkey);
+		t[c] = now_ms() - start;
+		if (n != nkeys)
+			fprintf(stderr, "avl: iterated %d of %d keys\n", n, nkeys);
+	}
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++) {
+		pkey = avlkey_create(&idx, keys[i]);
+		avl_delete_key(pkey, &idx);
+		free(pkey);
+	}
+	t[5] = now_ms() - start;
+
+	avl_destroy_index(&idx);
+}
+
+/**
+ * @brief
+ *		time pbs_idx
+ */
+static void
+bench_idx(double *t)
+{
+	void *idx;
+	void *ctx = NULL;
+	void *data;
+	void *key;
+	double start;
+	int i;
+	int n;
+	int c;
+
+	idx = pbs_idx_create(0, 0);
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++)
+		pbs_idx_insert(idx, keys[i], keys[i]);
+	t[0] = now_ms() - start;
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++) {
+		key = keys[i];
+		if (pbs_idx_find(idx, &key, &data, NULL) != PBS_IDX_RET_OK || data != keys[i])
+			fprintf(stderr, "pbs_idx: lookup of %s failed\n", keys[i]);
+	}
+	t[1] = now_ms() - start;
+
+	start = now_ms();
+	for (i = 0; i < nkeys; i++) {
+		key = miss_keys[i];
+		pbs_idx_find(idx, &key, &data, NULL);
+	}
+	t[2] = now_ms() - start;
+
+	/* the first iteration also builds the ordered view */
+	for (c = 3; c <= 4; c++) {
+		start = now_ms();
+		key = NULL;
+		ctx = NULL;
+		for (n = 0; pbs_idx_find(idx, &key, &data, &ctx) == PBS_IDX_RET_OK; n++)
+			;
+		pbs_idx_free_ctx(ctx);
+		t[c] = now_ms() - start;
+		if (n != nkeys)
+			fprintf(stderr, "pbs_idx: iterated %d of %d keys\n", n, nkeys);
+	}
+
+	/* deletes now keep both the hash table and the B+tree up to date */
+	start = now_ms();
+	for (i = 0; i < nkeys; i++)
+		pbs_idx_delete(idx, keys[i]);
+	t[5] = now_ms() - start;
+
+	pbs_idx_destroy(idx);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *phase[] = {"insert", "lookup", "lookup miss", "1st iterate", "iterate", "delete"};
+	double t_avl[6];
+	double t_idx[6];
+	char buf[64];
+	int i;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:")) != -1) {
+		switch (c) {
+			case 'n':
+				nkeys = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n number_of_keys]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (nkeys <= 0) {
+		fprintf(stderr, "usage: %s [-n number_of_keys]\n", argv[0]);
+		return 1;
+	}
+
+	keys = malloc(nkeys * sizeof(char *));
+	miss_keys = malloc(nkeys * sizeof(char *));
+	if (keys == NULL || miss_keys == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	/* job ids, inserted in a shuffled order */
+	for (i = 0; i < nkeys; i++) {
+		snprintf(buf, sizeof(buf), "%d.pbsserver.example.com", i);
+		keys[i] = strdup(buf);
+		snprintf(buf, sizeof(buf), "%d.otherserver.example.com", i);
+		miss_keys[i] = strdup(buf);
+		if (keys[i] == NULL || miss_keys[i] == NULL) {
+			fprintf(stderr, "out of memory\n");
+			return 1;
+		}
+	}
+	srand(1);
+	for (i = nkeys - 1; i > 0; i--) {
+		int j = rand() % (i + 1);
+		char *tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	bench_avl(t_avl);
+	bench_idx(t_idx);
+
+	printf("%d keys\n", nkeys);
+	printf("%-12s %12s %12s %8s\n", "operation", "avl (ms)", "pbs_idx (ms)", "speedup");
+	for (i = 0; i < 6; i++)
+		printf("%-12s %12.1f %12.1f %7.1fx\n", phase[i], t_avl[i], t_idx[i],
+		       t_idx[i] > 0 ? t_avl[i] / t_idx[i] : 0.0);
+
+	return 0;
+}
@@ -1445,27 +1445,27 @@ main(int argc, char *argv[], char *envp[])
 		return (-1);
 	}
 
-	if ((job_attr_idx = cr_attrdef_idx(job_attr_def, JOB_ATR_LAST)) == NULL) {
+	if ((job_attr_idx = cr_attrdef_idx(job_attr_def, JOB_ATR_LAST, &job_attr_def_phash)) == NULL) {
 		log_err(errno, PBS_PYTHON_PROGRAM, "Failed creating job attribute search index");
 		return (-1);
 	}
-	if ((node_attr_idx = cr_attrdef_idx(node_attr_def, ND_ATR_LAST)) == NULL) {
+	if ((node_attr_idx = cr_attrdef_idx(node_attr_def, ND_ATR_LAST, &node_attr_def_phash)) == NULL) {
 		log_err(errno, PBS_PYTHON_PROGRAM, "Failed creating node attribute search index");
 		return (-1);
 	}
-	if ((que_attr_idx = cr_attrdef_idx(que_attr_def, QA_ATR_LAST)) == NULL) {
+	if ((que_attr_idx = cr_attrdef_idx(que_attr_def, QA_ATR_LAST, &que_attr_def_phash)) == NULL) {
 		log_err(errno, PBS_PYTHON_PROGRAM, "Failed creating queue attribute search index");
 		return (-1);
 	}
-	if ((svr_attr_idx = cr_attrdef_idx(svr_attr_def, SVR_ATR_LAST)) == NULL) {
+	if ((svr_attr_idx = cr_attrdef_idx(svr_attr_def, SVR_ATR_LAST, &svr_attr_def_phash)) == NULL) {
 		log_err(errno, PBS_PYTHON_PROGRAM, "Failed creating server attribute search index");
 		return (-1);
 	}
-	if ((sched_attr_idx = cr_attrdef_idx(sched_attr_def, SCHED_ATR_LAST)) == NULL) {
+	if ((sched_attr_idx = cr_attrdef_idx(sched_attr_def, SCHED_ATR_LAST, &sched_attr_def_phash)) == NULL) {
 		log_err(errno, PBS_PYTHON_PROGRAM, "Failed creating sched attribute search index");
 		return (-1);
 	}
-	if ((resv_attr_idx = cr_attrdef_idx(resv_attr_def, RESV_ATR_LAST)) == NULL) {
+	if ((resv_attr_idx = cr_attrdef_idx(resv_attr_def, RESV_ATR_LAST, &resv_attr_def_phash)) == NULL) {
 		log_err(errno, PBS_PYTHON_PROGRAM, "Failed creating resv attribute search index");
 		return (-1);
 	}
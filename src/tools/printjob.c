@@ -222,6 +222,26 @@ print_attr(svrattrl *pal)
 	printf("\n");
 }
 
+/**
+ * @brief	Print a list of attributes read from a job file
+ *
+ * @param[in]	pal  - list returned by read_all_attrs_from_jbfile()
+ *
+ * @return	void
+ */
+static void
+print_attrs(svrattrl *pal)
+{
+	svrattrl *pali = pal;
+
+	while (pali != NULL) {
+		print_attr(pali);
+		if (pali->al_link.ll_next == NULL)
+			break;
+		pali = GET_NEXT(pali->al_link);
+	}
+}
+
 /**
  * @brief
  * 		save the db info into job structure
@@ -286,13 +306,13 @@ print_db_job(char *id, int no_attributes)
 		/* connect to database */
 #ifdef NAS /* localmod 111 */
 		if (pbs_conf.pbs_data_service_host) {
-			failcode = pbs_db_connect(&conn, pbs_conf.pbs_data_service_host, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
+			failcode = pbs_db_connect_readonly(&conn, pbs_conf.pbs_data_service_host, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
 		}
 		else
 #endif /* localmod 111 */
-		failcode = pbs_db_connect(&conn, pbs_conf.pbs_server_name, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
+		failcode = pbs_db_connect_readonly(&conn, pbs_conf.pbs_server_name, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
 		if (!conn && pbs_conf.pbs_secondary != NULL) {
-			failcode = pbs_db_connect(&conn, pbs_conf.pbs_secondary, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
+			failcode = pbs_db_connect_readonly(&conn, pbs_conf.pbs_secondary, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
 			if (!conn) {
 				pbs_db_get_errmsg(failcode, &db_errmsg);
 				fprintf(stderr, "%s\n", db_errmsg);
@@ -397,6 +417,9 @@ char *argv[];
 	extern int optind;
 	char *job_id = NULL;
 	char job_script[BUF_SIZE];
+	svrattrl **journal = NULL;
+	int njournal;
+	int i;
 
 	/*
 	 * Check for the user. If the user is not root/administrator,
@@ -569,28 +592,46 @@ char *argv[];
 				}
 			}
 
+			errbuf[0] = '\0';
 			pal = read_all_attrs_from_jbfile(fp, &state, &substate, &errbuf);
 			if (pal == NULL && errbuf[0] != '\0') {
 				fprintf(stderr, "%s\n", errbuf);
 				exit(1);
 			}
 
+			/* attributes changed since the last full save follow as journal records */
+			njournal = 0;
+			while (1) {
+				svrattrl **tmp;
+
+				errbuf[0] = '\0';
+				pali = read_all_attrs_from_jbfile(fp, &state, &substate, &errbuf);
+				if (pali == NULL && errbuf[0] != '\0')
+					break;
+				tmp = realloc(journal, (njournal + 1) * sizeof(svrattrl *));
+				if (tmp == NULL) {
+					fprintf(stderr, "Malloc error\n");
+					exit(1);
+				}
+				journal = tmp;
+				journal[njournal++] = pali;
+			}
+
 			/* Print the summary first */
 			prt_job_struct(&xjob, state, substate);
 
 			/* now do attributes, one at a time */
-			if (no_attributes == 0 && pal != NULL) {
+			if (no_attributes == 0) {
 				/* Now print all attributes */
 				printf("--attributes--\n");
-
-				pali = GET_NEXT(pal->al_link);
-				while (pali != NULL) {
-					print_attr(pali);
-					if (pali->al_link.ll_next == NULL)
-						break;
-					pali = GET_NEXT(pali->al_link);
+				print_attrs(pal);
+				for (i = 0; i < njournal; i++) {
+					printf("--journal record %d--\n", i + 1);
+					print_attrs(journal[i]);
 				}
 			}
+			free(journal);
+			journal = NULL;
 
 			(void)close(fp);
 			printf("\n");
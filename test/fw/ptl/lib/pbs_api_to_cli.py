@@ -192,6 +192,7 @@ api_to_cli = {
     ATTR_rsvsync: 'reserved_sync',
     ATTR_start: 'started',
     ATTR_count: 'state_count',
+    ATTR_user_count: 'user_state_count',
     ATTR_number: 'number_jobs',
     ATTR_SvrHost: 'server_host',
     ATTR_aclroot: 'acl_roots',
@@ -0,0 +1,221 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+import socket
+
+from tests.functional import *
+
+
+def hacl_match(can, master):
+    """
+    Host match as acl_check() does it: compare from the end, a leading
+    '*' in master matches the rest of can
+    """
+    pc = len(can) - 1
+    pm = len(master) - 1
+    while pc > 0 and pm > 0:
+        if can[pc].lower() != master[pm].lower():
+            return False
+        pc -= 1
+        pm -= 1
+    if pm == 0:
+        if master[0] == '*':
+            return True
+        if pc == 0 and can[0].lower() == master[0].lower():
+            return True
+    return False
+
+
+def user_match(can, master):
+    """
+    User match as acl_check() does it: a master without a host matches
+    the user from any host
+    """
+    c = can + '\0'
+    m = master + '\0'
+    i = 0
+    while True:
+        if m[i] != c[i]:
+            return False
+        i += 1
+        if m[i] in '@\0':
+            break
+    if m[i] == '\0':
+        return c[i] in '@\0'
+    if c[i] != '@':
+        return False
+    return hacl_match(can[i + 1:], master[i + 1:])
+
+
+def scan_acl(entries, name):
+    """
+    Result of the linear scan acl_check() falls back to for short ACLs
+    """
+    default = False
+    for e in entries:
+        pstr = e
+        if e[0] in '+-':
+            if len(e) == 1:
+                default = e == '+'
+            pstr = e[1:]
+        if user_match(name, pstr):
+            return e[0] != '-'
+    return default
+
+
+class TestAclIndex(TestFunctional):
+    """
+    Tests that user, group and host ACLs of eight or more entries, which
+    the server looks up through an index, give the same answers as the
+    entry by entry scan used for short ACLs
+    """
+    fillers = ['nouser%d' % i for i in range(8)]
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        a = {'queue_type': 'execution', 'started': 'True',
+             'enabled': 'True'}
+        self.server.manager(MGR_CMD_CREATE, QUEUE, a, id='aclq')
+
+    def can_submit(self, user):
+        """
+        Return whether `user` may submit a job to aclq
+        """
+        j = Job(user, attrs={ATTR_queue: 'aclq'})
+        try:
+            self.server.submit(j)
+        except PbsSubmitError:
+            return False
+        return True
+
+    def owner_host(self):
+        """
+        Host part of Job_Owner of a job submitted from this host
+        """
+        jid = self.server.submit(Job(TEST_USER))
+        st = self.server.status(JOB, 'Job_Owner', id=jid)
+        return st[0]['Job_Owner'].split('@', 1)[1]
+
+    def set_acl(self, attr, entries):
+        """
+        Set the ACL `attr` of aclq and return its entries as stored
+        """
+        self.server.manager(MGR_CMD_SET, QUEUE, {attr: ','.join(entries)},
+                            id='aclq')
+        st = self.server.status(QUEUE, attr, id='aclq')
+        return st[0][attr].split(',')
+
+    def test_user_at_host(self):
+        """
+        Test user@host, user@* and bare user entries in a long user ACL
+        """
+        host = self.owner_host()
+        entries = self.fillers + ['%s@%s' % (TEST_USER, host),
+                                  '%s@nohost.example' % TEST_USER1,
+                                  '%s@*' % TEST_USER2,
+                                  str(TEST_USER3)]
+        self.server.manager(MGR_CMD_SET, QUEUE, {'acl_user_enable': True},
+                            id='aclq')
+        self.set_acl('acl_users', entries)
+        self.assertTrue(self.can_submit(TEST_USER))
+        self.assertFalse(self.can_submit(TEST_USER1))
+        self.assertTrue(self.can_submit(TEST_USER2))
+        self.assertTrue(self.can_submit(TEST_USER3))
+        self.assertFalse(self.can_submit(TEST_USER4))
+
+    def test_bare_entries_order(self):
+        """
+        Test that bare '+' and '-' entries in user ACLs of eight or more
+        entries set the default as they do in short ACLs
+        """
+        host = self.owner_host()
+        users = [TEST_USER, TEST_USER1, TEST_USER2, TEST_USER3]
+        acls = [['+'],
+                ['-'],
+                ['+', '-%s' % TEST_USER1],
+                ['-', '+%s' % TEST_USER2],
+                ['+', '-', '%s@%s' % (TEST_USER3, host)],
+                ['-', '+', '-%s@*' % TEST_USER]]
+        self.server.manager(MGR_CMD_SET, QUEUE, {'acl_user_enable': True},
+                            id='aclq')
+        for acl in acls:
+            for entries in [acl, self.fillers + acl]:
+                stored = self.set_acl('acl_users', entries)
+                for u in users:
+                    want = scan_acl(stored, '%s@%s' % (u, host))
+                    self.assertEqual(self.can_submit(u), want,
+                                     'acl_users %s, user %s' % (stored, u))
+
+    def test_group_acl(self):
+        """
+        Test a long group ACL against primary and secondary groups
+        """
+        groups = ['nogroup%d' % i for i in range(8)]
+        self.server.manager(MGR_CMD_SET, QUEUE, {'acl_group_enable': True},
+                            id='aclq')
+        self.set_acl('acl_groups', groups + [str(TSTGRP3)])
+        # TSTGRP3 is a secondary group of TEST_USER2 only
+        self.assertTrue(self.can_submit(TEST_USER2))
+        self.assertFalse(self.can_submit(TEST_USER1))
+        self.set_acl('acl_groups', groups + [str(TSTGRP1)])
+        # TSTGRP1 is the primary group of TEST_USER7
+        self.assertTrue(self.can_submit(TEST_USER7))
+        self.assertTrue(self.can_submit(TEST_USER1))
+        self.assertFalse(self.can_submit(TEST_USER))
+
+    def test_wildcard_hosts(self):
+        """
+        Test '*.domain' entries in a long host ACL
+        """
+        fqdn = socket.getfqdn(self.server.hostname)
+        if '.' not in fqdn:
+            self.skipTest('server host %s has no domain' % fqdn)
+        domain = fqdn.split('.', 1)[1]
+        others = ['*.nowhere%d.example' % i for i in range(8)]
+        self.server.manager(MGR_CMD_SET, QUEUE, {'acl_host_enable': True},
+                            id='aclq')
+        self.set_acl('acl_hosts', others)
+        self.assertFalse(self.can_submit(TEST_USER))
+        self.set_acl('acl_hosts', others + ['*.' + domain])
+        self.assertTrue(self.can_submit(TEST_USER))
+        self.set_acl('acl_hosts', others + ['-*.' + domain, '+'])
+        self.assertFalse(self.can_submit(TEST_USER))
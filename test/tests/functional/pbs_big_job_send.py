@@ -0,0 +1,110 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestBigJobSend(TestFunctional):
+    """
+    Tests for jobs whose script is too big to send to the mom in one
+    request, so the server streams it in chunks, one job at a time per mom
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 4}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname)
+        # log_events 2047 logs the queued sends
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_enable': 'True',
+                             'log_events': 2047})
+
+    def submit_big(self, marker, size=3 * 1024 * 1024):
+        """
+        Submit a job with a script of about `size` bytes that echoes
+        `marker`, and return its id
+        """
+        pad = '#' + 'x' * 78 + '\n'
+        body = 'echo %s\nsleep 5\n' % marker
+        body += pad * (size // len(pad))
+        j = Job(TEST_USER, attrs={'Resource_List.ncpus': 1})
+        j.create_script(body)
+        return self.server.submit(j)
+
+    def test_big_scripts_share_mom(self):
+        """
+        Test that several jobs with a script over 2MB, sent to the same
+        mom at once, all run and see their whole script
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = [self.submit_big('big%d' % i) for i in range(3)]
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.log_match('mom stream busy, job send queued')
+        for i, jid in enumerate(jids):
+            self.server.expect(JOB, {'job_state': 'F', 'Exit_status': 0},
+                               id=jid, extend='x', offset=5)
+            job = self.server.status(JOB, 'Output_Path', id=jid,
+                                     extend='x')[0]
+            out = job['Output_Path'].split(':', 1)[1]
+            ret = self.du.cat(self.server.hostname, out, sudo=True)
+            self.assertIn('big%d' % i, ret['out'])
+
+    def test_delete_queued_big_send(self):
+        """
+        Test that deleting a job whose send waits behind another one
+        neither hangs the run request nor keeps the mom's stream busy
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        j1 = self.submit_big('first')
+        j2 = self.submit_big('second')
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.server.log_match(j2 + ';mom stream busy, job send queued')
+        self.server.deljob(j2, extend='force', wait=True)
+        self.server.expect(JOB, {'job_state': 'F'}, id=j1, extend='x',
+                           offset=5)
+
+        # the stream is free again for the next big job
+        j3 = self.submit_big('third')
+        self.server.expect(JOB, {'job_state': 'F', 'Exit_status': 0},
+                           id=j3, extend='x', offset=5)
+        self.assertTrue(self.server.isUp())
@@ -0,0 +1,150 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+import pwd
+
+from tests.functional import *
+
+
+class TestClientDaemon(TestFunctional):
+    """
+    This test suite tests the client daemon the PBS commands use when
+    PBS_CLIENT_DAEMON is set
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.uid = pwd.getpwnam(str(TEST_USER)).pw_uid
+        self.tmpdir = self.server.pbs_conf.get('PBS_TMPDIR', '/var/tmp')
+        self.qstat = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                  'bin', 'qstat')
+        self.stop_daemons()
+
+    def tearDown(self):
+        self.stop_daemons()
+        TestFunctional.tearDown(self)
+
+    def stop_daemons(self):
+        """
+        Kill the client daemons of TEST_USER and remove their sockets
+        """
+        self.du.run_cmd(self.server.hostname,
+                        ['pkill', '-u', str(self.uid), '-x', 'qstat'],
+                        sudo=True, logerr=False)
+        for s in self.sockets():
+            self.du.rm(self.server.hostname, s, sudo=True, force=True)
+
+    def sockets(self):
+        """
+        Returns the client daemon sockets of TEST_USER
+        """
+        prefix = 'pbs_cmd_%d_' % self.uid
+        files = self.du.listdir(self.server.hostname, self.tmpdir,
+                                sudo=True, fullpath=False) or []
+        return [os.path.join(self.tmpdir, f) for f in files
+                if f.startswith(prefix)]
+
+    def run_qstat(self, env='', args=''):
+        """
+        Run qstat as TEST_USER with the given environment settings and
+        arguments, holding an extra file open that a client daemon must
+        not keep
+        """
+        cmd = env + ' ' + self.qstat + ' ' + args + ' 7</etc/hosts'
+        ret = self.du.run_cmd(self.server.hostname, cmd, runas=TEST_USER,
+                              as_script=True)
+        self.assertEqual(ret['rc'], 0)
+        return ret['out']
+
+    def test_client_daemon_opt_in(self):
+        """
+        Verify that qstat leaves no client daemon unless PBS_CLIENT_DAEMON
+        is set, and that with it set later commands are served through
+        the daemon, which keeps none of the files of the command open
+        """
+        jid = self.server.submit(Job(TEST_USER, {ATTR_h: None}))
+        self.run_qstat()
+        self.assertEqual(self.sockets(), [])
+
+        self.run_qstat('PBS_CLIENT_DAEMON=1')
+        self.assertEqual(len(self.sockets()), 1)
+        out = self.run_qstat('PBS_CLIENT_DAEMON=1')
+        self.assertIn(jid.split('.')[0], '\n'.join(out))
+
+        ret = self.du.run_cmd(self.server.hostname,
+                              ['pgrep', '-u', str(self.uid), '-x', 'qstat'])
+        self.assertEqual(len(ret['out']), 1, 'expected one client daemon')
+        pid = ret['out'][0].strip()
+        ret = self.du.run_cmd(self.server.hostname,
+                              ['ls', '-l', '/proc/%s/fd' % pid], sudo=True)
+        self.assertNotIn('/etc/hosts', '\n'.join(ret['out']))
+
+    def test_client_daemon_per_conf_file(self):
+        """
+        Verify that commands run with another pbs.conf file do not share
+        a client daemon
+        """
+        conf = self.du.create_temp_file(asuser=TEST_USER)
+        self.du.run_cmd(self.server.hostname,
+                        ['cp', self.du.get_pbs_conf_file(), conf],
+                        sudo=True)
+        self.du.chmod(self.server.hostname, conf, mode=0o644, sudo=True)
+        self.run_qstat('PBS_CLIENT_DAEMON=1')
+        self.run_qstat('PBS_CLIENT_DAEMON=1 PBS_CONF_FILE=' + conf)
+        self.assertEqual(len(self.sockets()), 2)
+
+    def test_client_daemon_killed_command(self):
+        """
+        Verify that a command killed while it reads a long reply through
+        the client daemon does not leave the rest of that reply to the
+        next command
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        for _ in range(200):
+            self.server.submit(Job(TEST_USER, {ATTR_h: None}))
+        self.run_qstat('PBS_CLIENT_DAEMON=1')
+        for _ in range(5):
+            cmd = 'PBS_CLIENT_DAEMON=1 timeout -s KILL 0.1 ' + \
+                self.qstat + ' -f'
+            self.du.run_cmd(self.server.hostname, cmd, runas=TEST_USER,
+                            as_script=True, logerr=False)
+            out = '\n'.join(self.run_qstat('PBS_CLIENT_DAEMON=1', '-Bf'))
+            self.assertIn('Server:', out)
+            self.assertNotIn('Job Id:', out)
@@ -0,0 +1,83 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestDbPipeline(TestFunctional):
+    """
+    This test suite tests that the saves the server queues in a datastore
+    pipeline are all stored
+    """
+
+    def test_many_vnodes_stored(self):
+        """
+        Verify that more vnodes than fit in one pipeline segment are all
+        stored as new nodes and are still there after a server restart
+        """
+        num = 300
+        self.mom.create_vnodes({'resources_available.ncpus': 1}, num)
+        self.server.restart()
+        vnodes = self.server.status(NODE, id=None)
+        names = [v['id'] for v in vnodes
+                 if v['id'].startswith(self.mom.shortname + '[')]
+        self.assertEqual(len(names), num)
+
+        # the second save of the nodes updates the rows stored first
+        self.server.manager(MGR_CMD_SET, NODE, {'comment': 'saved'},
+                            id=names[-1])
+        self.server.restart()
+        self.server.expect(NODE, {'comment': 'saved'}, id=names[-1])
+        vnodes = self.server.status(NODE, id=None)
+        self.assertEqual(len([v for v in vnodes if v['id'] in names]), num)
+
+    def test_job_commit_stored(self):
+        """
+        Verify that jobs saved with their scripts in one pipeline are
+        stored and can run after a server restart
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = [self.server.submit(Job(TEST_USER)) for _ in range(5)]
+        self.server.restart()
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.server.expect(JOB, {'job_state': 'R'}, id=jids[0])
@@ -0,0 +1,183 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestEmbeddedDatastore(TestFunctional):
+    """
+    Tests for the embedded datastore backend (PBS_DATA_SERVICE_BACKEND
+    set to embedded) and for pbs_ds_migrate
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.ds_dir = os.path.join(self.server.pbs_conf['PBS_HOME'],
+                                   'server_priv', 'datastore')
+        self.ds_log = os.path.join(self.ds_dir, 'log')
+        self.migrate = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                    'sbin', 'pbs_ds_migrate')
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'scheduling': 'False', 'job_history_enable': 1})
+
+    def tearDown(self):
+        self.server.stop()
+        self.du.unset_pbs_config(self.server.hostname,
+                                 confs='PBS_DATA_SERVICE_BACKEND')
+        self.server.start()
+        TestFunctional.tearDown(self)
+
+    def run_migrate(self, frm, to):
+        """
+        Run pbs_ds_migrate from backend `frm` to backend `to`
+        and return the result of the command
+        """
+        cmd = [self.migrate, '-f', frm, '-t', to]
+        return self.du.run_cmd(self.server.hostname, cmd=cmd, sudo=True)
+
+    def switch_to_embedded(self):
+        """
+        Stop the server, copy its data into the embedded datastore and
+        start it again on the embedded backend
+        """
+        self.server.stop()
+        ret = self.run_migrate('pgsql', 'embedded')
+        self.assertEqual(ret['rc'], 0, 'pbs_ds_migrate failed: %s' %
+                         ret['err'])
+        self.du.set_pbs_config(self.server.hostname,
+                               confs={'PBS_DATA_SERVICE_BACKEND':
+                                      'embedded'})
+        self.server.start()
+        self.assertTrue(self.server.isUp(), 'Server not up on embedded')
+
+    def kill_and_start(self):
+        """
+        Kill the server without a clean shutdown and start it again
+        """
+        self.server.stop('-KILL')
+        self.server.start()
+        self.assertTrue(self.server.isUp(), 'Server failed to recover')
+
+    def submit_held(self, count):
+        """
+        Submit `count` held jobs and return their ids
+        """
+        jids = []
+        for _ in range(count):
+            j = Job(TEST_USER, attrs={ATTR_h: None})
+            jids.append(self.server.submit(j))
+        return jids
+
+    def test_migrate_to_embedded(self):
+        """
+        Test that pbs_ds_migrate carries queues and jobs over to the
+        embedded datastore, and that it refuses to run while the server
+        holds that datastore
+        """
+        a = {'queue_type': 'execution', 'enabled': 'True',
+             'started': 'True'}
+        self.server.manager(MGR_CMD_CREATE, QUEUE, a, id='workq2')
+        jids = self.submit_held(3)
+        self.switch_to_embedded()
+
+        self.server.expect(QUEUE, {'queue_type': 'Execution'}, id='workq2')
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'H'}, id=jid)
+
+        ret = self.run_migrate('embedded', 'pgsql')
+        self.assertNotEqual(ret['rc'], 0,
+                            'pbs_ds_migrate ran against a live server')
+        self.assertIn('in use by another process', '\n'.join(ret['err']))
+
+    def test_snapshot_and_log_recovery(self):
+        """
+        Test that the state saved in the snapshot and in the log,
+        including changes made after a compaction, survives a crash of
+        the server
+        """
+        self.switch_to_embedded()
+        # enough saves for the log to outgrow the snapshot and compact
+        jids = self.submit_held(50)
+        self.server.alterjob(jids[0], {ATTR_N: 'after_compact'})
+        self.server.deljob(jids[1], wait=True)
+        self.kill_and_start()
+
+        self.server.expect(JOB, {ATTR_N: 'after_compact'}, id=jids[0])
+        self.server.expect(JOB, {'job_state': 'F'}, id=jids[1],
+                           extend='x')
+        for jid in jids[2:]:
+            self.server.expect(JOB, {'job_state': 'H'}, id=jid)
+
+    def test_torn_log_replay(self):
+        """
+        Test that a record torn by a crash at the end of the log is
+        dropped on replay, and that the server keeps logging after it
+        """
+        self.switch_to_embedded()
+        jids = self.submit_held(2)
+        self.server.stop('-KILL')
+
+        # a partial record, as left by a crash in the middle of a write
+        cmd = ['sh', '-c', 'printf "\\001\\002\\003\\004torn" >> %s' %
+               self.ds_log]
+        ret = self.du.run_cmd(self.server.hostname, cmd=cmd, sudo=True)
+        self.assertEqual(ret['rc'], 0)
+        self.server.start()
+        self.assertTrue(self.server.isUp(), 'Server failed to replay log')
+
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'H'}, id=jid)
+        self.server.alterjob(jids[0], {ATTR_N: 'after_torn'})
+        self.kill_and_start()
+        self.server.expect(JOB, {ATTR_N: 'after_torn'}, id=jids[0])
+
+    def test_unknown_backend(self):
+        """
+        Test that an unknown PBS_DATA_SERVICE_BACKEND value stops the
+        server from starting instead of falling back to pgsql
+        """
+        self.server.stop()
+        self.du.set_pbs_config(self.server.hostname,
+                               confs={'PBS_DATA_SERVICE_BACKEND': 'bogus'})
+        with self.assertRaises(PbsServiceError):
+            self.server.start()
+        self.server.log_match(
+            'Unknown PBS_DATA_SERVICE_BACKEND value "bogus"')
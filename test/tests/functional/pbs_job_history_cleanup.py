@@ -0,0 +1,111 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestJobHistoryCleanup(TestFunctional):
+    """
+    Tests for the purge of expired history jobs and for the compaction
+    of jobs as they become history
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'job_history_enable': 'True',
+             'job_history_duration': '10:00:00'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+        a = {'resources_available.ncpus': 4}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname)
+
+    def submit_short(self, count):
+        """
+        Submit `count` short jobs, wait for them to finish and return
+        their ids
+        """
+        jids = []
+        for _ in range(count):
+            j = Job(TEST_USER)
+            j.set_sleep_time(1)
+            jids.append(self.server.submit(j))
+        for jid in jids:
+            self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x',
+                               offset=1)
+        return jids
+
+    def test_expired_history_purged(self):
+        """
+        Test that history jobs past job_history_duration are purged while
+        newer jobs stay
+        """
+        old = self.submit_short(5)
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_duration': '00:00:05'})
+        j = Job(TEST_USER)
+        j.set_sleep_time(1000)
+        running = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=running)
+
+        # the cleanup task runs at least every two minutes
+        for jid in old:
+            self.server.expect(JOB, 'queue', op=UNSET, id=jid, extend='x',
+                               max_attempts=75, interval=2)
+        self.server.expect(JOB, {'job_state': 'R'}, id=running)
+
+    def test_history_stat_unchanged_by_compaction(self):
+        """
+        Test that qstat -x reports the same for a history job before and
+        after it is recovered and compacted again on restart, and that
+        what a finished job shows is still there
+        """
+        jid = self.submit_short(1)[0]
+        before = self.server.status(JOB, id=jid, extend='x')[0]
+        for attr in ['exec_host', 'exec_vnode', 'Resource_List.ncpus',
+                     'resources_used.walltime', 'Exit_status', 'stime',
+                     'obittime', 'Output_Path']:
+            self.assertIn(attr, before, '%s missing from history job' % attr)
+
+        self.server.restart()
+        after = self.server.status(JOB, id=jid, extend='x')[0]
+        # mtime records the recovery itself
+        before.pop('mtime', None)
+        after.pop('mtime', None)
+        self.assertEqual(before, after)
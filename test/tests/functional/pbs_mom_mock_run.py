@@ -78,3 +78,59 @@ class TestMomMockRun(TestFunctional):
         self.server.accounting_match(
             msg=used_walltime, existence=False, id=jid,
             max_attempts=1, n='ALL')
+
+    def test_mock_vnodes_runtime_failures(self):
+        """
+        Test that a mock run mom reports $mock_run_vnodes vnodes, ends
+        jobs after $mock_run_runtime and fails $mock_run_fail_pct of them
+        """
+        self.mom.add_config({'$mock_run_vnodes': '10 2 1gb',
+                             '$mock_run_runtime': '2',
+                             '$mock_run_fail_pct': '100'})
+        self.mom.stop()
+
+        # Start mom in mock run mode
+        mompath = os.path.join(self.server.pbs_conf["PBS_EXEC"], "sbin",
+                               "pbs_mom")
+        cmd = [mompath, "-m"]
+        self.du.run_cmd(hosts=self.mom.shortname, cmd=cmd, sudo=True)
+
+        vn = self.mom.shortname + '[9]'
+        self.server.expect(NODE, {'state': 'free',
+                                  'resources_available.ncpus': 2,
+                                  'resources_available.mem': '1gb'},
+                           id=vn)
+
+        # The job asks for far more walltime than it will run
+        attr = {ATTR_l + ".select": "2:ncpus=2",
+                ATTR_l + ".place": "scatter",
+                ATTR_l + ".walltime": "01:00:00"}
+        j = Job(attrs=attr)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.expect(JOB, 'queue', op=UNSET, id=jid, offset=2)
+        self.server.accounting_match(msg="Exit_status=1", id=jid, n='ALL')
+
+    def test_mock_vnodes_lowered(self):
+        """
+        Test that lowering $mock_run_vnodes and sending a HUP stops the
+        mom from reporting the vnodes above the new count
+        """
+        self.mom.add_config({'$mock_run_vnodes': '10 2 1gb'})
+        self.mom.stop()
+
+        # Start mom in mock run mode
+        mompath = os.path.join(self.server.pbs_conf["PBS_EXEC"], "sbin",
+                               "pbs_mom")
+        cmd = [mompath, "-m"]
+        self.du.run_cmd(hosts=self.mom.shortname, cmd=cmd, sudo=True)
+
+        vn = self.mom.shortname + '[%d]'
+        self.server.expect(NODE, {'state': 'free'}, id=vn % 9)
+
+        # add_config() sends the mom a HUP
+        self.mom.add_config({'$mock_run_vnodes': '4 2 1gb'})
+        self.server.expect(NODE, {'state': 'free'}, id=vn % 3)
+        for i in range(4, 10):
+            self.server.expect(NODE, {'state': (MATCH_RE, 'Stale')},
+                               id=vn % i)
@@ -0,0 +1,96 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestMomVnodeDelta(TestFunctional):
+    """
+    This test suite tests that vnode changes the MoM reports as deltas
+    reach the server.
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.vdef = "$configversion 2\n" + self.mom.shortname + \
+            ": resources_available.ncpus = %d\n"
+
+    def set_ncpus(self, ncpus):
+        """
+        Change the ncpus of the natural vnode through a vnode
+        definition file and have the MoM read it again
+        """
+        self.mom.insert_vnode_def(self.vdef % ncpus, fname='delta.def',
+                                  additive=True, restart=False)
+        self.mom.signal('-HUP')
+
+    def test_changes_within_one_second(self):
+        """
+        Verify that the last of several vnode changes made in quick
+        succession reaches the server, even when they fall in the same
+        second
+        """
+        self.set_ncpus(2)
+        self.server.expect(NODE, {'resources_available.ncpus': 2},
+                           id=self.mom.shortname)
+        for ncpus in (3, 4, 5):
+            self.set_ncpus(ncpus)
+        self.server.expect(NODE, {'resources_available.ncpus': 5},
+                           id=self.mom.shortname, max_attempts=10)
+
+    def test_changes_after_server_restart(self):
+        """
+        Verify that vnode changes keep reaching the server after it
+        restarts and the MoM says hello again
+        """
+        self.set_ncpus(2)
+        self.server.expect(NODE, {'resources_available.ncpus': 2},
+                           id=self.mom.shortname)
+        self.server.restart()
+        self.server.expect(NODE, {'state': 'free'}, id=self.mom.shortname)
+        self.set_ncpus(3)
+        self.server.expect(NODE, {'resources_available.ncpus': 3},
+                           id=self.mom.shortname, max_attempts=10)
+
+    def tearDown(self):
+        self.mom.delete_vnode_defs()
+        self.mom.signal('-HUP')
+        TestFunctional.tearDown(self)
@@ -0,0 +1,136 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestNodefileCompact(TestFunctional):
+    """
+    This test suite tests the compact PBS_NODEFILE written when the
+    mom config parameter nodefile_compact is set.
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 4}
+        self.server.manager(MGR_CMD_SET, NODE, a, self.mom.shortname)
+        self.mom.add_config({'$nodefile_compact': 1})
+
+    def test_nodefile_compact(self):
+        """
+        Verify that a job sees PBS_NODEFILE_COMPACT with one "host:count"
+        line per host and that the expanded PBS_NODEFILE, read as soon as
+        the job starts, matches it
+        """
+        j = Job(TEST_USER)
+        j.set_attributes({'Resource_List.select': '4:ncpus=1',
+                          'Resource_List.place': 'pack'})
+        j.create_script('cat $PBS_NODEFILE_COMPACT\n'
+                        'echo ---\n'
+                        'cat $PBS_NODEFILE\n'
+                        'sleep 5\n')
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        compact = os.path.join(self.server.pbs_conf['PBS_HOME'],
+                               "aux", jid + ".compact")
+        file_exists = self.du.isfile(hostname=self.mom.shortname,
+                                     path=compact, sudo=True)
+        self.assertTrue(file_exists, "PBS_NODEFILE_COMPACT not created")
+        self.server.expect(JOB, 'queue', op=UNSET, id=jid, offset=5)
+        job_out = self.server.status(JOB, 'Output_Path', id=jid,
+                                     extend='x')[0]['Output_Path']
+        job_out = job_out.split(':', 1)[1]
+        out = self.du.cat(self.mom.shortname, job_out, sudo=True)['out']
+        sep = out.index('---')
+        lines = out[:sep]
+        expanded = out[sep + 1:]
+        self.assertEqual(len(lines), 1)
+        host, count = lines[0].rsplit(':', 1)
+        self.assertEqual(int(count), 4)
+        self.assertEqual(expanded, [host] * 4)
+        file_exists = self.du.isfile(hostname=self.mom.shortname,
+                                     path=compact, sudo=True)
+        self.assertFalse(file_exists, "PBS_NODEFILE_COMPACT not deleted")
+        nodefile = os.path.join(self.server.pbs_conf['PBS_HOME'], "aux", jid)
+        file_exists = self.du.isfile(hostname=self.mom.shortname,
+                                     path=nodefile, sudo=True)
+        self.assertFalse(file_exists, "PBS_NODEFILE not deleted")
+
+    def test_nodefile_compact_unset_while_running(self):
+        """
+        Verify that both nodefiles of a job are removed when it ends even
+        if nodefile_compact was turned off while the job ran
+        """
+        j = Job(TEST_USER)
+        j.set_attributes({'Resource_List.select': '1:ncpus=1'})
+        j.set_sleep_time(10)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        aux = os.path.join(self.server.pbs_conf['PBS_HOME'], "aux")
+        compact = os.path.join(aux, jid + ".compact")
+        file_exists = self.du.isfile(hostname=self.mom.shortname,
+                                     path=compact, sudo=True)
+        self.assertTrue(file_exists, "PBS_NODEFILE_COMPACT not created")
+        self.mom.unset_mom_config('$nodefile_compact')
+        self.server.expect(JOB, 'queue', op=UNSET, id=jid, offset=10)
+        for path in (compact, os.path.join(aux, jid)):
+            file_exists = self.du.isfile(hostname=self.mom.shortname,
+                                         path=path, sudo=True)
+            self.assertFalse(file_exists, "%s not deleted" % path)
+
+    def test_nodefile_compact_task(self):
+        """
+        Verify that a task started through the TM interface sees the
+        expanded PBS_NODEFILE
+        """
+        j = Job(TEST_USER)
+        j.set_attributes({'Resource_List.select': '2:ncpus=1',
+                          'Resource_List.place': 'pack'})
+        pbsdsh = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                              'bin', 'pbsdsh')
+        j.create_script(pbsdsh + ' -n 1 -- /bin/sh -c '
+                        '"wc -l < \\$PBS_NODEFILE"\n')
+        jid = self.server.submit(j)
+        self.server.expect(JOB, 'queue', op=UNSET, id=jid, offset=2)
+        job_out = self.server.status(JOB, 'Output_Path', id=jid,
+                                     extend='x')[0]['Output_Path']
+        job_out = job_out.split(':', 1)[1]
+        out = self.du.cat(self.mom.shortname, job_out, sudo=True)['out']
+        self.assertEqual([l.strip() for l in out if l.strip()], ['2'])
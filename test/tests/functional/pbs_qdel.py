@@ -102,3 +102,20 @@ class TestQdel(TestFunctional):
         m = "Resource busy on job"
         self.assertIn(m, e.exception.msg[0])
         self.server.delete(jid, extend='deletehist')
+
+    def test_qdel_long_list_in_slices(self):
+        """
+        Test that a delete list longer than one slice is handled in
+        several slices and that every job in it is deleted
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False',
+                                                  'log_events': 2047})
+        jids = []
+        for _ in range(1200):
+            j = Job(TEST_USER)
+            jids.append(self.server.submit(j))
+        self.server.delete(jids, wait=True)
+        self.server.log_match("delete job list: 1000 of 1200 jobs handled")
+        for jid in jids:
+            self.server.expect(JOB, 'queue', id=jid, op=UNSET,
+                               max_attempts=1)
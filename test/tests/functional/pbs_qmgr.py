@@ -417,3 +417,50 @@ class TestQmgr(TestFunctional):
                     if rv:
                         self.delete_resource_helper(None, resc_flag,
                                                     ctrl_flag, k, v)
+
+    def test_node_list_and_pattern(self):
+        """
+        Test that a list of nodes can be created, and that a node name
+        pattern sets and unsets an attribute on every matching node
+        """
+        names = ['ptlvn1', 'ptlvn2', 'ptlvn3']
+        self.server.manager(MGR_CMD_CREATE, NODE, id=','.join(names))
+        for n in names:
+            self.server.expect(NODE, {'Mom': n}, id=n, op=SET)
+        self.server.manager(MGR_CMD_SET, NODE, {ATTR_comment: 'bulk'},
+                            id='ptlvn*')
+        for n in names:
+            self.server.expect(NODE, {ATTR_comment: 'bulk'}, id=n)
+        self.server.manager(MGR_CMD_UNSET, NODE, ATTR_comment,
+                            id='ptlvn?')
+        for n in names:
+            self.server.expect(NODE, ATTR_comment, id=n, op=UNSET)
+        try:
+            self.server.manager(MGR_CMD_SET, NODE, {ATTR_comment: 'x'},
+                                id='nosuchnode*')
+        except PbsManagerError as e:
+            self.assertIn('Unknown node', e.msg[0])
+        else:
+            self.fail('pattern matching no node was accepted')
+        for n in names:
+            self.server.manager(MGR_CMD_DELETE, NODE, id=n)
+
+    def test_node_list_create_all_or_none(self):
+        """
+        Test that the server rejects a node list that repeats a name or
+        names an existing node without creating any of the other nodes
+        """
+        if self.server.set_op_mode(PTL_API) != PTL_API:
+            self.skipTest("needs the PBS IFL API to send a node list")
+        self.server.manager(MGR_CMD_CREATE, NODE, id='ptlvn1')
+        try:
+            for names in ('ptlvn2,ptlvn3,ptlvn2', 'ptlvn2,ptlvn1,ptlvn3'):
+                # a list id is sent to the server as one object name
+                with self.assertRaises(PbsManagerError):
+                    self.server.manager(MGR_CMD_CREATE, NODE, id=[names])
+                nodes = [n['id'] for n in self.server.status(NODE)]
+                self.assertNotIn('ptlvn2', nodes)
+                self.assertNotIn('ptlvn3', nodes)
+        finally:
+            self.server.set_op_mode(PTL_CLI)
+        self.server.manager(MGR_CMD_DELETE, NODE, id='ptlvn1')
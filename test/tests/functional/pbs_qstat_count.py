@@ -279,3 +279,74 @@ class TestqstatStateCount(TestFunctional):
         # Restart server
         self.server.restart()
         self.verify_count()
+
+    def find_user_state_counts(self, runas=None):
+        """
+        Parses user_state_count from the output of qstat -Bf into a
+        dictionary of per-user dictionaries of state counts.
+        """
+        counts = {}
+        qstat = self.server.status(SERVER, ATTR_user_count, runas=runas)
+        if ATTR_user_count not in qstat[0]:
+            return counts
+        for entry in qstat[0][ATTR_user_count].split(','):
+            fields = entry.split()
+            counts[fields[0]] = {}
+            for s in fields[1:]:
+                state = s.split(':')
+                counts[fields[0]][state[0]] = int(state[1])
+        return counts
+
+    def test_user_state_count(self):
+        """
+        The test case verifies that user_state_count in qstat -Bf reports
+        the jobs of each user by state, both before and after a server
+        restart, and drops a user once all of the user's jobs are gone.
+        (each job uses ncpus=1)
+        """
+        jid = []
+        # 2 jobs run as available ncpus=2, the other 2 stay queued
+        for _ in range(4):
+            j = Job(TEST_USER)
+            jid.append(self.server.submit(j))
+        j = Job(TEST_USER1, {ATTR_h: None})
+        held = self.server.submit(j)
+
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid[0])
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid[1])
+        self.server.expect(JOB, {'job_state': 'H'}, id=held)
+
+        expected = {str(TEST_USER): {'Queued': 2, 'Running': 2},
+                    str(TEST_USER1): {'Held': 1}}
+        self.assertEqual(self.find_user_state_counts(), expected)
+
+        self.server.restart()
+        self.assertEqual(self.find_user_state_counts(), expected)
+
+        self.server.delete(held, wait=True)
+        del expected[str(TEST_USER1)]
+        self.assertEqual(self.find_user_state_counts(), expected)
+
+    def test_user_state_count_query_others(self):
+        """
+        The test case verifies that with query_other_jobs False a user
+        sees only the user's own entry in user_state_count while a
+        manager still sees every user
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'query_other_jobs': 'False'})
+        j = Job(TEST_USER, {ATTR_h: None})
+        self.server.submit(j)
+        j = Job(TEST_USER1, {ATTR_h: None})
+        self.server.submit(j)
+
+        mine = {str(TEST_USER1): {'Held': 1}}
+        self.assertEqual(self.find_user_state_counts(runas=TEST_USER1),
+                         mine)
+        everyone = {str(TEST_USER): {'Held': 1}, str(TEST_USER1): {'Held': 1}}
+        self.assertEqual(self.find_user_state_counts(), everyone)
+
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'query_other_jobs': 'True'})
+        self.assertEqual(self.find_user_state_counts(runas=TEST_USER1),
+                         everyone)
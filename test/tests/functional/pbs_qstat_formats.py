@@ -745,3 +745,22 @@ class TestQstatFormats(TestFunctional):
         except ValueError:
             self.logger.info(qstat_out)
             self.assertFalse(True, "Json failed to load")
+
+    def test_qstat_json_queue_and_bad_job(self):
+        """
+        Test that the json status of all the jobs of a queue, which is
+        read a page at a time, lists every job, and that the json stays
+        valid when a later job id fails
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = [self.server.submit(Job(TEST_USER)) for _ in range(5)]
+        qstat = os.path.join(self.server.pbs_conf['PBS_EXEC'], 'bin',
+                             'qstat')
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=qstat + ' -f -F json workq')
+        js = json.loads('\n'.join(ret['out']))
+        self.assertEqual(sorted(js['Jobs'].keys()), sorted(jids))
+        cmd = qstat + ' -f -F json ' + jids[0] + ' 99999999'
+        ret = self.du.run_cmd(self.server.hostname, cmd=cmd)
+        js = json.loads('\n'.join(ret['out']))
+        self.assertIn(jids[0], js['Jobs'])
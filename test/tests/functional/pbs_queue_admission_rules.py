@@ -0,0 +1,169 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestQueueAdmissionRules(TestFunctional):
+    """
+    Tests that the limits and defaults a job is admitted with follow
+    qmgr changes to the queue, the server and resource definitions
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        attr = {'type': 'long', 'flag': 'q'}
+        self.server.manager(MGR_CMD_CREATE, RSC, attr, id='rq')
+
+    def submit_rejected(self, attrs):
+        """
+        Check that a job with `attrs` is refused at submission
+        """
+        with self.assertRaises(PbsSubmitError):
+            self.server.submit(Job(TEST_USER, attrs=attrs))
+
+    def check_default(self, value):
+        """
+        Submit a job without rq, check the value it was given and
+        return the job id
+        """
+        jid = self.server.submit(Job(TEST_USER))
+        self.server.expect(JOB, {'Resource_List.rq': value}, id=jid)
+        return jid
+
+    def test_default_precedence(self):
+        """
+        Test that a job gets rq from the queue default, then the server
+        default, then the queue maximum, then the server maximum, as
+        each is unset in turn
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'resources_default.rq': 2,
+                             'resources_max.rq': 4})
+        self.server.manager(MGR_CMD_SET, QUEUE,
+                            {'resources_default.rq': 1,
+                             'resources_max.rq': 3}, id='workq')
+        self.check_default(1)
+        self.server.manager(MGR_CMD_UNSET, QUEUE, 'resources_default.rq',
+                            id='workq')
+        self.check_default(2)
+        self.server.manager(MGR_CMD_UNSET, SERVER, 'resources_default.rq')
+        self.check_default(3)
+        self.server.manager(MGR_CMD_UNSET, QUEUE, 'resources_max.rq',
+                            id='workq')
+        self.check_default(4)
+
+    def test_max_precedence(self):
+        """
+        Test that the queue maximum overrides the server maximum and
+        that the server maximum applies once the queue one is unset
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'resources_max.rq': 10})
+        self.server.manager(MGR_CMD_SET, QUEUE, {'resources_max.rq': 3},
+                            id='workq')
+        self.submit_rejected({'Resource_List.rq': 5})
+        self.server.manager(MGR_CMD_SET, QUEUE, {'resources_max.rq': 20},
+                            id='workq')
+        jid = self.server.submit(Job(TEST_USER,
+                                     attrs={'Resource_List.rq': 15}))
+        self.server.expect(JOB, {'Resource_List.rq': 15}, id=jid)
+        self.server.manager(MGR_CMD_UNSET, QUEUE, 'resources_max.rq',
+                            id='workq')
+        self.submit_rejected({'Resource_List.rq': 15})
+        jid = self.server.submit(Job(TEST_USER,
+                                     attrs={'Resource_List.rq': 5}))
+        self.server.expect(JOB, {'Resource_List.rq': 5}, id=jid)
+
+    def test_walltime_min_max(self):
+        """
+        Test the queue's minimum and maximum walltime after they are
+        set, changed and unset
+        """
+        self.server.manager(MGR_CMD_SET, QUEUE,
+                            {'resources_min.walltime': 100,
+                             'resources_max.walltime': 200}, id='workq')
+        self.submit_rejected({'Resource_List.walltime': 50})
+        self.submit_rejected({'Resource_List.walltime': 300})
+        self.server.submit(Job(TEST_USER,
+                               attrs={'Resource_List.walltime': 150}))
+
+        self.server.manager(MGR_CMD_SET, QUEUE,
+                            {'resources_min.walltime': 20}, id='workq')
+        self.server.submit(Job(TEST_USER,
+                               attrs={'Resource_List.walltime': 50}))
+
+        self.server.manager(MGR_CMD_UNSET, QUEUE, 'resources_min',
+                            id='workq')
+        self.server.manager(MGR_CMD_UNSET, QUEUE, 'resources_max.walltime',
+                            id='workq')
+        self.server.submit(Job(TEST_USER,
+                               attrs={'Resource_List.walltime': 10}))
+        self.server.submit(Job(TEST_USER,
+                               attrs={'Resource_List.walltime': 300}))
+
+    def test_limits_after_resource_delete(self):
+        """
+        Test that deleting a resource limited on the queue and server
+        leaves the remaining limits and defaults working, and that a
+        resource created again under the same name is not limited
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'resources_max.rq': 4})
+        self.server.manager(MGR_CMD_SET, QUEUE,
+                            {'resources_max.rq': 3,
+                             'resources_default.rq': 2,
+                             'resources_min.walltime': 100,
+                             'resources_max.walltime': 200}, id='workq')
+        jid = self.check_default(2)
+        # a resource requested by a job cannot be deleted
+        self.server.delete(jid, wait=True)
+        self.server.manager(MGR_CMD_DELETE, RSC, id='rq')
+
+        self.submit_rejected({'Resource_List.walltime': 50})
+        self.submit_rejected({'Resource_List.walltime': 300})
+        self.server.submit(Job(TEST_USER,
+                               attrs={'Resource_List.walltime': 150}))
+
+        attr = {'type': 'long', 'flag': 'q'}
+        self.server.manager(MGR_CMD_CREATE, RSC, attr, id='rq')
+        a = {'Resource_List.rq': 50, 'Resource_List.walltime': 150}
+        jid = self.server.submit(Job(TEST_USER, attrs=a))
+        self.server.expect(JOB, a, id=jid)
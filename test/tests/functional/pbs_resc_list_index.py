@@ -0,0 +1,127 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestRescListIndex(TestFunctional):
+    """
+    Tests that setting and comparing resource lists finds the right
+    entries for custom resources created while the server runs
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        attr = {'type': 'long', 'flag': 'q'}
+        for r in ['ria', 'rib', 'ric']:
+            self.server.manager(MGR_CMD_CREATE, RSC, attr, id=r)
+
+    def submit_rejected(self, attrs):
+        """
+        Submit a job with `attrs` and check it is refused for
+        exceeding a limit
+        """
+        j = Job(TEST_USER, attrs=attrs)
+        with self.assertRaises(PbsSubmitError) as e:
+            self.server.submit(j)
+        self.assertIn('resource limits', e.exception.msg[0])
+
+    def test_queue_limits_on_runtime_resources(self):
+        """
+        Test that queue limits on custom resources created at runtime
+        are checked against the matching job resource, including one
+        created after another was deleted
+        """
+        self.server.manager(MGR_CMD_DELETE, RSC, id='rib')
+        attr = {'type': 'long', 'flag': 'q'}
+        self.server.manager(MGR_CMD_CREATE, RSC, attr, id='rid')
+        a = {'resources_max.ria': 5, 'resources_max.ric': 10,
+             'resources_max.rid': 20}
+        self.server.manager(MGR_CMD_SET, QUEUE, a, id='workq')
+
+        a = {'Resource_List.ria': 5, 'Resource_List.ric': 10,
+             'Resource_List.rid': 20}
+        jid = self.server.submit(Job(TEST_USER, attrs=a))
+        self.server.expect(JOB, a, id=jid)
+
+        self.submit_rejected({'Resource_List.ria': 6})
+        self.submit_rejected({'Resource_List.ric': 11})
+        self.submit_rejected({'Resource_List.rid': 21,
+                              'Resource_List.ria': 1})
+
+    def test_set_runtime_resources(self):
+        """
+        Test that altering a job sets each custom resource created at
+        runtime on its own entry of Resource_List
+        """
+        a = {'Resource_List.ria': 1, 'Resource_List.rib': 2}
+        jid = self.server.submit(Job(TEST_USER, attrs=a))
+        attr = {'type': 'long', 'flag': 'q'}
+        self.server.manager(MGR_CMD_CREATE, RSC, attr, id='rid')
+
+        a = {'Resource_List.rib': 7, 'Resource_List.rid': 9}
+        self.server.alterjob(jid, a)
+        self.server.expect(JOB, {'Resource_List.ria': 1,
+                                 'Resource_List.rib': 7,
+                                 'Resource_List.rid': 9}, id=jid)
+
+        # queue defaults fill in only what the job does not have
+        a = {'resources_default.ric': 3, 'resources_default.rid': 4}
+        self.server.manager(MGR_CMD_SET, QUEUE, a, id='workq')
+        jid2 = self.server.submit(Job(TEST_USER,
+                                      attrs={'Resource_List.rid': 8}))
+        self.server.expect(JOB, {'Resource_List.ric': 3,
+                                 'Resource_List.rid': 8}, id=jid2)
+
+    def test_runtime_resources_after_restart(self):
+        """
+        Test that limits on custom resources created at runtime are
+        still applied to the right resource after a server restart
+        """
+        a = {'resources_max.rib': 4, 'resources_max.ric': 8}
+        self.server.manager(MGR_CMD_SET, QUEUE, a, id='workq')
+        self.server.restart()
+        a = {'Resource_List.rib': 4, 'Resource_List.ric': 8}
+        jid = self.server.submit(Job(TEST_USER, attrs=a))
+        self.server.expect(JOB, a, id=jid)
+        self.submit_rejected({'Resource_List.rib': 5})
+        self.submit_rejected({'Resource_List.ric': 9})
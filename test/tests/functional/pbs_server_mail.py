@@ -0,0 +1,137 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+
+from tests.functional import *
+
+
+class TestServerMail(TestFunctional):
+    """
+    Tests for how the server queues, batches and rate limits job mail
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.maillog = self.du.create_temp_file()
+        body = '#!/bin/sh\n'
+        body += 'echo "=== mail to $3" >> %s\n' % self.maillog
+        body += 'cat >> %s\n' % self.maillog
+        self.mailer = self.du.create_temp_file(body=body)
+        self.du.chmod(path=self.mailer, mode=0o755)
+        self.du.chmod(path=self.maillog, mode=0o666)
+        self.server.manager(MGR_CMD_SET, SERVER, {'mailer': self.mailer})
+        a = {'resources_available.ncpus': 10}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname)
+
+    def read_mail(self):
+        """
+        Return the lines the mailer logged, stripped
+        """
+        ret = self.du.cat(filename=self.maillog, sudo=True)
+        return [x.strip() for x in ret['out']]
+
+    def has_notice(self, lines, jid, msg):
+        """
+        Check that the notice `msg` of job `jid` is in `lines`, with
+        its "PBS Job Id:" header two lines above it
+        """
+        for i in range(len(lines) - 2):
+            if lines[i] == 'PBS Job Id: ' + jid and lines[i + 2] == msg:
+                return True
+        return False
+
+    def test_lone_notice_sent_at_once(self):
+        """
+        Test that a single notice is not held back for batching
+        """
+        j = Job(TEST_USER, attrs={ATTR_m: 'b'})
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        time.sleep(3)
+        lines = self.read_mail()
+        self.assertTrue(self.has_notice(lines, jid, 'Begun execution'),
+                        'begin mail for %s not sent within 3s' % jid)
+
+    def test_burst_digest(self):
+        """
+        Test that a burst of subjob notices is sent as a few digests,
+        each holding every subjob notice with its own header, and that
+        no notice is lost
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        j = Job(TEST_USER, attrs={ATTR_m: 'bj', ATTR_J: '1-10'})
+        j.set_sleep_time(300)
+        jid = self.server.submit(j)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.server.expect(JOB, {'job_state=R': 10}, count=True, id=jid,
+                           extend='t')
+
+        # one flush interval for the batched notices, plus slack
+        time.sleep(12)
+        lines = self.read_mail()
+        for i in range(1, 11):
+            subjid = j.create_subjob_id(jid, i)
+            self.assertTrue(self.has_notice(lines, subjid,
+                                            'Begun execution'),
+                            'begin mail for %s missing' % subjid)
+        mails = [x for x in lines if x.startswith('=== mail to')]
+        self.assertLess(len(mails), 10, 'subjob notices were not batched')
+        self.assertTrue([x for x in lines if x.endswith(' notices')],
+                        'no digest sent')
+
+    def test_bad_mail_user_skipped(self):
+        """
+        Test that a Mail_Users entry the mailer would take for an option
+        is dropped and the mail still goes to the other entries
+        """
+        good = '%s@%s' % (TEST_USER, self.server.shortname)
+        a = {ATTR_m: 'b', ATTR_M: '-oQ/tmp,%s' % good}
+        j = Job(TEST_USER, attrs=a)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        time.sleep(3)
+        lines = self.read_mail()
+        self.assertTrue(self.has_notice(lines, jid, 'Begun execution'),
+                        'begin mail for %s not sent within 3s' % jid)
+        mails = [x for x in lines if x.startswith('=== mail to')]
+        self.assertIn('=== mail to %s' % good, mails)
+        self.assertFalse([x for x in mails if '-oQ' in x],
+                         'option-like mail address passed to the mailer')
+        self.server.log_match('Ignoring bad mail address "-oQ/tmp"')
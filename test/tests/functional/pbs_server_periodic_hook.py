@@ -413,3 +413,106 @@ pbs.logmsg(pbs.LOG_DEBUG, "periodic hook ended at %%d" %% time.time())
             self.assertTrue(False, msg)
         self.server.manager(MGR_CMD_SET, HOOK, attrs, hook_name)
         self.server.manager(MGR_CMD_LIST, HOOK, {'freq': '120'}, hook_name)
+
+    def test_sp_hook_sees_current_jobs(self):
+        """
+        Check that a periodic hook sees a job change within the 30 second
+        bound the Server allows the hook helper to lag behind.
+        """
+        hook_name = "job_state_hook"
+        freq = 5
+        scr = """
+import pbs
+e = pbs.event()
+for j in pbs.server().jobs():
+    if j.job_state == pbs.JOB_STATE_HELD:
+        pbs.logmsg(pbs.LOG_DEBUG, "periodic hook sees %s held" % j.id)
+e.accept()
+"""
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        j = Job(TEST_USER)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
+        attrs = {'event': "periodic", 'freq': freq, 'enabled': 'True'}
+        self.server.create_import_hook(hook_name, attrs, scr)
+        # let the helper start and run the hook while the job is queued
+        self.server.log_match(hook_name + ";periodic hook accepted",
+                              interval=(freq + 1))
+        self.server.holdjob(jid)
+        self.server.expect(JOB, {'job_state': 'H'}, id=jid)
+        start_time = time.time()
+        self.server.log_match("periodic hook sees %s held" % jid,
+                              starttime=start_time, interval=1,
+                              max_attempts=(30 + 2 * freq))
+
+    def test_sp_hook_helper_kept_across_saves(self):
+        """
+        Check that job changes between runs do not make the Server fork a
+        new periodic hook helper for every run.
+        """
+        hook_name = "pid_hook"
+        freq = 3
+        scr = """
+import os
+import pbs
+pbs.logmsg(pbs.LOG_DEBUG, "periodic hook helper pid %d" % os.getpid())
+pbs.event().accept()
+"""
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        attrs = {'event': "periodic", 'freq': freq, 'enabled': 'True'}
+        self.server.create_import_hook(hook_name, attrs, scr)
+        self.server.log_match("periodic hook helper pid",
+                              interval=(freq + 1))
+        start_time = time.time()
+        for _ in range(4):
+            self.server.submit(Job(TEST_USER))
+            time.sleep(freq)
+        msgs = self.server.log_match("periodic hook helper pid",
+                                     starttime=start_time, allmatch=True)
+        self.assertGreaterEqual(len(msgs), 3)
+        pids = set(m[1].rsplit(' ', 1)[1] for m in msgs)
+        self.assertEqual(len(pids), 1,
+                         "helper was forked again: %s" % sorted(pids))
+
+    def test_sp_hook_skipped_occurrences(self):
+        """
+        Check that occurrences that come due while the hook is still
+        running are skipped and counted in the run statistics.
+        """
+        hook_name = "slow_hook"
+        freq = 3
+        hook_run_time = 10
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047})
+        scr = self.create_hook(True, hook_run_time)
+        attrs = {'event': "periodic", 'freq': freq, 'enabled': 'True'}
+        self.server.create_import_hook(hook_name, attrs, scr)
+        msg = hook_name + r";run took \d+ ms \(\d+ ms cpu\); 1 runs, " + \
+            r"average \d+ ms, longest \d+ ms, [1-9]\d* occurrences skipped"
+        self.server.log_match(msg, regexp=True, max_attempts=10,
+                              interval=(hook_run_time / 2))
+        # the skipped occurrences did not start runs of their own
+        lines = self.server.log_match(self.start_msg, allmatch=True,
+                                      n='ALL', max_attempts=1)
+        self.assertLessEqual(len(lines), 2)
+
+    def test_sp_hook_run_stats(self):
+        """
+        Check that the time each run takes is logged along with the
+        number of runs, their average and the longest run.
+        """
+        hook_name = "timed_hook"
+        freq = 5
+        hook_run_time = 2
+        self.server.manager(MGR_CMD_SET, SERVER, {'log_events': 2047})
+        scr = self.create_hook(True, hook_run_time)
+        attrs = {'event': "periodic", 'freq': freq, 'enabled': 'True'}
+        self.server.create_import_hook(hook_name, attrs, scr)
+        msg = hook_name + r";run took (\d+) ms \(\d+ ms cpu\); 2 runs, " + \
+            r"average (\d+) ms, longest (\d+) ms, 0 occurrences skipped"
+        line = self.server.log_match(msg, regexp=True, max_attempts=10,
+                                     interval=freq)
+        m = re.search(msg, line[1])
+        took, average, longest = [int(v) for v in m.groups()]
+        self.assertGreaterEqual(took, hook_run_time * 1000)
+        self.assertGreaterEqual(average, hook_run_time * 1000)
+        self.assertGreaterEqual(longest, max(took, average))
@@ -0,0 +1,102 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestStatjobSort(TestFunctional):
+    """
+    This test suite tests the sort, limit and offset options of a job
+    status request
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        if self.server.set_op_mode(PTL_API) != PTL_API:
+            self.skipTest("sort, limit and offset need the PBS IFL API")
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_enable': 'True'})
+
+    def tearDown(self):
+        self.server.set_op_mode(PTL_CLI)
+        TestFunctional.tearDown(self)
+
+    def stat_ids(self, extend):
+        """
+        Returns the ids of the jobs in a job status with the given extend
+        """
+        return [j['id'] for j in
+                self.server.status(JOB, ATTR_qrank, extend=extend)]
+
+    def test_sort_limit_offset_history(self):
+        """
+        Verify that a status sorted on queue_rank, with a limit and an
+        offset, returns the same slice as sorting all jobs, including
+        history jobs whose queue has been deleted
+        """
+        a = {'queue_type': 'execution', 'enabled': 'True',
+             'started': 'True'}
+        self.server.manager(MGR_CMD_CREATE, QUEUE, a, id='histq')
+        hist = []
+        for _ in range(3):
+            j = Job(TEST_USER, {ATTR_queue: 'histq'})
+            j.set_sleep_time(1)
+            hist.append(self.server.submit(j))
+        for jid in hist:
+            self.server.expect(JOB, {'job_state': 'F'}, id=jid,
+                               extend='x', offset=1)
+        self.server.manager(MGR_CMD_DELETE, QUEUE, id='histq')
+
+        # history jobs of the deleted queue are relinked at recovery
+        self.server.restart()
+        for _ in range(4):
+            j = Job(TEST_USER, {ATTR_h: None})
+            self.server.submit(j)
+
+        jobs = self.server.status(JOB, ATTR_qrank, extend='x')
+        byrank = [j['id'] for j in
+                  sorted(jobs, key=lambda j: int(j[ATTR_qrank]))]
+        self.assertEqual(len(byrank), 7)
+        for (limit, offset) in ((2, 0), (3, 2), (4, 5), (7, 0)):
+            opts = ':limit=%d:offset=%d' % (limit, offset)
+            self.assertEqual(self.stat_ids('x:sort=queue_rank' + opts),
+                             byrank[offset:offset + limit])
+            self.assertEqual(self.stat_ids('x:sort=-queue_rank' + opts),
+                             byrank[::-1][offset:offset + limit])
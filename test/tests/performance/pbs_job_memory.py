@@ -0,0 +1,86 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.performance import *
+
+
+class TestJobMemory(TestPerformance):
+    """
+    Measure how much server memory each queued job takes
+    """
+
+    def setUp(self):
+        TestPerformance.setUp(self)
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+
+    def server_rss(self):
+        """
+        Return the resident set size of pbs_server in kB
+        """
+        pid = self.server.get_pid()
+        procs = self.server.pu.get_proc_info(self.server.hostname, pid=pid)
+        self.assertTrue(procs, "could not read pbs_server process info")
+        return int(list(procs.values())[0][0].rss)
+
+    @timeout(3600)
+    def test_memory_per_queued_job(self):
+        """
+        Submit a batch of plain queued jobs and report the growth of the
+        server's resident memory divided by the number of jobs.  The
+        jobs are stat-ed and modified first, the way a scheduler cycle
+        touches them, so attributes read along the way are counted too.
+        """
+        num_jobs = 5000
+        self.server.expect(SERVER, {'total_jobs': 0})
+        rss_before = self.server_rss()
+
+        for _ in range(num_jobs):
+            j = Job(TEST_USER)
+            j.set_sleep_time(1000)
+            jid = self.server.submit(j)
+        self.server.expect(SERVER, {'total_jobs': num_jobs})
+        self.server.status(JOB)
+        self.server.alterjob(jid, {ATTR_p: '10'})
+
+        rss_after = self.server_rss()
+        per_job = float(rss_after - rss_before) / num_jobs
+        self.logger.info("pbs_server rss %d kB -> %d kB, %.2f kB per job",
+                         rss_before, rss_after, per_job)
+        self.perf_test_result(per_job, "server_memory_per_queued_job", "kB")